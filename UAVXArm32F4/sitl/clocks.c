@@ -0,0 +1,308 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL stand-in for clocks.c. Time is virtual - every clock read costs SITL_CLOCK_QUANTUM_US
+// so busy waits terminate and delays skip straight to their timeout. Interrupt sources due
+// by the new time are dispatched from here as if they had preempted the main loop.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+volatile uint32 TicksuS, uSPerCycleQ32;
+
+volatile uint64 SITLuS = 0;
+uint64 SITLStartuS = 0;
+uint64 SITLStopuS = 0;
+volatile boolean SITLInISR = false;
+
+uint64 SITLClockReads = 0;
+uint32 SITLClockErrors = 0;
+
+static uint64 NextSysTickuS = 1000;
+
+void cycleCounterInit(void) {
+
+	TicksuS = SystemCoreClock / 1000000;
+	uSPerCycleQ32 = (uint32) ((0x100000000ULL + TicksuS - 1) / TicksuS);
+
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT_CTRL |= CYCCNTENA;
+} // cycleCounterInit
+
+// Starts the virtual clock as if the board had already been up for StartuS so the 32 bit
+// uS and mS clocks can be run through their wrap.
+
+void SITLInitClock(uint64 StartuS) {
+
+	cycleCounterInit();
+
+	StartuS -= StartuS % 1000;
+
+	SITLuS = SITLStartuS = StartuS;
+	NextSysTickuS = StartuS + 1000;
+
+	sysTickUptime = (uint32) (StartuS / 1000);
+	sysTickuS = StartuS;
+	sysTickCycleCounter = (uint32) (StartuS * (SystemCoreClock / 1000000));
+	*DWT_CYCCNT = sysTickCycleCounter;
+
+	SITLCPPM.NextEdgeuS = StartuS;
+
+} // SITLInitClock
+
+void SITLDispatch(void) {
+
+	if (SITLInISR || SITLPRIMASK)
+		return;
+
+	SITLInISR = true;
+
+	while (SITLuS >= NextSysTickuS) {
+		SysTick_Handler();
+		NextSysTickuS += 1000;
+		SITLUpdatePilot();
+	}
+
+	SITLUpdateCPPM();
+	SITLUpdateSPI();
+	SITLUpdateI2C();
+	SITLServiceUSART(TelemetrySerial);
+	SITLServiceUSART(RCSerial);
+
+	SITLInISR = false;
+
+	if (SITLuS >= SITLStopuS)
+		exit(0);
+
+} // SITLDispatch
+
+void SITLAdvance(uint32 uS) {
+
+	SITLuS += uS;
+	*DWT_CYCCNT = (uint32) (SITLuS * (SystemCoreClock / 1000000));
+	SITLDispatch();
+
+} // SITLAdvance
+
+
+// Profiling probes time host execution, scaled to target clock cycles, as the virtual
+// DWT_CYCCNT only advances with the clock reads charged by SITLAdvance
+
+uint32 cycleCounter(void) {
+	return ((uint32) ((SITLHostnS() * TicksuS) / 1000));
+} // cycleCounter
+
+// The target conversion runs over the virtual DWT_CYCCNT, which wraps every 25.6S, and is
+// checked against the virtual clock
+
+uint64 uSClock64(void) {
+	uint64 NowuS;
+
+	SITLAdvance(SITL_CLOCK_QUANTUM_US);
+
+	NowuS = sysTickuS + uSFromCycles(*DWT_CYCCNT - sysTickCycleCounter);
+
+	SITLClockReads++;
+	if (NowuS != SITLuS)
+		SITLClockErrors++;
+
+	return (NowuS);
+} // uSClock64
+
+uint32 uSClock(void) {
+	return ((uint32) uSClock64());
+} // uSClock
+
+void Delay1uS(uint16 d) {
+
+	SITLAdvance(d);
+
+} // Delay1uS
+
+uint32 mSClock(void) {
+
+	SITLAdvance(SITL_CLOCK_QUANTUM_US);
+
+	return (sysTickUptime);
+} // mSClock
+
+void Delay1mS(uint16 d) {
+	uint32 TimeOut;
+
+	TimeOut = mSClock() + d + 1; // as target - may return up to 1mS late
+	while (!TimeReached(mSClock(), TimeOut))
+		SITLAdvance(1000 - (SITLuS % 1000));
+
+} // Delay1mS
+
+void delay(uint16 d) {
+
+	Delay1mS(d);
+
+} // delay
+
+real32 dTUpdate(uint32 NowuS, uint32 * LastUpdateuS) {
+	real32 dT;
+
+	NowuS = uSClock();
+	dT = (NowuS - *LastUpdateuS) * 0.000001f;
+	*LastUpdateuS = NowuS;
+
+	return (dT);
+} // dtUpdate
+
+void mSTimer(uint32 NowmS, uint8 t, int32 TimePeriod) {
+	mS[t] = NowmS + TimePeriod;
+} // mSTimer
+
+void uSTimer(uint64 NowuS, uint8 t, int32 TimePeriod) {
+	uS[t] = NowuS + TimePeriod;
+} // uSTimer
+
+boolean mSTimeout(uint32 NowmS, uint8 t) {
+	return (TimeReached(NowmS, mS[t]));
+} // mSTimeout
+
+boolean uSTimeout(uint64 NowuS, uint8 t) {
+	return (NowuS >= uS[t]);
+} // uSTimeout
+
+void InitClocks(void) {
+	cycleCounterInit();
+	SysTick_Config(SystemCoreClock / 1000); // 1mS
+} // InitClocks
+
+//______________________________________________________________________________________________
+
+// Time base benchmark - checks the divide free conversion against a divide over the range
+// a late SysTick could leave and times clock reads on the host. Both reads spin on the same
+// memory mapped registers so the difference is the conversion, not the virtual clock.
+
+static uint32 LegacyuSClock(void) {
+	uint32 ms, cycle_cnt;
+
+	do {
+		ms = sysTickUptime;
+		cycle_cnt = SysTick->VAL;
+	} while (ms != sysTickUptime);
+
+	return (ms * 1000) + (TicksuS * 1000 - cycle_cnt) / TicksuS;
+} // LegacyuSClock
+
+static uint64 CycleuSClock64(void) {
+	uint32 ms, c0, c;
+	uint64 BaseuS;
+
+	do {
+		ms = sysTickUptime;
+		BaseuS = sysTickuS;
+		c0 = sysTickCycleCounter;
+		c = *DWT_CYCCNT;
+	} while (ms != sysTickUptime);
+
+	return (BaseuS + uSFromCycles(c - c0));
+} // CycleuSClock64
+
+#define SITL_BENCH_CALLS 20000000
+
+static real64 BenchnS(uint32 (*Read)(void), volatile uint32 * Sink) {
+	uint64 StartnS;
+	uint32 i;
+
+	StartnS = SITLHostnS();
+	for (i = 0; i < SITL_BENCH_CALLS; i++)
+		*Sink += Read();
+
+	return ((real64) (SITLHostnS() - StartnS) / SITL_BENCH_CALLS);
+} // BenchnS
+
+static uint32 Bench64(void) {
+	return ((uint32) CycleuSClock64());
+} // Bench64
+
+static uint32 BenchmS(void) {
+	return (sysTickUptime);
+} // BenchmS
+
+// A lone sample must come back as its own percentile whichever bin it lands in,
+// including the top bin whose upper bound is clamped to the counter range.
+
+static boolean ProfileLoneSample(uint32 c) {
+	ResetProfile();
+	ProfileInterval(ProfCycle, c);
+	return (ProfilePercentilec(ProfCycle, 99) == c);
+} // ProfileLoneSample
+
+static uint32 ProfileBinErrors(void) {
+	uint32 c, Errors;
+	idx b, q;
+
+	Errors = 0;
+	for (b = 0; b < 32; b++)
+		for (q = 0; q < 4; q++) { // bottom and top of each quarter octave
+			c = (1u << b) + q * ((1u << b) >> 2);
+			if (!ProfileLoneSample(c) || !ProfileLoneSample(c - 1))
+				Errors++;
+		}
+	if (!ProfileLoneSample(0xffffffff)) // last bin
+		Errors++;
+	ResetProfile();
+
+	return (Errors);
+} // ProfileBinErrors
+
+int SITLClockBenchmark(void) {
+	volatile uint32 Sink = 0;
+	uint32 c, ExactLimitc, Errors, MaxErroruS, BinErrors;
+	int32 e;
+
+	SITLInitClock(0);
+	SysTick->VAL = 12345;
+	*DWT_CYCCNT = 12345;
+
+	ExactLimitc = (uint32) (0x100000000ULL / TicksuS);
+	Errors = 0;
+	for (c = 0; c < ExactLimitc; c++)
+		if (uSFromCycles(c) != (c / TicksuS))
+			Errors++;
+
+	MaxErroruS = 0;
+	for (c = ExactLimitc; c < 0xffffff00; c += 997) {
+		e = (int32) uSFromCycles(c) - (int32) (c / TicksuS);
+		if ((uint32) Abs(e) > MaxErroruS)
+			MaxErroruS = Abs(e);
+	}
+
+	printf("UAVX SITL time base, %u cycles/uS\n", TicksuS);
+	printf("  uSFromCycles exact to %u cycles (%.0fmS of late SysTick): %u errors\n",
+			ExactLimitc, ExactLimitc / (TicksuS * 1000.0), Errors);
+	printf("  max error to DWT_CYCCNT wrap %uuS\n", MaxErroruS);
+	printf("  TimeReached across 32 bit wrap: %s\n", (TimeReached(5, 0xfffffff0)
+			&& !TimeReached(0xfffffff0, 5) && TimeReached(7, 7)) ? "ok" : "FAILED");
+	BinErrors = ProfileBinErrors();
+	printf("  profile percentiles across all %u bins: %u errors\n",
+			PROFILE_BINS, BinErrors);
+	printf("  host ns/call: divide uSClock %.2f, uSClock64 %.2f, mSClock %.2f\n",
+			BenchnS(LegacyuSClock, &Sink), BenchnS(Bench64, &Sink), BenchnS(
+					BenchmS, &Sink));
+
+	return ((Errors == 0) && (BinErrors == 0) && TimeReached(5, 0xfffffff0) ? 0
+			: 1);
+} // SITLClockBenchmark
@@ -0,0 +1,237 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Coning and sculling test (-c). Synthetic sample streams with exact truth are integrated
+// through IMUDelta at 1 to 8 samples per cycle and compared with summing the samples, as
+// averaging them down to the cycle rate does. Coning is a 2deg half angle cone at 20Hz,
+// sculling a 2deg roll oscillation in phase with a 2M/S^2 lateral one at 20Hz.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define CONING_SAMPLE_S		0.001 // 1KHz as the MPU6XXX FIFO
+#define CONING_HZ			20.0
+#define CONING_ANGLE		DegreesToRadians(2.0)
+#define CONING_ACC			2.0 // M/S^2
+#define CONING_DURATION_S	10.0
+
+typedef real64 QStruct[4];
+
+static void QMul(real64 * r, const real64 * p, const real64 * q) {
+	real64 t[4];
+
+	t[0] = p[0] * q[0] - p[1] * q[1] - p[2] * q[2] - p[3] * q[3];
+	t[1] = p[0] * q[1] + p[1] * q[0] + p[2] * q[3] - p[3] * q[2];
+	t[2] = p[0] * q[2] - p[1] * q[3] + p[2] * q[0] + p[3] * q[1];
+	t[3] = p[0] * q[3] + p[1] * q[2] - p[2] * q[1] + p[3] * q[0];
+	memcpy(r, t, sizeof(t));
+
+} // QMul
+
+// q = q x exp(v/2) exactly, so only the delta angle is under test
+
+static void QRotate(real64 * q, const real64 * v) {
+	real64 d[4], a, s;
+
+	a = sqrt(Sqr(v[0]) + Sqr(v[1]) + Sqr(v[2]));
+	s = (a > 1.0e-12) ? sin(0.5 * a) / a : 0.5;
+	d[0] = cos(0.5 * a);
+	d[1] = v[0] * s;
+	d[2] = v[1] * s;
+	d[3] = v[2] * s;
+	QMul(q, q, d);
+
+} // QRotate
+
+static real64 QAngle(const real64 * p, const real64 * q) {
+	real64 c;
+
+	c = fabs(p[0] * q[0] + p[1] * q[1] + p[2] * q[2] + p[3] * q[3]);
+	return (2.0 * acos(fmin(c, 1.0)));
+} // QAngle
+
+static void QToR(real64 R[3][3], const real64 * q) {
+
+	R[0][0] = 1.0 - 2.0 * (q[2] * q[2] + q[3] * q[3]);
+	R[0][1] = 2.0 * (q[1] * q[2] - q[0] * q[3]);
+	R[0][2] = 2.0 * (q[1] * q[3] + q[0] * q[2]);
+	R[1][0] = 2.0 * (q[1] * q[2] + q[0] * q[3]);
+	R[1][1] = 1.0 - 2.0 * (q[1] * q[1] + q[3] * q[3]);
+	R[1][2] = 2.0 * (q[2] * q[3] - q[0] * q[1]);
+	R[2][0] = 2.0 * (q[1] * q[3] - q[0] * q[2]);
+	R[2][1] = 2.0 * (q[2] * q[3] + q[0] * q[1]);
+	R[2][2] = 1.0 - 2.0 * (q[1] * q[1] + q[2] * q[2]);
+
+} // QToR
+
+// Cone about z - attitude is a rotation of the cone half angle about a horizontal axis
+// turning at W, with body rate (-W sinB sinWt, W sinB cosWt, -W (1 - cosB))
+
+static void ConeAttitude(real64 t, real64 * q) {
+	const real64 W = TWO_PI * CONING_HZ;
+
+	q[0] = cos(0.5 * CONING_ANGLE);
+	q[1] = sin(0.5 * CONING_ANGLE) * cos(W * t);
+	q[2] = sin(0.5 * CONING_ANGLE) * sin(W * t);
+	q[3] = 0.0;
+
+} // ConeAttitude
+
+static void ConeSample(real64 t0, real64 h, real32 * w) {
+	const real64 W = TWO_PI * CONING_HZ;
+
+	// mean rate over the sample interval, as an integrating gyro
+	w[X] = sin(CONING_ANGLE) * (cos(W * (t0 + h)) - cos(W * t0)) / h;
+	w[Y] = sin(CONING_ANGLE) * (sin(W * (t0 + h)) - sin(W * t0)) / h;
+	w[Z] = -W * (1.0 - cos(CONING_ANGLE));
+
+} // ConeSample
+
+// Sculling - roll A sinWt with lateral specific force B sinWt rectifies into a steady
+// vertical velocity change
+
+static void ScullSample(real64 t0, real64 h, real32 * w, real32 * f) {
+	const real64 W = TWO_PI * CONING_HZ;
+
+	w[X] = CONING_ANGLE * (sin(W * (t0 + h)) - sin(W * t0)) / h;
+	w[Y] = w[Z] = 0.0f;
+	f[X] = f[Z] = 0.0f;
+	f[Y] = CONING_ACC * (cos(W * t0) - cos(W * (t0 + h))) / (W * h);
+
+} // ScullSample
+
+static void ScullTruth(real64 t, real64 * v) {
+	const real64 W = TWO_PI * CONING_HZ;
+	const uint32 Steps = 200000; // Simpson
+	real64 s, h, r, fy;
+	uint32 i;
+
+	v[0] = v[1] = v[2] = 0.0;
+	h = t / Steps;
+	for (i = 0; i <= Steps; i++) {
+		s = i * h;
+		r = CONING_ANGLE * sin(W * s);
+		fy = CONING_ACC * sin(W * s) * ((i == 0) || (i == Steps) ? 1.0
+				: ((i & 1) ? 4.0 : 2.0)) * h / 3.0;
+		v[1] += cos(r) * fy;
+		v[2] += sin(r) * fy;
+	}
+
+} // ScullTruth
+
+static void ConingRun(uint32 n, real64 * ConeE, real64 * ConeSumE,
+		real64 * ScullE, real64 * ScullSumE) {
+	const uint32 Cycles = (uint32) (CONING_DURATION_S / (n * CONING_SAMPLE_S));
+	const real64 h = CONING_SAMPLE_S;
+	real64 qT[4], qD[4], qS[4], qV[4], vD[3], vS[3], vT[3], R[3][3], Sum[3],
+			SumV[3], a[3], t;
+	real32 w[3], f[3];
+	uint32 c, k;
+	idx i, j;
+
+	// coning
+	ConeAttitude(0.0, qD);
+	memcpy(qS, qD, sizeof(qS));
+	ResetIMUDelta();
+	ConeSample(-h, h, w); // previous sample for the first coning term
+	f[X] = f[Y] = f[Z] = 0.0f;
+	AccumulateIMUDelta(w, f);
+	ResetIMUDelta();
+
+	t = 0.0;
+	for (c = 0; c < Cycles; c++) {
+		Sum[X] = Sum[Y] = Sum[Z] = 0.0;
+		for (k = 0; k < n; k++, t += h) {
+			ConeSample(t, h, w);
+			AccumulateIMUDelta(w, f);
+			for (i = X; i <= Z; i++)
+				Sum[i] += w[i] * h;
+		}
+		CompleteIMUDelta(n * h);
+		for (i = X; i <= Z; i++)
+			a[i] = IMUDelta.Angle[i];
+		QRotate(qD, a);
+		QRotate(qS, Sum);
+	}
+	ConeAttitude(t, qT);
+	*ConeE = QAngle(qT, qD);
+	*ConeSumE = QAngle(qT, qS);
+
+	// sculling - velocity is resolved with the true attitude at the start of each cycle
+	ResetIMUDelta();
+	ScullSample(-h, h, w, f);
+	AccumulateIMUDelta(w, f);
+	ResetIMUDelta();
+
+	qV[0] = 1.0;
+	qV[1] = qV[2] = qV[3] = 0.0;
+	for (i = 0; i < 3; i++)
+		vD[i] = vS[i] = 0.0;
+	t = 0.0;
+	for (c = 0; c < Cycles; c++) {
+		QToR(R, qV);
+		SumV[X] = SumV[Y] = SumV[Z] = 0.0;
+		for (k = 0; k < n; k++, t += h) {
+			ScullSample(t, h, w, f);
+			AccumulateIMUDelta(w, f);
+			for (i = X; i <= Z; i++)
+				SumV[i] += f[i] * h;
+		}
+		CompleteIMUDelta(n * h);
+		for (i = 0; i < 3; i++)
+			for (j = 0; j < 3; j++) {
+				vD[i] += R[i][j] * IMUDelta.Vel[j];
+				vS[i] += R[i][j] * SumV[j];
+			}
+		qV[0] = cos(0.5 * CONING_ANGLE * sin(TWO_PI * CONING_HZ * t));
+		qV[1] = sin(0.5 * CONING_ANGLE * sin(TWO_PI * CONING_HZ * t));
+	}
+	ScullTruth(t, vT);
+	*ScullE = sqrt(Sqr(vD[0] - vT[0]) + Sqr(vD[1] - vT[1]) + Sqr(vD[2] - vT[2]));
+	*ScullSumE = sqrt(Sqr(vS[0] - vT[0]) + Sqr(vS[1] - vT[1]) + Sqr(vS[2]
+			- vT[2]));
+
+} // ConingRun
+
+int SITLConingTest(void) {
+	real64 ConeE, ConeSumE, ScullE, ScullSumE;
+	uint32 n;
+	boolean OK;
+
+	SITLInitClock(0);
+	SITLStopuS = ~0ULL;
+
+	printf("UAVX SITL coning and sculling, %.0fHz samples at %.0fHz, errors after %.0fS\n",
+			1.0 / CONING_SAMPLE_S, CONING_HZ, CONING_DURATION_S);
+	printf("  %-9s %22s %22s\n", "samples", "attitude deg", "velocity M/S");
+	printf("  %-9s %11s %10s %11s %10s\n", "per cycle", "summed", "IMUDelta",
+			"summed", "IMUDelta");
+
+	OK = true;
+	for (n = 1; n <= 8; n <<= 1) {
+		ConingRun(n, &ConeE, &ConeSumE, &ScullE, &ScullSumE);
+		printf("  %-9u %11.4f %10.4f %11.5f %10.5f\n", n, RadiansToDegrees(
+				ConeSumE), RadiansToDegrees(ConeE), ScullSumE, ScullE);
+		OK &= (ConeE < 0.1 * ConeSumE) && (ScullE < 0.1 * ScullSumE);
+	}
+	printf("  %s\n", OK ? "ok" : "FAILED");
+
+	return (OK ? 0 : 1);
+} // SITLConingTest
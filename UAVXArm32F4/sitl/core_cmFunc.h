@@ -0,0 +1,119 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL replacement for the CMSIS core register intrinsics. PRIMASK is honoured by the
+// SITL interrupt dispatcher so __disable_irq()/__enable_irq() critical sections behave.
+
+#ifndef __CORE_CMFUNC_H
+#define __CORE_CMFUNC_H
+
+extern volatile uint32_t SITLPRIMASK;
+extern uint32_t SITLCoreReg[8];
+
+enum {
+	SITLCONTROL, SITLPSP, SITLMSP, SITLBASEPRI, SITLFAULTMASK, SITLFPSCR
+};
+
+static inline void __enable_irq(void) {
+	SITLPRIMASK = 0;
+}
+
+static inline void __disable_irq(void) {
+	SITLPRIMASK = 1;
+}
+
+static inline uint32_t __get_PRIMASK(void) {
+	return (SITLPRIMASK);
+}
+
+static inline void __set_PRIMASK(uint32_t priMask) {
+	SITLPRIMASK = priMask & 1;
+}
+
+static inline void __enable_fault_irq(void) {
+	SITLCoreReg[SITLFAULTMASK] = 0;
+}
+
+static inline void __disable_fault_irq(void) {
+	SITLCoreReg[SITLFAULTMASK] = 1;
+}
+
+static inline uint32_t __get_CONTROL(void) {
+	return (SITLCoreReg[SITLCONTROL]);
+}
+
+static inline void __set_CONTROL(uint32_t control) {
+	SITLCoreReg[SITLCONTROL] = control;
+}
+
+static inline uint32_t __get_IPSR(void) {
+	return (0);
+}
+
+static inline uint32_t __get_APSR(void) {
+	return (0);
+}
+
+static inline uint32_t __get_xPSR(void) {
+	return (0);
+}
+
+static inline uint32_t __get_PSP(void) {
+	return (SITLCoreReg[SITLPSP]);
+}
+
+static inline void __set_PSP(uint32_t topOfProcStack) {
+	SITLCoreReg[SITLPSP] = topOfProcStack;
+}
+
+static inline uint32_t __get_MSP(void) {
+	return (SITLCoreReg[SITLMSP]);
+}
+
+static inline void __set_MSP(uint32_t topOfMainStack) {
+	SITLCoreReg[SITLMSP] = topOfMainStack;
+}
+
+static inline uint32_t __get_BASEPRI(void) {
+	return (SITLCoreReg[SITLBASEPRI]);
+}
+
+static inline void __set_BASEPRI(uint32_t value) {
+	SITLCoreReg[SITLBASEPRI] = value;
+}
+
+static inline uint32_t __get_FAULTMASK(void) {
+	return (SITLCoreReg[SITLFAULTMASK]);
+}
+
+static inline void __set_FAULTMASK(uint32_t faultMask) {
+	SITLCoreReg[SITLFAULTMASK] = faultMask;
+}
+
+static inline uint32_t __get_FPSCR(void) {
+	return (SITLCoreReg[SITLFPSCR]);
+}
+
+static inline void __set_FPSCR(uint32_t fpscr) {
+	SITLCoreReg[SITLFPSCR] = fpscr;
+}
+
+#endif /* __CORE_CMFUNC_H */
+
@@ -0,0 +1,128 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL replacement for the CMSIS core instruction intrinsics - found ahead of
+// lib/Device/ST/STM32F4xx/Include by core_cm4.h's <core_cmInstr.h>
+
+#ifndef __CORE_CMINSTR_H
+#define __CORE_CMINSTR_H
+
+static inline void __NOP(void) {
+}
+
+static inline void __WFI(void) {
+}
+
+static inline void __WFE(void) {
+}
+
+static inline void __SEV(void) {
+}
+
+static inline void __ISB(void) {
+	__sync_synchronize();
+}
+
+static inline void __DSB(void) {
+	__sync_synchronize();
+}
+
+static inline void __DMB(void) {
+	__sync_synchronize();
+}
+
+static inline uint32_t __REV(uint32_t value) {
+	return (__builtin_bswap32(value));
+}
+
+static inline uint32_t __REV16(uint32_t value) {
+	return (((value & 0xff00ff00) >> 8) | ((value & 0x00ff00ff) << 8));
+}
+
+static inline int32_t __REVSH(int32_t value) {
+	return ((int16_t) __builtin_bswap16((uint16_t) value));
+}
+
+static inline uint32_t __ROR(uint32_t op1, uint32_t op2) {
+	op2 &= 31;
+	return (op2 == 0 ? op1 : (op1 >> op2) | (op1 << (32 - op2)));
+}
+
+static inline uint32_t __RBIT(uint32_t value) {
+	uint32_t r = 0;
+	int i;
+
+	for (i = 0; i < 32; i++, value >>= 1)
+		r = (r << 1) | (value & 1);
+	return (r);
+}
+
+static inline uint8_t __LDREXB(volatile uint8_t *addr) {
+	return (*addr);
+}
+
+static inline uint16_t __LDREXH(volatile uint16_t *addr) {
+	return (*addr);
+}
+
+static inline uint32_t __LDREXW(volatile uint32_t *addr) {
+	return (*addr);
+}
+
+static inline uint32_t __STREXB(uint8_t value, volatile uint8_t *addr) {
+	*addr = value;
+	return (0);
+}
+
+static inline uint32_t __STREXH(uint16_t value, volatile uint16_t *addr) {
+	*addr = value;
+	return (0);
+}
+
+static inline uint32_t __STREXW(uint32_t value, volatile uint32_t *addr) {
+	*addr = value;
+	return (0);
+}
+
+static inline void __CLREX(void) {
+}
+
+static inline int32_t __sitl_ssat(int32_t v, uint32_t sat) {
+	const int32_t max = (int32_t) ((1UL << (sat - 1)) - 1);
+	const int32_t min = -max - 1;
+
+	return (v > max ? max : (v < min ? min : v));
+}
+
+static inline uint32_t __sitl_usat(int32_t v, uint32_t sat) {
+	const int32_t max = (int32_t) ((1UL << sat) - 1);
+
+	return (v > max ? max : (v < 0 ? 0 : v));
+}
+
+#define __SSAT(ARG1,ARG2) __sitl_ssat((int32_t)(ARG1), (ARG2))
+#define __USAT(ARG1,ARG2) __sitl_usat((int32_t)(ARG1), (ARG2))
+
+static inline uint8_t __CLZ(uint32_t value) {
+	return (value == 0 ? 32 : __builtin_clz(value));
+}
+
+#endif /* __CORE_CMINSTR_H */
+
@@ -0,0 +1,394 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Estimator benchmark (-e). A multirotor flight with known truth is synthesised with thrust
+// along the body z axis, so in manoeuvres the accelerometer does not see the direction of
+// gravity. Its biased, noisy gyro, accelerometer, magnetometer, altitude and GPS samples
+// drive each state estimator in turn from the same start and the attitude errors after
+// settling and the host time per update are reported, with altitude, position and bias
+// errors for the error state EKF.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define EST_DURATION_S		120.0
+#define EST_SETTLE_S		10.0
+#define EST_MAG_DIV			7 // ~70Hz
+#define EST_ALT_DIV			25 // 20Hz as ALT_UPDATE_MS
+#define EST_GPS_DIV			100 // 5Hz
+#define EST_DIFF_S			1.0e-3
+#define EST_YAW_RMS_DEG		10.0 // estimators with the magnetometer
+#define EST_ATT_CACHE_ERR	1.0e-3 // Att DCM and gravity against its sin/cos
+
+#define EST_GYRO_SDEV		0.02f // rad/S
+#define EST_ACC_SDEV		0.5f // M/S^2
+#define EST_MAG_SDEV		0.01f // normalised
+#define EST_ALT_SDEV		0.3f
+#define EST_GPS_POS_SDEV	1.0f
+#define EST_GPS_VEL_SDEV	0.15f
+
+static const real32 GyroBiasT[3] = { 0.005f, -0.004f, 0.003f }; // ~0.3deg/S residual
+static const real32 AccBiasT[3] = { 0.15f, -0.1f, 0.2f };
+
+typedef struct {
+	real64 SumSq[3], Max[3];
+	real64 AttCacheErr;
+	real64 AltSumSq, ROCSumSq, PosSumSq, VelSumSq;
+	real64 AltRawSumSq, PosRawSumSq;
+	uint32 n, nAlt, nAltRaw, nGPS;
+	uint64 nS;
+} EstErrStruct;
+
+real32 SITLGauss(void) {
+	real32 u, v;
+
+	u = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+	v = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+	return (sqrtf(-2.0f * logf(u)) * cosf(TWO_PI * v));
+} // SITLGauss
+
+// a circuit with a superimposed weave, a slow climb and descent and yawing, eased in
+// after hovering for 5S
+
+static void TruthPath(real64 t, real64 * p, real64 * Yaw) {
+	real64 x, e;
+
+	x = fmin(fmax((t - 5.0) / 10.0, 0.0), 1.0); // smooth to the third derivative
+	e = x * x * x * x * (35.0 + x * (-84.0 + x * (70.0 - 20.0 * x)));
+
+	p[NorthC] = e * (25.0 * sin(2.0 * M_PI * t / 25.0) + 0.5 * sin(2.0 * M_PI
+			* 0.4 * t));
+	p[EastC] = e * 25.0 * (1.0 - cos(2.0 * M_PI * t / 25.0));
+	p[DownC] = -10.0 - e * 3.0 * sin(2.0 * M_PI * t / 15.0);
+	*Yaw = 0.5 + e * 1.2 * sin(2.0 * M_PI * t / 30.0);
+
+} // TruthPath
+
+static void Cross(real64 * c, const real64 * a, const real64 * b) {
+
+	c[0] = a[1] * b[2] - a[2] * b[1];
+	c[1] = a[2] * b[0] - a[0] * b[2];
+	c[2] = a[0] * b[1] - a[1] * b[0];
+
+} // Cross
+
+static void Normalise(real64 * v) {
+	real64 n;
+
+	n = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+	v[0] /= n;
+	v[1] /= n;
+	v[2] /= n;
+
+} // Normalise
+
+// body z is opposite the specific force and body x is as near the yaw as it allows
+
+static void TruthAttitude(real64 t, real64 R[3][3], real64 * fn, real64 * Vel,
+		real64 * Pos) {
+	const real64 h = EST_DIFF_S;
+	real64 pm[3], p[3], pp[3], Yaw, x[3], y[3], z[3], c[3];
+	idx i;
+
+	TruthPath(t - h, pm, &Yaw);
+	TruthPath(t + h, pp, &Yaw);
+	TruthPath(t, p, &Yaw);
+
+	for (i = 0; i < 3; i++) {
+		fn[i] = (pp[i] - 2.0 * p[i] + pm[i]) / (h * h);
+		if (Vel)
+			Vel[i] = (pp[i] - pm[i]) / (2.0 * h);
+		if (Pos)
+			Pos[i] = p[i];
+	}
+	fn[DownC] -= GRAVITY_MPS_S;
+
+	for (i = 0; i < 3; i++)
+		z[i] = -fn[i];
+	Normalise(z);
+	c[0] = cos(Yaw);
+	c[1] = sin(Yaw);
+	c[2] = 0.0;
+	Cross(y, z, c);
+	Normalise(y);
+	Cross(x, y, z);
+
+	for (i = 0; i < 3; i++) {
+		R[i][0] = x[i];
+		R[i][1] = y[i];
+		R[i][2] = z[i];
+	}
+
+} // TruthAttitude
+
+void SITLTruth(real64 t, SITLTruthStruct * T) {
+	const real64 h = EST_DIFF_S;
+	real64 Rm[3][3], Rp[3][3], Rd[3][3], W[3][3], fn[3], Unused[3];
+	idx i, j, k;
+
+	TruthAttitude(t, T->R, fn, T->Vel, T->Pos);
+	TruthAttitude(t - h, Rm, Unused, NULL, NULL);
+	TruthAttitude(t + h, Rp, Unused, NULL, NULL);
+
+	for (i = 0; i < 3; i++)
+		for (j = 0; j < 3; j++)
+			Rd[i][j] = (Rp[i][j] - Rm[i][j]) / (2.0 * h);
+
+	for (i = 0; i < 3; i++) { // W = R' dR/dt
+		T->f[i] = 0.0;
+		for (j = 0; j < 3; j++) {
+			T->f[i] += T->R[j][i] * fn[j];
+			W[i][j] = 0.0;
+			for (k = 0; k < 3; k++)
+				W[i][j] += T->R[k][i] * Rd[k][j];
+		}
+	}
+	T->Rate[X] = W[2][1];
+	T->Rate[Y] = W[0][2];
+	T->Rate[Z] = W[1][0];
+
+	T->Angle[Roll] = atan2(T->R[2][1], T->R[2][2]);
+	T->Angle[Pitch] = -asin(T->R[2][0]);
+	T->Angle[Yaw] = atan2(T->R[1][0], T->R[0][0]);
+
+} // SITLTruth
+
+static void EstRun(uint8 Est, EstErrStruct * E) {
+	const uint32 Cycles = (uint32) (EST_DURATION_S * 1.0e6 / PID_CYCLE_2000US);
+	const real64 Dip = DegreesToRadians(60.0);
+	SITLTruthStruct T;
+	real64 t, e, mn[3], p, v;
+	real32 Alt, Pos[2], Vel[2];
+	uint64 StartnS;
+	uint32 k;
+	idx a, i;
+
+	memset(E, 0, sizeof(EstErrStruct));
+	srand(1);
+
+	CurrStateEst = Est;
+	State = InFlight;
+	F.Emulation = false;
+	MagVariation = 0.0f;
+	mn[NorthC] = cos(Dip);
+	mn[EastC] = 0.0;
+	mn[DownC] = sin(Dip);
+
+	dT = CurrPIDCycleS;
+	dTOn2 = 0.5f * dT;
+	dTR = 1.0f / dT;
+	dTROn2 = 0.5f * dTR;
+
+	for (k = 0; k <= Cycles; k++) {
+		t = (real64) k * CurrPIDCycleS;
+		SITLTruth(t, &T);
+
+		Rate[Roll] = T.Rate[X] + GyroBiasT[X] + EST_GYRO_SDEV * SITLGauss();
+		Rate[Pitch] = T.Rate[Y] + GyroBiasT[Y] + EST_GYRO_SDEV * SITLGauss();
+		Rate[Yaw] = T.Rate[Z] + GyroBiasT[Z] + EST_GYRO_SDEV * SITLGauss();
+		for (a = X; a <= Z; a++)
+			Acc[a] = T.f[a] + AccBiasT[a] + EST_ACC_SDEV * SITLGauss();
+
+		if ((k % EST_MAG_DIV) == 0) {
+			for (a = X; a <= Z; a++) {
+				e = 0.0;
+				for (i = 0; i < 3; i++)
+					e += T.R[i][a] * mn[i];
+				Mag[a] = e + EST_MAG_SDEV * SITLGauss();
+			}
+			e = invSqrt(Sqr(Mag[X]) + Sqr(Mag[Y]) + Sqr(Mag[Z]));
+			for (a = X; a <= Z; a++)
+				Mag[a] *= e;
+			F.NewMagValues = true;
+		}
+
+		if (k == 0) { // everyone starts from the true attitude
+			A[Yaw].Angle = T.Angle[Yaw];
+			Altitude = -T.Pos[DownC];
+			if (Est == MadgwickMARG) // as InitMadgwick
+				ConvertEulerToMARGQuaternion(T.Angle[Pitch], T.Angle[Roll],
+						T.Angle[Yaw]);
+			else {
+				ConvertEulerToQuaternion(T.Angle[Pitch], T.Angle[Roll],
+						T.Angle[Yaw]);
+				ConvertQuaternionToEuler();
+			}
+			if (Est == ErrorStateEKF)
+				InitESKF();
+		}
+
+		CompleteIMUDelta(dT); // one sample per cycle, as UpdateInertial
+
+		StartnS = SITLHostnS();
+		switch (Est) {
+		case ErrorStateEKF:
+			ESKFUpdate(IMUDelta.Angle[X], IMUDelta.Angle[Y], IMUDelta.Angle[Z],
+					IMUDelta.Vel[X], IMUDelta.Vel[Y], IMUDelta.Vel[Z]);
+			if (F.NewMagValues) { // as UpdateHeading
+				CalculateMagneticHeading();
+				ESKFFuseHeading(MagHeading);
+			}
+			if ((k % EST_ALT_DIV) == 0) {
+				Alt = -T.Pos[DownC] + EST_ALT_SDEV * SITLGauss();
+				Altitude = Alt;
+				ESKFFuseAltitude();
+				E->AltRawSumSq += Sqr(Alt + T.Pos[DownC]);
+				E->nAltRaw++;
+			}
+			if ((k % EST_GPS_DIV) == 0) {
+				for (a = NorthC; a <= EastC; a++) {
+					Pos[a] = Nav.C[a].Pos = T.Pos[a] + EST_GPS_POS_SDEV
+							* SITLGauss();
+					Vel[a] = Nav.C[a].Vel = T.Vel[a] + EST_GPS_VEL_SDEV
+							* SITLGauss();
+				}
+				GPS.hAcc = EST_GPS_POS_SDEV;
+				GPS.sAcc = EST_GPS_VEL_SDEV;
+				ESKFFuseGPS();
+				E->PosRawSumSq += Sqr(Pos[NorthC] - T.Pos[NorthC]) + Sqr(
+						Pos[EastC] - T.Pos[EastC]);
+				E->nGPS++;
+			}
+			break;
+		case MadgwickMARG:
+			MadgwickMARGUpdate(IMUDelta.Angle[X], IMUDelta.Angle[Y],
+					IMUDelta.Angle[Z], Acc[BF], Acc[LR], Acc[UD], Mag[X], Mag[Y],
+					Mag[Z]);
+			break;
+		default:
+			MadgwickUpdate(Est == MadgwickAHRS, IMUDelta.Angle[X],
+					IMUDelta.Angle[Y], IMUDelta.Angle[Z], Acc[BF], Acc[LR],
+					Acc[UD], Mag[X], Mag[Y], Mag[Z]);
+			if (F.NewMagValues) // MadgwickIMU heading is gyro only in flight
+				CalculateMagneticHeading();
+			break;
+		}
+		E->nS += SITLHostnS() - StartnS;
+		F.NewMagValues = false;
+
+		if (t >= EST_SETTLE_S) {
+			for (a = Pitch; a <= Yaw; a++) {
+				e = fabs(remainder(A[a].Angle - T.Angle[a], 2.0 * M_PI));
+				E->SumSq[a] += e * e;
+				E->Max[a] = fmax(E->Max[a], e);
+			}
+			E->n++;
+
+			// the cached products must describe the same attitude
+			e = fmax(fabs(Att.Gravity[X] + Att.Sin[Pitch]), fabs(Att.Gravity[Y]
+					- Att.Sin[Roll] * Att.Cos[Pitch]));
+			e = fmax(e, fabs(Att.Gravity[Z] - Att.Cos[Roll] * Att.Cos[Pitch]));
+			e = fmax(e, fabs(Att.DCM[0][0] - Att.Cos[Yaw] * Att.Cos[Pitch]));
+			e = fmax(e, fabs(Att.DCM[1][0] - Att.Sin[Yaw] * Att.Cos[Pitch]));
+			E->AttCacheErr = fmax(E->AttCacheErr, e);
+
+			if (Est == ErrorStateEKF) {
+				E->AltSumSq += Sqr(ESKF.Pos[DownC] - T.Pos[DownC]);
+				E->ROCSumSq += Sqr(ESKF.Vel[DownC] - T.Vel[DownC]);
+				p = v = 0.0;
+				for (a = NorthC; a <= EastC; a++) {
+					p += Sqr(ESKF.Pos[a] - T.Pos[a]);
+					v += Sqr(ESKF.Vel[a] - T.Vel[a]);
+				}
+				E->PosSumSq += p;
+				E->VelSumSq += v;
+				E->nAlt++;
+			}
+		}
+	}
+
+} // EstRun
+
+static real64 RMSDeg(real64 SumSq, uint32 n) {
+	return (RadiansToDegrees(sqrt(SumSq / n)));
+} // RMSDeg
+
+int SITLEstimatorBenchmark(void) {
+	static const char * Name[] = { "MadgwickIMU", "MadgwickAHRS",
+			"MadgwickMARG", "ErrorStateEKF" };
+	EstErrStruct E[EstUnknown];
+	real64 GyroBiasE, AccBiasE, AttRMS[EstUnknown], YawRMS[EstUnknown], e;
+	uint32 Cycles;
+	idx Est, a;
+	boolean OK;
+
+	SITLInitClock(0);
+	SITLStopuS = ~0ULL;
+	SITLInitSensors();
+	SITLCommission();
+
+	// as UpdateParameters
+	SetPIDPeriod();
+	KpAccBase = P(MadgwickKpAcc) * 0.1f;
+	BetaBase = KpAccBase * 0.2f;
+	KpMagBase = P(MadgwickKpMag) * 0.1f;
+	F.MagnetometerActive = false; // Mag[] is supplied
+
+	printf("UAVX SITL state estimators, %.0fS synthetic flight at %uuS, errors after %.0fS\n",
+			EST_DURATION_S, CurrPIDCycleuS, EST_SETTLE_S);
+	printf("  %-14s %16s %16s %16s %9s\n", "", "roll rms/max", "pitch rms/max",
+			"yaw rms/max", "nS/update");
+
+	for (Est = MadgwickIMU; Est < EstUnknown; Est++) {
+		EstRun(Est, &E[Est]);
+		Cycles = (uint32) (EST_DURATION_S * 1.0e6 / PID_CYCLE_2000US) + 1;
+		printf("  %-14s %7.2f %7.2fdeg %7.2f %7.2fdeg %7.2f %7.2fdeg %9.0f\n",
+				Name[Est], RMSDeg(E[Est].SumSq[Roll], E[Est].n),
+				RadiansToDegrees(E[Est].Max[Roll]), RMSDeg(E[Est].SumSq[Pitch],
+						E[Est].n), RadiansToDegrees(E[Est].Max[Pitch]),
+				RMSDeg(E[Est].SumSq[Yaw], E[Est].n), RadiansToDegrees(
+						E[Est].Max[Yaw]), (real64) E[Est].nS / Cycles);
+		AttRMS[Est] = fmax(RMSDeg(E[Est].SumSq[Roll], E[Est].n), RMSDeg(
+				E[Est].SumSq[Pitch], E[Est].n));
+		YawRMS[Est] = RMSDeg(E[Est].SumSq[Yaw], E[Est].n);
+	}
+
+	GyroBiasE = AccBiasE = 0.0;
+	for (a = X; a <= Z; a++) {
+		GyroBiasE = fmax(GyroBiasE, fabs(ESKF.GyroBias[a] - GyroBiasT[a]));
+		AccBiasE = fmax(AccBiasE, fabs(ESKF.AccBias[a] - AccBiasT[a]));
+	}
+
+	Est = ErrorStateEKF;
+	printf("  ESKF altitude rms %.2fM (measured %.2fM), ROC rms %.2fM/S\n", sqrt(
+			E[Est].AltSumSq / E[Est].nAlt), sqrt(E[Est].AltRawSumSq
+			/ E[Est].nAltRaw), sqrt(E[Est].ROCSumSq / E[Est].nAlt));
+	printf("  ESKF position rms %.2fM (GPS %.2fM), velocity rms %.2fM/S\n",
+			sqrt(E[Est].PosSumSq / E[Est].nAlt), sqrt(E[Est].PosRawSumSq
+					/ E[Est].nGPS), sqrt(E[Est].VelSumSq / E[Est].nAlt));
+	printf("  ESKF final bias error gyro %.3fdeg/S, acc %.3fM/S^2\n",
+			RadiansToDegrees(GyroBiasE), AccBiasE);
+
+	OK = (AttRMS[ErrorStateEKF] < AttRMS[MadgwickIMU]) && (YawRMS[ErrorStateEKF]
+			< YawRMS[MadgwickIMU]) && (sqrt(E[Est].AltSumSq / E[Est].nAlt)
+			< EST_ALT_SDEV) && (sqrt(E[Est].PosSumSq / E[Est].nAlt)
+			< EST_GPS_POS_SDEV);
+	for (Est = MadgwickAHRS; Est < EstUnknown; Est++)
+		OK &= YawRMS[Est] < EST_YAW_RMS_DEG;
+	e = 0.0;
+	for (Est = MadgwickIMU; Est < EstUnknown; Est++)
+		e = fmax(e, E[Est].AttCacheErr);
+	printf("  Att DCM and gravity against sin/cos, max error %.1e\n", e);
+	OK &= e < EST_ATT_CACHE_ERR;
+	printf("  %s\n", OK ? "ok" : "FAILED");
+
+	return (OK ? 0 : 1);
+} // SITLEstimatorBenchmark
+
@@ -0,0 +1,261 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// MPU6XXX FIFO replay (-f file). A recording holds, for each drain, the time the FIFO
+// count was read, the count and the bytes read. Each is fed through the flight code's
+// drain decision and decimator. If the file does not exist a synthetic recording with a
+// known signal, jittered and stalled drains and an overflow is written first and the
+// decimated samples and time stamps are then checked against that signal.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+typedef struct {
+	char Magic[8];
+	uint32 SampleuS;
+	uint32 Synthetic;
+} FIFOHeaderStruct;
+
+typedef struct {
+	uint64 ReaduS;
+	uint16 Count, Bytes;
+} FIFORecordStruct;
+
+#define SYNTH_CYCLE_US		2000
+#define SYNTH_CYCLES		4000
+#define SYNTH_STALL_CYCLE	500 // 30mS - backlog beyond one drain
+#define SYNTH_OFLOW_CYCLE	1200 // 1.2S - FIFO overflow and reset
+
+static const char FIFOMagic[8] = { 'U', 'A', 'V', 'X', 'F', 'I', 'F', 'O' };
+
+// sample k is taken at k * SampleuS
+
+static void SynthSample(uint32 k, uint32 SampleuS, int16 * v) {
+	real64 t;
+
+	t = (real64) k * SampleuS * 1.0e-6;
+
+	v[0] = (int16) lround(60.0 * sin(2.0 * PI * 3.0 * t));
+	v[1] = (int16) lround(-40.0 * sin(2.0 * PI * 7.0 * t));
+	v[2] = (int16) (MPU_1G + lround(50.0 * sin(2.0 * PI * 5.0 * t)));
+	v[3] = (int16) (-3956 + (k / 100) % 200);
+	v[4] = (int16) lround(800.0 * sin(2.0 * PI * 37.0 * t));
+	v[5] = (int16) lround(300.0 * cos(2.0 * PI * 113.0 * t));
+	v[6] = (int16) lround(400.0 * sin(2.0 * PI * 450.0 * t)); // aliases at the cycle rate
+
+} // SynthSample
+
+static boolean WriteSynthetic(const char * fn) {
+	static uint8 F[MPU_FIFO_BYTES];
+	FIFOHeaderStruct h;
+	FIFORecordStruct r;
+	FILE * f;
+	uint32 Seed, Cycle, NextSample, OldestSample, Queued, SampleuS;
+	uint64 NowuS;
+	int16 v[7], n;
+	idx i, s;
+
+	f = fopen(fn, "wb");
+	if (!f)
+		return (false);
+
+	SampleuS = 1000000 / MPU_FIFO_HZ;
+	memcpy(h.Magic, FIFOMagic, sizeof(h.Magic));
+	h.SampleuS = SampleuS;
+	h.Synthetic = true;
+	fwrite(&h, sizeof(h), 1, f);
+
+	Seed = 4321;
+	NowuS = 0;
+	NextSample = OldestSample = 0;
+
+	for (Cycle = 0; Cycle < SYNTH_CYCLES; Cycle++) {
+		Seed = Seed * 1103515245 + 12345;
+		NowuS += SYNTH_CYCLE_US + (int32) ((Seed >> 16) % 801) - 400;
+		if (Cycle == SYNTH_STALL_CYCLE)
+			NowuS += 30000;
+		else if (Cycle == SYNTH_OFLOW_CYCLE)
+			NowuS += 1200000;
+
+		// FIFO fill - the oldest samples are lost when full
+		while (((uint64) NextSample * SampleuS) <= NowuS) {
+			NextSample++;
+			if ((NextSample - OldestSample) > (MPU_FIFO_BYTES
+					/ MPU_FIFO_SAMPLE_BYTES))
+				OldestSample++;
+		}
+		Queued = NextSample - OldestSample;
+
+		r.ReaduS = NowuS;
+		r.Count = (Queued == (MPU_FIFO_BYTES / MPU_FIFO_SAMPLE_BYTES))
+				? MPU_FIFO_BYTES : Queued * MPU_FIFO_SAMPLE_BYTES; // as read
+		n = MPU6XXXFIFOSamples(r.Count);
+		r.Bytes = (n > 0) ? n * MPU_FIFO_SAMPLE_BYTES : 0;
+
+		for (s = 0; s < n; s++) {
+			SynthSample(OldestSample++, SampleuS, v);
+			for (i = 0; i < 7; i++) {
+				F[s * MPU_FIFO_SAMPLE_BYTES + i * 2] = (uint8) (v[i] >> 8);
+				F[s * MPU_FIFO_SAMPLE_BYTES + i * 2 + 1] = (uint8) v[i];
+			}
+		}
+
+		fwrite(&r, sizeof(r), 1, f);
+		fwrite(F, 1, r.Bytes, f);
+
+		if (n < 0) // reset
+			OldestSample = NextSample;
+	}
+
+	fclose(f);
+
+	return (true);
+} // WriteSynthetic
+
+int SITLFIFOReplay(const char * fn) {
+	static uint8 F[MPU_FIFO_BYTES];
+	FIFOHeaderStruct h;
+	FIFORecordStruct r;
+	FILE * f;
+	boolean Wrote, ok;
+	uint32 Records, Mismatches, k, SamplesRead, Lost, NextSample, AliasN;
+	uint64 LastuS;
+	int32 TimeErruS, MaxTimeErruS, MaxValueErr, e;
+	real64 Sum[7], AliasNewest, AliasDecimated;
+	int16 B[7], v[7], n, MinN, MaxN;
+	idx i, s;
+
+	Wrote = false;
+	f = fopen(fn, "rb");
+	if (!f) {
+		memset(&MPUFIFO, 0, sizeof(MPUFIFO));
+		if (!WriteSynthetic(fn)) {
+			fprintf(stderr, "sitl: unable to write %s\n", fn);
+			return (1);
+		}
+		Wrote = true;
+		f = fopen(fn, "rb");
+	}
+
+	if (!f || (fread(&h, sizeof(h), 1, f) != 1) || memcmp(h.Magic, FIFOMagic,
+			sizeof(FIFOMagic))) {
+		fprintf(stderr, "sitl: %s is not a FIFO recording\n", fn);
+		return (1);
+	}
+
+	memset(&MPUFIFO, 0, sizeof(MPUFIFO));
+	MPUFIFO.SampleuS = h.SampleuS;
+
+	Records = Mismatches = SamplesRead = Lost = AliasN = 0;
+	MaxTimeErruS = MaxValueErr = 0;
+	MinN = MPU_FIFO_MAX_SAMPLES;
+	MaxN = 0;
+	LastuS = 0;
+	NextSample = 0;
+	AliasNewest = AliasDecimated = 0.0;
+	ok = true;
+
+	while (fread(&r, sizeof(r), 1, f) == 1) {
+		if ((r.Bytes > sizeof(F)) || (fread(F, 1, r.Bytes, f) != r.Bytes)) {
+			ok = false;
+			break;
+		}
+		Records++;
+
+		n = MPU6XXXFIFOSamples(r.Count);
+
+		if (n < 0) { // reset drops what was queued
+			if (h.Synthetic) {
+				Lost += (r.ReaduS / h.SampleuS) + 1 - NextSample;
+				NextSample = (r.ReaduS / h.SampleuS) + 1;
+			}
+			continue;
+		}
+		if ((n * MPU_FIFO_SAMPLE_BYTES) != r.Bytes) {
+			Mismatches++;
+			continue;
+		}
+		if (n == 0)
+			continue;
+
+		MPU6XXXFIFODecimate(r.ReaduS, r.Count / MPU_FIFO_SAMPLE_BYTES, F, n, B);
+		SamplesRead += n;
+		MinN = Min(MinN, n);
+		MaxN = Max(MaxN, n);
+
+		ok &= MPUFIFO.LastSampleuS >= LastuS;
+		LastuS = MPUFIFO.LastSampleuS;
+
+		if (h.Synthetic) {
+			// no sample lost - the newest queued is the last taken
+			if ((NextSample + r.Count / MPU_FIFO_SAMPLE_BYTES - 1)
+					!= (r.ReaduS / h.SampleuS))
+				Mismatches++;
+
+			for (i = 0; i < 7; i++)
+				Sum[i] = 0.0;
+			for (s = 0; s < n; s++) {
+				SynthSample(NextSample + s, h.SampleuS, v);
+				for (i = 0; i < 7; i++)
+					Sum[i] += v[i];
+			}
+
+			for (i = 0; i < 7; i++) {
+				e = B[i] - (int32) lround(Sum[i] / n);
+				MaxValueErr = Max(MaxValueErr, Abs(e));
+			}
+
+			TimeErruS = (int32) ((int64) MPUFIFO.LastSampleuS - (int64) ((uint64) (NextSample
+					+ n - 1) * h.SampleuS));
+			MaxTimeErruS = Max(MaxTimeErruS, Abs(TimeErruS));
+
+			k = NextSample + n - 1;
+			SynthSample(k, h.SampleuS, v);
+			AliasNewest += Sqr((real64) v[6]);
+			AliasDecimated += Sqr((real64) B[6]);
+			AliasN++;
+
+			NextSample += n;
+		}
+	}
+
+	fclose(f);
+
+	printf("UAVX SITL MPU6XXX FIFO replay of %s%s\n", fn, Wrote
+			? " (synthetic recording written)" : "");
+	printf("  %u drains, %u samples at %uuS, %d to %d per drain, %u empty, %u resets\n",
+			Records, SamplesRead, h.SampleuS, MinN, MaxN, MPUFIFO.Empty,
+			MPUFIFO.Overflows);
+	printf("  max queued %u samples, count/length mismatches %u, time stamps %s\n",
+			MPUFIFO.MaxQueued, Mismatches, ok ? "monotonic" : "NOT MONOTONIC");
+
+	if (h.Synthetic) {
+		ok &= (Mismatches == 0) && (MaxValueErr <= 1) && (MaxTimeErruS
+				< (int32) h.SampleuS) && (MPUFIFO.Overflows == 1);
+		printf("  samples lost only to the overflow reset: %u\n", Lost);
+		printf("  decimated vs signal max error %d LSB, newest sample time stamp error %duS\n",
+				MaxValueErr, MaxTimeErruS);
+		printf("  450Hz gyro component rms: newest sample %.1f, decimated %.1f\n",
+				sqrt(AliasNewest / AliasN), sqrt(AliasDecimated / AliasN));
+		printf("  %s\n", ok ? "ok" : "FAILED");
+	}
+
+	return (ok ? 0 : 1);
+} // SITLFIFOReplay
@@ -0,0 +1,446 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Filter micro-benchmark (-m). The filters as they were before coefficients were held in
+// the filter objects are kept here, uninlined like the flight versions, so per call cost
+// can be compared on the host and the outputs checked against each other. The three axis
+// banks are checked against three of the scalar filters; build with
+// CONFIG+=-DFILTER_BANK_SCALAR to check the scalar form of the banks. The sliding median
+// is checked against re-selecting the median of a copy of each window with median().
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define BENCH_CALLS		10000000
+#define BENCH_DT		0.002f
+
+typedef struct {
+	real32 c[5];
+	real32 h[64];
+	real32 S;
+	real32 Tau;
+	boolean Primed;
+	uint8 Head, Tail;
+	uint64 SampleuS;
+} LegacyHistStruct;
+
+static __attribute__((noinline)) real32 LegacyLPFilter(LegacyHistStruct * F,
+		const idx Order, real32 v, const real32 CutHz, real32 dT) {
+	idx n;
+
+	if (!F->Primed) {
+		for (n = 1; n <= Order; n++)
+			F->h[n] = v;
+		F->Primed = true;
+		F->Tau = 1.0f / (TWO_PI * CutHz);
+	}
+
+	F->S = dT / (F->Tau + dT);
+
+	F->h[0] = v;
+
+	for (n = 1; n <= Order; n++)
+		F->h[n] += (F->h[n - 1] - F->h[n]) * F->S;
+
+	return (F->h[Order]);
+} // LegacyLPFilter
+
+static __attribute__((noinline)) real32 LegacyLPFilterAt(LegacyHistStruct * F,
+		const idx Order, real32 v, const real32 CutHz, uint64 SampleuS) {
+	real32 dT;
+
+	dT = (F->Primed && (SampleuS > F->SampleuS)) ? (SampleuS - F->SampleuS)
+			* 0.000001f : 0.0f;
+	F->SampleuS = SampleuS;
+
+	return (LegacyLPFilter(F, Order, v, CutHz, dT));
+} // LegacyLPFilterAt
+
+static __attribute__((noinline)) real32 LegacySmoothr32xn(LegacyHistStruct * F,
+		uint8 n, real32 v) {
+	idx i, p;
+
+	if (!F->Primed) {
+		for (i = 0; i < n; i++)
+			F->h[i] = v;
+		F->Head = 0;
+		F->Tail = (n - 1);
+		F->S = v * (real32) n;
+		F->Primed = true;
+	} else {
+		p = F->Head;
+		F->S -= F->h[p];
+		F->Head = (p + 1) & (n - 1);
+		p = F->Tail;
+		p = (p + 1) & (n - 1);
+		F->h[p] = v;
+		F->Tail = p;
+		F->S += v;
+	}
+
+	return (F->S / (real32) n);
+} // LegacySmoothr32xn
+
+static __attribute__((noinline)) real32 LegacyPavel(LegacyHistStruct * F,
+		real32 v) {
+	const idx N = 6;
+	const real32 C[] = { 0.375f, 0.5f, -0.5f, -0.75, 0.125f, 0.25f };
+	real32 r = 0.0f;
+	idx i;
+
+	if (!F->Primed) {
+		for (i = 0; i < N; i++)
+			F->h[i] = v;
+		F->Primed = true;
+	} else {
+		for (i = N; i > 0; --i)
+			F->h[i] = F->h[i - 1];
+		F->h[0] = v;
+	}
+
+	for (i = 0; i < N; ++i)
+		r += C[i] * F->h[i];
+
+	return (r);
+} // LegacyPavel
+
+static __attribute__((noinline)) real32 LegacyLPFilterBW(LegacyHistStruct * F,
+		real32 v, const real32 CutHz, real32 dT) {
+	real32 r;
+	idx i;
+
+	if (!F->Primed) {
+		real32 wc, k1, k2, k3, a0, a1, a2, b1, b2;
+
+		wc = tan(PI * CutHz * dT);
+		k1 = sqrtf(2.0f) * wc;
+		k2 = Sqr(wc);
+		a0 = k2 / (1.0f + k1 + k2);
+		a1 = 2.0f * a0;
+		a2 = a0;
+		k3 = 2.0f * a0 / k2;
+		b1 = -2.0f * a0 + k3;
+		b2 = 1 - 2.0f * a0 - k3;
+		F->c[0] = a0;
+		F->c[1] = a1;
+		F->c[2] = a2;
+		F->c[3] = b1;
+		F->c[4] = b2;
+		for (i = 0; i < 5; i++)
+			F->h[i] = v;
+		F->Primed = true;
+	}
+
+	for (i = 4; i > 0; i--)
+		F->h[i] = F->h[i - 1];
+	F->h[0] = v;
+
+	r = 0.0f;
+	for (i = 0; i < 5; i++)
+		r += F->h[i] * F->c[i];
+
+	return (r);
+} // LegacyLPFilterBW
+
+static real32 BenchInput(uint32 i) {
+	return (sinf(i * 0.01f) + 0.1f * ((i * 2654435761u) >> 24) * (1.0f / 256.0f));
+} // BenchInput
+
+static real32 In[4096];
+
+#define BENCH(Label, Expr) { \
+	StartnS = SITLHostnS(); \
+	for (i = 0; i < BENCH_CALLS; i++) \
+		Sink += (Expr); \
+	nS[Label] = (real64) (SITLHostnS() - StartnS) / BENCH_CALLS; \
+}
+
+enum {
+	OldLP1, NewLP1, OldLP3, NewLP3, OldLPAt, NewLPAt, OldMA, NewMA, OldPavel,
+	NewPavel, OldBW, NewBW, AxesLP, BankLP, AxesBQ, BankBQ, BenchCases
+};
+
+static LPFilterStruct AxisLP[3];
+static LPFilterBankStruct LPBank;
+static BiquadStruct AxisBQ[3];
+static BiquadBankStruct BQBank;
+
+static real32 AxesLPFilter(uint32 i) {
+	idx a;
+
+	for (a = X; a <= Z; a++)
+		LPFilterAt(&AxisLP[a], In[(i + a * 1000) & 4095], i * 2000ull + (i & 3));
+
+	return (AxisLP[X].h[2]);
+} // AxesLPFilter
+
+static real32 BankLPFilter(uint32 i) {
+	real32 v[3];
+	idx a;
+
+	for (a = X; a <= Z; a++)
+		v[a] = In[(i + a * 1000) & 4095];
+	LPFilterBankAt(&LPBank, v, i * 2000ull + (i & 3));
+
+	return (v[X]);
+} // BankLPFilter
+
+static real32 AxesBiquad(uint32 i) {
+	idx a;
+
+	for (a = X; a <= Z; a++)
+		Biquad(&AxisBQ[a], In[(i + a * 1000) & 4095]);
+
+	return (AxisBQ[X].y1);
+} // AxesBiquad
+
+static real32 BankBiquad(uint32 i) {
+	real32 v[3];
+	idx a;
+
+	for (a = X; a <= Z; a++)
+		v[a] = In[(i + a * 1000) & 4095];
+	BiquadBank(&BQBank, v);
+
+	return (v[X]);
+} // BankBiquad
+
+// Sliding median against re-selection over the same windows. The input is quantised, as
+// from an ADC, so there are ties, with spikes of both signs.
+
+#define MEDIAN_CALLS	1000000
+
+static real32 MedianInput(uint32 i) {
+	real32 v;
+
+	v = floorf(In[i & 4095] * 64.0f) * (1.0f / 64.0f);
+	if ((i % 37) == 0)
+		v += 50.0f;
+	else if ((i % 53) == 0)
+		v -= 50.0f;
+
+	return (v);
+} // MedianInput
+
+static real32 LegacyMedian(real32 W[], idx N, uint32 i) {
+	real32 a[MEDIAN_MAX_LEN];
+
+	W[i % N] = MedianInput(i);
+	memcpy(a, W, sizeof(real32) * Min(i + 1, N));
+
+	return (median(a, Min(i + 1, N)));
+} // LegacyMedian
+
+static boolean MedianBench(void) {
+	static volatile real32 Sink = 0.0f;
+	const idx Len[] = { 5, 15, 31, 63 };
+	MedianFilterStruct M;
+	real32 W[MEDIAN_MAX_LEN];
+	real64 OldnS, NewnS;
+	uint64 StartnS;
+	uint32 i, Errors;
+	idx l, N;
+	boolean OK;
+
+	OK = true;
+	printf("  sliding median, host nS/sample re-selection -> heaps, mismatches\n");
+	for (l = 0; l < 4; l++) {
+		N = Len[l];
+
+		InitMedianFilter(&M, N);
+		Errors = 0;
+		for (i = 0; i < 100000; i++)
+			if (MedianFilter(&M, MedianInput(i)) != LegacyMedian(W, N, i))
+				Errors++;
+
+		StartnS = SITLHostnS();
+		for (i = 0; i < MEDIAN_CALLS; i++)
+			Sink += LegacyMedian(W, N, i);
+		OldnS = (real64) (SITLHostnS() - StartnS) / MEDIAN_CALLS;
+
+		InitMedianFilter(&M, N);
+		StartnS = SITLHostnS();
+		for (i = 0; i < MEDIAN_CALLS; i++)
+			Sink += MedianFilter(&M, MedianInput(i));
+		NewnS = (real64) (SITLHostnS() - StartnS) / MEDIAN_CALLS;
+
+		printf("  window %2d          %6.2f -> %6.2f  %u\n", N, OldnS, NewnS, Errors);
+		OK &= Errors == 0;
+	}
+
+	return (OK);
+} // MedianBench
+
+static void InitBanks(void) {
+	idx a;
+
+	InitLPFilterBank(&LPBank, 2, 100.0f, BENCH_DT);
+	InitBiquadBank(&BQBank);
+	for (a = X; a <= Z; a++) {
+		InitLPFilter(&AxisLP[a], 2, 100.0f, BENCH_DT);
+		SetNotch(&AxisBQ[a], 80.0f + 40.0f * a, 3.0f, BENCH_DT);
+		InitBiquad(&AxisBQ[a], In[a * 1000]);
+		SetBiquadBankLane(&BQBank, a, &AxisBQ[a]);
+		PrimeBiquadBankLane(&BQBank, a, In[a * 1000]);
+	}
+
+} // InitBanks
+
+int SITLFilterBenchmark(void) {
+	static volatile real32 Sink = 0.0f;
+	LegacyHistStruct Old;
+	LPFilterStruct LP;
+	MAFilterStruct MA;
+	PavelStruct PD;
+	BiquadStruct BW;
+	real64 nS[BenchCases];
+	real32 e, MaxE[6], v;
+	uint64 StartnS;
+	uint32 i;
+	idx a;
+	boolean OK;
+
+	for (i = 0; i < 4096; i++)
+		In[i] = BenchInput(i);
+
+	for (i = 0; i < 6; i++)
+		MaxE[i] = 0.0f;
+
+	// outputs
+
+	memset(&Old, 0, sizeof(Old));
+	InitLPFilter(&LP, 3, 20.0f, BENCH_DT);
+	for (i = 0; i < 100000; i++) {
+		v = In[i & 4095];
+		e = fabsf(LegacyLPFilter(&Old, 3, v, 20.0f, BENCH_DT) - LPFilter(&LP, v));
+		MaxE[0] = Max(MaxE[0], e);
+	}
+
+	memset(&Old, 0, sizeof(Old));
+	InitLPFilter(&LP, 2, 100.0f, BENCH_DT);
+	for (i = 0; i < 100000; i++) {
+		v = In[i & 4095];
+		e = fabsf(LegacyLPFilterAt(&Old, 2, v, 100.0f, 1000000 + i * 2000
+				+ (i % 7)) - LPFilterAt(&LP, v, 1000000 + i * 2000 + (i % 7)));
+		MaxE[1] = Max(MaxE[1], e);
+	}
+
+	memset(&Old, 0, sizeof(Old));
+	InitMAFilter(&MA, 16);
+	for (i = 0; i < 100000; i++) {
+		v = In[i & 4095];
+		e = fabsf(LegacySmoothr32xn(&Old, 16, v) - MAFilter(&MA, v));
+		MaxE[2] = Max(MaxE[2], e);
+	}
+
+	memset(&Old, 0, sizeof(Old));
+	PD.Primed = false;
+	for (i = 0; i < 100000; i++) {
+		v = In[i & 4095];
+		e = fabsf(LegacyPavel(&Old, v) - PavelDifferentiator(&PD, v));
+		MaxE[3] = Max(MaxE[3], e);
+	}
+
+	InitBanks();
+	for (i = 0; i < 100000; i++) {
+		AxesLPFilter(i);
+		AxesBiquad(i);
+		BankLPFilter(i);
+		BankBiquad(i);
+		for (a = X; a <= Z; a++) { // each lane against its axis
+			e = fabsf(LPBank.h[2][a] - AxisLP[a].h[2]);
+			MaxE[4] = Max(MaxE[4], e);
+			e = fabsf(BQBank.y1[a] - AxisBQ[a].y1);
+			MaxE[5] = Max(MaxE[5], e);
+		}
+	}
+
+	// cost
+
+	memset(&Old, 0, sizeof(Old));
+	BENCH(OldLP1, LegacyLPFilter(&Old, 1, In[i & 4095], 20.0f, BENCH_DT));
+	InitLPFilter(&LP, 1, 20.0f, BENCH_DT);
+	BENCH(NewLP1, LPFilter(&LP, In[i & 4095]));
+
+	memset(&Old, 0, sizeof(Old));
+	BENCH(OldLP3, LegacyLPFilter(&Old, 3, In[i & 4095], 20.0f, BENCH_DT));
+	InitLPFilter(&LP, 3, 20.0f, BENCH_DT);
+	BENCH(NewLP3, LPFilter(&LP, In[i & 4095]));
+
+	memset(&Old, 0, sizeof(Old));
+	BENCH(OldLPAt, LegacyLPFilterAt(&Old, 2, In[i & 4095], 100.0f, i * 2000ull
+			+ (i & 3)));
+	InitLPFilter(&LP, 2, 100.0f, BENCH_DT);
+	BENCH(NewLPAt, LPFilterAt(&LP, In[i & 4095], i * 2000ull + (i & 3)));
+
+	memset(&Old, 0, sizeof(Old));
+	BENCH(OldMA, LegacySmoothr32xn(&Old, 16, In[i & 4095]));
+	InitMAFilter(&MA, 16);
+	BENCH(NewMA, MAFilter(&MA, In[i & 4095]));
+
+	memset(&Old, 0, sizeof(Old));
+	BENCH(OldPavel, LegacyPavel(&Old, In[i & 4095]));
+	PD.Primed = false;
+	BENCH(NewPavel, PavelDifferentiator(&PD, In[i & 4095]));
+
+	memset(&Old, 0, sizeof(Old));
+	BENCH(OldBW, LegacyLPFilterBW(&Old, In[i & 4095], 20.0f, BENCH_DT));
+	SetButterworth(&BW, 20.0f, BENCH_DT);
+	InitBiquad(&BW, In[0]);
+	BENCH(NewBW, Biquad(&BW, In[i & 4095]));
+
+	InitBanks();
+	BENCH(AxesLP, AxesLPFilter(i));
+	BENCH(BankLP, BankLPFilter(i));
+	BENCH(AxesBQ, AxesBiquad(i));
+	BENCH(BankBQ, BankBiquad(i));
+
+	OK = (MaxE[4] < 1.0e-6f) && (MaxE[5] < 1.0e-5f) && (MaxE[0] < 1.0e-5f) && (MaxE[1] < 1.0e-3f) && (MaxE[2] < 1.0e-4f)
+			&& (MaxE[3] < 1.0e-5f);
+
+	printf("UAVX SITL filter micro-benchmark, host nS/call old -> new, max output difference\n");
+	printf("  LP order 1         %6.2f -> %6.2f\n", nS[OldLP1], nS[NewLP1]);
+	printf("  LP order 3         %6.2f -> %6.2f  %.1e\n", nS[OldLP3], nS[NewLP3],
+			MaxE[0]);
+	printf("  LP at capture time %6.2f -> %6.2f  %.1e (jittered intervals)\n",
+			nS[OldLPAt], nS[NewLPAt], MaxE[1]);
+	printf("  moving average 16  %6.2f -> %6.2f  %.1e\n", nS[OldMA], nS[NewMA],
+			MaxE[2]);
+	printf("  Pavel              %6.2f -> %6.2f  %.1e\n", nS[OldPavel],
+			nS[NewPavel], MaxE[3]);
+	printf("  Butterworth        %6.2f -> %6.2f  (old was FIR only)\n", nS[OldBW],
+			nS[NewBW]);
+	printf("  3 axis banks (%s), host nS/call 3 scalar -> bank, max lane difference\n",
+#if (defined(__SSE__) || defined(__ARM_NEON)) && !defined(FILTER_BANK_SCALAR)
+			"vectors"
+#else
+			"scalar"
+#endif
+	);
+	printf("  LP order 2 at time %6.2f -> %6.2f  %.1e\n", nS[AxesLP], nS[BankLP],
+			MaxE[4]);
+	printf("  notch biquad       %6.2f -> %6.2f  %.1e\n", nS[AxesBQ], nS[BankBQ],
+			MaxE[5]);
+	OK &= MedianBench();
+	printf("  %s\n", OK ? "ok" : "FAILED");
+
+	return (OK ? 0 : 1);
+} // SITLFilterBenchmark
+
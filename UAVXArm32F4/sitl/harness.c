@@ -0,0 +1,238 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL stand-in for boards/harness.c. GPIO works on the RAM backed port registers with
+// inputs driven by the SITL pilot. Peripheral setup is reduced to the register state
+// the flight code and the SITL dispatcher look at.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+boolean digitalRead(PinDef * d) {
+	return ((d->Port->IDR & d->Pin) != 0);
+} // digitalRead
+
+void digitalWrite(PinDef * d, uint8 m) {
+
+	if (m)
+		d->Port->ODR |= d->Pin;
+	else
+		d->Port->ODR &= ~d->Pin;
+
+	if (d == &GPIOPins[ProbeSel])
+		SITLProbe(m);
+
+} // digitalWrite
+
+void digitalToggle(PinDef * d) {
+	d->Port->ODR ^= d->Pin;
+} // digitalToggle
+
+void pinInit(PinDef * d) {
+
+	if ((d->Mode == GPIO_Mode_IN) && (d->PuPd == GPIO_PuPd_UP))
+		d->Port->IDR |= d->Pin;
+
+} // pinInit
+
+void pinInitMode(PinDef * d, boolean IsInput) {
+
+	if (IsInput)
+		d->Port->IDR |= d->Pin;
+
+} // pinInitMode
+
+void pinInitOutput(PinDef * d) {
+} // pinInitOutput
+
+void NVICDisable(IRQn_Type ISR) {
+} // NVICDisable
+
+TIM_ICInitTypeDef TIM_ICInitStructure = { 0, }; // global for rc
+
+void InitRCPins(uint8 PPMInputs) {
+	uint8 i;
+
+	for (i = 0; i < PPMInputs; i++) {
+		pinInit(&RCPins[i]);
+		TIM_ITConfig(RCPins[i].Timer.Tim, RCPins[i].Timer.CC, ENABLE);
+	}
+	for (i = 0; i < PPMInputs; i++)
+		TIM_Cmd(RCPins[i].Timer.Tim, ENABLE);
+
+} // InitRCPins
+
+void i2cInit(uint8 i2cCurr) {
+
+	i2cState[i2cCurr].busy = false;
+
+} // i2cInit
+
+void i2cUnstick(uint8 i2cCurr) {
+} // i2cUnstick
+
+void spiInitGPIOPins(uint8 spiPort, boolean highClock) {
+} // spiInitGPIOPins
+
+void spiInit(uint8 spiPort) {
+} // spiInit
+
+void spiDeInit(uint8 spiPort) {
+} // spiDeInit
+
+void InitPWMPin(PinDef * u, uint16 pwmprescaler, uint32 pwmperiod,
+		uint32 pwmwidth, boolean usingSync) {
+
+	pinInit(u);
+
+	if (u->TimerUsed) {
+		*u->Timer.CCR = pwmwidth;
+		u->Timer.Tim->ARR = pwmperiod - 1;
+		TIM_Cmd(u->Timer.Tim, ENABLE);
+	}
+
+} // InitPWMPin
+
+void serialBaudRate(uint8 s, uint32 BaudRate) {
+
+	switch (s) {
+	case SoftSerialTx:
+		SoftUSARTBaudRate = BaudRate;
+		break;
+	case USBSerial:
+		break;
+	default:
+		SerialPorts[s].Baud = BaudRate;
+		break;
+	} // switch
+
+} // serialBaudRate
+
+void InitSerialPort(uint8 s, boolean Enable) {
+	SerialPortDef * u;
+
+	u = &SerialPorts[s];
+
+	TxQTail[s] = TxQHead[s] = TxQNewHead[s] = 0;
+	ringInit(&RxRing[s], (void *) RxQ[s], SERIAL_BUFFER_SIZE, 1);
+
+	u->USART->SR = USART_FLAG_TXE | USART_FLAG_TC;
+	USART_ITConfig(u->USART, USART_IT_RXNE, ENABLE);
+
+	RxEnabled[s] = Enable;
+	USART_Cmd(u->USART, ENABLE);
+
+} // InitSerialPort
+
+void serialInitSBus(uint8 s, boolean Enable) {
+
+	InitSerialPort(s, Enable);
+
+} // serialInitSBus
+
+void InitAnalogPorts(void) {
+	// emulation mocks the battery and there are no analog gyros
+} // InitAnalogPorts
+
+void InitSensorInterrupts(void) {
+} // InitSensorInterrupts
+
+void InitRCComboPort(void) {
+	uint8 CurrNoOfRCPins;
+
+	switch (CurrComboPort1Config) {
+	case CPPM_GPS_M7to10:
+		CurrMaxPWMOutputs = 6 + 4;
+		CurrNoOfRCPins = 1;
+		GPSTxSerial = GPSRxSerial = RCSerial;
+		InitSerialPort(GPSRxSerial, false);
+		RxUsingSerial = false;
+		break;
+	case ParallelPPM:
+		CurrMaxPWMOutputs = 6;
+		CurrNoOfRCPins = MAX_RC_INPS;
+		RxUsingSerial = false;
+		GPSRxSerial = TelemetrySerial;
+		GPSTxSerial = SoftSerialTx;
+		break;
+	default:
+		CurrMaxPWMOutputs = 6 + 4;
+		CurrNoOfRCPins = 0;
+		RxUsingSerial = true;
+		GPSRxSerial = TelemetrySerial;
+		GPSTxSerial = SoftSerialTx;
+
+		if (CurrComboPort1Config == FutabaSBus_M7to10)
+			serialInitSBus(RCSerial, false);
+		else
+			InitSerialPort(RCSerial, false); // Spektrum
+		break;
+	} // switch
+
+	if (UsingDCMotors)
+		CurrMaxPWMOutputs = 4;
+
+	InitRCPins(CurrNoOfRCPins);
+
+} // InitRCComboPort
+
+void InitHarness(void) {
+	uint8 i;
+
+	for (i = 0; i < MAX_PWM_OUTPUTS; i++) { // switch off all (potential) motor output pins
+		pinInitOutput(&PWMPins[i]);
+		digitalWrite(&PWMPins[i], 0);
+	}
+
+	for (i = 0; i < MAX_LEDS; i++) {
+		pinInit(&LEDPins[i]);
+		digitalWrite(&LEDPins[i], 1);
+	}
+
+	for (i = 0; i < MAX_GPIO_PINS; i++)
+		pinInit(&GPIOPins[i]);
+	BeeperOff();
+
+	for (i = 0; i < MAX_I2C_PORTS; i++)
+		i2cInit(i);
+
+	Delay1mS(10);
+
+	InitSerialPort(TelemetrySerial, true);
+
+	digitalWrite(&GPIOPins[Aux2Sel], 1); // soft USART Tx
+
+	for (i = 0; i < MAX_SPI_DEVICES; i++) // deselect all
+		if (SPISelectPins[i].Port) {
+			pinInit(&SPISelectPins[i]);
+			digitalWrite(&SPISelectPins[i], 1);
+		}
+
+	for (i = 0; i < MAX_SPI_PORTS; i++)
+		spiInit(i);
+
+#if defined(USE_SPI_DMA)
+	spiInitDMA(spiMap[mpu60xxSel] - 1);
+#endif
+
+	InitAnalogPorts();
+
+} // InitHarness
+
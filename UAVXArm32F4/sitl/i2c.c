@@ -0,0 +1,355 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL stand-in for i2c.c. The target driver is a state machine run from the I2C event
+// interrupts which the sitl does not model. Queued transactions go to the device models
+// in sensors.c when their bus time at I2C_CLOCK_HZ has elapsed and complete from the
+// dispatcher as if from the event ISR. Devices that are not modelled NACK and count as
+// errors as on the target. Stalls may be injected to exercise the timeout.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+volatile i2cStateDef i2cState[MAX_I2C_PORTS] = { { 0 } };
+i2cStatsStruct i2cStats[MAX_I2C_PORTS];
+SITLI2CStruct SITLI2C;
+
+static i2cTransStruct i2cQ[MAX_I2C_PORTS][I2C_QUEUE_LEN];
+static volatile uint8 i2cQHead[MAX_I2C_PORTS], i2cQTail[MAX_I2C_PORTS];
+static uint64 i2cDoneuS[MAX_I2C_PORTS];
+
+void i2c_er_handler(uint8 i2cCurr) {
+} // i2c_er_handler
+
+void i2c_ev_handler(uint8 i2cCurr) {
+} // i2c_ev_handler
+
+static void i2cStart(idx i2cCurr) {
+	i2cTransStruct * t;
+
+	t = &i2cQ[i2cCurr][i2cQHead[i2cCurr] & (I2C_QUEUE_LEN - 1)];
+
+	i2cState[i2cCurr].addr = t->id;
+	i2cState[i2cCurr].bytes = t->len;
+	i2cState[i2cCurr].StartuS = (uint32) SITLuS;
+	i2cState[i2cCurr].busy = true;
+
+	if (SITLI2C.InjectStalls > 0) {
+		SITLI2C.InjectStalls--;
+		i2cDoneuS[i2cCurr] = ~0ULL;
+	} else // start, address, sub-address, data and stop with 9 clocks per byte
+		i2cDoneuS[i2cCurr] = SITLuS + (uint64) ((t->len + 3) * 9
+				* SITL_I2C_BIT_US) + 1;
+
+} // i2cStart
+
+static void i2cFinish(idx i2cCurr, boolean ok) {
+	i2cTransStruct * t;
+
+	t = &i2cQ[i2cCurr][i2cQHead[i2cCurr] & (I2C_QUEUE_LEN - 1)];
+
+	if (ok)
+		i2cStats[i2cCurr].Completed++;
+	else {
+		i2cState[i2cCurr].i2cErrors++;
+		setStat(I2CFailS, i2cState[i2cCurr].i2cErrors);
+	}
+
+	i2cState[i2cCurr].ok = ok;
+	i2cState[i2cCurr].busy = false;
+	i2cQHead[i2cCurr]++;
+
+	if (t->Done)
+		t->Done(ok);
+
+	if (i2cQHead[i2cCurr] != i2cQTail[i2cCurr])
+		i2cStart(i2cCurr);
+
+} // i2cFinish
+
+void SITLUpdateI2C(void) {
+	i2cTransStruct * t;
+	boolean ok;
+	idx i2cCurr;
+
+	for (i2cCurr = 0; i2cCurr < MAX_I2C_PORTS; i2cCurr++)
+		while (i2cState[i2cCurr].busy && (SITLuS >= i2cDoneuS[i2cCurr])) {
+			t = &i2cQ[i2cCurr][i2cQHead[i2cCurr] & (I2C_QUEUE_LEN - 1)];
+			ok = t->Read ? SITLI2CRead(t->id, t->reg, t->len, t->data)
+					: SITLI2CWrite(t->id, t->reg, t->len, t->data);
+			SITLI2C.Transfers++;
+			if (!ok)
+				i2cStats[i2cCurr].Errors++;
+			i2cFinish(i2cCurr, ok);
+		}
+
+} // SITLUpdateI2C
+
+void i2cCheckTimeout(uint8 i2cSel) {
+	idx i2cCurr;
+
+	i2cCurr = i2cMap[i2cSel] - 1;
+
+	if (i2cState[i2cCurr].busy && ((uSClock() - i2cState[i2cCurr].StartuS)
+			> I2C_TIMEOUT_US(i2cState[i2cCurr].bytes))) {
+		SITLInISR = true; // hold off completions as __disable_irq
+		if (i2cState[i2cCurr].busy) {
+			i2cStats[i2cCurr].Timeouts++;
+			i2cFinish(i2cCurr, false);
+		}
+		SITLInISR = false;
+	}
+
+} // i2cCheckTimeout
+
+static boolean i2cQueue(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		boolean Read, uint8 * data, i2cDoneFn Done) {
+	i2cTransStruct * t;
+	uint8 Entries;
+	idx i2cCurr;
+
+	i2cCurr = i2cMap[i2cSel] - 1;
+
+	if (len > 127)
+		return (false);
+
+	if ((uint8) (i2cQTail[i2cCurr] - i2cQHead[i2cCurr]) >= I2C_QUEUE_LEN) {
+		i2cStats[i2cCurr].Overflows++;
+		return (false);
+	}
+
+	t = &i2cQ[i2cCurr][i2cQTail[i2cCurr] & (I2C_QUEUE_LEN - 1)];
+	t->id = id;
+	t->reg = reg;
+	t->len = len;
+	t->Read = Read;
+	t->data = data;
+	t->Done = Done;
+
+	i2cQTail[i2cCurr]++;
+	Entries = i2cQTail[i2cCurr] - i2cQHead[i2cCurr];
+	if (!i2cState[i2cCurr].busy)
+		i2cStart(i2cCurr);
+
+	i2cStats[i2cCurr].Queued++;
+	if (Entries > i2cStats[i2cCurr].MaxQueue)
+		i2cStats[i2cCurr].MaxQueue = Entries;
+
+	return (true);
+} // i2cQueue
+
+boolean i2cQueueRead(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, i2cDoneFn Done) {
+	return (i2cQueue(i2cSel, id, reg, len, true, data, Done));
+} // i2cQueueRead
+
+boolean i2cQueueWrite(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, i2cDoneFn Done) {
+	return (i2cQueue(i2cSel, id, reg, len, false, data, Done));
+} // i2cQueueWrite
+
+boolean i2cIdle(uint8 i2cSel) {
+	idx i2cCurr;
+
+	i2cCurr = i2cMap[i2cSel] - 1;
+
+	return (i2cQHead[i2cCurr] == i2cQTail[i2cCurr]);
+} // i2cIdle
+
+// Skips to the end of the transfer in progress rather than spinning clock reads
+
+void i2cWaitIdle(uint8 i2cSel) {
+	idx i2cCurr;
+
+	i2cCurr = i2cMap[i2cSel] - 1;
+
+	while (!i2cIdle(i2cSel)) {
+		if (i2cState[i2cCurr].busy && (i2cDoneuS[i2cCurr] != ~0ULL)
+				&& (i2cDoneuS[i2cCurr] > SITLuS))
+			SITLAdvance((uint32) (i2cDoneuS[i2cCurr] - SITLuS));
+		i2cCheckTimeout(i2cSel);
+	}
+
+} // i2cWaitIdle
+
+static boolean i2cTransfer(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		boolean Read, uint8 * data) {
+
+	i2cWaitIdle(i2cSel);
+	if (!i2cQueue(i2cSel, id, reg, len, Read, data, 0))
+		return (false);
+	i2cWaitIdle(i2cSel);
+
+	return (i2cState[i2cMap[i2cSel] - 1].ok);
+} // i2cTransfer
+
+boolean i2cReadBlock(uint8 i2cSel, uint8 id, uint8 reg, uint8 len, uint8* buf) {
+	return (i2cTransfer(i2cSel, id, reg, len, true, buf));
+} // i2cReadBlock
+
+boolean i2cWriteBlock(uint8 i2cSel, uint8 id, uint8 reg, uint8 len_,
+		uint8 *data) {
+	return (i2cTransfer(i2cSel, id, reg, len_, false, data));
+} // i2cWriteBlock
+
+boolean i2cResponse(uint8 i2cSel, uint8 d) {
+	uint8 v;
+
+	v = 77;
+	return (i2cReadBlock(i2cSel, d, 0, 1, &v) && (v != 77));
+
+} // i2cResponse
+
+//______________________________________________________________________________________________
+
+// Transaction queue test - the baro read and conversion start pair, an EEPROM page, a NACK
+// and a stall on the shared I2C2 bus
+
+static uint8 DoneOrder[I2C_QUEUE_LEN + 2], DoneN;
+static boolean DoneOK[I2C_QUEUE_LEN + 2];
+
+#define DONE_FN(n) static void Done##n(boolean ok) { \
+	DoneOK[DoneN] = ok; DoneOrder[DoneN++] = n; }
+
+DONE_FN(0)
+DONE_FN(1)
+DONE_FN(2)
+DONE_FN(3)
+DONE_FN(4)
+DONE_FN(5)
+DONE_FN(6)
+DONE_FN(7)
+DONE_FN(8)
+
+static const i2cDoneFn DoneFn[I2C_QUEUE_LEN + 1] = { Done0, Done1, Done2, Done3,
+		Done4, Done5, Done6, Done7, Done8 };
+
+static uint32 Failures;
+
+static void Check(boolean ok, const char * s) {
+
+	printf("  %-56s %s\n", s, ok ? "ok" : "FAILED");
+	if (!ok)
+		Failures++;
+
+} // Check
+
+int SITLI2CTest(void) {
+	uint8 B[I2C_QUEUE_LEN][8], P[2], W[I2C_QUEUE_LEN][6];
+	uint64 StartuS;
+	uint32 BusuS, StalluS, Errors;
+	i2cStatsStruct * s;
+	boolean ok;
+	idx i, j;
+
+	SITLInitClock(0);
+	SITLStopuS = ~0ULL;
+	SITLInitSensors();
+
+	s = &i2cStats[i2cMap[SIOBaro] - 1];
+
+	printf("UAVX SITL I2C transactions, I2C2 at %ukHz\n", I2C_CLOCK_HZ / 1000);
+
+	// baro ADC read then conversion start
+
+	DoneN = 0;
+	StartuS = SITLuS;
+	ok = i2cQueueRead(SIOBaro, MS56XX_ID, 0, 3, B[0], DoneFn[0]);
+	ok &= i2cQueueWrite(SIOBaro, MS56XX_ID, 0x40, 0, 0, DoneFn[1]);
+	Check(ok && (DoneN == 0) && !i2cIdle(SIOBaro),
+			"read and start queued, return before completion");
+	while (DoneN < 2)
+		SITLAdvance(1);
+	BusuS = (uint32) (SITLuS - StartuS);
+	Check(DoneOK[0] && DoneOK[1] && (DoneOrder[0] == 0) && (DoneOrder[1] == 1)
+			&& i2cIdle(SIOBaro), "callbacks in queue order");
+
+	i2cReadBlock(SIOBaro, MS56XX_ID, 0xa2, 2, P);
+	DoneN = 0;
+	i2cQueueRead(SIOBaro, MS56XX_ID, 0xa2, 2, B[0], DoneFn[0]);
+	i2cWaitIdle(SIOBaro);
+	Check((DoneN == 1) && DoneOK[0] && !memcmp(B[0], P, 2),
+			"queued read matches blocking read");
+
+	// EEPROM writes then read back, and overflow
+
+	DoneN = 0;
+	for (i = 0; i < I2C_QUEUE_LEN; i++) {
+		W[i][0] = 0x12;
+		W[i][1] = i * 4;
+		for (j = 2; j < 6; j++)
+			W[i][j] = 0x50 + i * 4 + j;
+		i2cQueueWrite(memSel, EEPROM_ID, 0xff, 6, W[i], DoneFn[i]);
+	}
+	ok = !i2cQueueWrite(memSel, EEPROM_ID, 0xff, 6, W[0],
+			DoneFn[I2C_QUEUE_LEN]);
+	Check(ok && (s->Overflows == 1) && (s->MaxQueue == I2C_QUEUE_LEN),
+			"full queue rejects and counts overflow");
+	i2cWaitIdle(memSel);
+
+	W[0][1] = 0;
+	i2cWriteBlock(memSel, EEPROM_ID, 0xff, 2, W[0]);
+	i2cReadBlock(memSel, EEPROM_ID, 0xff, 4, B[0]);
+	i2cReadBlock(memSel, EEPROM_ID, 0xff, 4, B[1]);
+	Check((DoneN == I2C_QUEUE_LEN) && (B[0][0] == 0x52) && (B[1][3]
+			== 0x59), "writes landed");
+
+	// NACK fails its callback only
+
+	DoneN = 0;
+	Errors = s->Errors;
+	i2cQueueRead(SIOBaro, 0x10, 0, 2, B[0], DoneFn[0]);
+	i2cQueueRead(SIOBaro, MS56XX_ID, 0, 3, B[1], DoneFn[1]);
+	i2cWaitIdle(SIOBaro);
+	Check((DoneN == 2) && !DoneOK[0] && DoneOK[1] && (s->Errors == Errors + 1),
+			"NACK fails its callback only");
+
+	// stalled transfer times out
+
+	DoneN = 0;
+	SITLI2C.InjectStalls = 1;
+	StartuS = SITLuS;
+	i2cQueueRead(SIOBaro, MS56XX_ID, 0, 3, B[0], DoneFn[0]);
+	i2cQueueRead(SIOBaro, MS56XX_ID, 0, 3, B[1], DoneFn[1]);
+	i2cWaitIdle(SIOBaro);
+	StalluS = (uint32) (SITLuS - StartuS);
+	Check((DoneN == 2) && !DoneOK[0] && DoneOK[1] && (s->Timeouts == 1)
+			&& (StalluS > I2C_TIMEOUT_US(3)) && (StalluS < 2
+			* I2C_TIMEOUT_US(3)), "stall times out and the queue moves on");
+
+	// blocking transfers wait for the queue
+
+	DoneN = 0;
+	i2cQueueRead(SIOBaro, MS56XX_ID, 0, 3, B[0], DoneFn[0]);
+	ok = i2cReadBlock(SIOBaro, MS56XX_ID, 0xa4, 2, B[1]);
+	Check(ok && (DoneN == 1) && DoneOK[0], "blocking read waits for queue");
+	Check(i2cState[i2cMap[SIOBaro] - 1].i2cErrors == s->Errors + s->Timeouts,
+			"errors and timeouts counted as I2C failures");
+
+	printf("  baro read and start: bus %uuS, main loop blocked none (was the bus time)\n",
+			BusuS);
+	printf("  stall: abandoned after %uuS (I2C_TIMEOUT_US(3) %uuS)\n", StalluS,
+			I2C_TIMEOUT_US(3));
+	printf("  queued %u completed %u errors %u timeouts %u overflows %u high water %u\n",
+			s->Queued, s->Completed, s->Errors, s->Timeouts, s->Overflows,
+			s->MaxQueue);
+
+	return (Failures == 0 ? 0 : 1);
+} // SITLI2CTest
@@ -0,0 +1,221 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL stand-in for isr.c. Handlers keep their target names and are called by the
+// SITL dispatcher rather than the NVIC. Faults stop the simulation.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+// Master Clock
+
+volatile uint32 sysTickUptime = 0;
+volatile uint32 sysTickCycleCounter = 0;
+volatile uint64 sysTickuS = 0;
+
+void SysTick_Handler(void) {
+	sysTickCycleCounter += SystemCoreClock / 1000; // one SysTick reload period
+	sysTickuS += 1000;
+	sysTickUptime++;
+} // SysTick_Handler
+
+void NMI_Handler(void) {
+}
+
+static void SITLFault(const char * s) {
+	fprintf(stderr, "sitl: %s at %.6fs\n", s, (SITLuS - SITLStartuS)
+			* 0.000001);
+	exit(2);
+} // SITLFault
+
+void HardFault_Handler(void) {
+	SITLFault("HardFault");
+}
+
+void MemManage_Handler(void) {
+	SITLFault("MemManage");
+}
+
+void BusFault_Handler(void) {
+	SITLFault("BusFault");
+}
+
+void UsageFault_Handler(void) {
+	SITLFault("UsageFault");
+}
+
+void SVC_Handler(void) {
+}
+
+void DebugMon_Handler(void) {
+}
+
+void PendSV_Handler(void) {
+}
+
+//______________________________________________________________________________________________
+
+// RC Timers
+
+void TIM2_IRQHandler(void) {
+
+	if (CurrComboPort1Config == CPPM_GPS_M7to10) {
+		if (TIM_GetITStatus(TIM2, TIM_IT_CC1) == SET)
+			RCSerialISR(TIM_GetCapture1(TIM2));
+		TIM_ClearITPendingBit(TIM2, TIM_IT_CC1);
+	} else if (CurrComboPort1Config == ParallelPPM)
+		RCParallelISR(TIM2);
+
+} // TIM2_IRQHandler
+
+void TIM3_IRQHandler(void) {
+
+	if (CurrComboPort1Config == ParallelPPM)
+		RCParallelISR(TIM3);
+
+} // TIM3_IRQHandler
+
+SITLCPPMStruct SITLCPPM = { 0, 0, 0, { 1000, 1500, 1500, 1500, 1000, 1000,
+		1500, 1000 } };
+
+void SITLUpdateCPPM(void) {
+	static uint16 FrameWidthuS[8];
+	uint32 SyncuS;
+	idx c;
+
+	while (SITLuS >= SITLCPPM.NextEdgeuS) {
+
+		TIM2->CCR1 = (uint16) SITLCPPM.NextEdgeuS; // 1uS timer tick
+		TIM2->SR |= TIM_IT_CC1;
+		if (TIM2->DIER & TIM_IT_CC1)
+			TIM2_IRQHandler();
+		SITLCPPM.Edges++;
+
+		if (SITLCPPM.Ch == 0)
+			memcpy(FrameWidthuS, SITLCPPM.WidthuS, sizeof(FrameWidthuS));
+
+		if (SITLCPPM.Ch < 8)
+			SITLCPPM.NextEdgeuS += FrameWidthuS[SITLCPPM.Ch++];
+		else {
+			SyncuS = 22500;
+			for (c = 0; c < 8; c++)
+				SyncuS -= FrameWidthuS[c];
+			SITLCPPM.NextEdgeuS += SyncuS;
+			SITLCPPM.Ch = 0;
+		}
+	}
+
+} // SITLUpdateCPPM
+
+//______________________________________________________________________________________________
+
+// DMA
+
+void DMA2_Stream2_IRQHandler(void) {
+
+	// Half-Transfer completed
+	if (DMA_GetITStatus(DMA2_Stream2, DMA_IT_HTIF2)) {
+		DMA_ClearITPendingBit(DMA2_Stream2, DMA_IT_HTIF2);
+		wsUpdateBuffer(wsPWMBuffer);
+	}
+
+	// Transfer completed
+	if (DMA_GetITStatus(DMA2_Stream2, DMA_IT_TCIF2)) {
+		DMA_ClearITPendingBit(DMA2_Stream2, DMA_IT_TCIF2);
+		wsUpdateBuffer(wsPWMBuffer + (wsBufferSize >> 1));
+	}
+
+} // DMA2_Stream2_IRQHandler
+
+void DMA1_Stream3_IRQHandler(void) { // SPI2 Rx as on the V4 board
+	spiDMAISR();
+} // DMA1_Stream3_IRQHandler
+
+//______________________________________________________________________________________________
+
+// Serial
+
+void USART1_IRQHandler(void) {
+	serialISR(0);
+} // USART1_IRQHandler
+
+void USART2_IRQHandler(void) {
+	serialISR(1);
+} // USART2_IRQHandler
+
+// TXE is always set as the USART model transmits instantly so a queued transmit
+// drains as soon as its interrupt is enabled and is not masked
+
+void SITLServiceUSART(uint8 s) {
+	USART_TypeDef * u;
+
+	if (s >= MAX_SERIAL_PORTS)
+		return;
+
+	u = SerialPorts[s].USART;
+	u->SR |= USART_FLAG_TXE | USART_FLAG_TC;
+
+	while ((u->CR1 & USART_CR1_TXEIE) && (u->CR1 & USART_CR1_UE))
+		if (s == 0)
+			USART1_IRQHandler();
+		else
+			USART2_IRQHandler();
+
+} // SITLServiceUSART
+
+// A received character raises RXNE and its interrupt is taken at once
+
+void SITLReceiveUSART(uint8 s, uint8 ch) {
+	USART_TypeDef * u;
+
+	if (s >= MAX_SERIAL_PORTS)
+		return;
+
+	u = SerialPorts[s].USART;
+	u->DR = ch;
+	u->SR |= USART_FLAG_RXNE;
+
+	if (s == 0)
+		USART1_IRQHandler();
+	else
+		USART2_IRQHandler();
+
+} // SITLReceiveUSART
+
+//______________________________________________________________________________________________
+
+// I2C - transfers are completed synchronously by the sitl i2c.c
+
+void I2C1_ER_IRQHandler(void) {
+	i2c_er_handler(0);
+}
+
+void I2C1_EV_IRQHandler(void) {
+	i2c_ev_handler(0);
+}
+
+void I2C2_ER_IRQHandler(void) {
+	i2c_er_handler(1);
+}
+
+void I2C2_EV_IRQHandler(void) {
+	i2c_ev_handler(1);
+}
+
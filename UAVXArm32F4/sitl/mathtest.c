@@ -0,0 +1,177 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Fast math test (-a). The fastmath.h functions are swept over their ranges against
+// double precision libm for the bounds given there, the wraps are checked to land in
+// range, and host cost is compared with single precision libm.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define MATH_CALLS		10000000
+#define MATH_TABLE		4096
+
+static real32 In[MATH_TABLE], In2[MATH_TABLE];
+
+#define BENCH(nS, Expr) { \
+	StartnS = SITLHostnS(); \
+	for (i = 0; i < MATH_CALLS; i++) \
+		Sink += (Expr); \
+	nS = (real64) (SITLHostnS() - StartnS) / MATH_CALLS; \
+}
+
+static __attribute__((noinline)) real32 LegacyMakePi(real32 A) {
+	while (A < -DegreesToRadians(180.0f))
+		A += DegreesToRadians(360.0f);
+	while (A >= DegreesToRadians(180.0f))
+		A -= DegreesToRadians(360.0f);
+
+	return (A);
+} // LegacyMakePi
+
+static void Fill(real32 Lo, real32 Hi) {
+	uint32 i;
+
+	for (i = 0; i < MATH_TABLE; i++) {
+		In[i] = Lo + (Hi - Lo) * ((i * 2654435761u) & 0xffff) / 65535.0f;
+		In2[i] = Lo + (Hi - Lo) * ((i * 40503u + 12345u) & 0xffff) / 65535.0f;
+	}
+
+} // Fill
+
+static void Report(const char * Name, real64 Err, real64 Bound, real64 LibnS,
+		real64 FastnS, boolean * OK) {
+
+	printf("  %-12s %9.2e %9.2e   %6.2f -> %6.2f\n", Name, Err, Bound, LibnS,
+			FastnS);
+	*OK &= Err < Bound;
+
+} // Report
+
+int SITLMathTest(void) {
+	static volatile real32 Sink = 0.0f;
+	real64 e, Err, LibnS, FastnS;
+	real32 a, x, y, s, c;
+	uint64 StartnS;
+	uint32 i, RangeErrors;
+	idx j;
+	boolean OK;
+
+	OK = true;
+	printf("UAVX SITL fast math, max error against double libm, host nS/call libm -> fast\n");
+	printf("  %-12s %9s %9s\n", "", "error", "bound");
+
+	// atan2 around circles of several radii
+
+	Err = 0.0;
+	for (i = 0; i < 4000000; i++) {
+		a = (i % 1000000) * (TWO_PI / 1000000.0f) - PI;
+		e = ldexp(1.0, (int) (i / 1000000) * 8 - 12); // 2^-12 .. 2^12
+		y = (real32) (sin(a) * e);
+		x = (real32) (cos(a) * e);
+		e = fabs(FastAtan2(y, x) - atan2((real64) y, (real64) x));
+		Err = fmax(Err, (e > PI) ? fabs(e - 2.0 * M_PI) : e);
+	}
+	Fill(-10.0f, 10.0f);
+	BENCH(LibnS, atan2f(In[i & 4095], In2[i & 4095]));
+	BENCH(FastnS, FastAtan2(In[i & 4095], In2[i & 4095]));
+	Report("atan2", Err, 2.5e-6, LibnS, FastnS, &OK);
+
+	Err = 0.0;
+	for (i = 0; i <= 4000000; i++) {
+		x = i * (2.0f / 4000000.0f) - 1.0f;
+		Err = fmax(Err, fabs(FastAsin(x) - asin((real64) x)));
+	}
+	Err = fmax(Err, fabs(FastAsin(1.0001f) - M_PI_2)); // clamped
+	Fill(-1.0f, 1.0f);
+	BENCH(LibnS, asinf(In[i & 4095]));
+	BENCH(FastnS, FastAsin(In[i & 4095]));
+	Report("asin", Err, 3.0e-7, LibnS, FastnS, &OK);
+
+	Err = 0.0;
+	for (i = 0; i <= 4000000; i++) {
+		a = i * (200.0f / 4000000.0f) - 100.0f;
+		FastSinCos(a, &s, &c);
+		Err = fmax(Err, fabs(s - sin((real64) a)));
+		Err = fmax(Err, fabs(c - cos((real64) a)));
+	}
+	Fill(-PI, PI);
+	BENCH(LibnS, sinf(In[i & 4095]) + cosf(In[i & 4095]));
+	BENCH(FastnS, (FastSinCos(In[i & 4095], &s, &c), s + c));
+	Report("sin and cos", Err, 2.5e-7, LibnS, FastnS, &OK);
+
+	Err = 0.0;
+	for (i = 0; i <= 4000000; i++) {
+		x = (real32) pow(10.0, i * (12.0 / 4000000.0) - 6.0);
+		Err = fmax(Err, fabs(invSqrt(x) * sqrt((real64) x) - 1.0));
+	}
+	Fill(0.01f, 100.0f);
+	BENCH(LibnS, 1.0f / sqrtf(In[i & 4095]));
+	BENCH(FastnS, invSqrt(In[i & 4095]));
+	Report("invSqrt rel", Err, 5.0e-6, LibnS, FastnS, &OK);
+
+	// wraps must land in range, with error from float resolution only
+
+	Err = 0.0;
+	RangeErrors = 0;
+	for (i = 0; i <= 4000000; i++) {
+		a = i * (2000.0f / 4000000.0f) - 1000.0f;
+		x = MakePi(a);
+		y = Make2Pi(a);
+		if ((x < -PI) || (x >= PI) || (y < 0.0f) || (y >= TWO_PI))
+			RangeErrors++;
+		Err = fmax(Err, fabs(remainder(x - (real64) a, 2.0 * M_PI)));
+		Err = fmax(Err, fabs(remainder(y - (real64) a, 2.0 * M_PI)));
+	}
+	for (i = 0; i < 1000; i++) { // either side of the boundaries
+		a = nextafterf(PI, (i & 1) ? 10.0f : -10.0f) + (i / 2) * TWO_PI;
+		x = MakePi(a);
+		y = Make2Pi(-a);
+		if ((x < -PI) || (x >= PI) || (y < 0.0f) || (y >= TWO_PI))
+			RangeErrors++;
+	}
+	Fill(-10.0f, 10.0f);
+	BENCH(LibnS, LegacyMakePi(In[i & 4095]));
+	BENCH(FastnS, MakePi(In[i & 4095]));
+	Report("MakePi", Err, 2.5e-4, LibnS, FastnS, &OK);
+	printf("  %-12s %u out of range (old: loops)\n", "wraps", RangeErrors);
+	OK &= RangeErrors == 0;
+
+	// cached attitude sin/cos against the Euler angles, through gimbal lock
+
+	Err = 0.0;
+	for (i = 0; i <= 1000000; i++) {
+		ConvertEulerToQuaternion(
+				(i % 1801) * (PI / 1800.0f) - HALF_PI,
+				(i % 997) * (TWO_PI / 996.0f) - PI,
+				(i % 499) * (TWO_PI / 498.0f) - PI);
+		ConvertQuaternionToEuler();
+		for (j = Pitch; j <= Yaw; j++) {
+			Err = fmax(Err, fabs(Att.Sin[j] - sin((real64) A[j].Angle)));
+			Err = fmax(Err, fabs(Att.Cos[j] - cos((real64) A[j].Angle)));
+		}
+	}
+	printf("  %-12s %9.2e %9.2e\n", "Att sin/cos", Err, 2.0e-5);
+	OK &= Err < 2.0e-5;
+
+	printf("  %s\n", OK ? "ok" : "FAILED");
+
+	return (OK ? 0 : 1);
+} // SITLMathTest
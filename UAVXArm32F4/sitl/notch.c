@@ -0,0 +1,150 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Gyro notch test (-n). Synthetic gyro traces at the 2mS control rate carry a slow manoeuvre,
+// white noise and motor tones: a fundamental and harmonic sweeping on X, a fixed tone on Y
+// and a tone stepping in frequency on Z. Once the window has filled the notch centres should
+// sit within a spectrum bin of the tones and the noise about the manoeuvre should fall.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define NOTCH_TEST_S		8.0f
+#define NOTCH_SETTLE_S		1.0f
+
+static real32 Gauss(void) {
+	real32 u, v;
+
+	u = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+	v = (rand() + 1.0f) / (RAND_MAX + 2.0f);
+	return (sqrtf(-2.0f * logf(u)) * cosf(TWO_PI * v));
+} // Gauss
+
+static void Tones(real32 t, real32 * Hz) {
+
+	Hz[0] = 80.0f + 30.0f * t / NOTCH_TEST_S; // X fundamental
+	Hz[1] = 2.0f * Hz[0]; // X harmonic
+	Hz[2] = 150.0f; // Y
+	Hz[3] = (t < (NOTCH_TEST_S * 0.5f)) ? 110.0f : 170.0f; // Z
+} // Tones
+
+int SITLNotchTest(void) {
+	const real32 DPS = DegreesToRadians(1.0f) / GyroScale[UAVXArm32IMU];
+	real32 Hz[4], Phase[4], g[3], Clean[3], In[3], Out[3];
+	real64 NoiseIn[3], NoiseOut[3];
+	real32 t, e, ErrHz[4], BinHz, Worst;
+	uint32 i, n, Cycles, Settled, ZStepRetrack, RetrackmS;
+	uint64 StartnS, nS;
+	idx a, k;
+	boolean OK;
+
+	CurrAttSensorType = UAVXArm32IMU;
+	CurrPIDCycleuS = PID_CYCLE_2000US;
+	CurrPIDCycleS = CurrPIDCycleuS * 1.0e-6f;
+	BinHz = 1.0f / (GYRO_SPECTRUM_N * CurrPIDCycleS);
+	InitGyroSpectrum();
+	srand(1);
+
+	for (k = 0; k < 4; k++) {
+		Phase[k] = 0.0f;
+		ErrHz[k] = 0.0f;
+	}
+	for (a = X; a <= Z; a++)
+		NoiseIn[a] = NoiseOut[a] = 0.0;
+
+	Cycles = (uint32) (NOTCH_TEST_S / CurrPIDCycleS);
+	Settled = ZStepRetrack = 0;
+	nS = 0;
+
+	for (i = 0; i < Cycles; i++) {
+		t = i * CurrPIDCycleS;
+		Tones(t, Hz);
+		for (k = 0; k < 4; k++)
+			Phase[k] = Make2Pi(Phase[k] + TWO_PI * Hz[k] * CurrPIDCycleS);
+
+		for (a = X; a <= Z; a++)
+			Clean[a] = 100.0f * DPS * sinf(TWO_PI * (1.0f + a) * t) + 50.0f * a; // with bias
+		In[X] = Clean[X] + DPS * (20.0f * sinf(Phase[0]) + 10.0f * sinf(Phase[1]));
+		In[Y] = Clean[Y] + DPS * 15.0f * sinf(Phase[2]);
+		In[Z] = Clean[Z] + DPS * 25.0f * sinf(Phase[3]);
+		for (a = X; a <= Z; a++)
+			g[a] = In[a] += DPS * 2.0f * Gauss();
+
+		StartnS = SITLHostnS();
+		UpdateGyroNotches(g);
+		nS += SITLHostnS() - StartnS;
+		for (a = X; a <= Z; a++)
+			Out[a] = g[a];
+
+		if (t < NOTCH_SETTLE_S)
+			continue;
+
+		Settled++;
+		for (a = X; a <= Z; a++) {
+			NoiseIn[a] += Sqr(In[a] - Clean[a]);
+			NoiseOut[a] += Sqr(Out[a] - Clean[a]);
+		}
+
+		for (k = 0; k < 4; k++) { // distance from each tone to the nearest notch
+			a = (k < 2) ? X : k - 1;
+			Worst = 1.0e6f;
+			for (n = 0; n < GYRO_NOTCHES; n++)
+				if (GyroNotch[a].Active[n]) {
+					e = fabsf(GyroNotch[a].CentreHz[n] - Hz[k]);
+					if (e < Worst)
+						Worst = e;
+				}
+			if ((k == 3) && (Worst > BinHz))
+				ZStepRetrack++;
+			else
+				ErrHz[k] = Max(ErrHz[k], Worst);
+		}
+	}
+
+	printf("UAVX SITL gyro notch test, %u point spectrum at %.0fHz, %.1fHz bins, %u notches/axis Q %.1f\n",
+			GYRO_SPECTRUM_N, 1.0f / CurrPIDCycleS, BinHz, GYRO_NOTCHES,
+			GYRO_NOTCH_Q);
+
+	OK = true;
+	for (k = 0; k < 4; k++) {
+		OK &= ErrHz[k] < BinHz;
+		printf("  tone %u max tracking error %.1fHz\n", k, ErrHz[k]);
+	}
+	RetrackmS = ZStepRetrack * CurrPIDCycleuS / 1000;
+	OK &= RetrackmS < 500;
+	printf("  Z step 110 to 170Hz retracked in %umS\n", RetrackmS);
+
+	for (a = X; a <= Z; a++) {
+		e = 10.0f * log10f(NoiseIn[a] / NoiseOut[a]);
+		OK &= e > 10.0f;
+		printf("  axis %u noise %.1f to %.1f deg/S RMS, %.1fdB, final notches", a,
+				sqrtf(NoiseIn[a] / Settled) / DPS, sqrtf(NoiseOut[a] / Settled)
+						/ DPS, e);
+		for (n = 0; n < GYRO_NOTCHES; n++)
+			printf(" %.1fHz", GyroNotch[a].Active[n] ? GyroNotch[a].CentreHz[n]
+					: 0.0f);
+		printf("\n");
+	}
+	printf("  %u analyses, host %.0fnS/cycle: %s\n", GyroSpectrumAnalyses,
+			(real64) nS / Cycles, OK ? "ok" : "FAILED");
+
+	return (OK ? 0 : 1);
+} // SITLNotchTest
+
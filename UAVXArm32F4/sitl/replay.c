@@ -0,0 +1,530 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Estimator replay (-l file). A recording is a text file of time stamped records, one per
+// line, as decoded from a blackbox log or synthesised:
+//
+//   I t gx gy gz ax ay az               body rates rad/S and specific force M/S^2
+//   M t mx my mz                        body magnetic field, any units
+//   B t alt                             barometric altitude M
+//   G t lat lon alt vn ve vd hacc sacc  fix deg, M and M/S
+//   T t roll pitch yaw lat lon alt      truth deg and M
+//
+// with t in seconds. The values are substituted in the MPU6050, HMC5883L and MS5611 models
+// and fixes arrive as UBX NAV-PVT packets, so UpdateInertial with UpdateAltitudeEstimates
+// and UpdateWhere runs unchanged once per IMU record. The aircraft is landed for the first
+// REPLAY_LANDED_S and then armed where it is. Errors against the truth records and the host
+// time per call are reported. If the file does not exist the synthetic flight of -e is
+// written first and the errors are checked.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define REPLAY_MAX_VALUES	9
+#define REPLAY_LANDED_S		2.0
+#define REPLAY_SETTLE_S		10.0
+
+#define SYNTH_DURATION_S	60.0
+#define SYNTH_IMU_US		2000
+#define SYNTH_MAG_DIV		7 // ~70Hz
+#define SYNTH_BARO_DIV		10 // 50Hz
+#define SYNTH_GPS_DIV		100 // 5Hz
+#define SYNTH_TRUTH_DIV		5
+#define SYNTH_MSL_M			580.0
+#define SYNTH_DIP_DEG		60.0
+
+#define SYNTH_GYRO_SDEV		0.02 // rad/S
+#define SYNTH_ACC_SDEV		0.5 // M/S^2
+#define SYNTH_MAG_SDEV		0.01
+#define SYNTH_ALT_SDEV		0.3
+#define SYNTH_GPS_POS_SDEV	1.0
+#define SYNTH_GPS_VEL_SDEV	0.15
+
+static const real64 SynthGyroBias[3] = { 0.005, -0.004, 0.003 };
+static const real64 SynthAccBias[3] = { 0.15, -0.1, 0.2 };
+static const char SynthMagic[] = "# UAVX replay synthetic\n";
+
+typedef struct {
+	char Tag;
+	real64 t;
+	real64 v[REPLAY_MAX_VALUES];
+} ReplayRecordStruct;
+
+typedef struct {
+	real64 SumSq[3], Max[3];
+	real64 AltSumSq, AltMax, PosSumSq, DistSumSq;
+	uint32 n, nPos;
+	uint64 nS, MaxnS;
+	uint32 Calls;
+} ReplayErrStruct;
+
+static ReplayRecordStruct * Rec = NULL;
+static uint32 Records, Rejected;
+static boolean Synthetic;
+
+static const real64 MPerDeg = (real64) EARTH_RADIUS_M * M_PI / 180.0;
+
+static uint8 ReplayValues(char Tag) {
+
+	switch (Tag) {
+	case 'I':
+		return (6);
+	case 'M':
+		return (3);
+	case 'B':
+		return (1);
+	case 'G':
+		return (8);
+	case 'T':
+		return (6);
+	default:
+		return (0);
+	} // switch
+
+} // ReplayValues
+
+static boolean LoadRecording(const char * fn) {
+	ReplayRecordStruct r;
+	char Line[256];
+	uint32 Allocated;
+	FILE * f;
+	int n;
+
+	f = fopen(fn, "r");
+	if (!f)
+		return (false);
+
+	Records = Rejected = Allocated = 0;
+	Synthetic = false;
+
+	while (fgets(Line, sizeof(Line), f)) {
+		if (Line[0] == '#') {
+			Synthetic |= strcmp(Line, SynthMagic) == 0;
+			continue;
+		}
+
+		memset(&r, 0, sizeof(r));
+		n = sscanf(Line, " %c %lf %lf %lf %lf %lf %lf %lf %lf %lf %lf", &r.Tag,
+				&r.t, &r.v[0], &r.v[1], &r.v[2], &r.v[3], &r.v[4], &r.v[5],
+				&r.v[6], &r.v[7], &r.v[8]);
+		if (n <= 0)
+			continue;
+		if ((ReplayValues(r.Tag) == 0) || (n < (2 + ReplayValues(r.Tag)))) {
+			Rejected++;
+			continue;
+		}
+
+		if (Records == Allocated) {
+			Allocated = Allocated ? Allocated * 2 : 4096;
+			Rec = realloc(Rec, Allocated * sizeof(ReplayRecordStruct));
+		}
+		Rec[Records++] = r;
+	}
+
+	fclose(f);
+
+	return (true);
+} // LoadRecording
+
+//______________________________________________________________________________________________
+
+// Synthetic recording - the -e flight with the same sensor errors
+
+static void SynthLatLon(const real64 * Pos, real64 * Lat, real64 * Lon) {
+	const real64 HomeLat = DEFAULT_HOME_LAT * 1e-7;
+
+	*Lat = HomeLat + Pos[NorthC] / MPerDeg;
+	*Lon = DEFAULT_HOME_LON * 1e-7 + Pos[EastC] / (MPerDeg * cos(
+			DegreesToRadians(HomeLat)));
+
+} // SynthLatLon
+
+static boolean WriteSynthetic(const char * fn) {
+	const uint32 Steps = (uint32) (SYNTH_DURATION_S * 1.0e6 / SYNTH_IMU_US);
+	const real64 Dip = DegreesToRadians(SYNTH_DIP_DEG);
+	SITLTruthStruct T;
+	real64 t, mn[3], m[3], p[3], Lat, Lon;
+	uint32 k;
+	FILE * f;
+	idx a, i;
+
+	f = fopen(fn, "w");
+	if (!f)
+		return (false);
+
+	srand(1);
+	mn[NorthC] = cos(Dip);
+	mn[EastC] = 0.0;
+	mn[DownC] = sin(Dip);
+
+	fputs(SynthMagic, f);
+	fprintf(f, "# %.0fS at %uuS, gyro and accelerometer biased and noisy\n",
+			SYNTH_DURATION_S, SYNTH_IMU_US);
+
+	for (k = 0; k <= Steps; k++) {
+		t = (real64) k * SYNTH_IMU_US * 1.0e-6;
+		SITLTruth(t, &T);
+
+		fprintf(f, "I %.6f", t);
+		for (a = X; a <= Z; a++)
+			fprintf(f, " %.5f", T.Rate[a] + SynthGyroBias[a] + SYNTH_GYRO_SDEV
+					* SITLGauss());
+		for (a = X; a <= Z; a++)
+			fprintf(f, " %.4f", T.f[a] + SynthAccBias[a] + SYNTH_ACC_SDEV
+					* SITLGauss());
+		fputc('\n', f);
+
+		if ((k % SYNTH_MAG_DIV) == 0) {
+			for (a = X; a <= Z; a++) {
+				m[a] = 0.0;
+				for (i = 0; i < 3; i++)
+					m[a] += T.R[i][a] * mn[i];
+			}
+			fprintf(f, "M %.6f %.4f %.4f %.4f\n", t, m[X] + SYNTH_MAG_SDEV
+					* SITLGauss(), m[Y] + SYNTH_MAG_SDEV * SITLGauss(), m[Z]
+					+ SYNTH_MAG_SDEV * SITLGauss());
+		}
+
+		if ((k % SYNTH_BARO_DIV) == 0)
+			fprintf(f, "B %.6f %.3f\n", t, SYNTH_MSL_M - T.Pos[DownC]
+					+ SYNTH_ALT_SDEV * SITLGauss());
+
+		if ((k % SYNTH_GPS_DIV) == 0) {
+			for (a = NorthC; a <= DownC; a++)
+				p[a] = T.Pos[a] + SYNTH_GPS_POS_SDEV * SITLGauss();
+			SynthLatLon(p, &Lat, &Lon);
+			fprintf(f, "G %.6f %.8f %.8f %.3f %.3f %.3f %.3f %.2f %.2f\n", t,
+					Lat, Lon, SYNTH_MSL_M - p[DownC], T.Vel[NorthC]
+							+ SYNTH_GPS_VEL_SDEV * SITLGauss(), T.Vel[EastC]
+							+ SYNTH_GPS_VEL_SDEV * SITLGauss(), T.Vel[DownC]
+							+ SYNTH_GPS_VEL_SDEV * SITLGauss(),
+					SYNTH_GPS_POS_SDEV, SYNTH_GPS_VEL_SDEV);
+		}
+
+		if ((k % SYNTH_TRUTH_DIV) == 0) {
+			SynthLatLon(T.Pos, &Lat, &Lon);
+			fprintf(f, "T %.6f %.4f %.4f %.4f %.8f %.8f %.3f\n", t,
+					RadiansToDegrees(T.Angle[Roll]), RadiansToDegrees(
+							T.Angle[Pitch]), RadiansToDegrees(T.Angle[Yaw]),
+					Lat, Lon, SYNTH_MSL_M - T.Pos[DownC]);
+		}
+	}
+
+	fclose(f);
+
+	return (true);
+} // WriteSynthetic
+
+//______________________________________________________________________________________________
+
+static void Put32(uint8 * p, int32 v) {
+	p[0] = (uint8) v;
+	p[1] = (uint8) (v >> 8);
+	p[2] = (uint8) (v >> 16);
+	p[3] = (uint8) (v >> 24);
+} // Put32
+
+// a fix is received on the GPS port as a u-blox NAV-PVT packet
+
+#define UBX_PVT_LEN		92
+
+static void ReceivePVT(const ReplayRecordStruct * r, uint32 iTOW) {
+	uint8 B[6 + UBX_PVT_LEN + 2], * P, CK_A, CK_B;
+	idx i;
+
+	memset(B, 0, sizeof(B));
+	B[0] = 0xb5;
+	B[1] = 0x62;
+	B[2] = 0x01; // NAV
+	B[3] = 0x07; // PVT
+	B[4] = UBX_PVT_LEN;
+
+	P = &B[6];
+	Put32(&P[0], iTOW);
+	P[20] = 3; // 3D fix
+	P[21] = 1; // gnssFixOK
+	P[23] = 12;
+	Put32(&P[24], (int32) llround(r->v[1] * 1e7));
+	Put32(&P[28], (int32) llround(r->v[0] * 1e7));
+	Put32(&P[32], (int32) llround(r->v[2] * 1000.0));
+	Put32(&P[36], (int32) llround(r->v[2] * 1000.0));
+	Put32(&P[40], (int32) llround(r->v[6] * 1000.0));
+	Put32(&P[44], (int32) llround(r->v[6] * 1500.0));
+	Put32(&P[48], (int32) llround(r->v[3] * 1000.0));
+	Put32(&P[52], (int32) llround(r->v[4] * 1000.0));
+	Put32(&P[56], (int32) llround(r->v[5] * 1000.0));
+	Put32(&P[60], (int32) llround(hypot(r->v[3], r->v[4]) * 1000.0));
+	Put32(&P[64], (int32) llround(RadiansToDegrees(atan2(r->v[4], r->v[3]))
+			* 1e5));
+	Put32(&P[68], (int32) llround(r->v[7] * 1000.0));
+	Put32(&P[72], 50000); // 0.5deg
+	P[76] = 100; // pDOP 1.0
+
+	CK_A = CK_B = 0;
+	for (i = 2; i < (6 + UBX_PVT_LEN); i++) {
+		CK_A += B[i];
+		CK_B += CK_A;
+	}
+	B[6 + UBX_PVT_LEN] = CK_A;
+	B[6 + UBX_PVT_LEN + 1] = CK_B;
+
+	for (i = 0; i < sizeof(B); i++)
+		SITLReceiveUSART(GPSRxSerial, B[i]);
+
+} // ReceivePVT
+
+static real32 StandardPressure(real64 Alt) {
+	return (101325.0 * pow(1.0 - Alt / 44330.0, 1.0 / 0.190295));
+} // StandardPressure
+
+static void AdvanceTo(uint64 uS) {
+
+	if (uS > SITLuS)
+		SITLAdvance((uint32) (uS - SITLuS));
+
+} // AdvanceTo
+
+static void ApplyRecord(const ReplayRecordStruct * r) {
+	idx a;
+
+	switch (r->Tag) {
+	case 'I':
+		for (a = X; a <= Z; a++) {
+			SITLReplay.Rate[a] = r->v[a];
+			SITLReplay.Acc[a] = r->v[3 + a];
+		}
+		break;
+	case 'M':
+		for (a = X; a <= Z; a++)
+			SITLReplay.Mag[a] = r->v[a];
+		break;
+	case 'B':
+		SITLReplay.Pressure = StandardPressure(r->v[0]);
+		break;
+	default:
+		break;
+	} // switch
+
+} // ApplyRecord
+
+static void Commission(void) {
+	boolean Seen[3] = { false, false, false };
+	const char * Tags = "IMB";
+	idx i, j;
+
+	memset(&SITLReplay, 0, sizeof(SITLReplay));
+	SITLReplay.Acc[Z] = -GRAVITY_MPS_S;
+	SITLReplay.Mag[X] = 1.0f;
+	SITLReplay.Pressure = 101325.0f;
+
+	for (i = 0; i < Records; i++) // initialised with the first of each
+		for (j = 0; j < 3; j++)
+			if ((Rec[i].Tag == Tags[j]) && !Seen[j]) {
+				ApplyRecord(&Rec[i]);
+				Seen[j] = true;
+			}
+	SITLReplay.Active = true;
+
+	SITLCommission();
+	SetP(Config1Bits, P(Config1Bits) & ~EmulationEnableMask);
+	NVChanged = true;
+	UpdateNV();
+
+	// as UAVXMain
+	InitHarness();
+	InitParameters();
+	InitIMU();
+	InitMagnetometer();
+	InitMadgwick();
+	InitBarometer();
+	InitControl();
+	InitNavigation();
+	if (GPSRxSerial != TelemetrySerial)
+		InitGPS();
+
+} // Commission
+
+static real64 RMSDeg(real64 SumSq, uint32 n) {
+	return (n ? RadiansToDegrees(sqrt(SumSq / n)) : 0.0);
+} // RMSDeg
+
+int SITLEstimatorReplay(const char * fn) {
+	static const char * Name[] = { "MadgwickIMU", "MadgwickAHRS",
+			"MadgwickMARG", "ErrorStateEKF" };
+	static const idx TruthAngle[] = { 1, 0, 2 }; // Pitch, Roll, Yaw in roll, pitch, yaw
+	static const uint8 Probes[] = { ProfIMU, ProfEstimator, ProfHeading,
+			ProfGPS, ProfAltitude };
+	ReplayErrStruct E;
+	const ReplayRecordStruct * r;
+	uint32 Count[5], i;
+	uint64 StartuS, nS;
+	real64 t, t0, ArmedS, e, TruthAltP, N, East, Alt, Pos, Dist;
+	boolean Wrote, Flying, ok;
+	idx a, p;
+
+	Wrote = false;
+	if (!LoadRecording(fn)) {
+		if (!WriteSynthetic(fn) || !LoadRecording(fn)) {
+			fprintf(stderr, "sitl: unable to write %s\n", fn);
+			return (1);
+		}
+		Wrote = true;
+	}
+
+	memset(Count, 0, sizeof(Count));
+	for (i = 0; i < Records; i++)
+		Count[strchr("IMBGT", Rec[i].Tag) - "IMBGT"]++;
+
+	if (Count[0] == 0) {
+		fprintf(stderr, "sitl: %s has no IMU records\n", fn);
+		return (1);
+	}
+
+	SITLInitClock(0);
+	SITLStopuS = ~0ULL;
+	SITLInitSensors();
+
+	Commission();
+
+	memset(&E, 0, sizeof(E));
+	State = Landed;
+	Flying = false;
+	ArmedS = TruthAltP = 0.0;
+	StartuS = SITLuS;
+	t0 = Rec[0].t;
+
+	for (i = 0; i < Records; i++) {
+		r = &Rec[i];
+		t = r->t - t0;
+
+		switch (r->Tag) {
+		case 'I':
+			AdvanceTo(StartuS + (uint64) (t * 1.0e6));
+			ApplyRecord(r);
+
+			if (!Flying && (t >= REPLAY_LANDED_S)) { // armed where it is
+				State = InFlight;
+				CaptureHomePosition();
+				ResetProfile();
+				ArmedS = t;
+				Flying = true;
+			}
+
+			nS = SITLHostnS();
+			UpdateInertial();
+			nS = SITLHostnS() - nS;
+
+			if (Flying) {
+				E.nS += nS;
+				E.MaxnS = Max(E.MaxnS, nS);
+				E.Calls++;
+			}
+			break;
+		case 'G':
+			AdvanceTo(StartuS + (uint64) (t * 1.0e6));
+			ReceivePVT(r, (uint32) llround(t * 1000.0) + 1);
+			break;
+		case 'T':
+			if (!Flying)
+				TruthAltP = r->v[5]; // altitude zeroed while landed
+			else if (t >= REPLAY_SETTLE_S) {
+				for (a = Pitch; a <= Yaw; a++) {
+					e = fabs(remainder(A[a].Angle - DegreesToRadians(
+							r->v[TruthAngle[a]]), 2.0 * M_PI));
+					E.SumSq[a] += e * e;
+					E.Max[a] = fmax(E.Max[a], e);
+				}
+
+				Alt = Altitude - (r->v[5] - TruthAltP);
+				E.AltSumSq += Alt * Alt;
+				E.AltMax = fmax(E.AltMax, fabs(Alt));
+				E.n++;
+
+				if (F.OriginValid) {
+					N = (r->v[3] - GPS.C[NorthC].OriginRaw * 1e-7) * MPerDeg;
+					East = (r->v[4] - GPS.C[EastC].OriginRaw * 1e-7) * MPerDeg
+							* GPS.longitudeCorrection;
+					Pos = Sqr(Nav.C[NorthC].Pos - N) + Sqr(Nav.C[EastC].Pos
+							- East);
+					Dist = Nav.Distance - sqrt(N * N + East * East);
+					E.PosSumSq += Pos;
+					E.DistSumSq += Dist * Dist;
+					E.nPos++;
+				}
+			}
+			break;
+		default:
+			ApplyRecord(r);
+			break;
+		} // switch
+	}
+
+	SITLReplay.Active = false;
+
+	printf("UAVX SITL estimator replay of %s%s\n", fn, Wrote
+			? " (synthetic recording written)" : "");
+	printf("  %u records over %.1fS: %u IMU, %u mag, %u baro, %u GPS, %u truth, %u rejected\n",
+			Records, Rec[Records - 1].t - t0, Count[0], Count[1], Count[2],
+			Count[3], Count[4], Rejected);
+	printf("  %s, armed at %.1fS, errors after %.0fS\n", Name[Limit(
+			CurrStateEst, 0, EstUnknown - 1)], ArmedS, REPLAY_SETTLE_S);
+
+	if (E.n > 0) {
+		printf("  attitude rms/max roll %.2f/%.2fdeg, pitch %.2f/%.2fdeg, yaw %.2f/%.2fdeg\n",
+				RMSDeg(E.SumSq[Roll], E.n), RadiansToDegrees(E.Max[Roll]),
+				RMSDeg(E.SumSq[Pitch], E.n), RadiansToDegrees(E.Max[Pitch]),
+				RMSDeg(E.SumSq[Yaw], E.n), RadiansToDegrees(E.Max[Yaw]));
+		printf("  altitude rms/max %.2f/%.2fM", sqrt(E.AltSumSq / E.n), E.AltMax);
+		if (E.nPos > 0)
+			printf(", position rms %.2fM, distance rms %.2fM", sqrt(E.PosSumSq
+					/ E.nPos), sqrt(E.DistSumSq / E.nPos));
+		printf("\n");
+	} else
+		printf("  no truth records after %.0fS\n", REPLAY_SETTLE_S);
+
+	printf("  UpdateInertial %u calls, host mean %.0fnS, max %.0fnS\n", E.Calls,
+			E.Calls ? (real64) E.nS / E.Calls : 0.0, (real64) E.MaxnS);
+	printf("  %-10s %9s %10s %10s %10s\n", "Probe", "Count", "mean uS", "max",
+			"p99");
+	for (p = 0; p < sizeof(Probes); p++) {
+		a = Probes[p];
+		if (Profile[a].Count > 0)
+			printf("  %-10s %9u %10.1f %10.1f %10.1f\n", ProfileName[a],
+					Profile[a].Count, ProfileTenthsuS(Profile[a].Sumc
+							/ Profile[a].Count) * 0.1f, ProfileTenthsuS(
+							Profile[a].Maxc) * 0.1f, ProfileTenthsuS(
+							ProfilePercentilec(a, 99)) * 0.1f);
+	}
+
+	ok = true;
+	if (Synthetic) {
+		ok = (E.n > 0) && (E.nPos > 0) && (Rejected == 0);
+		for (a = Pitch; a <= Roll; a++) // tilt, yaw is held by the mag alone
+			ok &= RMSDeg(E.SumSq[a], E.n) < 15.0;
+		ok &= (sqrt(E.AltSumSq / Max(E.n, 1)) < 2.0) && (sqrt(E.PosSumSq
+				/ Max(E.nPos, 1)) < 2.0 * SYNTH_GPS_POS_SDEV);
+		printf("  %s\n", ok ? "ok" : "FAILED");
+	}
+
+	free(Rec);
+	Rec = NULL;
+
+	return (ok ? 0 : 1);
+} // SITLEstimatorReplay
@@ -0,0 +1,407 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Filter response (-g). Sinusoids from 10 to 100Hz and a step are run through each filter
+// and through the gyro and rate derivative chains as configured by the parameters (the
+// defaults, or as given with -p) at the rates they run in flight. Gain and phase come from
+// a least squares fit to the settled output and the phase is also given as a delay. The
+// derivatives are referred to an ideal differentiator so a pure delay reads the same way.
+// The gyro chain carries no notches as they are only placed on motor tones; the cost of
+// one at the lowest centre frequency is given separately.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define RESPONSE_HZ			10 // 10, 20.. 100Hz
+#define RESPONSE_SETTLE_S	1.0f
+#define RESPONSE_FIT_S		2.0f
+#define RESPONSE_STEP_S		0.25f
+#define RESPONSE_CALLS		1000000
+#define RESPONSE_DPS		50.0f
+
+typedef struct {
+	const char * Name;
+	real32 (*Do)(real32 v);
+	real32 dT; // input sample interval
+	idx Decimate; // inputs per output
+	real32 DPS; // test amplitude
+	boolean Derivative; // referred to d/dt
+	idx Order; // first order lags of CutHz for the exact discrete response, or 0
+	real32 CutHz;
+} ResponseStruct;
+
+static uint64 NowuS;
+static real32 GyrodT, PIDdT;
+
+static int16 SlewP;
+static LPFilterBankStruct GyroLP, AccLP;
+static BiquadBankStruct NotchB;
+static BiquadStruct BW;
+static PavelStruct PD;
+static LPFilterStruct DLP;
+static MAFilterStruct DMA;
+static real32 DiffP, GyroSum, RateD;
+static idx GyroSamples;
+static boolean GyroCycle;
+
+static void ResetAll(void) {
+	BiquadStruct N;
+
+	SlewP = 0;
+	InitLPFilterBank(&GyroLP, RollPitchGyroLPFOrder, CurrGyroLPFHz, GyrodT);
+	InitLPFilterBank(&AccLP, RollPitchAccLPFOrder, CurrAccLPFHz, PIDdT);
+	InitBiquadBank(&NotchB);
+	SetNotch(&N, GYRO_NOTCH_MIN_HZ, GYRO_NOTCH_Q, PIDdT);
+	SetBiquadBankLane(&NotchB, X, &N);
+	PrimeBiquadBankLane(&NotchB, X, 0.0f);
+	SetButterworth(&BW, CurrGyroLPFHz, PIDdT);
+	InitBiquad(&BW, 0.0f);
+	PD.Primed = false;
+	InitLPFilter(&DLP, 1, CurrDerivativeLPFHz, PIDdT);
+	InitMAFilter(&DMA, 4);
+	DiffP = GyroSum = RateD = 0.0f;
+	GyroSamples = 0;
+	GyroCycle = false;
+
+} // ResetAll
+
+// Stages as called in flight
+
+static real32 Slew(real32 v) {
+	return (SensorSlewLimit(GyroFailS, &SlewP, (int16) lrintf(v),
+			SlewLimitGyroClicks));
+} // Slew
+
+static real32 GyroLPF(real32 v) {
+	real32 g[3] = { v, v, v };
+
+	LPFilterBankAt(&GyroLP, g, NowuS);
+	return (g[X]);
+} // GyroLPF
+
+static real32 AccLPF(real32 v) {
+	real32 a[3] = { v, v, v };
+
+	LPFilterBankAt(&AccLP, a, NowuS);
+	return (a[X]);
+} // AccLPF
+
+static real32 Notch(real32 v) {
+	real32 g[3] = { v, 0.0f, 0.0f };
+
+	BiquadBank(&NotchB, g);
+	return (g[X]);
+} // Notch
+
+static real32 Butterworth(real32 v) {
+	return (Biquad(&BW, v));
+} // Butterworth
+
+static real32 Pavel(real32 v) {
+	return (PavelDifferentiator(&PD, v) / PIDdT);
+} // Pavel
+
+static real32 DerivativeLPF(real32 v) {
+	return (LPFilter(&DLP, v));
+} // DerivativeLPF
+
+static real32 DifferenceMA(real32 v) {
+	real32 d;
+
+	d = (v - DiffP) / PIDdT;
+	DiffP = v;
+	return (MAFilter(&DMA, d));
+} // DifferenceMA
+
+// Chains as configured, from GetIMU and ComputeAttitudeRateDerivative
+
+static real32 GyroChain(real32 v) {
+
+	if (P(GyroSlewRate) > 0)
+		v = Slew(v);
+	if (P(GyroLPFHz) > 0)
+		v = GyroLPF(v);
+
+	GyroSum += v;
+	GyroCycle = ++GyroSamples >= CurrGyroOversample;
+	if (GyroCycle) {
+		v = GyroSum / GyroSamples;
+		GyroSum = 0.0f;
+		GyroSamples = 0;
+	}
+
+	return (v);
+} // GyroChain
+
+static real32 RateDChain(real32 v) {
+
+	v = GyroChain(v);
+	if (GyroCycle) {
+		if (UsingPavelFilter) {
+			RateD = Pavel(v);
+			if (P(DerivativeLPFHz) > 0)
+				RateD = DerivativeLPF(RateD);
+		} else
+			RateD = DifferenceMA((P(DerivativeLPFHz) > 0) ? DerivativeLPF(v)
+					: v);
+	}
+
+	return (RateD);
+} // RateDChain
+
+//______________________________________________________________________________________________
+
+static real32 ClicksPerDPS;
+
+static boolean Fit(const ResponseStruct * C, real32 Hz, real32 * Gain,
+		real32 * Phase) {
+	// least squares fit of a sin + b cos + c to the settled output
+	real64 S[3][3], R[3], a, b, Det, w, t, s, c, y, A;
+	uint32 i, Samples;
+	uint32 uS;
+	idx j, k;
+
+	memset(S, 0, sizeof(S));
+	memset(R, 0, sizeof(R));
+
+	ResetAll();
+	A = C->DPS * ClicksPerDPS;
+	w = TWO_PI * Hz;
+	uS = (uint32) lrintf(C->dT * 1.0e6f);
+	Samples = (uint32) ((RESPONSE_SETTLE_S + RESPONSE_FIT_S) / C->dT);
+	for (i = 1; i <= Samples; i++) {
+		NowuS = (uint64) i * uS;
+		t = i * (real64) C->dT;
+		y = C->Do(A * sin(w * t));
+		if (((i % C->Decimate) == 0) && (t >= RESPONSE_SETTLE_S)) {
+			s = sin(w * t);
+			c = cos(w * t);
+			const real64 v[3] = { s, c, 1.0 };
+			for (j = 0; j < 3; j++) {
+				for (k = 0; k < 3; k++)
+					S[j][k] += v[j] * v[k];
+				R[j] += v[j] * y;
+			}
+		}
+	}
+
+	Det = S[0][0] * (S[1][1] * S[2][2] - S[1][2] * S[2][1]) - S[0][1] * (S[1][0]
+			* S[2][2] - S[1][2] * S[2][0]) + S[0][2] * (S[1][0] * S[2][1]
+			- S[1][1] * S[2][0]);
+	if (fabs(Det) < 1.0e-12)
+		return (false);
+
+	a = (R[0] * (S[1][1] * S[2][2] - S[1][2] * S[2][1]) - S[0][1] * (R[1]
+			* S[2][2] - S[1][2] * R[2]) + S[0][2] * (R[1] * S[2][1] - S[1][1]
+			* R[2])) / Det;
+	b = (S[0][0] * (R[1] * S[2][2] - S[1][2] * R[2]) - R[0] * (S[1][0]
+			* S[2][2] - S[1][2] * S[2][0]) + S[0][2] * (S[1][0] * R[2] - R[1]
+			* S[2][0])) / Det;
+
+	*Gain = sqrt(a * a + b * b) / A;
+	*Phase = RadiansToDegrees(atan2(b, a));
+	if (C->Derivative) {
+		*Gain /= w;
+		*Phase -= 90.0f;
+	}
+
+	return (true);
+} // Fit
+
+static void Exact(const ResponseStruct * C, real32 Hz, real32 * Gain,
+		real32 * Phase) {
+	// n first order lags K / (1 - (1 - K) z^-1) at z = e^(jwT)
+	real64 K, wT, Re, Im;
+
+	K = C->dT / (1.0 / (TWO_PI * C->CutHz) + C->dT);
+	wT = TWO_PI * Hz * C->dT;
+	Re = 1.0 - (1.0 - K) * cos(wT);
+	Im = (1.0 - K) * sin(wT);
+
+	*Gain = pow(K / sqrt(Re * Re + Im * Im), C->Order);
+	*Phase = -C->Order * RadiansToDegrees(atan2(Im, Re));
+
+} // Exact
+
+static void Step(const ResponseStruct * C, real32 * HalfmS, real32 * RisemS,
+		real32 * Overshoot) {
+	// a step, or for derivatives a ramp, after the filters have settled at zero
+	const uint32 StartSample = (uint32) (0.1f / C->dT);
+	real32 A, y, t, T10, T90;
+	uint32 i, Samples;
+	uint32 uS;
+
+	ResetAll();
+	A = C->DPS * ClicksPerDPS;
+	uS = (uint32) lrintf(C->dT * 1.0e6f);
+	Samples = StartSample + (uint32) (RESPONSE_STEP_S / C->dT);
+	*HalfmS = T10 = T90 = -1.0f;
+	*Overshoot = 0.0f;
+	for (i = 1; i <= Samples; i++) {
+		NowuS = (uint64) i * uS;
+		t = (i < StartSample) ? 0.0f : (i - StartSample) * C->dT;
+		y = C->Do((i < StartSample) ? 0.0f : (C->Derivative ? A * t : A));
+		if ((i % C->Decimate) == 0) {
+			y /= A;
+			if ((T10 < 0.0f) && (y >= 0.1f))
+				T10 = t;
+			if ((*HalfmS < 0.0f) && (y >= 0.5f))
+				*HalfmS = t * 1000.0f;
+			if ((T90 < 0.0f) && (y >= 0.9f))
+				T90 = t;
+			*Overshoot = Max(*Overshoot, (y - 1.0f) * 100.0f);
+		}
+	}
+	*RisemS = ((T10 >= 0.0f) && (T90 >= 0.0f)) ? (T90 - T10) * 1000.0f : -1.0f;
+
+} // Step
+
+static real64 CostnS(const ResponseStruct * C) {
+	static volatile real32 Sink = 0.0f;
+	uint64 StartnS;
+	uint32 i, uS;
+
+	ResetAll();
+	uS = (uint32) lrintf(C->dT * 1.0e6f);
+	StartnS = SITLHostnS();
+	for (i = 1; i <= RESPONSE_CALLS; i++) {
+		NowuS = (uint64) i * uS;
+		Sink += C->Do((i & 255) * 4.0f);
+	}
+
+	return ((real64) (SITLHostnS() - StartnS) / RESPONSE_CALLS);
+} // CostnS
+
+int SITLFilterResponse(void) {
+	ResponseStruct Cases[12];
+	real32 Gain[RESPONSE_HZ], Phase[RESPONSE_HZ], Hz, G, Ph, HalfmS, RisemS,
+			Overshoot, MaxGaindB, MaxPhase;
+	char Name[40];
+	idx c, n, f;
+	boolean OK;
+
+	SITLInitClock(0);
+	SITLStopuS = ~0ULL;
+	SITLInitSensors();
+	SITLCommission();
+
+	// as UpdateParameters
+
+	CurrAttSensorType = UAVXArm32IMU;
+	CurrESCType = Limit(P(ESCType), 0, ESCUnknown);
+	SetPIDPeriod();
+	UsingPavelFilter = (P(Config2Bits) & UsePavelFilterMask) != 0;
+	CurrAccLPFHz = P(AccLPFHz);
+	CurrGyroLPFHz = P(GyroLPFHz);
+	CurrDerivativeLPFHz = P(DerivativeLPFHz);
+#if defined(USE_GYRO_OVERSAMPLING) && !defined(USE_MPU6XXX_FIFO)
+	CurrGyroOversample = Limit(P(GyroOversample), 1, MAX_GYRO_OVERSAMPLE);
+#else
+	CurrGyroOversample = 1;
+#endif
+	SlewLimitGyroClicks = (DegreesToRadians(P(GyroSlewRate) * 100.0f)
+			* CurrPIDCycleS) / GyroScale[CurrAttSensorType];
+
+	PIDdT = CurrPIDCycleS;
+	GyrodT = PIDdT / CurrGyroOversample;
+	ClicksPerDPS = DegreesToRadians(1.0f) / GyroScale[CurrAttSensorType];
+
+	n = 0;
+#define CASE(N, D, T, Dec, A, Deriv, O, Cut) \
+	Cases[n++] = (ResponseStruct) { N, D, T, Dec, A, Deriv, O, Cut }
+
+	if (P(GyroSlewRate) > 0) {
+		CASE("gyro slew limit 10deg/S", Slew, GyrodT, 1, 10.0f, false, 0, 0.0f);
+		CASE("gyro slew limit 100deg/S", Slew, GyrodT, 1, 100.0f, false, 0, 0.0f);
+	}
+	if (CurrGyroLPFHz > 0.0f) {
+		CASE("gyro LP", GyroLPF, GyrodT, 1, RESPONSE_DPS, false,
+				RollPitchGyroLPFOrder, CurrGyroLPFHz);
+		CASE("Butterworth (unused)", Butterworth, PIDdT, 1, RESPONSE_DPS,
+				false, 0, 0.0f);
+	}
+	CASE("gyro notch", Notch, PIDdT, 1, RESPONSE_DPS, false, 0, 0.0f);
+	if (CurrAccLPFHz > 0.0f)
+		CASE("acc LP", AccLPF, PIDdT, 1, RESPONSE_DPS, false,
+				RollPitchAccLPFOrder, CurrAccLPFHz);
+	CASE("Pavel differentiator", Pavel, PIDdT, 1, RESPONSE_DPS, true, 0, 0.0f);
+	if (CurrDerivativeLPFHz > 0.0f)
+		CASE("derivative LP", DerivativeLPF, PIDdT, 1, RESPONSE_DPS, false, 1,
+				CurrDerivativeLPFHz);
+	CASE("difference and MA 4", DifferenceMA, PIDdT, 1, RESPONSE_DPS, true, 0,
+			0.0f);
+	CASE("gyro chain", GyroChain, GyrodT, CurrGyroOversample, RESPONSE_DPS,
+			false, 0, 0.0f);
+	CASE("rate derivative chain", RateDChain, GyrodT, CurrGyroOversample,
+			RESPONSE_DPS, true, 0, 0.0f);
+
+	printf("UAVX SITL filter response, control cycle %uuS, gyro %u samples/cycle\n",
+			CurrPIDCycleuS, CurrGyroOversample);
+	printf("  gyro LP %.0fHz order %d, acc LP %.0fHz order %d, derivative LP %.0fHz, %s\n",
+			CurrGyroLPFHz, RollPitchGyroLPFOrder, CurrAccLPFHz,
+			RollPitchAccLPFOrder, CurrDerivativeLPFHz,
+			UsingPavelFilter ? "Pavel" : "difference and MA 4");
+	printf("  slew limit %d clicks/sample, notch %.0fHz Q %.0f, chains at %.0fdeg/S\n",
+			SlewLimitGyroClicks, GYRO_NOTCH_MIN_HZ, GYRO_NOTCH_Q, RESPONSE_DPS);
+	printf("  %-28s", "Hz");
+	for (f = 0; f < RESPONSE_HZ; f++)
+		printf("%7d", (f + 1) * 10);
+	printf("\n");
+
+	OK = true;
+	MaxGaindB = MaxPhase = 0.0f;
+	for (c = 0; c < n; c++) {
+		for (f = 0; f < RESPONSE_HZ; f++) {
+			Hz = (f + 1) * 10.0f;
+			if (!Fit(&Cases[c], Hz, &Gain[f], &Phase[f]))
+				OK = false;
+			if ((f > 0) && (Phase[f] > Phase[f - 1] + 180.0f)) // unwrap
+				Phase[f] -= 360.0f;
+			if (Cases[c].Order > 0) { // check the fit
+				Exact(&Cases[c], Hz, &G, &Ph);
+				MaxGaindB = Max(MaxGaindB, fabsf(20.0f * log10f(Gain[f] / G)));
+				MaxPhase = Max(MaxPhase, fabsf(Phase[f] - Ph));
+			}
+		}
+		Step(&Cases[c], &HalfmS, &RisemS, &Overshoot);
+
+		snprintf(Name, sizeof(Name), (Cases[c].CutHz > 0.0f) ? "%s %.0fHz" : "%s",
+				Cases[c].Name, Cases[c].CutHz);
+		printf("  %-24s dB ", Name);
+		for (f = 0; f < RESPONSE_HZ; f++)
+			printf("%7.2f", 20.0f * log10f(Gain[f]));
+		printf("\n  %-24s deg", "");
+		for (f = 0; f < RESPONSE_HZ; f++)
+			printf("%7.1f", Phase[f]);
+		printf("\n  %-24s mS ", "");
+		for (f = 0; f < RESPONSE_HZ; f++)
+			printf("%7.2f", -Phase[f] / (0.36f * (f + 1) * 10.0f));
+		printf("\n  %-28s%s %.1fmS, 10-90%% %.1fmS, overshoot %.0f%%, host %.1fnS/call\n",
+				"", Cases[c].Derivative ? "ramp 50%" : "step 50%", HalfmS, RisemS,
+				Overshoot, CostnS(&Cases[c]));
+	}
+
+	OK &= (MaxGaindB < 0.01f) && (MaxPhase < 0.1f);
+	printf("  LP fits against exact discrete response: %.4fdB, %.3fdeg\n",
+			MaxGaindB, MaxPhase);
+	printf("  %s\n", OK ? "ok" : "FAILED");
+
+	return (OK ? 0 : 1);
+} // SITLFilterResponse
@@ -0,0 +1,199 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Ring stress test (-r). A producer thread stands in for an ISR and the main thread for the
+// flight loop. Every record carries a sequence number and words derived from it so a torn
+// copy, a lost or repeated entry or an unaccounted overrun shows up as a failure. On an x86
+// host this exercises the index arithmetic and the atomics but not the weaker ordering of
+// the Cortex-M4 bus.
+
+#include <pthread.h>
+#include <sched.h>
+#include "UAVX.h"
+#include "sitl.h"
+
+#define RING_TEST_RECORDS	4000000
+#define RING_TEST_BYTES		20000000
+#define RING_TEST_WORDS		15
+
+typedef struct {
+	uint32 Seq;
+	uint32 w[RING_TEST_WORDS];
+} RingTestStruct;
+
+typedef struct {
+	RingStruct * R;
+	uint32 n;
+	boolean Lossy;
+	uint32 Puts, Waits;
+	boolean Finished;
+} RingTestArgStruct;
+
+static uint32 RingTestWord(uint32 Seq, idx i) {
+	uint32 h;
+
+	h = Seq * 2654435761u + i * 40503u;
+	return (h ^ (h >> 15));
+} // RingTestWord
+
+static void * RecordProducer(void * a) {
+	RingTestArgStruct * A = (RingTestArgStruct *) a;
+	RingTestStruct v;
+	uint32 Seq;
+	idx i;
+
+	for (Seq = 1; Seq <= A->n; Seq++) {
+		v.Seq = Seq;
+		for (i = 0; i < RING_TEST_WORDS; i++)
+			v.w[i] = RingTestWord(Seq, i);
+		if (!A->Lossy)
+			while (ringUsed(A->R) == A->R->Mask) {
+				A->Waits++;
+				sched_yield();
+			}
+		if (ringPut(A->R, &v))
+			A->Puts++;
+		if (A->Lossy && ((Seq & 0xff) == 0)) // let a single core host run the consumer
+			sched_yield();
+	}
+	__atomic_store_n(&A->Finished, true, __ATOMIC_RELEASE);
+
+	return (NULL);
+} // RecordProducer
+
+static void * ByteProducer(void * a) {
+	RingTestArgStruct * A = (RingTestArgStruct *) a;
+	uint32 n;
+
+	for (n = 0; n < A->n; n++) {
+		while (ringUsed(A->R) == A->R->Mask) {
+			A->Waits++;
+			sched_yield();
+		}
+		if (ringPutByte(A->R, (uint8) RingTestWord(n, 0)))
+			A->Puts++;
+	}
+
+	return (NULL);
+} // ByteProducer
+
+static boolean RecordTest(boolean Lossy) {
+	static RingTestStruct Buf[8];
+	RingStruct R;
+	RingTestArgStruct A;
+	RingTestStruct v;
+	pthread_t Producer;
+	uint32 Gets, Torn, Order, LastSeq, Throttle;
+	uint64 StartnS;
+	boolean Finished, OK;
+	idx i;
+
+	ringInit(&R, Buf, 8, sizeof(RingTestStruct));
+	memset(&A, 0, sizeof(A));
+	A.R = &R;
+	A.n = RING_TEST_RECORDS;
+	A.Lossy = Lossy;
+
+	Gets = Torn = Order = LastSeq = 0;
+	StartnS = SITLHostnS();
+	pthread_create(&Producer, NULL, RecordProducer, &A);
+
+	do {
+		Finished = __atomic_load_n(&A.Finished, __ATOMIC_ACQUIRE);
+		if (ringGet(&R, &v)) {
+			Gets++;
+			for (i = 0; i < RING_TEST_WORDS; i++)
+				if (v.w[i] != RingTestWord(v.Seq, i)) {
+					Torn++;
+					break;
+				}
+			if (Lossy ? (v.Seq <= LastSeq) : (v.Seq != (LastSeq + 1)))
+				Order++;
+			LastSeq = v.Seq;
+			if (Lossy && ((Gets & 0x3ff) == 0)) // consumer falls behind now and then
+				for (Throttle = 0; Throttle < 20000; Throttle++)
+					__asm__ volatile("");
+		} else
+			sched_yield();
+	} while (!Finished || ringAvailable(&R));
+
+	pthread_join(Producer, NULL);
+
+	OK = (Torn == 0) && (Order == 0) && (Gets == A.Puts) && ((A.Puts
+			+ R.Overruns) == A.n) && (Lossy ? (R.Overruns > 0) : (R.Overruns
+			== 0));
+
+	printf("  %s records: %u put, %u got, %u overruns, max used %u, %u torn, %u out of order, %.0fnS/entry: %s\n",
+			Lossy ? "lossy   " : "lossless", A.Puts, Gets, R.Overruns,
+			R.MaxUsed, Torn, Order, (real64) (SITLHostnS() - StartnS) / A.n,
+			OK ? "ok" : "FAILED");
+
+	return (OK);
+} // RecordTest
+
+static boolean ByteTest(void) {
+	static uint8 Buf[64];
+	RingStruct R;
+	RingTestArgStruct A;
+	pthread_t Producer;
+	uint32 n, Errors;
+	uint64 StartnS;
+	boolean OK;
+
+	ringInit(&R, Buf, sizeof(Buf), 1);
+	memset(&A, 0, sizeof(A));
+	A.R = &R;
+	A.n = RING_TEST_BYTES;
+
+	Errors = 0;
+	StartnS = SITLHostnS();
+	pthread_create(&Producer, NULL, ByteProducer, &A);
+
+	for (n = 0; n < A.n; n++) {
+		while (!ringAvailable(&R))
+			sched_yield();
+		if (ringGetByte(&R) != (uint8) RingTestWord(n, 0))
+			Errors++;
+	}
+
+	pthread_join(Producer, NULL);
+
+	OK = (Errors == 0) && (R.Overruns == 0) && (A.Puts == A.n)
+			&& !ringAvailable(&R);
+
+	printf("  bytes   : %u put, %u wrong, %u overruns, max used %u, %.1fnS/byte: %s\n",
+			A.Puts, Errors, R.Overruns, R.MaxUsed, (real64) (SITLHostnS()
+					- StartnS) / A.n, OK ? "ok" : "FAILED");
+
+	return (OK);
+} // ByteTest
+
+int SITLRingTest(void) {
+	boolean OK;
+
+	printf("UAVX SITL SPSC ring stress test, producer and consumer threads\n");
+
+	OK = RecordTest(false);
+	OK &= RecordTest(true);
+	OK &= ByteTest();
+
+	return (OK ? 0 : 1);
+} // SITLRingTest
+
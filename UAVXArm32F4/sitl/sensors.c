@@ -0,0 +1,370 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL I2C device models for the V3 board: MPU6050, HMC5883L, MS5611 and 24LC512.
+// The board sits level and at rest with a little deterministic noise. In flight the
+// emulation in emu.c replaces the IMU, baro and GPS. During an estimator replay the
+// readings are the replayed values taken back through the board's calibration.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+static uint32 Seed = 12345;
+
+static int16 Jitter(int16 a) {
+
+	Seed = Seed * 1103515245 + 12345;
+	return ((int16) ((Seed >> 16) % (2 * a + 1)) - a);
+} // Jitter
+
+static void Put16(uint8 * p, int16 v) {
+	p[0] = (uint8) (v >> 8);
+	p[1] = (uint8) v;
+} // Put16
+
+static int16 Clip16(real32 v) {
+	return ((int16) Limit(lroundf(v), -32768, 32767));
+} // Clip16
+
+SITLReplayStruct SITLReplay;
+
+//______________________________________________________________________________________________
+
+// MPU6050 +/-4g, +/-2000deg/S. With its FIFO enabled samples are queued in register order
+// at the divided sample rate - the oldest are lost when it is full.
+
+static uint8 MPUReg[128];
+
+static uint8 MPUFIFOBuf[MPU_FIFO_BYTES];
+static uint16 MPUFIFOHead = 0, MPUFIFOCount = 0;
+static uint64 MPUFIFONextuS = 0;
+
+// body x and y are the sensor y and x, body z is the sensor -z as GetIMU
+
+static void MPUReplaySample(uint8 * p) {
+	const real32 GyroR = 1.0f / GyroScale[UAVXArm32IMU];
+
+	Put16(&p[0], Clip16(SITLReplay.Acc[Y] / NV.AccCal.Scale[X]
+			+ NV.AccCal.Bias[X]));
+	Put16(&p[2], Clip16(SITLReplay.Acc[X] / NV.AccCal.Scale[Y]
+			+ NV.AccCal.Bias[Y]));
+	Put16(&p[4], Clip16(-SITLReplay.Acc[Z] / NV.AccCal.Scale[Z]
+			+ NV.AccCal.Bias[Z]));
+	Put16(&p[6], -3956); // 25C
+	Put16(&p[8], Clip16(SITLReplay.Rate[Y] * GyroR + NV.GyroCal.C[X]));
+	Put16(&p[10], Clip16(SITLReplay.Rate[X] * GyroR + NV.GyroCal.C[Y]));
+	Put16(&p[12], Clip16(-SITLReplay.Rate[Z] * GyroR + NV.GyroCal.C[Z]));
+
+} // MPUReplaySample
+
+static void MPUSample(uint8 * p) {
+
+	if (SITLReplay.Active) {
+		MPUReplaySample(p);
+		return;
+	}
+
+	Put16(&p[0], Jitter(8));
+	Put16(&p[2], Jitter(8));
+	Put16(&p[4], MPU_1G + Jitter(8));
+	Put16(&p[6], -3956); // 25C
+	Put16(&p[8], Jitter(2));
+	Put16(&p[10], Jitter(2));
+	Put16(&p[12], Jitter(2));
+
+} // MPUSample
+
+static void MPUFillFIFO(void) {
+	uint8 S[MPU_FIFO_SAMPLE_BYTES];
+	uint32 PerioduS;
+	idx i;
+
+	if (!(MPUReg[MPU_RA_USER_CTRL] & (1 << MPU_RA_USERCTRL_FIFO_EN_BIT))
+			|| (MPUReg[MPU_RA_FIFO_EN] == 0)) {
+		MPUFIFONextuS = SITLuS;
+		return;
+	}
+
+	i = MPUReg[MPU_RA_CONFIG] & 7;
+	PerioduS = ((i == 0) || (i == 7) ? 125 : 1000) * (1
+			+ MPUReg[MPU_RA_SMPLRT_DIV]);
+
+	while (MPUFIFONextuS <= SITLuS) {
+		MPUSample(S);
+		for (i = 0; i < MPU_FIFO_SAMPLE_BYTES; i++) {
+			if (MPUFIFOCount == MPU_FIFO_BYTES) {
+				MPUFIFOHead = (MPUFIFOHead + 1) % MPU_FIFO_BYTES;
+				MPUFIFOCount--;
+				MPUReg[MPU_RA_INT_STATUS] |= 1 << MPU_RA_INTERRUPT_FIFO_OFLOW_BIT;
+			}
+			MPUFIFOBuf[(MPUFIFOHead + MPUFIFOCount++) % MPU_FIFO_BYTES] = S[i];
+		}
+		MPUFIFONextuS += PerioduS;
+	}
+
+} // MPUFillFIFO
+
+static void MPURead(uint8 reg, uint8 len, uint8 * data) {
+	idx i;
+
+	MPUFillFIFO();
+
+	if (reg == MPU_RA_FIFO_R_W) { // no auto increment
+		for (i = 0; i < len; i++)
+			if (MPUFIFOCount > 0) {
+				data[i] = MPUFIFOBuf[MPUFIFOHead];
+				MPUFIFOHead = (MPUFIFOHead + 1) % MPU_FIFO_BYTES;
+				MPUFIFOCount--;
+			} else
+				data[i] = 0xff;
+		return;
+	}
+
+	MPUSample(&MPUReg[MPU_RA_ACC_XOUT_H]);
+	Put16(&MPUReg[MPU_RA_FIFO_COUNTH], MPUFIFOCount);
+
+	for (i = 0; i < len; i++)
+		data[i] = MPUReg[(reg + i) & 0x7f];
+
+	if ((reg <= MPU_RA_INT_STATUS) && ((reg + len) > MPU_RA_INT_STATUS))
+		MPUReg[MPU_RA_INT_STATUS] = 0;
+
+} // MPURead
+
+static void MPUWrite(uint8 reg, uint8 len, uint8 * data) {
+	idx i;
+
+	MPUFillFIFO();
+
+	for (i = 0; i < len; i++)
+		MPUReg[(reg + i) & 0x7f] = data[i];
+
+	MPUReg[MPU_RA_PWR_MGMT_1] &= ~(1 << MPU_RA_PWR1_DEVICE_RESET_BIT);
+
+	if (MPUReg[MPU_RA_USER_CTRL] & (1 << MPU_RA_USERCTRL_FIFO_RESET_BIT)) {
+		MPUReg[MPU_RA_USER_CTRL] &= ~(1 << MPU_RA_USERCTRL_FIFO_RESET_BIT);
+		MPUFIFOHead = MPUFIFOCount = 0;
+		MPUFIFONextuS = SITLuS;
+	}
+
+} // MPUWrite
+
+//______________________________________________________________________________________________
+
+// HMC5883L
+
+static uint8 HMCReg[16] = { 0x10, 0x20, 0x01, 0, 0, 0, 0, 0, 0, 0, 'H', '4',
+		'3' };
+
+#define HMC_REPLAY_GAIN	600.0f // counts for a unit field
+
+static void HMCReplayAxis(uint8 m, idx a, real32 Sign) {
+	real32 Scale;
+
+	Scale = (MagScale[m] > 0.0f) ? MagScale[m] : 1.0f;
+	Put16(&HMCReg[3 + m * 2], Clip16(Sign * (SITLReplay.Mag[a]
+			* HMC_REPLAY_GAIN + NV.MagCal.Bias[a]) / Scale));
+
+} // HMCReplayAxis
+
+static void HMCRead(uint8 reg, uint8 len, uint8 * data) {
+	idx i;
+
+	if ((HMCReg[0] & 0x03) == 1) { // positive bias self test
+		Put16(&HMCReg[3], 632);
+		Put16(&HMCReg[5], 589);
+		Put16(&HMCReg[7], 632);
+	} else if (SITLReplay.Active) { // as GetMagnetometer
+		if (F.InvertMagnetometer) {
+			HMCReplayAxis(MX, BF, 1.0f);
+			HMCReplayAxis(MY, LR, -1.0f);
+			HMCReplayAxis(MZ, UD, 1.0f);
+		} else {
+			HMCReplayAxis(MY, BF, 1.0f);
+			HMCReplayAxis(MX, LR, 1.0f);
+			HMCReplayAxis(MZ, UD, -1.0f);
+		}
+	} else { // heading north with dip
+		Put16(&HMCReg[3], 200 + Jitter(2));
+		Put16(&HMCReg[5], -400 + Jitter(2));
+		Put16(&HMCReg[7], Jitter(2));
+	}
+
+	for (i = 0; i < len; i++)
+		data[i] = HMCReg[(reg + i) & 0x0f];
+
+} // HMCRead
+
+static void HMCWrite(uint8 reg, uint8 len, uint8 * data) {
+	idx i;
+
+	for (i = 0; i < len; i++)
+		if ((reg + i) < 3)
+			HMCReg[reg + i] = data[i];
+
+} // HMCWrite
+
+//______________________________________________________________________________________________
+
+// MS5611 - datasheet example coefficients and conversions (1000.09mBar, 20.07C)
+
+static uint16 MSProm[8] = { 0, 40127, 36924, 23317, 23282, 33464, 28312, 0 };
+static uint8 MSCmd = 0;
+
+static void MSInitProm(void) {
+	uint16 crc = 0;
+	idx i, k;
+
+	for (i = 0; i < 16; i++) {
+		if (i % 2 == 1)
+			crc ^= MSProm[i >> 1] & 0x00ff;
+		else
+			crc ^= MSProm[i >> 1] >> 8;
+		for (k = 8; k > 0; k--)
+			if (crc & 0x8000)
+				crc = (crc << 1) ^ 0x3000;
+			else
+				crc = crc << 1;
+	}
+	MSProm[7] |= (crc >> 12) & 0xf;
+
+} // MSInitProm
+
+#define MS_D2	8569150
+
+// D1 for a pressure at the fixed D2 temperature, from the datasheet first order compensation
+
+static uint32 MSReplayD1(real32 P) {
+	int64 dT, Off, Sens;
+
+	dT = (int64) MS_D2 - ((int64) MSProm[5] << 8);
+	Off = ((int64) MSProm[2] << 16) + (((int64) MSProm[4] * dT) >> 7);
+	Sens = ((int64) MSProm[1] << 15) + (((int64) MSProm[3] * dT) >> 8);
+
+	return ((uint32) (((((int64) llroundf(P * 16.0f) << 11) + Off) << 21)
+			/ Sens));
+} // MSReplayD1
+
+static void MSRead(uint8 reg, uint8 len, uint8 * data) {
+	uint32 v;
+
+	if ((reg >= 0xa0) && (reg <= 0xae) && (len == 2))
+		Put16(data, MSProm[(reg - 0xa0) >> 1]);
+	else if (len == 3) {
+		if ((MSCmd & 0xf0) == 0x40)
+			v = SITLReplay.Active ? MSReplayD1(SITLReplay.Pressure) : 9085466
+					+ Jitter(4);
+		else
+			v = MS_D2 + (SITLReplay.Active ? 0 : Jitter(4));
+		data[0] = v >> 16;
+		data[1] = v >> 8;
+		data[2] = v;
+	}
+
+} // MSRead
+
+static void MSWrite(uint8 reg, uint8 len, uint8 * data) {
+
+	MSCmd = ((len > 0) && (reg == 0)) ? data[0] : reg;
+
+} // MSWrite
+
+//______________________________________________________________________________________________
+
+// 24LC512 EEPROM - the first two bytes written are the address
+
+static uint8 EE[MEM_SIZE];
+static uint16 EEAddr;
+
+static void EERead(uint8 len, uint8 * data) {
+	idx i;
+
+	for (i = 0; i < len; i++)
+		data[i] = EE[(uint16) (EEAddr + i)];
+	EEAddr += len;
+
+} // EERead
+
+static void EEWrite(uint8 len, uint8 * data) {
+	idx i;
+
+	if (len >= 2) {
+		EEAddr = ((uint16) data[0] << 8) | data[1];
+		for (i = 2; i < len; i++)
+			EE[(uint16) (EEAddr + i - 2)] = data[i];
+	}
+
+} // EEWrite
+
+//______________________________________________________________________________________________
+
+boolean SITLI2CRead(uint8 id, uint8 reg, uint8 len, uint8 * data) {
+
+	switch (id) {
+	case MPU_0x68_ID:
+		MPURead(reg, len, data);
+		break;
+	case HMC5XXX_ID:
+		HMCRead(reg, len, data);
+		break;
+	case MS56XX_ID:
+		MSRead(reg, len, data);
+		break;
+	case EEPROM_ID:
+		EERead(len, data);
+		break;
+	default:
+		return (false);
+	} // switch
+
+	return (true);
+} // SITLI2CRead
+
+boolean SITLI2CWrite(uint8 id, uint8 reg, uint8 len, uint8 * data) {
+
+	switch (id) {
+	case MPU_0x68_ID:
+		MPUWrite(reg, len, data);
+		break;
+	case HMC5XXX_ID:
+		HMCWrite(reg, len, data);
+		break;
+	case MS56XX_ID:
+		MSWrite(reg, len, data);
+		break;
+	case EEPROM_ID:
+		EEWrite(len, data);
+		break;
+	default:
+		return (false);
+	} // switch
+
+	return (true);
+} // SITLI2CWrite
+
+void SITLInitSensors(void) {
+
+	MPUReg[MPU_RA_WHO_AM_I] = 0x68;
+	MPUReg[MPU_RA_PRODUCT_ID] = 0x54;
+	MSInitProm();
+	memset(EE, 0xff, sizeof(EE));
+
+} // SITLInitSensors
+
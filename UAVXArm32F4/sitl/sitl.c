@@ -0,0 +1,499 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL host entry point, STM32 memory map, pilot script and cycle cost report
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+uint32_t SystemCoreClock = 168000000;
+
+volatile uint32 SITLPRIMASK = 0;
+uint32 SITLCoreReg[8];
+
+FILE * SITLTelemetryFile = NULL;
+boolean SITLVerbose = false;
+
+int UAVXMain(void);
+
+uint64 SITLHostnS(void) {
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return ((uint64) t.tv_sec * 1000000000ULL + t.tv_nsec);
+} // SITLHostnS
+
+static void MapRegion(uintptr_t Base, size_t Size, uint8 Fill) {
+	void * p;
+
+	p = mmap((void *) Base, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE
+			| MAP_ANONYMOUS | MAP_FIXED_NOREPLACE | MAP_NORESERVE, -1, 0);
+	if (p != (void *) Base) {
+		fprintf(stderr, "sitl: unable to map 0x%08lx\n", (unsigned long) Base);
+		exit(1);
+	}
+	if (Fill != 0)
+		memset(p, Fill, Size);
+} // MapRegion
+
+//______________________________________________________________________________________________
+
+// Pilot - each script line holds "time thr roll pitch yaw arm" until the next line
+
+#define SITL_MAX_SCRIPT	64
+
+static const SITLStickStruct DefaultScript[] = {
+	{ 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, false },
+	{ 8.0f, 0.0f, 0.0f, 0.0f, 0.0f, true }, // arming switch
+	{ 10.0f, 0.0f, 100.0f, 0.0f, 0.0f, true }, // roll stick arming
+	{ 14.0f, 0.0f, 0.0f, 0.0f, 0.0f, true },
+	{ 20.0f, 55.0f, 0.0f, 0.0f, 0.0f, true }, // takeoff
+	{ 35.0f, 55.0f, 20.0f, 0.0f, 0.0f, true },
+	{ 37.0f, 55.0f, -20.0f, 0.0f, 0.0f, true },
+	{ 39.0f, 55.0f, 0.0f, 0.0f, 0.0f, true },
+	{ 45.0f, 55.0f, 0.0f, 20.0f, 0.0f, true },
+	{ 47.0f, 55.0f, 0.0f, -20.0f, 0.0f, true },
+	{ 49.0f, 55.0f, 0.0f, 0.0f, 0.0f, true },
+	{ 55.0f, 55.0f, 0.0f, 0.0f, 30.0f, true },
+	{ 58.0f, 55.0f, 0.0f, 0.0f, 0.0f, true },
+	{ 70.0f, 0.0f, 0.0f, 0.0f, 0.0f, true }, // land
+	{ 90.0f, 0.0f, 0.0f, 0.0f, 0.0f, false }, };
+
+static SITLStickStruct Script[SITL_MAX_SCRIPT];
+static uint8 ScriptLength = 0;
+static uint8 ScriptStep = 0;
+
+SITLStickStruct SITLSticks;
+
+boolean SITLLoadScript(const char * fn) {
+	FILE * f;
+	char Line[128];
+	SITLStickStruct * s;
+	int Arm;
+
+	f = fopen(fn, "r");
+	if (f == NULL)
+		return (false);
+
+	ScriptLength = 0;
+	while ((ScriptLength < SITL_MAX_SCRIPT) && fgets(Line, sizeof(Line), f)) {
+		if ((Line[0] == '#') || (Line[0] == '\n'))
+			continue;
+		s = &Script[ScriptLength];
+		if (sscanf(Line, "%f %f %f %f %f %d", &s->TimeS, &s->Throttle,
+				&s->Roll, &s->Pitch, &s->Yaw, &Arm) == 6) {
+			s->Arm = Arm != 0;
+			ScriptLength++;
+		}
+	}
+	fclose(f);
+
+	return (ScriptLength > 0);
+} // SITLLoadScript
+
+void SITLUpdatePilot(void) {
+	real32 NowS;
+
+	NowS = (SITLuS - SITLStartuS) * 0.000001f;
+	while ((ScriptStep < ScriptLength) && (NowS >= Script[ScriptStep].TimeS))
+		SITLSticks = Script[ScriptStep++];
+
+	// arming switch reads high when armed, landing switch is active low
+	if (SITLSticks.Arm)
+		GPIOPins[ArmedSel].Port->IDR |= GPIOPins[ArmedSel].Pin;
+	else
+		GPIOPins[ArmedSel].Port->IDR &= ~GPIOPins[ArmedSel].Pin;
+	GPIOPins[LandingSel].Port->IDR |= GPIOPins[LandingSel].Pin;
+
+	SITLCPPM.WidthuS[0] = 1000 + Limit(SITLSticks.Throttle, 0, 100) * 10.0f;
+	SITLCPPM.WidthuS[1] = 1500 + Limit1(SITLSticks.Roll, 100) * 5.0f;
+	SITLCPPM.WidthuS[2] = 1500 + Limit1(SITLSticks.Pitch, 100) * 5.0f;
+	SITLCPPM.WidthuS[3] = 1500 + Limit1(SITLSticks.Yaw, 100) * 5.0f;
+	SITLCPPM.WidthuS[4] = 1000; // nav mode off
+	SITLCPPM.WidthuS[5] = 1000; // angle mode
+	SITLCPPM.WidthuS[6] = 1500; // nav gain
+	SITLCPPM.WidthuS[7] = 1000; // bypass off
+
+} // SITLUpdatePilot
+
+//______________________________________________________________________________________________
+
+// Trig call count - libm and fastmath.h trig are wrapped at link time so calls from the
+// flight code are counted without changing it
+
+uint64 SITLTrigCalls = 0;
+
+#define WRAP1(f) \
+	real32 __real_##f(real32 x); \
+	real32 __wrap_##f(real32 x) { SITLTrigCalls++; return (__real_##f(x)); }
+
+#define WRAP2(f) \
+	real32 __real_##f(real32 y, real32 x); \
+	real32 __wrap_##f(real32 y, real32 x) { SITLTrigCalls++; return (__real_##f(y, x)); }
+
+#define WRAPSC(f) \
+	void __real_##f(real32 A, real32 * s, real32 * c); \
+	void __wrap_##f(real32 A, real32 * s, real32 * c) { SITLTrigCalls++; __real_##f(A, s, c); }
+
+WRAP1(sinf)
+WRAP1(cosf)
+WRAP1(tanf)
+WRAP1(atanf)
+WRAP1(asinf)
+WRAP1(acosf)
+WRAP2(atan2f)
+WRAPSC(sincosf)
+WRAP1(FastSin)
+WRAP1(FastCos)
+WRAP1(FastAsin)
+WRAP2(FastAtan2)
+WRAPSC(FastSinCos)
+
+//______________________________________________________________________________________________
+
+// Cycle cost - the Probe() pin marks the flight control cycle on the target
+
+typedef struct {
+	uint32 Cycles;
+	uint64 HostnS, HostMinnS, HostMaxnS;
+	uint64 VirtualuS;
+	uint32 VirtualMaxuS;
+	uint64 TrigCalls;
+	uint32 MaxTrigCalls;
+} SITLCycleStatsStruct;
+
+static SITLCycleStatsStruct CycleStats[UnknownFlightState + 1];
+static uint64 ProbeStartnS, ProbeStartuS, ProbeStartTrig;
+static uint8 ProbeState;
+static uint8 PrevState = UnknownFlightState;
+static uint64 SimStartnS;
+static real32 MinIMUdT = 1.0f, MaxIMUdT = 0.0f;
+static real64 AngleErrSumSq = 0.0;
+
+const char * SITLStateName[] = { "Starting", "Warmup", "Landing", "Landed",
+		"Shutdown", "InFlight", "IREmulate", "Preflight", "Ready",
+		"Launching", "Unknown" };
+
+const char * SITLTaskName[] = { "Alarms", "Battery", "Telemetry",
+		"CalAlarm", "wsLED", "Jobs" };
+
+const char * SITLJobName[] = { "UbxSave", "UpdateNV", "InitGPS", "InitBB" };
+
+void SITLProbe(uint8 p) {
+	uint64 NowuS, NownS, dTnS;
+	SITLCycleStatsStruct * c;
+	idx a;
+
+	NownS = SITLHostnS();
+	NowuS = SITLuS;
+
+	if (p) {
+		ProbeStartnS = NownS;
+		ProbeStartuS = NowuS;
+		ProbeStartTrig = SITLTrigCalls;
+		ProbeState = Limit(State, 0, UnknownFlightState);
+	} else if (ProbeStartnS != 0) {
+		c = &CycleStats[ProbeState];
+		dTnS = NownS - ProbeStartnS;
+
+		if ((c->Cycles == 0) || (dTnS < c->HostMinnS))
+			c->HostMinnS = dTnS;
+		if (dTnS > c->HostMaxnS)
+			c->HostMaxnS = dTnS;
+		c->HostnS += dTnS;
+		c->VirtualuS += NowuS - ProbeStartuS;
+		c->VirtualMaxuS = Max(c->VirtualMaxuS, (uint32) (NowuS - ProbeStartuS));
+		c->TrigCalls += SITLTrigCalls - ProbeStartTrig;
+		c->MaxTrigCalls = Max(c->MaxTrigCalls, (uint32) (SITLTrigCalls - ProbeStartTrig));
+		c->Cycles++;
+		ProbeStartnS = 0;
+
+		if (ProbeState == InFlight) { // sample to sample
+			MinIMUdT = Min(MinIMUdT, dT);
+			MaxIMUdT = Max(MaxIMUdT, dT);
+			for (a = Pitch; a <= Roll; a++) // setpoint tracking
+				AngleErrSumSq += Sqr(A[a].P.Desired - A[a].Angle);
+		}
+
+		if (SITLVerbose && (State != PrevState)) {
+			fprintf(stderr, "%9.3fs %s -> %s\n", (NowuS - SITLStartuS) * 0.000001,
+					SITLStateName[Limit(PrevState, 0, UnknownFlightState)],
+					SITLStateName[Limit(State, 0, UnknownFlightState)]);
+			PrevState = State;
+		}
+	}
+
+} // SITLProbe
+
+void SITLReport(void) {
+	idx s;
+	real64 HostS, SimS;
+	SITLCycleStatsStruct * c;
+
+	HostS = (SITLHostnS() - SimStartnS) * 1.0e-9;
+	SimS = (SITLuS - SITLStartuS) * 1.0e-6;
+
+	printf("\nUAVX SITL: %.1fs simulated in %.2fs host (x%.1f)\n", SimS, HostS,
+			SimS / HostS);
+	printf("%-10s %9s %10s %10s %10s %10s %10s\n", "State", "Cycles",
+			"Host min", "mean", "max uS", "Virt uS", "max");
+	for (s = 0; s <= UnknownFlightState; s++) {
+		c = &CycleStats[s];
+		if (c->Cycles > 0)
+			printf("%-10s %9u %10.2f %10.2f %10.2f %10.1f %10u\n",
+					SITLStateName[s], c->Cycles, c->HostMinnS * 0.001,
+					(c->HostnS * 0.001) / c->Cycles, c->HostMaxnS * 0.001,
+					(real32) c->VirtualuS / c->Cycles, c->VirtualMaxuS);
+	}
+	printf("%-10s %9s %10s %10s %10s %10s\n", "Probe", "Count", "min uS",
+			"mean", "max", "p99");
+	for (s = 0; s < MAX_PROBES; s++)
+		if (Profile[s].Count > 0)
+			printf("%-10s %9u %10.1f %10.1f %10.1f %10.1f\n", ProfileName[s],
+					Profile[s].Count, ProfileTenthsuS(Profile[s].Minc) * 0.1f,
+					ProfileTenthsuS(Profile[s].Sumc / Profile[s].Count) * 0.1f,
+					ProfileTenthsuS(Profile[s].Maxc) * 0.1f, ProfileTenthsuS(
+							ProfilePercentilec(s, 99)) * 0.1f);
+	printf("%-10s %9s %6s %8s %8s %8s %8s %8s\n", "Task", "Runs", "Budget",
+			"mean uS", "max uS", "Budget", "Dline", "Cycle");
+	for (s = 0; s < MAX_TASKS; s++)
+		printf("%-10s %9u %6u %8.1f %8u %8u %8u %8u\n", SITLTaskName[s],
+				Tasks[s].Runs, Tasks[s].BudgetuS, Tasks[s].Runs ? (real32)
+						Tasks[s].TotaluS / Tasks[s].Runs : 0.0f, Tasks[s].MaxuS,
+				Tasks[s].BudgetOverruns, Tasks[s].DeadlineMisses,
+				Tasks[s].CycleOverruns);
+	printf("%-10s %9s %6s %8s %-10s %8s\n", "Job", "Runs", "Steps", "max uS",
+			"in", "Pending");
+	for (s = 0; s < MAX_JOBS; s++)
+		printf("%-10s %9u %6u %8u %-10s %7u%%\n", SITLJobName[s], Jobs[s].Runs,
+				Jobs[s].StepsRun, Jobs[s].MaxStepuS, Jobs[s].StepsRun
+						? SITLStateName[Limit(Jobs[s].MaxStepState, 0,
+								UnknownFlightState)] : "-", Jobs[s].Queued
+						? JobProgress(s) : 0);
+	c = &CycleStats[InFlight];
+	if (c->Cycles > 0) {
+		printf("Trig calls per InFlight cycle %.2f, max %u\n", (real64) c->TrigCalls
+				/ c->Cycles, c->MaxTrigCalls);
+		printf("Roll/pitch angle tracking rms %.2fdeg\n", RadiansToDegrees(sqrt(
+				AngleErrSumSq / (2 * c->Cycles))));
+	}
+	printf("Gyro oversampling x%u, missed samples %u\n", CurrGyroOversample,
+			GyroOversamplesMissed);
+	if (MPUFIFO.Drains > 0)
+		printf("MPU FIFO %u drains, %u samples, max queued %u, %u empty, %u resets\n",
+				MPUFIFO.Drains, MPUFIFO.Samples, MPUFIFO.MaxQueued,
+				MPUFIFO.Empty, MPUFIFO.Overflows);
+	printf("RC frames max queued %u, %u overruns; serial Rx max queued %u/%u, %u/%u overruns\n",
+			RCWidthQ.MaxUsed, RCWidthQ.Overruns, RxRing[RCSerial].MaxUsed,
+			RxRing[TelemetrySerial].MaxUsed, RxRing[RCSerial].Overruns,
+			RxRing[TelemetrySerial].Overruns);
+	printf("IMU dT in flight %.0f-%.0fuS, GPS lag %.1fmS\n", MinIMUdT * 1.0e6f,
+			MaxIMUdT * 1.0e6f, GPSLag * 1000.0f);
+	printf("Late cycles %u (max %uuS), last culprit %d\n", CycleOverruns,
+			MaxCycleLateuS, currStat(SchedCulpritS));
+	printf("Time base %llu reads, %u errors, %u DWT wraps, uS clock %s\n",
+			(unsigned long long) SITLClockReads, SITLClockErrors,
+			(uint32) ((SITLuS * TicksuS) >> 32) - (uint32) ((SITLStartuS
+					* TicksuS) >> 32), ((SITLuS ^ SITLStartuS) >> 32) ? "wrapped"
+					: "not wrapped");
+	printf("Final state %s, telemetry %u bytes, I2C errors %u\n",
+			SITLStateName[Limit(State, 0, UnknownFlightState)], SITLTxBytes[0]
+					+ SITLTxBytes[1], i2cState[0].i2cErrors);
+	fflush(stdout);
+
+} // SITLReport
+
+//______________________________________________________________________________________________
+
+// Commissioning - a blank board is given defaults, emulation, nominal calibration and
+// any parameters from the command line numbered as in UAVXGUI (1..128)
+
+#define SITL_MAX_PARAMS	32
+
+static uint8 ParamNo[SITL_MAX_PARAMS], ParamValue[SITL_MAX_PARAMS];
+static uint8 Params = 0;
+
+void SITLCommission(void) {
+	idx a;
+
+	CheckParametersInitialised();
+
+	SetP(Config1Bits, P(Config1Bits) | EmulationEnableMask);
+	for (a = 0; a < Params; a++)
+		SetP(ParamNo[a] - 1, ParamValue[a]);
+
+	for (a = X; a <= Z; a++) {
+		NV.AccCal.Bias[a] = 1.0f; // non-zero flags calibrated
+		NV.AccCal.Scale[a] = DEF_ACC_SCALE;
+		NV.GyroCal.M[a] = 0.0f;
+		NV.GyroCal.C[a] = 0.0f;
+	}
+	NV.AccCal.TRef = NV.GyroCal.TRef = 25.0f;
+
+	NV.MagCal.CalSamples = MAG_CAL_SAMPLES;
+
+	NVChanged = true;
+	UpdateNV();
+
+} // SITLCommission
+
+static void Usage(const char * Name) {
+	fprintf(stderr,
+			"usage: %s [-a] [-b] [-c] [-d seconds] [-e] [-f fifo.bin] [-g] [-l replay.txt] [-m] [-n]\n"
+			"          [-o uptime seconds] [-p param=value] [-q] [-r] [-s script] [-t telemetry.bin] [-v]\n",
+			Name);
+	exit(1);
+} // Usage
+
+int main(int argc, char * argv[]) {
+	real32 DurationS = 0.0f;
+	real64 UptimeS = 0.0;
+	boolean MathTest = false;
+	boolean Benchmark = false;
+	boolean BusTest = false;
+	boolean RingTest = false;
+	boolean NotchTest = false;
+	boolean FilterBench = false;
+	boolean FilterResponse = false;
+	boolean EstimatorBench = false;
+	boolean ConingTest = false;
+	const char * FIFOFile = NULL;
+	const char * ReplayFile = NULL;
+	int o, No, Value;
+
+	while ((o = getopt(argc, argv, "abcd:ef:gl:mno:p:qrs:t:v")) != -1)
+		switch (o) {
+		case 'a':
+			MathTest = true;
+			break;
+		case 'b':
+			Benchmark = true;
+			break;
+		case 'c':
+			ConingTest = true;
+			break;
+		case 'd':
+			DurationS = atof(optarg);
+			break;
+		case 'e':
+			EstimatorBench = true;
+			break;
+		case 'f':
+			FIFOFile = optarg;
+			break;
+		case 'g':
+			FilterResponse = true;
+			break;
+		case 'l':
+			ReplayFile = optarg;
+			break;
+		case 'm':
+			FilterBench = true;
+			break;
+		case 'n':
+			NotchTest = true;
+			break;
+		case 'o':
+			UptimeS = atof(optarg);
+			break;
+		case 'p':
+			if ((Params >= SITL_MAX_PARAMS) || (sscanf(optarg, "%d=%d", &No,
+					&Value) != 2) || (No < 1) || (No > MAX_PARAMETERS))
+				Usage(argv[0]);
+			ParamNo[Params] = No;
+			ParamValue[Params++] = Value;
+			break;
+		case 'q':
+			BusTest = true;
+			break;
+		case 'r':
+			RingTest = true;
+			break;
+		case 's':
+			if (!SITLLoadScript(optarg)) {
+				fprintf(stderr, "sitl: unable to read script %s\n", optarg);
+				exit(1);
+			}
+			break;
+		case 't':
+			SITLTelemetryFile = fopen(optarg, "wb");
+			break;
+		case 'v':
+			SITLVerbose = true;
+			break;
+		default:
+			Usage(argv[0]);
+		} // switch
+
+	if (ScriptLength == 0) {
+		ScriptLength = sizeof(DefaultScript) / sizeof(DefaultScript[0]);
+		memcpy(Script, DefaultScript, sizeof(DefaultScript));
+	}
+	if (DurationS <= 0.0f)
+		DurationS = Script[ScriptLength - 1].TimeS + 5.0f;
+
+	MapRegion(SITL_FLASH_BASE, SITL_FLASH_SIZE, 0xff);
+	MapRegion(SITL_PERIPH_BASE, SITL_PERIPH_SIZE, 0);
+	MapRegion(SITL_CORE_BASE, SITL_CORE_SIZE, 0);
+	FLASH->CR = FLASH_CR_LOCK;
+
+	if (MathTest)
+		return (SITLMathTest());
+	if (Benchmark)
+		return (SITLClockBenchmark());
+	if (BusTest)
+		return (SITLSPITest() | SITLI2CTest());
+	if (FilterBench)
+		return (SITLFilterBenchmark());
+	if (NotchTest)
+		return (SITLNotchTest());
+	if (FilterResponse)
+		return (SITLFilterResponse());
+	if (EstimatorBench)
+		return (SITLEstimatorBenchmark());
+	if (ConingTest)
+		return (SITLConingTest());
+	if (RingTest)
+		return (SITLRingTest());
+	if (FIFOFile)
+		return (SITLFIFOReplay(FIFOFile));
+	if (ReplayFile)
+		return (SITLEstimatorReplay(ReplayFile));
+
+	SITLInitClock((uint64) (UptimeS * 1000000.0));
+	SITLStopuS = SITLStartuS + (uint64) (DurationS * 1000000.0f);
+
+	SITLInitSensors();
+	SITLUpdatePilot();
+
+	SITLCommission();
+
+	SimStartnS = SITLHostnS();
+	atexit(SITLReport);
+
+	UAVXMain();
+
+	return (0);
+} // main
+
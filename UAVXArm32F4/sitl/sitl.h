@@ -0,0 +1,190 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// Host-native software-in-the-loop (SITL) build. The flight code runs unmodified against
+// a RAM backed STM32F4 memory map, stand-ins for clocks.c, isr.c, boards/harness.c and i2c.c
+// and a mock of the parts of the ST peripheral library the flight code calls.
+
+#ifndef _sitl_h
+#define _sitl_h
+
+#include <stdio.h>
+
+// STM32F4 memory map regions backed by host RAM
+
+#define SITL_FLASH_BASE		0x08000000
+#define SITL_FLASH_SIZE		0x00100000
+#define SITL_PERIPH_BASE	0x40000000
+#define SITL_PERIPH_SIZE	0x10061000 // APB1 to AHB2
+#define SITL_CORE_BASE		0xe0000000
+#define SITL_CORE_SIZE		0x00100000
+
+// Virtual time
+
+#define SITL_CLOCK_QUANTUM_US	1 // charged to every clock read so busy waits terminate
+#define SITL_I2C_BIT_US			(1000000.0f/I2C_CLOCK_HZ)
+
+extern volatile uint64 SITLuS;
+extern uint64 SITLStartuS, SITLStopuS;
+extern volatile boolean SITLInISR;
+extern volatile uint32 SITLPRIMASK;
+extern uint64 SITLClockReads;
+extern uint32 SITLClockErrors;
+
+void SITLInitClock(uint64 StartuS);
+int SITLClockBenchmark(void);
+void SITLAdvance(uint32 uS);
+void SITLDispatch(void);
+uint64 SITLHostnS(void);
+
+// SPSC ring stress test
+
+int SITLRingTest(void);
+
+// Gyro spectrum and notch test
+
+int SITLNotchTest(void);
+
+// Filter micro-benchmark
+
+int SITLFilterBenchmark(void);
+
+// Fast math accuracy and cost
+
+int SITLMathTest(void);
+
+// Filter and chain frequency response
+
+int SITLFilterResponse(void);
+
+// State estimator accuracy and cost - a synthetic multirotor flight with known truth
+
+typedef struct {
+	real64 R[3][3]; // body to NED
+	real64 Pos[3], Vel[3];
+	real64 f[3]; // specific force, body
+	real64 Rate[3];
+	real64 Angle[3];
+} SITLTruthStruct;
+
+real32 SITLGauss(void);
+void SITLTruth(real64 t, SITLTruthStruct * T);
+int SITLEstimatorBenchmark(void);
+
+// Estimator replay - recorded or synthesised sensor values substituted in the device models
+
+typedef struct {
+	boolean Active;
+	real32 Rate[3], Acc[3]; // body, rad/S and M/S^2 specific force
+	real32 Mag[3]; // body, any units
+	real32 Pressure; // Pa
+} SITLReplayStruct;
+
+extern SITLReplayStruct SITLReplay;
+
+int SITLEstimatorReplay(const char * fn);
+
+// Delta angle and velocity integration
+
+int SITLConingTest(void);
+
+// Interrupt sources modelled
+
+typedef struct {
+	uint32 Edges;
+	uint64 NextEdgeuS;
+	uint8 Ch;
+	uint16 WidthuS[8];
+} SITLCPPMStruct;
+
+extern SITLCPPMStruct SITLCPPM;
+
+void SITLUpdateCPPM(void);
+void SITLServiceUSART(uint8 s);
+void SITLReceiveUSART(uint8 s, uint8 ch);
+
+extern FILE * SITLTelemetryFile;
+extern uint32 SITLTxBytes[];
+
+// SPI bus
+
+#define SITL_SPI_REGS	128
+
+typedef struct {
+	uint32 Transfers, Bytes, BusFaults;
+	uint8 InjectFaults, InjectStalls; // applied to the next transfers
+} SITLSPIStruct;
+
+extern uint8 SITLSPIRegs[MAX_SPI_DEVICES][SITL_SPI_REGS];
+extern SITLSPIStruct SITLSPI;
+
+void SITLApplyDMAClears(void);
+void SITLSPIStartDMA(SPI_TypeDef * SPIx);
+void SITLSPIStopDMA(void);
+void SITLUpdateSPI(void);
+void DMA1_Stream3_IRQHandler(void);
+int SITLSPITest(void);
+
+// I2C bus
+
+typedef struct {
+	uint32 Transfers;
+	uint8 InjectStalls; // applied to the next transfers
+} SITLI2CStruct;
+
+extern SITLI2CStruct SITLI2C;
+
+void SITLUpdateI2C(void);
+int SITLI2CTest(void);
+
+// MPU6XXX FIFO
+
+int SITLFIFOReplay(const char * fn);
+
+// Pilot
+
+typedef struct {
+	real32 TimeS;
+	real32 Throttle, Roll, Pitch, Yaw; // percent
+	boolean Arm;
+} SITLStickStruct;
+
+extern SITLStickStruct SITLSticks;
+extern boolean SITLVerbose;
+
+boolean SITLLoadScript(const char * fn);
+void SITLUpdatePilot(void);
+
+// Sensors
+
+boolean SITLI2CRead(uint8 id, uint8 reg, uint8 len, uint8 * data);
+boolean SITLI2CWrite(uint8 id, uint8 reg, uint8 len, uint8 * data);
+void SITLInitSensors(void);
+void SITLCommission(void);
+
+// Cycle cost
+
+extern uint64 SITLTrigCalls;
+
+void SITLProbe(uint8 p);
+void SITLReport(void);
+
+#endif
+
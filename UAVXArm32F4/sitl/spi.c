@@ -0,0 +1,403 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL SPI bus. Devices are register files selected by their chip select pin and addressed
+// as the MPU6XXX - bit 7 read - or HMC5XXX - bit 6 auto increment. A DMA transfer is clocked
+// at the rate set in CR1 and completed from the dispatcher which raises the Rx stream flags
+// and calls its handler. DMA errors and stalls may be injected. The V3 board has no SPI
+// devices so the transaction queue test (-q) fits the V4 SPI2 bus.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+#define SITL_SPI_PCLK_MHZ	42.0f // APB1 - SPI2 and SPI3
+
+uint8 SITLSPIRegs[MAX_SPI_DEVICES][SITL_SPI_REGS];
+SITLSPIStruct SITLSPI;
+
+static struct {
+	boolean Active, Fault;
+	uint8 Dev;
+	uint64 DoneuS;
+	DMA_Stream_TypeDef * Tx, *Rx;
+} Xfer;
+
+static DMA_Stream_TypeDef * const Streams[16] = { DMA1_Stream0, DMA1_Stream1,
+		DMA1_Stream2, DMA1_Stream3, DMA1_Stream4, DMA1_Stream5, DMA1_Stream6,
+		DMA1_Stream7, DMA2_Stream0, DMA2_Stream1, DMA2_Stream2, DMA2_Stream3,
+		DMA2_Stream4, DMA2_Stream5, DMA2_Stream6, DMA2_Stream7 };
+
+static DMA_Stream_TypeDef * FindStream(SPI_TypeDef * SPIx, uint32 Dir) {
+	DMA_Stream_TypeDef * s;
+	idx i;
+
+	for (i = 0; i < 16; i++) {
+		s = Streams[i];
+		if ((s->CR & DMA_SxCR_EN) && (s->PAR == (uint32) &SPIx->DR)
+				&& ((s->CR & DMA_SxCR_DIR) == Dir))
+			return (s);
+	}
+
+	return (0);
+} // FindStream
+
+static void SetStreamFlags(DMA_Stream_TypeDef * s, uint32 f) {
+	static const uint8 Shift[4] = { 0, 6, 16, 22 };
+	DMA_TypeDef * d;
+	uint8 n;
+
+	d = ((uint32) s < DMA2_BASE) ? DMA1 : DMA2;
+	n = (((uint32) s & 0xff) - 0x10) / 0x18;
+
+	SITLApplyDMAClears();
+	if (n < 4)
+		d->LISR |= f << Shift[n];
+	else
+		d->HISR |= f << Shift[n - 4];
+
+} // SetStreamFlags
+
+void SITLSPIStartDMA(SPI_TypeDef * SPIx) {
+	real32 MHz;
+	uint8 Selected;
+	idx i;
+
+	Xfer.Tx = FindStream(SPIx, DMA_DIR_MemoryToPeripheral);
+	Xfer.Rx = FindStream(SPIx, DMA_DIR_PeripheralToMemory);
+
+	Selected = 0;
+	for (i = 0; i < MAX_SPI_DEVICES; i++)
+		if (SPISelectPins[i].Port && !(SPISelectPins[i].Port->ODR
+				& SPISelectPins[i].Pin)) {
+			Xfer.Dev = i;
+			Selected++;
+		}
+
+	if (Xfer.Active || !Xfer.Tx || !Xfer.Rx || (Selected != 1)
+			|| (Xfer.Tx->NDTR != Xfer.Rx->NDTR)) {
+		SITLSPI.BusFaults++;
+		Xfer.Active = false;
+		return;
+	}
+
+	MHz = SITL_SPI_PCLK_MHZ / (2 << ((SPIx->CR1 >> 3) & 7));
+
+	Xfer.Active = true;
+	Xfer.DoneuS = SITLuS + (uint64) ceilf(Xfer.Tx->NDTR * 8.0f / MHz);
+	Xfer.Fault = SITLSPI.InjectFaults > 0;
+	if (Xfer.Fault)
+		SITLSPI.InjectFaults--;
+	if (SITLSPI.InjectStalls > 0) {
+		SITLSPI.InjectStalls--;
+		Xfer.DoneuS = ~0ULL;
+	}
+
+	SITLSPI.Transfers++;
+
+} // SITLSPIStartDMA
+
+void SITLSPIStopDMA(void) {
+
+	Xfer.Active = false;
+
+} // SITLSPIStopDMA
+
+void SITLUpdateSPI(void) {
+	uint8 * Tx, *Rx, a;
+	boolean Read;
+	idx i, n;
+
+	if (!Xfer.Active)
+		return;
+
+	if (SITLuS < Xfer.DoneuS)
+		return;
+
+	Tx = (uint8 *) (uintptr_t) Xfer.Tx->M0AR;
+	Rx = (uint8 *) (uintptr_t) Xfer.Rx->M0AR;
+	n = Xfer.Tx->NDTR;
+
+	if (!Xfer.Fault) {
+		a = Tx[0] & ((Xfer.Dev == hmc5xxxSel) ? 0x3f : 0x7f);
+		Read = (Tx[0] & 0x80) != 0;
+		Rx[0] = 0xff;
+		for (i = 1; i < n; i++, a = (a + 1) & (SITL_SPI_REGS - 1))
+			if (Read)
+				Rx[i] = SITLSPIRegs[Xfer.Dev][a];
+			else {
+				SITLSPIRegs[Xfer.Dev][a] = Tx[i];
+				Rx[i] = 0xff;
+			}
+		Xfer.Tx->NDTR = Xfer.Rx->NDTR = 0;
+		SITLSPI.Bytes += n;
+	}
+
+	Xfer.Tx->CR &= ~DMA_SxCR_EN;
+	Xfer.Rx->CR &= ~DMA_SxCR_EN;
+	SetStreamFlags(Xfer.Tx, Xfer.Fault ? 0x08 : 0x20);
+	SetStreamFlags(Xfer.Rx, Xfer.Fault ? 0x08 : 0x20);
+	Xfer.Active = false;
+
+	if ((Xfer.Rx == DMA1_Stream3) && (Xfer.Rx->CR & (DMA_IT_TC | DMA_IT_TE)))
+		DMA1_Stream3_IRQHandler();
+
+} // SITLUpdateSPI
+
+//______________________________________________________________________________________________
+
+// Transaction queue test
+
+static uint8 DoneOrder[SPI_QUEUE_LEN + 2], DoneN;
+static boolean DoneOK[SPI_QUEUE_LEN + 2];
+
+#define DONE_FN(n) static void Done##n(boolean ok) { \
+	DoneOK[DoneN] = ok; DoneOrder[DoneN++] = n; }
+
+DONE_FN(0)
+DONE_FN(1)
+DONE_FN(2)
+DONE_FN(3)
+DONE_FN(4)
+DONE_FN(5)
+DONE_FN(6)
+DONE_FN(7)
+DONE_FN(8)
+
+static const spiDoneFn DoneFn[SPI_QUEUE_LEN + 1] = { Done0, Done1, Done2, Done3,
+		Done4, Done5, Done6, Done7, Done8 };
+
+static uint32 Failures;
+
+static void Check(boolean ok, const char * s) {
+
+	printf("  %-56s %s\n", s, ok ? "ok" : "FAILED");
+	if (!ok)
+		Failures++;
+
+} // Check
+
+static void WaitDone(uint8 n) {
+
+	while (DoneN < n)
+		SITLAdvance(1);
+
+} // WaitDone
+
+#define SITL_SPI_BENCH	100000
+
+int SITLSPITest(void) {
+	static const struct {
+		GPIO_TypeDef * Port;
+		uint16 Pin;
+	} V4Sel[4] = { { GPIOB, GPIO_Pin_12 }, { GPIOC, GPIO_Pin_5 },
+			{ GPIOC, GPIO_Pin_4 }, { GPIOC, GPIO_Pin_3 } };
+	uint8 B[SPI_QUEUE_LEN][SPI_DMA_MAX_LEN], W[SPI_QUEUE_LEN][3];
+	uint64 StartuS, StartnS;
+	real64 SyncnS, AsyncnS;
+	uint32 SyncuS, WireuS, BusuS, I2CuS, CacheduS, ReconfiguS, Reconfigs;
+	spiBusStruct * b;
+	boolean ok;
+	idx i, j;
+
+	SITLInitClock(0);
+	SITLStopuS = ~0ULL;
+
+	SPIPorts[1].Used = true; // V4 SPI2
+	SPIPorts[1].TxDMAStream = DMA1_Stream4;
+	SPIPorts[1].RxDMAStream = DMA1_Stream3;
+	SPIPorts[1].DMAChannel = DMA_Channel_0;
+	SPIPorts[1].RxDMAISR = DMA1_Stream3_IRQn;
+	for (i = 0; i < 4; i++) {
+		SPISelectPins[i].Port = V4Sel[i].Port;
+		SPISelectPins[i].Pin = V4Sel[i].Pin;
+		digitalWrite(&SPISelectPins[i], 1);
+	}
+
+	for (i = 0; i < MAX_SPI_DEVICES; i++)
+		for (j = 0; j < SITL_SPI_REGS; j++)
+			SITLSPIRegs[i][j] = (i << 5) ^ (j * 7);
+
+	printf("UAVX SITL SPI DMA transactions, SPI2 DMA1 Stream4 Tx/Stream3 Rx\n");
+
+	Check(spiInitDMA(1), "engine enabled");
+
+	// MPU6XXX acc/temperature/gyro burst
+
+	DoneN = 0;
+	StartuS = SITLuS;
+	ok = spiQueueRead(mpu60xxSel, MPU_RA_ACC_XOUT_H, 14, B[0], DoneFn[0]);
+	Check(ok && (DoneN == 0) && !spiIdle(), "burst queued and returns before completion");
+	WaitDone(1);
+	BusuS = (uint32) (SITLuS - StartuS);
+	WireuS = (uint32) ceilf(15 * 8.0f / (SITL_SPI_PCLK_MHZ / 4.0f));
+	Check(DoneOK[0] && !memcmp(B[0], &SITLSPIRegs[mpu60xxSel][MPU_RA_ACC_XOUT_H],
+			14), "burst data and completion callback");
+	Check(spiIdle() && (SPISelectPins[mpu60xxSel].Port->ODR
+			& SPISelectPins[mpu60xxSel].Pin), "bus idle and chip select released");
+
+	// queue order, writes and overflow
+
+	DoneN = 0;
+	for (i = 0; i < SPI_QUEUE_LEN; i++)
+		if (i & 1) {
+			for (j = 0; j < 3; j++)
+				W[i][j] = 0xa0 + i + j;
+			spiQueueWrite(hmc5xxxSel, 0x20 + i * 4, 3, W[i], DoneFn[i]);
+		} else
+			spiQueueRead((i & 2) ? hmc5xxxSel : mpu60xxSel, 0x10 + i, 4 + i, B[i],
+					DoneFn[i]);
+	ok = !spiQueueWrite(memSel, 0, 1, W[0], DoneFn[SPI_QUEUE_LEN]);
+	Check(ok && (spiDMAStats.Overflows == 1) && (spiDMAStats.MaxQueue
+			== SPI_QUEUE_LEN), "full queue rejects and counts overflow");
+	spiWaitIdle();
+
+	ok = DoneN == SPI_QUEUE_LEN;
+	for (i = 0; i < DoneN; i++)
+		ok &= (DoneOrder[i] == i) && DoneOK[i];
+	Check(ok, "callbacks in queue order");
+
+	ok = true;
+	for (i = 0; i < SPI_QUEUE_LEN; i++)
+		if (i & 1)
+			ok &= !memcmp(W[i], &SITLSPIRegs[hmc5xxxSel][0x20 + i * 4], 3);
+		else
+			ok &= !memcmp(B[i], &SITLSPIRegs[(i & 2) ? hmc5xxxSel : mpu60xxSel][0x10
+					+ i], 4 + i);
+	Check(ok, "read data and writes landed");
+
+	// DMA transfer error then recovery
+
+	DoneN = 0;
+	SITLSPI.InjectFaults = 1;
+	spiQueueRead(hmc5xxxSel, 3, 6, B[0], DoneFn[0]);
+	spiQueueRead(hmc5xxxSel, 3, 6, B[1], DoneFn[1]);
+	spiWaitIdle();
+	Check((DoneN == 2) && !DoneOK[0] && DoneOK[1] && (spiDMAStats.Errors == 1),
+			"transfer error fails its callback only");
+
+	// stalled transfer times out
+
+	DoneN = 0;
+	SITLSPI.InjectStalls = 1;
+	StartuS = SITLuS;
+	spiQueueRead(mpu60xxSel, MPU_RA_ACC_XOUT_H, 14, B[0], DoneFn[0]);
+	spiQueueRead(mpu60xxSel, MPU_RA_ACC_XOUT_H, 14, B[1], DoneFn[1]);
+	spiWaitIdle();
+	Check((DoneN == 2) && !DoneOK[0] && DoneOK[1] && (spiDMAStats.Timeouts
+			== 1) && ((SITLuS - StartuS) > SPI_DMA_TIMEOUT_US),
+			"stall times out and the queue moves on");
+	Check(spiErrors == 2, "errors and timeouts counted as SPI failures");
+
+	// blocking transfers wait for the queue
+
+	DoneN = 0;
+	spiQueueRead(mpu60xxSel, MPU_RA_ACC_XOUT_H, 14, B[0], DoneFn[0]);
+	StartuS = SITLuS;
+	spiReadBlock(hmc5xxxSel, 0, 0, 6, B[1]);
+	SyncuS = (uint32) (SITLuS - StartuS);
+	Check((DoneN == 1) && DoneOK[0] && (SITLSPI.BusFaults == 0),
+			"blocking read waits for queue, no chip select overlap");
+
+	// bus manager - the port is only reconfigured on a rate change, polled transfers wait
+	// for the queue and queued transfers wait for a polled owner
+
+	b = &spiBus[1];
+	spiBusCycleStart();
+	spiReadBlock(mpu60xxSel, 0, MPU_RA_ACC_XOUT_H, 14, B[1]);
+	Reconfigs = b->Reconfigs;
+	StartuS = SITLuS;
+	spiReadBlock(mpu60xxSel, 0, MPU_RA_ACC_XOUT_H, 14, B[1]);
+	CacheduS = (uint32) (SITLuS - StartuS);
+	spiReadBlock(ms56xxSel, 0, 0, 3, B[1]);
+	Check(b->Reconfigs == Reconfigs, "same rate transfers skip reconfiguration");
+
+	W[0][0] = 0;
+	spiWriteBlock(mpu60xxSel, 0, 0x7f, 1, W[0]);
+	StartuS = SITLuS;
+	spiReadBlock(mpu60xxSel, 0, MPU_RA_ACC_XOUT_H, 14, B[1]);
+	ReconfiguS = (uint32) (SITLuS - StartuS);
+	Check((b->Reconfigs == Reconfigs + 2) && (b->ConfigDev == mpu60xxSel + 1),
+			"rate change reconfigures");
+
+	DoneN = 0;
+	spiQueueRead(mpu60xxSel, MPU_RA_ACC_XOUT_H, 14, B[0], DoneFn[0]);
+	spiReadBlock(memSel, 0, 0, 8, B[1]);
+	Check((DoneN == 1) && (b->CycleWaituS > 0) && (b->CSConflicts == 0)
+			&& (SITLSPI.BusFaults == 0), "log read waits for sensor burst");
+
+	DoneN = 0;
+	spiAcquire(memSel, true);
+	spiQueueRead(mpu60xxSel, MPU_RA_ACC_XOUT_H, 14, B[0], DoneFn[0]);
+	SITLAdvance(100);
+	ok = (DoneN == 0) && (b->Owner == memSel + 1);
+	spiRelease(memSel);
+	WaitDone(1);
+	Check(ok && DoneOK[0] && (SITLSPI.BusFaults == 0),
+			"queued burst held until polled owner releases");
+
+	spiBusCycleStart();
+	Check((b->MaxCycleReconfigs >= 2) && (b->MaxCycleWaituS > 0)
+			&& (b->CycleReconfigs == 0) && (b->CycleWaituS == 0),
+			"per cycle reconfiguration and wait counters");
+
+	// cost - the blocking read charges only its delays so the wire time is added
+
+	StartuS = SITLuS;
+	spiReadBlock(mpu60xxSel, 0, MPU_RA_ACC_XOUT_H, 14, B[1]);
+	SyncuS = (uint32) (SITLuS - StartuS) + WireuS;
+
+	StartnS = SITLHostnS();
+	for (i = 0; i < SITL_SPI_BENCH; i++)
+		spiReadBlock(mpu60xxSel, 0, MPU_RA_ACC_XOUT_H, 14, B[1]);
+	SyncnS = (real64) (SITLHostnS() - StartnS) / SITL_SPI_BENCH;
+
+	AsyncnS = 0;
+	for (i = 0; i < SITL_SPI_BENCH; i++) {
+		DoneN = 0;
+		StartnS = SITLHostnS();
+		spiQueueRead(mpu60xxSel, MPU_RA_ACC_XOUT_H, 14, B[0], DoneFn[0]);
+		AsyncnS += SITLHostnS() - StartnS;
+		SITLuS += WireuS;
+		StartnS = SITLHostnS();
+		SITLAdvance(0); // completion ISR
+		AsyncnS += SITLHostnS() - StartnS;
+	}
+	AsyncnS /= SITL_SPI_BENCH;
+	Check(spiIdle() && (spiDMAStats.Completed >= SITL_SPI_BENCH), "bench bursts completed");
+
+	I2CuS = (uint32) ((3 + 14) * 9 * SITL_I2C_BIT_US);
+
+	printf("  14 byte burst: bus %uuS (wire %uuS at 10.5MHz), queue high water %u\n",
+			BusuS, WireuS, spiDMAStats.MaxQueue);
+	printf("  main loop blocked per burst: polled %uuS (delays and wire), DMA none -\n"
+		"    queue and ISR %.0f host ns including the bus model (polled %.0f host ns)\n",
+			SyncuS, AsyncnS, SyncnS);
+	printf("  V3 I2C burst at %ukHz for comparison ~%uuS\n", I2C_CLOCK_HZ / 1000,
+			I2CuS);
+	printf("  queued %u completed %u errors %u timeouts %u overflows %u\n",
+			spiDMAStats.Queued, spiDMAStats.Completed, spiDMAStats.Errors,
+			spiDMAStats.Timeouts, spiDMAStats.Overflows);
+	printf("  polled 14 byte read delays: %uuS same rate, %uuS after a rate change\n",
+			CacheduS, ReconfiguS);
+	printf("  bus: %u acquires %u reconfigurations, per cycle max %u and %uuS waiting\n",
+			b->Acquires, b->Reconfigs, b->MaxCycleReconfigs, b->MaxCycleWaituS);
+
+	return (Failures == 0 ? 0 : 1);
+} // SITLSPITest
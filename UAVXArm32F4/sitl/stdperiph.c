@@ -0,0 +1,432 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+// SITL stand-in for the parts of the ST peripheral library used by the flight code. Each
+// call works on the RAM backed registers with the same set/clear semantics as the library
+// so the flight code and the SITL dispatcher see consistent peripheral state.
+
+#include "UAVX.h"
+#include "sitl.h"
+
+uint32 SITLTxBytes[MAX_SERIAL_PORTS];
+
+static void SetBits(volatile uint32 * r, uint32 m, FunctionalState NewState) {
+
+	if (NewState != DISABLE)
+		*r |= m;
+	else
+		*r &= ~m;
+
+} // SetBits
+
+static void SetBits16(volatile uint16 * r, uint16 m, FunctionalState NewState) {
+
+	if (NewState != DISABLE)
+		*r |= m;
+	else
+		*r &= ~m;
+
+} // SetBits16
+
+//______________________________________________________________________________________________
+
+// RCC, GPIO and NVIC
+
+void RCC_AHB1PeriphClockCmd(uint32_t RCC_AHB1Periph, FunctionalState NewState) {
+	SetBits(&RCC->AHB1ENR, RCC_AHB1Periph, NewState);
+} // RCC_AHB1PeriphClockCmd
+
+void RCC_APB2PeriphClockCmd(uint32_t RCC_APB2Periph, FunctionalState NewState) {
+	SetBits(&RCC->APB2ENR, RCC_APB2Periph, NewState);
+} // RCC_APB2PeriphClockCmd
+
+void GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_InitStruct) {
+	uint32 p;
+
+	for (p = 0; p < 16; p++)
+		if (GPIO_InitStruct->GPIO_Pin & (1 << p)) {
+			GPIOx->MODER &= ~(GPIO_MODER_MODER0 << (p * 2));
+			GPIOx->MODER |= (uint32) GPIO_InitStruct->GPIO_Mode << (p * 2);
+		}
+
+} // GPIO_Init
+
+void GPIO_PinAFConfig(GPIO_TypeDef* GPIOx, uint16_t GPIO_PinSource,
+		uint8_t GPIO_AF) {
+	uint32 s;
+
+	s = (GPIO_PinSource & 7) * 4;
+	GPIOx->AFR[GPIO_PinSource >> 3] &= ~(0xf << s);
+	GPIOx->AFR[GPIO_PinSource >> 3] |= (uint32) GPIO_AF << s;
+
+} // GPIO_PinAFConfig
+
+void NVIC_Init(NVIC_InitTypeDef* NVIC_InitStruct) {
+	uint8 n;
+
+	n = NVIC_InitStruct->NVIC_IRQChannel;
+	if (NVIC_InitStruct->NVIC_IRQChannelCmd != DISABLE)
+		NVIC->ISER[n >> 5] |= 1 << (n & 0x1f);
+	else
+		NVIC->ISER[n >> 5] &= ~(1 << (n & 0x1f));
+
+} // NVIC_Init
+
+//______________________________________________________________________________________________
+
+// Timers - counters are not modelled, captures are loaded by the SITL dispatcher
+
+void TIM_TimeBaseInit(TIM_TypeDef* TIMx,
+		TIM_TimeBaseInitTypeDef* TIM_TimeBaseInitStruct) {
+
+	TIMx->ARR = TIM_TimeBaseInitStruct->TIM_Period;
+	TIMx->PSC = TIM_TimeBaseInitStruct->TIM_Prescaler;
+
+} // TIM_TimeBaseInit
+
+void TIM_SetCounter(TIM_TypeDef* TIMx, uint32_t Counter) {
+	TIMx->CNT = Counter;
+} // TIM_SetCounter
+
+void TIM_ARRPreloadConfig(TIM_TypeDef* TIMx, FunctionalState NewState) {
+	SetBits16(&TIMx->CR1, TIM_CR1_ARPE, NewState);
+} // TIM_ARRPreloadConfig
+
+void TIM_Cmd(TIM_TypeDef* TIMx, FunctionalState NewState) {
+	SetBits16(&TIMx->CR1, TIM_CR1_CEN, NewState);
+} // TIM_Cmd
+
+void TIM_OC1Init(TIM_TypeDef* TIMx, TIM_OCInitTypeDef* TIM_OCInitStruct) {
+	TIMx->CCR1 = TIM_OCInitStruct->TIM_Pulse;
+} // TIM_OC1Init
+
+void TIM_OCStructInit(TIM_OCInitTypeDef* TIM_OCInitStruct) {
+	memset(TIM_OCInitStruct, 0, sizeof(TIM_OCInitTypeDef));
+} // TIM_OCStructInit
+
+void TIM_OC1PreloadConfig(TIM_TypeDef* TIMx, uint16_t TIM_OCPreload) {
+} // TIM_OC1PreloadConfig
+
+void TIM_CCxCmd(TIM_TypeDef* TIMx, uint16_t TIM_Channel, uint16_t TIM_CCx) {
+
+	TIMx->CCER &= ~(TIM_CCER_CC1E << TIM_Channel);
+	TIMx->CCER |= TIM_CCx << TIM_Channel;
+
+} // TIM_CCxCmd
+
+void TIM_ICInit(TIM_TypeDef* TIMx, TIM_ICInitTypeDef* TIM_ICInitStruct) {
+
+	TIMx->CCER |= TIM_CCER_CC1E << TIM_ICInitStruct->TIM_Channel;
+
+} // TIM_ICInit
+
+uint32_t TIM_GetCapture1(TIM_TypeDef* TIMx) {
+	return (TIMx->CCR1);
+} // TIM_GetCapture1
+
+uint32_t TIM_GetCapture2(TIM_TypeDef* TIMx) {
+	return (TIMx->CCR2);
+} // TIM_GetCapture2
+
+uint32_t TIM_GetCapture3(TIM_TypeDef* TIMx) {
+	return (TIMx->CCR3);
+} // TIM_GetCapture3
+
+uint32_t TIM_GetCapture4(TIM_TypeDef* TIMx) {
+	return (TIMx->CCR4);
+} // TIM_GetCapture4
+
+void TIM_CtrlPWMOutputs(TIM_TypeDef* TIMx, FunctionalState NewState) {
+	SetBits16(&TIMx->BDTR, TIM_BDTR_MOE, NewState);
+} // TIM_CtrlPWMOutputs
+
+void TIM_ITConfig(TIM_TypeDef* TIMx, uint16_t TIM_IT, FunctionalState NewState) {
+	SetBits16(&TIMx->DIER, TIM_IT, NewState);
+} // TIM_ITConfig
+
+ITStatus TIM_GetITStatus(TIM_TypeDef* TIMx, uint16_t TIM_IT) {
+	return (((TIMx->SR & TIM_IT) && (TIMx->DIER & TIM_IT)) ? SET : RESET);
+} // TIM_GetITStatus
+
+void TIM_ClearITPendingBit(TIM_TypeDef* TIMx, uint16_t TIM_IT) {
+	TIMx->SR = (uint16_t) ~TIM_IT;
+} // TIM_ClearITPendingBit
+
+void TIM_DMACmd(TIM_TypeDef* TIMx, uint16_t TIM_DMASource,
+		FunctionalState NewState) {
+	SetBits16(&TIMx->DIER, TIM_DMASource, NewState);
+} // TIM_DMACmd
+
+//______________________________________________________________________________________________
+
+// DMA - stream flags live in the real LISR/HISR bits and are cleared through LIFCR/HIFCR
+// or the library. Only SPI transfers are modelled (spi.c), other streams stay idle.
+
+static DMA_TypeDef * DMAController(DMA_Stream_TypeDef* DMAy_Streamx) {
+	return (((uint32) DMAy_Streamx < DMA2_BASE) ? DMA1 : DMA2);
+} // DMAController
+
+// flag clear registers are write only on the target
+
+void SITLApplyDMAClears(void) {
+
+	DMA1->LISR &= ~DMA1->LIFCR;
+	DMA1->HISR &= ~DMA1->HIFCR;
+	DMA2->LISR &= ~DMA2->LIFCR;
+	DMA2->HISR &= ~DMA2->HIFCR;
+	DMA1->LIFCR = DMA1->HIFCR = DMA2->LIFCR = DMA2->HIFCR = 0;
+
+} // SITLApplyDMAClears
+
+void DMA_StructInit(DMA_InitTypeDef* DMA_InitStruct) {
+	memset(DMA_InitStruct, 0, sizeof(DMA_InitTypeDef));
+} // DMA_StructInit
+
+void DMA_DeInit(DMA_Stream_TypeDef* DMAy_Streamx) {
+
+	DMAy_Streamx->CR = DMAy_Streamx->NDTR = 0;
+	DMAy_Streamx->PAR = DMAy_Streamx->M0AR = 0;
+
+} // DMA_DeInit
+
+void DMA_Init(DMA_Stream_TypeDef* DMAy_Streamx, DMA_InitTypeDef* DMA_InitStruct) {
+
+	DMAy_Streamx->NDTR = DMA_InitStruct->DMA_BufferSize;
+	DMAy_Streamx->PAR = DMA_InitStruct->DMA_PeripheralBaseAddr;
+	DMAy_Streamx->M0AR = DMA_InitStruct->DMA_Memory0BaseAddr;
+	DMAy_Streamx->CR = (DMAy_Streamx->CR & ~DMA_SxCR_DIR)
+			| DMA_InitStruct->DMA_DIR;
+
+} // DMA_Init
+
+void DMA_Cmd(DMA_Stream_TypeDef* DMAy_Streamx, FunctionalState NewState) {
+	SetBits(&DMAy_Streamx->CR, DMA_SxCR_EN, NewState);
+} // DMA_Cmd
+
+void DMA_SetCurrDataCounter(DMA_Stream_TypeDef* DMAy_Streamx, uint16_t Counter) {
+	DMAy_Streamx->NDTR = Counter;
+} // DMA_SetCurrDataCounter
+
+uint16_t DMA_GetCurrDataCounter(DMA_Stream_TypeDef* DMAy_Streamx) {
+	return (DMAy_Streamx->NDTR);
+} // DMA_GetCurrDataCounter
+
+FunctionalState DMA_GetCmdStatus(DMA_Stream_TypeDef* DMAy_Streamx) {
+	return ((DMAy_Streamx->CR & DMA_SxCR_EN) ? ENABLE : DISABLE);
+} // DMA_GetCmdStatus
+
+void DMA_ITConfig(DMA_Stream_TypeDef* DMAy_Streamx, uint32_t DMA_IT,
+		FunctionalState NewState) {
+	SetBits(&DMAy_Streamx->CR, DMA_IT & 0x1e, NewState);
+} // DMA_ITConfig
+
+#define DMA_IT_MASK		0x0f7d0f7d
+#define DMA_IT_HIGH		0x20000000
+
+ITStatus DMA_GetITStatus(DMA_Stream_TypeDef* DMAy_Streamx, uint32_t DMA_IT) {
+	DMA_TypeDef * d;
+
+	SITLApplyDMAClears();
+
+	d = DMAController(DMAy_Streamx);
+	return ((((DMA_IT & DMA_IT_HIGH) ? d->HISR : d->LISR) & DMA_IT & DMA_IT_MASK)
+			? SET : RESET);
+} // DMA_GetITStatus
+
+void DMA_ClearITPendingBit(DMA_Stream_TypeDef* DMAy_Streamx, uint32_t DMA_IT) {
+	DMA_TypeDef * d;
+
+	d = DMAController(DMAy_Streamx);
+	if (DMA_IT & DMA_IT_HIGH)
+		d->HISR &= ~(DMA_IT & DMA_IT_MASK);
+	else
+		d->LISR &= ~(DMA_IT & DMA_IT_MASK);
+
+} // DMA_ClearITPendingBit
+
+//______________________________________________________________________________________________
+
+// SPI - polled transfers complete immediately and read 0xff, DMA transfers are clocked
+// through the device register files in spi.c
+
+void SPI_Cmd(SPI_TypeDef* SPIx, FunctionalState NewState) {
+
+	SetBits16(&SPIx->CR1, SPI_CR1_SPE, NewState);
+	SetBits16(&SPIx->SR, SPI_I2S_FLAG_TXE | SPI_I2S_FLAG_RXNE, NewState);
+
+} // SPI_Cmd
+
+uint16_t SPI_I2S_ReceiveData(SPI_TypeDef* SPIx) {
+	return (0xff);
+} // SPI_I2S_ReceiveData
+
+void SPI_I2S_SendData(SPI_TypeDef* SPIx, uint16_t Data) {
+	SPIx->DR = Data;
+} // SPI_I2S_SendData
+
+FlagStatus SPI_I2S_GetFlagStatus(SPI_TypeDef* SPIx, uint16_t SPI_I2S_FLAG) {
+	return ((SPI_I2S_FLAG == SPI_I2S_FLAG_BSY) ? RESET : SET);
+} // SPI_I2S_GetFlagStatus
+
+void SPI_I2S_DMACmd(SPI_TypeDef* SPIx, uint16_t SPI_I2S_DMAReq,
+		FunctionalState NewState) {
+
+	SetBits16(&SPIx->CR2, SPI_I2S_DMAReq, NewState);
+	if (SPI_I2S_DMAReq & SPI_I2S_DMAReq_Tx) {
+		if (NewState != DISABLE)
+			SITLSPIStartDMA(SPIx);
+		else
+			SITLSPIStopDMA();
+	}
+
+} // SPI_I2S_DMACmd
+
+//______________________________________________________________________________________________
+
+// USART - transmission is instantaneous, TXE is always set
+
+static uint8 USARTPort(USART_TypeDef* USARTx) {
+	uint8 s;
+
+	for (s = 0; s < MAX_SERIAL_PORTS; s++)
+		if (SerialPorts[s].USART == USARTx)
+			break;
+
+	return (s);
+} // USARTPort
+
+void USART_Cmd(USART_TypeDef* USARTx, FunctionalState NewState) {
+	SetBits16(&USARTx->CR1, USART_CR1_UE, NewState);
+} // USART_Cmd
+
+void USART_SendData(USART_TypeDef* USARTx, uint16_t Data) {
+	uint8 s;
+
+	USARTx->DR = Data & 0x1ff;
+
+	s = USARTPort(USARTx);
+	if (s < MAX_SERIAL_PORTS) {
+		SITLTxBytes[s]++;
+		if ((s == TelemetrySerial) && (SITLTelemetryFile != NULL))
+			fputc(Data & 0xff, SITLTelemetryFile);
+	}
+
+} // USART_SendData
+
+uint16_t USART_ReceiveData(USART_TypeDef* USARTx) {
+
+	USARTx->SR &= ~USART_FLAG_RXNE;
+
+	return (USARTx->DR & 0x1ff);
+} // USART_ReceiveData
+
+void USART_ITConfig(USART_TypeDef* USARTx, uint16_t USART_IT,
+		FunctionalState NewState) {
+	uint32 usartreg, itmask;
+
+	usartreg = (USART_IT & 0xff) >> 5;
+	itmask = 1 << (USART_IT & 0x1f);
+
+	if (usartreg == 1)
+		SetBits16(&USARTx->CR1, itmask, NewState);
+	else if (usartreg == 2)
+		SetBits16(&USARTx->CR2, itmask, NewState);
+	else
+		SetBits16(&USARTx->CR3, itmask, NewState);
+
+	// the transmit interrupt is taken at once unless masked or already in an ISR
+	if ((USART_IT == USART_IT_TXE) && (NewState != DISABLE) && !SITLInISR
+			&& !SITLPRIMASK) {
+		SITLInISR = true;
+		SITLServiceUSART(USARTPort(USARTx));
+		SITLInISR = false;
+	}
+
+} // USART_ITConfig
+
+FlagStatus USART_GetFlagStatus(USART_TypeDef* USARTx, uint16_t USART_FLAG) {
+	return ((USARTx->SR & USART_FLAG) ? SET : RESET);
+} // USART_GetFlagStatus
+
+ITStatus USART_GetITStatus(USART_TypeDef* USARTx, uint16_t USART_IT) {
+	uint32 usartreg, itmask, cr;
+
+	usartreg = (USART_IT & 0xff) >> 5;
+	itmask = 1 << (USART_IT & 0x1f);
+
+	cr = (usartreg == 1) ? USARTx->CR1 : ((usartreg == 2) ? USARTx->CR2
+			: USARTx->CR3);
+
+	return (((cr & itmask) && (USARTx->SR & (1 << (USART_IT >> 8)))) ? SET
+			: RESET);
+} // USART_GetITStatus
+
+//______________________________________________________________________________________________
+
+// Flash - programming acts directly on the RAM backed flash region. Typical STM32F405
+// x32 erase and program times are charged as the CPU stalls on instruction fetch.
+
+static const uint32 SectorKB[] = { 16, 16, 16, 16, 64, 128, 128, 128, 128, 128,
+		128, 128 };
+static const uint32 SectorEraseuS[] = { 250000, 250000, 250000, 250000, 550000,
+		1100000, 1100000, 1100000, 1100000, 1100000, 1100000, 1100000 };
+
+#define SITL_FLASH_WORD_US	16
+
+void FLASH_Unlock(void) {
+	FLASH->CR &= ~FLASH_CR_LOCK;
+} // FLASH_Unlock
+
+void FLASH_Lock(void) {
+	FLASH->CR |= FLASH_CR_LOCK;
+} // FLASH_Lock
+
+void FLASH_ClearFlag(uint32_t FLASH_FLAG) {
+	FLASH->SR = FLASH_FLAG;
+} // FLASH_ClearFlag
+
+FLASH_Status FLASH_EraseSector(uint32_t FLASH_Sector, uint8_t VoltageRange) {
+	uint32 a, s, i;
+
+	if (FLASH->CR & FLASH_CR_LOCK)
+		return (FLASH_ERROR_PROGRAM);
+
+	s = FLASH_Sector >> 3;
+	a = SITL_FLASH_BASE;
+	for (i = 0; i < s; i++)
+		a += SectorKB[i] * 1024;
+
+	memset((void *) (uintptr_t) a, 0xff, SectorKB[s] * 1024);
+	SITLAdvance(SectorEraseuS[s]);
+
+	return (FLASH_COMPLETE);
+} // FLASH_EraseSector
+
+FLASH_Status FLASH_ProgramWord(uint32_t Address, uint32_t Data) {
+
+	if (FLASH->CR & FLASH_CR_LOCK)
+		return (FLASH_ERROR_PROGRAM);
+
+	*(volatile uint32 *) (uintptr_t) Address &= Data; // can only clear bits
+	SITLAdvance(SITL_FLASH_WORD_US);
+
+	return (FLASH_COMPLETE);
+} // FLASH_ProgramWord
+
@@ -57,6 +57,9 @@
 
 #define INC_BARO_FULL_MATH
 
+#define USE_GYRO_OVERSAMPLING // gyro read at a multiple of the control cycle rate
+#define USE_GYRO_NOTCH // gyro spectrum steers notches onto motor noise
+
 #endif
 
 #define VOLT_MEASUREMENT_ONBOARD
@@ -66,7 +69,9 @@
 //__________________
 
 
-//#define MPU6XXX_INT
+//#define USE_MPU6XXX_INT // V4 only - MPU6XXX data ready starts the control cycle
+#define USE_SPI_DMA // MPU6XXX burst read by DMA overlapped with the drive update - SPI boards only
+//#define USE_MPU6XXX_FIFO // MPU6XXX samples at 1KHz drained from its FIFO each cycle and averaged
 //#define HMC5XXX_INT
 
 //#define BRICE // Drotek IMU
@@ -77,6 +82,14 @@
 
 //#define TEST_MAGVAR
 
+#if defined(USE_MPU6XXX_INT) && !defined(V4_BOARD)
+#error "USE_MPU6XXX_INT needs the MPU6XXX interrupt line of the V4 board"
+#endif
+
+#if defined(USE_MPU6XXX_INT) && defined(USE_MPU6XXX_FIFO)
+#error "USE_MPU6XXX_INT and USE_MPU6XXX_FIFO both set the MPU6XXX sample rate"
+#endif
+
 
 //________________________________________________________________________________________________
 
@@ -118,7 +131,9 @@
 
 
 #include "main.h"
+#include "fastmath.h"
 #include "filters.h"
+#include "ring.h"
 #include "alarms.h"
 #include "analog.h"
 #include "airspeed.h"
@@ -135,6 +150,8 @@
 #include "gps.h"
 #include "imu.h"
 #include "inertial.h"
+#include "eskf.h"
+#include "jobs.h"
 #include "mpu6xxx.h"
 #include "isr.h"
 #include "i2c.h"
@@ -148,10 +165,13 @@
 #include "mixer.h"
 #include "outputs.h"
 #include "params.h"
+#include "profile.h"
 #include "serial.h"
 #include "sio.h"
 #include "spi.h"
+#include "spectrum.h"
 #include "rc.h"
+#include "scheduler.h"
 #include "spiflash.h"
 #include "stats.h"
 #include "telemetry.h"
@@ -35,12 +35,11 @@ enum ASStatusFlags {
 	ASNormal, ASStale, ASError
 };
 
-void ReadASDiffPressureI2C(void) {
-
 #define ASP_LEN 5
-	static int16 s = 0;
-	real32 a[ASP_LEN];
 
+static MedianFilterStruct ASPMedianF;
+
+void ReadASDiffPressureI2C(void) {
 	const real32 AirDensityMSL = 1.2041f; // @ 20C
 	const real32 PSIToPascal = 6894.75729;
 	real32 RawASPressure = 0;
@@ -70,30 +69,25 @@ void ReadASDiffPressureI2C(void) {
 	uint8 ASStatus = (B[0] >> 6) & 0x03;
 	if (ASStatus == ASNormal) {
 
-		if (s >= ASP_LEN) {
-
-			ASP = median(a, ASP_LEN);
-			s = 0;
+		ASP = MedianFilter(&ASPMedianF, RawASPressure);
 
-			//ASPressure = -((RawASPressure - 0.1f*16383) * (P_max-P_min)/(0.8f*16383) + P_min);
-			ASP *= PSIToPascal;
-			ASTemperature = ((200.0f * RawASTemperature) / 2047) - 50;
+		//ASPressure = -((RawASPressure - 0.1f*16383) * (P_max-P_min)/(0.8f*16383) + P_min);
+		ASP *= PSIToPascal;
+		ASTemperature = ((200.0f * RawASTemperature) / 2047) - 50;
 
-			//ASPressure = (double) ((RawASPressure - 819.15) / (14744.7));
-			ASPressure = (real32) RawASPressure * 1.052;
-			//ASPressure = ASPressure - 0.49060678;
-			ASPressure = Abs(ASPressure); // deals with port swap??
-			Airspeed = sqrt((ASPressure * 13789.5144) / 1.225); // @ 15C
+		//ASPressure = (double) ((RawASPressure - 819.15) / (14744.7));
+		ASPressure = (real32) RawASPressure * 1.052f;
+		//ASPressure = ASPressure - 0.49060678;
+		ASPressure = Abs(ASPressure); // deals with port swap??
+		Airspeed = sqrtf((ASPressure * 13789.5144f) / 1.225f); // @ 15C
 
-			Airspeed = sqrtf(2.0f * (ASPressure / AirDensityMSL));
+		Airspeed = sqrtf(2.0f * (ASPressure / AirDensityMSL));
 
-			//	return (1.0f - powf((P / 101325.0f), 0.190295f)) * 44330.0f; // 5.5uS //66uS DP!
+		//	return (1.0f - powf((P / 101325.0f), 0.190295f)) * 44330.0f; // 5.5uS //66uS DP!
 
-			ASTemperature = (real32) RawASTemperatureHR * 0.09770395701;
-			ASTemperature = ASTemperature - 50;
+		ASTemperature = (real32) RawASTemperatureHR * 0.09770395701f;
+		ASTemperature = ASTemperature - 50;
 
-		} else
-			a[s++] = RawASPressure;
 	} else {
 
 		// error
@@ -108,6 +102,7 @@ uint32 NextASUpdatemS = 0;
 
 void InitASDiffPressureI2C(void) {
 
+	InitMedianFilter(&ASPMedianF, ASP_LEN);
 	sioWrite(SIOAS, MS4525_ID, 0, 0); // 8.4mS to first data
 
 	NextASUpdatemS = mSClock() + 9;
@@ -117,7 +112,7 @@ void InitASDiffPressureI2C(void) {
 
 void UpdateAirspeed(void) {
 
-	if (mSClock() > NextASUpdatemS) { // use mS[]
+	if (TimeReached(mSClock(), NextASUpdatemS)) { // use mS[]
 
 		NextASUpdatemS += 500; // make faster with filter and out of bound checks
 
@@ -63,7 +63,8 @@ boolean Armed(void) {
 	boolean NewUplinkState, IsArmed;
 
 	if ((ArmingSwitch != SwitchP) && (State != InFlight)) {
-		DoBeep(3, 0);
+		mSTimer(mSClock(), BeeperTimeout, 150); // was DoBeep(3, 0) - called from telemetry
+		BeeperOn();
 		SwitchP = ArmingSwitch;
 	}
 
@@ -77,8 +78,7 @@ boolean Armed(void) {
 	NewUplinkState = !((GPSRxSerial == TelemetrySerial) && IsArmed);
 	if (F.UsingUplink != NewUplinkState) {
 		RxEnabled[TelemetrySerial] = false;
-		RxQNewHead[TelemetrySerial] = RxQHead[TelemetrySerial]
-				= RxQTail[TelemetrySerial] = 0;
+		ringFlush(&RxRing[TelemetrySerial]);
 		RxEnabled[TelemetrySerial] = true;
 		F.UsingUplink = NewUplinkState;
 	}
@@ -113,15 +113,10 @@ boolean FailPreflight(void) {
 } // FailPreflight
 
 
-void DoCalibrationAlarm(void) {
-	static uint32 TimeoutmS = 0;
+void DoCalibrationAlarm(void) { // run by the scheduler at RG2Hz
 
-	if (!F.IMUCalibrated || !((F.MagnetometerActive && F.MagnetometerCalibrated) || F.IsFixedWing)) {
-		if (mSClock() > TimeoutmS) {
-			TimeoutmS = mSClock() + 500;
-			LEDToggle(LEDYellowSel);
-		}
-	}
+	if (!F.IMUCalibrated || !((F.MagnetometerActive && F.MagnetometerCalibrated) || F.IsFixedWing))
+		LEDToggle(LEDYellowSel);
 
 } // DoAccCalibrationAlarm
 
@@ -134,7 +129,7 @@ void DoBeep(uint8 t, uint8 d) {
 		Timeout = uSClock() + 500;
 		do {
 			GetBaro(); // hammer it to warm it up!
-		} while (uSClock() < Timeout);
+		} while (!TimeReached(uSClock(), Timeout));
 	}
 	BeeperOff();
 
@@ -142,7 +137,7 @@ void DoBeep(uint8 t, uint8 d) {
 		Timeout = uSClock() + 500;
 		do {
 			GetBaro();
-		} while (uSClock() < Timeout);
+		} while (!TimeReached(uSClock(), Timeout));
 	}
 } // DoBeep
 
@@ -179,7 +174,7 @@ void CheckAlarms(void) {
 			BeeperOnTime = 125;
 		}
 
-		if (mSClock() > mS[BeeperUpdate]) {
+		if (mSTimeout(mSClock(), BeeperUpdate)) {
 			if (BeeperIsOn()) {
 				mSTimer(mSClock(), BeeperUpdate, BeeperOffTime);
 				BeeperOff();
@@ -191,7 +186,7 @@ void CheckAlarms(void) {
 			}
 		}
 	} else {
-		if (mSClock() > mS[BeeperTimeout])
+		if (mSTimeout(mSClock(), BeeperTimeout))
 			BeeperOff();
 	}
 
@@ -220,7 +215,7 @@ boolean UpsideDownMulticopter(void) {
 				< CRASHED_ANGLE_RAD))
 			mSTimer(mSClock(), CrashedTimeout, CRASHED_TIMEOUT_MS);
 		else {
-			if ((mSClock() > mS[CrashedTimeout]) && (DesiredThrottle
+			if (mSTimeout(mSClock(), CrashedTimeout) && (DesiredThrottle
 					> IdleThrottle) && F.UsingAngleControl)
 				UpsideDown = true;
 		}
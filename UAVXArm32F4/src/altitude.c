@@ -41,7 +41,7 @@
 #endif
 
 const uint32 ms56xxSampleIntervaluS[] = { 1000, 1500, 2500, 5000, 10000 };
-//const uint32 ms56xxSampleIntervaluS[] = { 600, 1170, 2280, 4540, 9040 };
+const uint32 ms56xxConversionuS[] = { 600, 1170, 2280, 4540, 9040 }; // max
 
 uint16 ms56xx_c[8];
 int64 M[7];
@@ -57,14 +57,19 @@ uint32 NextBaroUpdateuS;
 real32 Airspeed;
 uint8 CurrRFSensorType;
 
-HistStruct AccZMAF, AccZLPF;
+MAFilterStruct AccZMAF;
+LPFilterStruct AccZLPF;
 real32 AltLPFHz;
 
 uint8 BaroType = MS5611Baro;
 
-HistStruct ROCLPF, BaroLPF, IRMAF, BaroMAF;
+LPFilterStruct ROCLPF, BaroLPF;
+MAFilterStruct IRMAF, BaroMAF;
 real32 FakeBaroAltitude;
 real32 AltdT, AltdTR;
+uint64 BaroSampleuS = 0; // capture time of BaroAltitude
+uint64 RangefinderSampleuS = 0;
+static volatile uint64 BaroConvStartuS = 0;
 
 const boolean UsingBeall = false; // AccZ gets bizarre so don't bother
 
@@ -85,6 +90,19 @@ void ZeroAltitude(void) {
 			= AccZMAF.Primed = AccZLPF.Primed = false;
 } // ZeroAltitude
 
+void InitAltitudeFilters(void) {
+
+	InitMAFilter(&AccZMAF, MA_FILTER_LEN);
+	InitLPFilter(&AccZLPF, 3, AltLPFHz, ms56xxSampleIntervaluS[MS56XX_OSR >> 1]
+			* 0.000001f);
+	InitMAFilter(&BaroMAF, MA_FILTER_LEN);
+	InitLPFilter(&BaroLPF, 3, AltLPFHz, ms56xxSampleIntervaluS[MS56XX_OSR >> 1]
+			* 0.000001f);
+	InitMAFilter(&IRMAF, MA_FILTER_LEN);
+	InitLPFilter(&ROCLPF, 1, AltLPFHz, ALT_UPDATE_MS * 0.001f);
+
+} // InitAltitudeFilters
+
 // -----------------------------------------------------------
 
 // Generic I2C Baro
@@ -93,6 +111,7 @@ void StartBaro(boolean ReadPressure) {
 
 	sioWriteBlock(SIOBaro, MS56XX_ID, ReadPressure ? MS56XX_PRESS : MS56XX_TEMP
 			| MS56XX_OSR, 0, 0);
+	BaroConvStartuS = uSClock64();
 
 } // StartBaro
 
@@ -231,11 +250,11 @@ void UpdateAccZ(real32 AccZdT) {
 
 	if (State == InFlight) // assume average vertical acceleration is zero
 		NV.AccCal.DynamicAccBias[Z] = NV.AccCal.DynamicAccBias[Z] * K_ACC_BIAS
-				+ AccZ * (1.0 - K_ACC_BIAS);
+				+ AccZ * (1.0f - K_ACC_BIAS);
 
-	AccZ = Smoothr32xn(&AccZMAF, MA_FILTER_LEN,
-			Limit1(GravityCompensatedAccZ(), GRAVITY_MPS_S * 2.0f));
-	AccZ = LPFilter(&AccZLPF, 3, AccZ, AltLPFHz, AccZdT);
+	AccZ = MAFilter(&AccZMAF, Limit1(GravityCompensatedAccZ(), GRAVITY_MPS_S
+			* 2.0f));
+	AccZ = LPFilterdT(&AccZLPF, AccZ, AccZdT);
 
 	AccZ -= NV.AccCal.DynamicAccBias[Z];
 
@@ -244,29 +263,84 @@ void UpdateAccZ(real32 AccZdT) {
 } // UpdateAccZ(void) {
 
 
+// The ADC read and the next conversion start are queued together, the read must come first,
+// and the result is collected on a later pass once its completion callback has run. A sample
+// is taken to have been captured half way through its conversion.
+
+enum BaroReadStates {
+	BaroReadIdle, BaroReadBusy, BaroReadReady, BaroReadFailed
+};
+
+static volatile uint8 BaroReadState = BaroReadIdle;
+static uint64 BaroReadSampleuS;
+static uint8 BaroReadB[3];
+static uint8 BaroStartCmd;
+static boolean BaroReadPressure;
+
+static void BaroReadDone(boolean ok) {
+
+	BaroReadState = ok ? BaroReadReady : BaroReadFailed;
+
+} // BaroReadDone
+
+static void BaroStartDone(boolean ok) {
+
+	BaroConvStartuS = uSClock64();
+
+} // BaroStartDone
+
+static void QueueBaroRead(void) {
+	static uint8 BaroPressCycles = 0;
+
+	BaroReadPressure = AcquiringPressure;
+
+	if (AcquiringPressure) {
+		if (++BaroPressCycles > 20) {
+			BaroPressCycles = 0;
+			AcquiringPressure = false;
+		}
+	} else
+		AcquiringPressure = true;
+
+	BaroStartCmd = AcquiringPressure ? MS56XX_PRESS : MS56XX_TEMP | MS56XX_OSR;
+
+	BaroReadSampleuS = BaroConvStartuS + (ms56xxConversionuS[MS56XX_OSR >> 1]
+			>> 1);
+
+	BaroReadState = BaroReadBusy;
+	if (!sioQueueRead(SIOBaro, MS56XX_ID, 0, 3, BaroReadB, BaroReadDone))
+		BaroReadState = BaroReadFailed;
+	sioQueueWrite(SIOBaro, MS56XX_ID, BaroStartCmd, 0, 0, BaroStartDone);
+
+} // QueueBaroRead
+
 void GetBaro(void) {
-	static uint32 LastBaroUpdateuS = 0;
 	static uint32 BaroTempVal = 0;
-	static uint8 BaroPressCycles = 0;
 	real32 BarodT;
-	uint32 NowuS;
 	uint32 BaroVal;
-	uint8 B[3];
 
 	static boolean Primed = false;
 
-	if (uSClock() > NextBaroUpdateuS) {
+	if (TimeReached(uSClock(), NextBaroUpdateuS) && (BaroReadState
+			== BaroReadIdle)) {
+		QueueBaroRead();
+		NextBaroUpdateuS = uSClock() + ms56xxSampleIntervaluS[MS56XX_OSR >> 1];
+	}
+
+	if (BaroReadState == BaroReadReady) {
 
-		sioReadBlock(SIOBaro, MS56XX_ID, 0, 3, B);
-		BaroVal = ((uint32) B[0] << 16) + ((uint32) B[1] << 8) + B[2];
+		BaroVal = ((uint32) BaroReadB[0] << 16) + ((uint32) BaroReadB[1] << 8)
+				+ BaroReadB[2];
 
-		if (AcquiringPressure) {
+		if (BaroReadPressure) {
 
 			BaroPressure = CompensateBaro(BaroTempVal, BaroVal);
 
-			NowuS = uSClock(); // should be no jitter in sioReadBlock?
-			BarodT = (NowuS - LastBaroUpdateuS) * 0.000001f;
-			LastBaroUpdateuS = NowuS;
+			if ((BaroSampleuS != 0) && (BaroReadSampleuS > BaroSampleuS))
+				BarodT = (BaroReadSampleuS - BaroSampleuS) * 0.000001f;
+			else
+				BarodT = ms56xxSampleIntervaluS[MS56XX_OSR >> 1] * 0.000001f;
+			BaroSampleuS = BaroReadSampleuS;
 
 			BaroRawAltitude = CalculateDensityAltitude(false, BaroPressure);
 
@@ -276,29 +350,21 @@ void GetBaro(void) {
 			BaroAltitude = SlewLimit(&BaroRawAltitudeP, BaroRawAltitude,
 					ALT_MAX_SLEW_M, BarodT);
 
-			BaroAltitude = Smoothr32xn(&BaroMAF, MA_FILTER_LEN, BaroAltitude);
-			BaroAltitude
-					= LPFilter(&BaroLPF, 3, BaroAltitude, AltLPFHz, BarodT);
+			BaroAltitude = MAFilter(&BaroMAF, BaroAltitude);
+			BaroAltitude = LPFilterdT(&BaroLPF, BaroAltitude, BarodT);
 
 			UpdateAccZ(BarodT); // stale ~180uS
 
 			if (BaroWarmupCycles > 0)
 				BaroWarmupCycles--;
 
-			if (++BaroPressCycles > 20) {
-				BaroPressCycles = 0;
-				AcquiringPressure = false;
-			}
-		} else {
+		} else
 			BaroTempVal = (BaroTempVal != 0) ? (uint32) ((uint64) BaroTempVal
 					* 127L + (uint64) BaroVal) >> 7 : BaroVal;
 
-			AcquiringPressure = true;
-		}
-		StartBaro(AcquiringPressure);
-
-		NextBaroUpdateuS = uSClock() + ms56xxSampleIntervaluS[MS56XX_OSR >> 1];
-	}
+		BaroReadState = BaroReadIdle;
+	} else if (BaroReadState == BaroReadFailed)
+		BaroReadState = BaroReadIdle; // conversion restarted, counted as I2CFailS
 
 } // GetBaro
 
@@ -403,25 +469,22 @@ void ReadSRFI2C(void) {
 
 } // ReadSRFI2C
 
-real32 SharpRFLookup(real32 r, uint8 Sel) {
 #define MEDIAN_LEN 31
+
+static MedianFilterStruct RFMedianF;
+
+real32 SharpRFLookup(real32 r, uint8 Sel) {
 	const real32 A[] = { 15.048f, 95.299 };
 	const real32 B[] = { -1.16f, -1.9197 };
 	//const real32 M[] = { 0.757, 0.666 };
 
-	static int16 s = 0;
-	real32 a[MEDIAN_LEN];
-	real32 v = 0.0f;
+	real32 v;
 
 	// MAJOR PROBLEM AS DISTANCE CURVE IS NOT MONOTONIC
 	//	if (RF[CurrRFSensorType].Min)
 
-	if (s >= MEDIAN_LEN) {
-		v = median(a, 31);
-		v = A[Sel] * powf(v, B[Sel]);
-		s = 0;
-	} else
-		a[s++] = r;
+	v = MedianFilter(&RFMedianF, r);
+	v = A[Sel] * powf(v, B[Sel]);
 
 	//if (r > M[Sel])
 	//	r = M[Sel];
@@ -467,10 +530,11 @@ void GetRangefinderAltitude(void) {
 
 	if (F.RangefinderActive) {
 
-		if (mSClock() >= mS[RangefinderUpdate]) {
+		if (mSTimeout(mSClock(), RangefinderUpdate)) {
 			mSTimer(mSClock(), RangefinderUpdate,
 					RF[CurrRFSensorType].intervalmS);
 
+			RangefinderSampleuS = uSClock64();
 			ReadRangefinder();
 
 			RFInRange = RangefinderAltitude <= RF[CurrRFSensorType].maxAlt;
@@ -523,8 +587,8 @@ void InitRangefinder(void) {
 			sioWrite(SIORF, SRFSONAR_ID, 81, 1);
 			break;
 		case SharpIRGP2Y0A02YK:
-			break;
 		case SharpIRGP2Y0A710K:
+			InitMedianFilter(&RFMedianF, MEDIAN_LEN);
 			break;
 		case UnknownRF:
 		default:
@@ -545,7 +609,7 @@ void InitRangefinder(void) {
 
 void SetDesiredAltitude(real32 Desired) {
 	Alt.P.Desired = Desired;
-	Alt.P.IntE = Alt.R.IntE = 0.0f; // ???
+	Alt.P.IntE = Alt.R.IntE = Alt.P.Sat = 0.0f; // ???
 } //SetDesiredAltitude
 
 real32 ConditionBaroAltitude(real32 BaroAltitude, real32 FAltitude) {
@@ -673,15 +737,20 @@ void SelectAltitudeSensor(void) {
 
 #endif
 
+// ROC is differenced over the interval between the capture times of the altitude samples
+// rather than the update period and is held until a new sample arrives.
+
 void UpdateAltitudeEstimates(void) {
 	static uint32 LastAltUpdatemS = 0;
+	static uint64 AltSamplePuS = 0;
+	uint64 AltSampleuS;
 	uint32 NowmS;
 
 	GetBaro();
 	GetRangefinderAltitude();
 
 	NowmS = mSClock();
-	if (NowmS > mS[AltUpdate]) { // 5 cycles @ 10mS -> 50mS or 20Hz
+	if (mSTimeout(NowmS, AltUpdate)) { // 5 cycles @ 10mS -> 50mS or 20Hz
 		mSTimer(mSClock(), AltUpdate, ALT_UPDATE_MS);
 
 		AltdT = (NowmS - LastAltUpdatemS) * 0.001f;
@@ -693,14 +762,22 @@ void UpdateAltitudeEstimates(void) {
 		if (F.UsingGPSAltitude && F.OriginValid)
 			ROC = -GPS.velD;
 		else {
-
-			ROC = (Altitude - AltitudeP) * AltdTR;
+			AltSampleuS = F.UsingRangefinderAlt ? RangefinderSampleuS
+					: BaroSampleuS;
+
+			if (AltSampleuS > AltSamplePuS) {
+				ROC = (Altitude - AltitudeP) / ((AltSampleuS - AltSamplePuS)
+						* 0.000001f);
+				ROC = LPFilterAt(&ROCLPF, ROC, AltSampleuS);
+				ROC = DeadZone(ROC, ALT_ROC_THRESHOLD_MPS);
+			}
 			AltitudeP = Altitude;
-
-			ROC = LPFilter(&ROCLPF, 1, ROC, AltLPFHz, AltdT);
-			ROC = DeadZone(ROC, ALT_ROC_THRESHOLD_MPS);
+			AltSamplePuS = AltSampleuS;
 		}
 
+		if (CurrStateEst == ErrorStateEKF)
+			ESKFFuseAltitude();
+
 		if (UAVXAirframe == Instrumentation)
 			ROC = Limit1(ROC, 20.0f);
 		else if (!F.IsFixedWing)
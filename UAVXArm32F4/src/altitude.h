@@ -62,6 +62,7 @@ boolean IsBaroActive(void);
 void GetBaro(void);
 void GetDensityAltitude(void);
 void InitBarometer(void);
+void InitAltitudeFilters(void);
 
 #define MAXSONAR_ID 0xe0
 #define SRFSONAR_ID 0xe0
@@ -91,6 +92,7 @@ extern real32 ROC, ROCF;
 extern int32 BaroVal;
 extern uint8 BaroType;
 extern real32 AltdT;
+extern uint64 BaroSampleuS, RangefinderSampleuS;
 extern real32 AltLPFHz;
 extern uint16 ms56xx_ManufacturersData;
 extern real32 BaroRawAltitude, BaroRawAltitudeP; // fusion filter output
@@ -111,7 +111,7 @@ void LaunchFW(void) {
 		ZeroThrottleCompensation();
 		DesiredThrottle = Max(IdleThrottle, Launch.idlethrottle);
 
-		if (NowmS > mS[NavStateTimeout]) { // 3Sec
+		if (mSTimeout(NowmS, NavStateTimeout)) { // 3Sec
 			StopDrives();
 			LaunchState = finishedLaunch;
 		} else {
@@ -123,10 +123,10 @@ void LaunchFW(void) {
 		}
 		break;
 	case doingLaunch:
-		if (NowmS > mS[NavStateTimeout]) // 5Sec
+		if (mSTimeout(NowmS, NavStateTimeout)) // 5Sec
 			LaunchState = finishedLaunch;
 		else {
-			DesiredThrottle = (NowmS > MotorStartTimemS) ?
+			DesiredThrottle = TimeReached(NowmS, MotorStartTimemS) ?
 			ThrottleUp(NowmS - MotorStartTimemS)
 					: Max(IdleThrottle, Launch.idlethrottle);
 		}
@@ -68,7 +68,7 @@ boolean DoLanding(void) {
 		}
 		break;
 	case CommenceDescent:
-		if (mSClock() > mS[NavStateTimeout]) {
+		if (mSTimeout(mSClock(), NavStateTimeout)) {
 			LastLandUpdateuS = uSClock();
 			bucketmS = NAV_LAND_TIMEOUT_MS;
 			LandingState = Descent;
@@ -310,7 +310,7 @@ void DoNavigation(void) {
 					NavState = NextWPState();
 				break;
 			case Perching:
-				if (mSClock() > mS[NavStateTimeout]) {
+				if (mSTimeout(mSClock(), NavStateTimeout)) {
 					SetDesiredAltitude(WP.Pos[DownC]);
 					NavState = Takeoff;
 				} else {
@@ -338,7 +338,7 @@ void DoNavigation(void) {
 				Navigate(&WP);
 
 				if ((F.AltControlEnabled && F.UsingRTHAutoDescend)
-						&& (mSClock() > mS[NavStateTimeout])) {
+						&& mSTimeout(mSClock(), NavStateTimeout)) {
 					F.RapidDescentHazard = false;
 					if (F.IsFixedWing) {
 					} else
@@ -390,7 +390,7 @@ void DoNavigation(void) {
 					break;
 				} // switch
 
-				if (mSClock() > mS[NavStateTimeout])
+				if (mSTimeout(mSClock(), NavStateTimeout))
 					NavState = NextWPState();
 
 				break;
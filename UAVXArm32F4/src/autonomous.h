@@ -56,6 +56,8 @@ typedef struct {
 
 	real32 HeadingTurnout;
 	real32 MaxCompassRate;
+
+	uint64 FixuS; // local capture time of the fix in C[].Pos/Vel
 } NavStruct;
 
 extern NavStruct Nav;
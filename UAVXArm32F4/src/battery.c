@@ -56,7 +56,7 @@ real32 MockBattery(void) {
 } // MockBattery
 
 
-void CheckBatteries(void) {
+void CheckBatteries(void) { // run by the scheduler at RG5Hz
 	enum lvcStates {
 		lvcStart = 0, lvcMonitor, lvcWarning, lvcWait, lvcLand
 	};
@@ -65,33 +65,29 @@ void CheckBatteries(void) {
 
 	NowmS = mSClock();
 
-	if ((NowmS >= mS[BatteryUpdate])) {
-		mSTimer(NowmS, BatteryUpdate, BATTERY_UPDATE_MS);
-
-		if (F.Emulation) {
-			BatteryCurrent = (DesiredThrottle + AltComp) * THR_MAX_CURRENT; // Mock Sensor
-			BatteryVolts = MockBattery() * BatteryCellCount;
-		} else {
+	if (F.Emulation) {
+		BatteryCurrent = (DesiredThrottle + AltComp) * THR_MAX_CURRENT; // Mock Sensor
+		BatteryVolts = MockBattery() * BatteryCellCount;
+	} else {
 #if defined(HAVE_CURRENT_SENSOR)
-			real32 Temp = -((analogRead(BattCurrentAnalogSel) - BatteryCurrentADCZero )) * (3.3f/0.04f) *CurrentScaleTrim;
-					//* CURRENT_SENSOR_MAX;
-			BatteryCurrent = SimpleFilter(BatteryCurrent, Temp, 0.1f);
+		real32 Temp = -((analogRead(BattCurrentAnalogSel) - BatteryCurrentADCZero )) * (3.3f/0.04f) *CurrentScaleTrim;
+				//* CURRENT_SENSOR_MAX;
+		BatteryCurrent = SimpleFilter(BatteryCurrent, Temp, 0.1f);
 #endif
 
-			BatteryVolts
-					= SimpleFilter(BatteryVolts, analogRead(BattVoltsAnalogSel) * VOLTS_SCALE * VoltScaleTrim, 0.25f);
-		}
+		BatteryVolts
+				= SimpleFilter(BatteryVolts, analogRead(BattVoltsAnalogSel) * VOLTS_SCALE * VoltScaleTrim, 0.25f);
+	}
 
-		dTmS = NowmS - mS[LastBattery];
-		mS[LastBattery] = NowmS;
+	dTmS = NowmS - mS[LastBattery];
+	mS[LastBattery] = NowmS;
 
-		BatterySagR = SimpleFilter(BatterySagR, StartupVolts / BatteryVolts, 0.25f);
+	BatterySagR = SimpleFilter(BatterySagR, StartupVolts / BatteryVolts, 0.25f);
 
-		BatteryChargeUsedmAH += BatteryCurrent * (real32) dTmS * (1.0f
-				/ 3600.0f);
+	BatteryChargeUsedmAH += BatteryCurrent * (real32) dTmS * (1.0f
+			/ 3600.0f);
 
-		F.LowBatt = BatteryVolts <= BatteryVoltsLimit;
-	}
+	F.LowBatt = BatteryVolts <= BatteryVoltsLimit;
 } // CheckBatteries
 
 
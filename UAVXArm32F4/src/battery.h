@@ -22,8 +22,6 @@
 #ifndef _battery_h
 #define _battery_h
 
-#define BATTERY_UPDATE_MS 200 // 1000
-
 extern void InitBattery(void);
 extern void CheckBatteries(void);
 extern void BatteryTest(uint8 s);
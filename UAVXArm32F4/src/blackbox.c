@@ -38,13 +38,14 @@ void UpdateBlackBox(void) {
 	uint16 i;
 
 	if (F.HaveExtMem)
-		if ((uSClock() >= uS[MemReady]) && (BBQEntries >= MEM_BLOCK_SIZE)) {
+		if (uSTimeout(uSClock64(), MemReady) && (BBQEntries >= MEM_BLOCK_SIZE)) {
 
-			for (i = 0; i < MEM_BLOCK_SIZE; i++) {
-				BBQHead = (BBQHead + 1) & BUFFER_MASK;
-				B[i] = BBQ[BBQHead];
-			}
-			WriteBlockExtMem(CurrExtMemAddr, MEM_BLOCK_SIZE, B);
+			for (i = 0; i < MEM_BLOCK_SIZE; i++)
+				B[i] = BBQ[(BBQHead + 1 + i) & BUFFER_MASK];
+			if (!QueueBlockExtMem(CurrExtMemAddr, MEM_BLOCK_SIZE, B))
+				return; // bus queue full - retry next pass
+
+			BBQHead = (BBQHead + MEM_BLOCK_SIZE) & BUFFER_MASK;
 			BBQEntries -= MEM_BLOCK_SIZE;
 
 			CurrExtMemAddr += MEM_BLOCK_SIZE;
@@ -122,3 +123,13 @@ void InitBlackBox(void) {
 	CurrExtMemAddr = 0;
 
 } // InitBlackBox
+
+int16 InitBlackBoxStep(uint8 n) {
+
+	if (!uSTimeout(uSClock64(), MemReady))
+		return (1); // a queued block write is still completing
+
+	InitBlackBox();
+
+	return (JOB_DONE);
+} // InitBlackBoxStep
@@ -33,6 +33,7 @@ extern void BlackBox(uint8 ch);
 extern void UpdateBlackBox(void);
 extern void DumpBlackBox(uint8 s);
 extern void InitBlackBox(void);
+extern int16 InitBlackBoxStep(uint8 n);
 
 
 extern boolean BlackBoxEnabled;
@@ -1123,7 +1123,7 @@ void blackboxUpdate(timeUs_t currentTimeUs) {
 		// Once the UART has had time to init, transmit the header in chunks so we don't overflow its transmit
 		// buffer, overflow the OpenLog's buffer, or keep the main loop busy for too long.
 
-		if (mSClock() > xmitState.u.startTime + 100) {
+		if (TimeReached(mSClock(), xmitState.u.startTime + 100)) {
 			if (blackboxDeviceReserveBufferSpace(
 					BLACKBOX_TARGET_HEADER_BUDGET_PER_ITERATION)
 					== BLACKBOX_RESERVE_SUCCESS) {
@@ -257,7 +257,7 @@ void i2cUnstick(uint8 i2cCurr) {
 	for (i = 0; i < 8; i++) { // Wait for any clock stretching to finish
 		while (!GPIO_ReadInputDataBit(d->SCLPort, d->SCLPin)) {
 			Delay1uS(I2C_DELAY_US);
-			if (mSClock() > Timeout) {
+			if (TimeReached(mSClock(), Timeout)) {
 				F.i2cFatal = true;
 				return;
 			}
@@ -560,8 +560,10 @@ void serialInitSBus(uint8 s, boolean Enable) {
 		DMA_Cmd(u->RxDMAStream, ENABLE);
 		USART_DMACmd(u->USART, USART_DMAReq_Rx, ENABLE);
 
-		RxQTail[s] = RxQHead[s] = SERIAL_BUFFER_SIZE - DMA_GetCurrDataCounter(
-				u->RxDMAStream);
+		ringInit(&RxRing[s], (void *) RxQ[s], SERIAL_BUFFER_SIZE, 1);
+		ringPublish(&RxRing[s], SERIAL_BUFFER_SIZE - DMA_GetCurrDataCounter(
+				u->RxDMAStream));
+		ringFlush(&RxRing[s]);
 
 		// Transmit DMA
 		NVIC_InitStructure.NVIC_IRQChannel = u->TxDMAISR;
@@ -584,7 +586,7 @@ void serialInitSBus(uint8 s, boolean Enable) {
 
 		USART_DMACmd(u->USART, USART_DMAReq_Tx, ENABLE);
 	} else if (u->InterruptsUsed) {
-		RxQTail[s] = RxQHead[s] = 0;
+		ringInit(&RxRing[s], (void *) RxQ[s], SERIAL_BUFFER_SIZE, 1);
 		NVIC_InitStructure.NVIC_IRQChannel = u->ISR;
 		NVIC_Init(&NVIC_InitStructure);
 
@@ -664,8 +666,10 @@ void InitSerialPort(uint8 s, boolean Enable) {
 		DMA_Cmd(u->RxDMAStream, ENABLE);
 		USART_DMACmd(u->USART, USART_DMAReq_Rx, ENABLE);
 
-		RxQTail[s] = RxQHead[s] = SERIAL_BUFFER_SIZE - DMA_GetCurrDataCounter(
-				u->RxDMAStream);
+		ringInit(&RxRing[s], (void *) RxQ[s], SERIAL_BUFFER_SIZE, 1);
+		ringPublish(&RxRing[s], SERIAL_BUFFER_SIZE - DMA_GetCurrDataCounter(
+				u->RxDMAStream));
+		ringFlush(&RxRing[s]);
 
 		// Transmit DMA
 		NVIC_InitStructure.NVIC_IRQChannel = u->TxDMAISR;
@@ -688,7 +692,7 @@ void InitSerialPort(uint8 s, boolean Enable) {
 
 		USART_DMACmd(u->USART, USART_DMAReq_Tx, ENABLE);
 	} else if (u->InterruptsUsed) {
-		RxQTail[s] = RxQHead[s] = 0;
+		ringInit(&RxRing[s], (void *) RxQ[s], SERIAL_BUFFER_SIZE, 1);
 		NVIC_InitStructure.NVIC_IRQChannel = u->ISR;
 		NVIC_Init(&NVIC_InitStructure);
 
@@ -805,6 +809,8 @@ void InitSensorInterrupts(void) {
 	 */
 	//pinInit(); // as input
 
+	RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+
 	SYSCFG_EXTILineConfig(EXTI_PortSourceGPIOC, EXTI_PinSource14);
 	EXTI_InitStruct.EXTI_Line = EXTI_Line14;
 	EXTI_InitStruct.EXTI_LineCmd = ENABLE;
@@ -822,7 +828,7 @@ void InitSensorInterrupts(void) {
 	//SYSCFG_EXTILineConfig(EXTI_PortSourceGPIOC, EXTI_PinSource15);
 
 #endif
-}
+} // InitSensorInterrupts
 
 void InitRCComboPort(void) {
 	uint8 CurrNoOfRCPins;
@@ -991,6 +997,10 @@ void InitHarness(void) {
 	for (i = 0; i < MAX_SPI_PORTS; i++)
 		spiInit(i);
 
+#if defined(USE_SPI_DMA)
+	spiInitDMA(spiMap[mpu60xxSel] - 1);
+#endif
+
 #if defined(INCLUDE_USB)
 
 	TM_USB_VCP_Init();
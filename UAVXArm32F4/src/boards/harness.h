@@ -163,6 +163,12 @@ typedef struct {
 		int16 PinSource;
 	} P[3];
 	boolean Used;
+#if !defined(STM32F1)
+	DMA_Stream_TypeDef * TxDMAStream; // zero if transactions are not used
+	DMA_Stream_TypeDef * RxDMAStream;
+	uint32 DMAChannel;
+	IRQn_Type RxDMAISR;
+#endif
 } SPIPortDef;
 
 extern SPIPortDef SPIPorts[];
@@ -185,6 +191,7 @@ extern void InitSerialPort(uint8 s, boolean Enable);
 extern void InitPWMPin(PinDef * u, uint16 pwmprescaler, uint32 pwmperiod, uint32 pwmwidth, boolean usingpwm);
 
 extern void InitRCComboPort(void);
+extern void InitSensorInterrupts(void);
 
 extern void i2cInit(uint8 I2CCurr);
 extern void i2cUnstick(uint8 I2CCurr);
@@ -320,7 +327,9 @@ extern const uint8 i2cMap[];
 #define MAX_RC_INPS 8
 #define ANALOG_CHANNELS 6
 #define MAX_GPIO_PINS 6
+#if !defined(MAX_SPI_DEVICES)
 #define MAX_SPI_DEVICES 0
+#endif
 #define MAX_SERIAL_PORTS 2
 #define MAX_PWM_OUTPUTS 10
 #define MAX_LEDS 4
@@ -126,7 +126,7 @@ SPIPortDef SPIPorts[MAX_SPI_PORTS] = { // SCK, MISO, MOSI
 	{ SPI2, GPIOB, {{GPIO_Pin_13, GPIO_PinSource13},
 			{GPIO_Pin_14, GPIO_PinSource14},
 			{GPIO_Pin_15, GPIO_PinSource15}},
-			true},
+			true, DMA1_Stream4, DMA1_Stream3, DMA_Channel_0, DMA1_Stream3_IRQn},
 	{ SPI3, GPIOC, {{GPIO_Pin_10, GPIO_PinSource10},
 			{GPIO_Pin_11, GPIO_PinSource11},
 			{GPIO_Pin_12, GPIO_PinSource12}},
@@ -168,7 +168,7 @@ SerialPortDef SerialPorts[MAX_SERIAL_PORTS] = { // Tx, Rx
         GPIO_Pin_11, GPIO_PinSource11,
         true, USART3_IRQn, // rx int used?
         false, DMA_Channel_4, // tx dma used?
-        DMA1_Stream3, DMA1_Stream3_IRQn, // tx
+        DMA1_Stream3, DMA1_Stream3_IRQn, // tx - shared with SPI2 Rx so DMA must stay unused
         DMA1_Stream1, // rx
         115200
     	}
@@ -416,6 +416,7 @@ void CalibrateAccSixPointSphere(uint8 s) {
 
 	NVChanged = true;
 	UpdateNV();
+	ResetIMUDelta();
 
 	F.AccCalibrated = true;
 
@@ -518,6 +519,7 @@ void CalibrateAccSixPoint(uint8 s) {
 
 	NVChanged = true;
 	UpdateNV();
+	ResetIMUDelta();
 
 	F.AccCalibrated = true;
 
@@ -22,12 +22,15 @@
 #include "UAVX.h"
 
 volatile uint32 TicksuS;
+volatile uint32 uSPerCycleQ32;
 
 void cycleCounterInit(void) {
 	RCC_ClocksTypeDef clocks;
 
 	RCC_GetClocksFreq(&clocks);
 	TicksuS = clocks.SYSCLK_Frequency / 1000000;
+	// rounded up so uSFromCycles(c) == c / TicksuS exactly for c below 2^32/TicksuS (152mS)
+	uSPerCycleQ32 = (uint32) ((0x100000000ULL + TicksuS - 1) / TicksuS);
 
 	// enable DWT access
 	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
@@ -35,19 +38,32 @@ void cycleCounterInit(void) {
 	DWT_CTRL |= CYCCNTENA;
 } // cycleCounterInit
 
+uint32 cycleCounter(void) {
+	return (*DWT_CYCCNT);
+} // cycleCounter
 
-uint32 uSClock(void) { // wraps at 71 minutes
-	volatile uint32 ms, cycle_cnt;
+
+// SysTick advances sysTickuS by 1000 and sysTickCycleCounter by exactly one SysTick
+// period of DWT cycles so the cycles since the last tick convert to uS with a multiply.
+// The 64 bit result does not wrap and is monotonic across DWT_CYCCNT rollover at 25.6S.
+
+uint64 uSClock64(void) {
+	uint32 ms, c0, c;
+	uint64 BaseuS;
 
 	do {
 		ms = sysTickUptime;
-		cycle_cnt = SysTick->VAL; //*DWT_CYCCNT; //
-		asm volatile("\tnop\n");
+		BaseuS = sysTickuS;
+		c0 = sysTickCycleCounter;
+		c = *DWT_CYCCNT;
 	} while (ms != sysTickUptime);
 
-	return (ms * 1000) + (TicksuS * 1000 - cycle_cnt) / TicksuS;
-	//return (ms * 1000) + ((8000 - cycle_cnt) >> 3);
+	return (BaseuS + uSFromCycles(c - c0));
+
+} // uSClock64
 
+uint32 uSClock(void) { // wraps at 71 minutes - compare with TimeReached
+	return ((uint32) uSClock64());
 } // uSClock
 
 
@@ -56,7 +72,7 @@ void Delay1uS(uint16 d) {
 	uint32 TimeOut;
 
 	TimeOut = uSClock() + d;
-	while (uSClock() < TimeOut) {
+	while (!TimeReached(uSClock(), TimeOut)) {
 	};
 
 } // Delay1uS
@@ -71,7 +87,7 @@ void Delay1mS(uint16 d) {
 	uint32 TimeOut;
 
 	TimeOut = mSClock() + d + 1; // clock may be rolling over
-	while (mSClock() < TimeOut) {
+	while (!TimeReached(mSClock(), TimeOut)) {
 	};
 
 } // Delay1mS
@@ -81,7 +97,7 @@ void delay(uint16 d) {
 	uint32 TimeOut;
 
 	TimeOut = mSClock() + d + 1; // clock may be rolling over
-	while (mSClock() < TimeOut) {
+	while (!TimeReached(mSClock(), TimeOut)) {
 	};
 
 } // delay
@@ -101,13 +117,22 @@ void mSTimer(uint32 NowmS, uint8 t, int32 TimePeriod) {
 	mS[t] = NowmS + TimePeriod;
 } // mSTimer
 
-void uSTimer(uint32 NowuS, uint8 t, int32 TimePeriod) {
+void uSTimer(uint64 NowuS, uint8 t, int32 TimePeriod) {
 	uS[t] = NowuS + TimePeriod;
 } // uSTimer
 
+boolean mSTimeout(uint32 NowmS, uint8 t) {
+	return (TimeReached(NowmS, mS[t]));
+} // mSTimeout
+
+boolean uSTimeout(uint64 NowuS, uint8 t) {
+	return (NowuS >= uS[t]);
+} // uSTimeout
+
 
 void InitClocks(void) {
 	cycleCounterInit();
 	SysTick_Config(SystemCoreClock / 1000); // 1mS
+	sysTickCycleCounter = *DWT_CYCCNT;
 } // InitClocks
 
@@ -22,9 +22,18 @@
 #ifndef _clocks_h
 #define _clocks_h
 
-extern volatile uint32 TicksuS;
+extern volatile uint32 TicksuS, uSPerCycleQ32;
+
+// cycles to uS without a divide, uSPerCycleQ32 is 2^32/TicksuS
+#define uSFromCycles(c) ((uint32)(((uint64)(c) * uSPerCycleQ32) >> 32))
+
+// wrap-safe for 32 bit times, true once Now has reached Then within 2^31 ticks.
+// uS[] deadlines are 64 bit and never wrap as an idle deadline may go stale for longer.
+#define TimeReached(Now, Then) ((int32)((uint32)(Now) - (uint32)(Then)) >= 0)
 
 void cycleCounterInit(void);
+uint32 cycleCounter(void);
+uint64 uSClock64(void);
 uint32 uSClock(void);
 void Delay1uS(uint16);
 void delay(uint16 d);
@@ -32,6 +41,8 @@ uint32 mSClock(void);
 void Delay1mS(uint16);
 real32 dTUpdate(uint32 NowuS, uint32 * LastUpdateuS);
 void mSTimer(uint32 NowmS, uint8 t, int32 TimePeriod);
-void uSTimer(uint32 NowuS, uint8 t, int32 TimePeriod);
+void uSTimer(uint64 NowuS, uint8 t, int32 TimePeriod);
+boolean mSTimeout(uint32 NowmS, uint8 t);
+boolean uSTimeout(uint64 NowuS, uint8 t);
 
 #endif
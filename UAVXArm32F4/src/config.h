@@ -81,7 +81,7 @@
 
 #define ACCZ_LANDING_MPS_S			(0.5f * GRAVITY_MPS_S)
 
-#define GYRO_MAX_SHAKE_RAW (DegreesToRadians(1.0)/GyroScale[CurrAttSensorType])
+#define GYRO_MAX_SHAKE_RAW (DegreesToRadians(1.0f)/GyroScale[CurrAttSensorType])
 
 #define THR_START_PW FromPercent(5)
 
@@ -126,6 +126,7 @@
 #define GPS_MIN_HACC 5.0f
 #define GPS_MIN_SACC 1.0f
 #define GPS_HDOP_TO_HACC 4.0f // crude approximation for NMEA GPS units
+#define GPS_LAG_S 1.0f // MTK 0.5 for UBlox, fix to serial Rx
 #define GPS_UPDATE_MS 200
 #define GPS_UPDATE_HZ (1000/GPS_UPDATE_MS)
 
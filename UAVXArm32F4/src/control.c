@@ -22,6 +22,7 @@
 
 #define ALT_HOLD_MAX_ROC_MPS 0.2f // Must be changing altitude at less than this for alt. hold to be detected
 #define NAV_RTH_LOCKOUT_ANGLE_RAD DegreesToRadians(10)
+#define PID_FF_LPF_HZ 20.0f // stick bandwidth, RC frames are ~22mS
 
 AxisStruct A[3];
 
@@ -61,45 +62,78 @@ real32 FWRollPitchFFFrac, FWAileronDifferentialFrac, FWPitchThrottleFFFrac,
 real32 FWGlideAngleOffsetRad = 0.0f;
 real32 ThrottleGain, gainScale;
 
-real32 ComputeAttitudeRateDerivative(PIDStruct *C) {
+real32 ComputeAttitudeRateDerivative(PIDStruct *C, real32 Current) {
 	// Using "rate on measurement" to avoid "derivative kick"
 	real32 r;
 
 	if (UsingPavelFilter) {
-		C->RateD = PavelDifferentiator(&C->RateDF, C->Error) * dTR;
+		C->RateD = PavelDifferentiator(&C->RateDF, -Current) * dTR;
 		if (P(DerivativeLPFHz) > 0)
-			C->RateD
-					= LPFilter(&C->RateF, 1, C->RateD, CurrDerivativeLPFHz, dT);
+			C->RateD = LPFilter(&C->RateF, C->RateD);
 	} else {
-		r = (P(DerivativeLPFHz)) > 0 ? LPFilter(&C->RateF, 1, C->Error,
-				CurrDerivativeLPFHz, dT) : C->Error;
+		r = (P(DerivativeLPFHz)) > 0 ? LPFilter(&C->RateF, -Current) : -Current;
 		C->RateD = (r - C->RateP) * dTR;
 		C->RateP = r;
-		C->RateD = Smoothr32xn(&C->RateDF, 4, C->RateD);
+		C->RateD = MAFilter(&C->RateMAF, C->RateD);
 	}
 
 	return (C->RateD);
 
 } // ComputeRateDerivative
 
+void InitPIDFilters(PIDStruct * C) {
+
+	InitLPFilter(&C->RateF, 1, CurrDerivativeLPFHz, CurrPIDCycleS);
+	InitMAFilter(&C->RateMAF, 4);
+	C->RateDF.Primed = false;
+	InitLPFilter(&C->DesiredF, 1, PID_FF_LPF_HZ, CurrPIDCycleS);
+
+} // InitPIDFilters
+
+void SetPIDShaping(PIDStruct * C, real32 Beta, real32 Kff, real32 RelaxS) {
+	// Beta weights the setpoint in P, Kff scales the setpoint rate and the
+	// integrator is frozen when the setpoint moves through Max in RelaxS
+
+	C->Beta = Beta;
+	C->Kff = Kff;
+	C->Kt = (C->Kp > 0.0f) ? C->Ki / C->Kp : 0.0f; // back-calculation 1/Ti
+	C->RelaxRate = (RelaxS > 0.0f) ? C->Max / RelaxS : 0.0f;
+
+} // SetPIDShaping
+
 real32 DoPID(PIDStruct * C, real32 Current, real32 dT) {
 	// do most general case - slightly more expensive
+	real32 Relax;
 
 	C->Error = Limit1(C->Desired - Current, C->Max);
 
-	C->PTerm = C->Error * C->Kp;
+	if ((C->Kff > 0.0f) || (C->RelaxRate > 0.0f)) {
+		if (!C->DesiredF.Primed)
+			C->DesiredP = C->Desired;
+		C->DesiredD = LPFilter(&C->DesiredF, (C->Desired - C->DesiredP) / dT);
+		C->DesiredP = C->Desired;
+	} else
+		C->DesiredD = 0.0f;
+
+	C->PTerm = Limit1(C->Beta * C->Desired - Current, C->Max) * C->Kp;
+
+	C->FFTerm = C->DesiredD * C->Kff;
 
 	if (C->Ki > 0.0f) {
-		C->IntE += C->Error * C->Ki * dT;
+		Relax = (C->RelaxRate > 0.0f) ? Limit(1.0f - Abs(C->DesiredD)
+				/ C->RelaxRate, 0.0f, 1.0f) : 1.0f;
+		// Sat is the output lost to saturation last cycle
+		C->IntE += (C->Error * C->Ki * Relax + C->Sat * C->Kt) * dT;
 		C->IntE = Limit1(C->IntE, C->IntLim);
 	} else
 		C->IntE = 0.0f; // redundant
 
 	C->ITerm = C->IntE;
 
-	C->DTerm = (C->Kd > 0.0f) ? ComputeAttitudeRateDerivative(C) * C->Kd : 0.0f;
+	C->DTerm = (C->Kd > 0.0f) ? ComputeAttitudeRateDerivative(C, Current)
+			* C->Kd : 0.0f;
 
-	return (C->PTerm + C->ITerm + C->DTerm);
+	return (C->PTerm + C->ITerm + C->DTerm + C->FFTerm);
 
 } // DoPID
 
@@ -108,7 +142,7 @@ void ZeroIntegrators(void) {
 	idx a;
 
 	for (a = Pitch; a <= Yaw; a++)
-		A[a].P.IntE = A[a].R.IntE = 0.0f;
+		A[a].P.IntE = A[a].R.IntE = A[a].P.Sat = A[a].R.Sat = 0.0f;
 
 } // ZeroIntegrators
 
@@ -130,6 +164,17 @@ real32 conditionOut(real32 v) {
 
 } // conditionOut
 
+real32 conditionPIDOut(PIDStruct * C, real32 v) {
+	// the mixer scale is from the previous cycle as drives are updated first
+	real32 Out;
+
+	Out = conditionOut(v);
+	C->Sat = Out * MixScale / gainScale - v;
+
+	return (Out);
+
+} // conditionPIDOut
+
 void ZeroThrottleCompensation(void) {
 	AltComp = 0.0f;
 	BattThrFFComp = TiltThrFFComp = 1.0f;
@@ -141,7 +186,7 @@ void CalcTiltThrFFComp(void) {
 	real32 Temp;
 
 	if (IsMulticopter && (State == InFlight) && F.UsingAngleControl) { // forget near level check
-		Temp = (1.0f / AttitudeCosine() - 1.0) * TiltThrFFFrac + 1.0f;
+		Temp = (1.0f / AttitudeCosine() - 1.0f) * TiltThrFFFrac + 1.0f;
 		Temp = Limit(Temp, 1.0f, TiltFFLimit);
 		TiltThrFFComp = SlewLimit(&TiltThrFFComp, Temp, TiltFFLimit, dT);
 	} else
@@ -193,8 +238,11 @@ void DoROCControl(real32 DesiredROC, real32 MinROCMPS, real32 MaxROCMPS) {
 
 
 void AltitudeHold(real32 MinROCMPS, real32 MaxROCMPS) {
+	real32 DesiredROC;
 
-	Alt.R.Desired = DoPID(&Alt.R, Altitude, AltdT);
+	DesiredROC = DoPID(&Alt.P, Altitude, AltdT);
+	Alt.R.Desired = Limit(DesiredROC, MinROCMPS, MaxROCMPS);
+	Alt.P.Sat = Alt.R.Desired - DesiredROC;
 
 	DoROCControl(Alt.R.Desired, MinROCMPS, MaxROCMPS);
 
@@ -348,21 +396,25 @@ void DoRateControl(idx a) {
 
 	C->R.Desired = Threshold(C->Stick, StickDeadZone) * C->P.Max;
 
-	C->Out = -conditionOut(DoPID(&C->R, Rate[a], dT));
+	C->Out = -conditionPIDOut(&C->R, DoPID(&C->R, Rate[a], dT));
 
 } // DoRateControl
 
 
 void DoAngleControl(idx a) { // with Ming Liu
 	AxisStruct *C = &A[a];
+	real32 DesiredRate;
 
 	C->P.Desired = Threshold(C->Stick, StickDeadZone) * C->P.Max + C->NavCorr;
 
 	if (F.IsFixedWing && (a == Pitch))
 		C->P.Desired += FWBoardPitchAngleRad;
 
-	C->R.Desired = DoPID(&C->P, C->Angle, dT);
-	C->Out = -conditionOut(DoPID(&C->R, Rate[a], dT));
+	DesiredRate = DoPID(&C->P, C->Angle, dT);
+	C->R.Desired = Limit1(DesiredRate, C->R.Max);
+	C->P.Sat = C->R.Desired - DesiredRate;
+
+	C->Out = -conditionPIDOut(&C->R, DoPID(&C->R, Rate[a], dT));
 
 } // DoAngleControl
 
@@ -376,18 +428,17 @@ void DoHorizonControl(idx a) {
 		C->P.Desired += FWBoardPitchAngleRad;
 
 	C->P.Desired = Limit1(C->P.Desired, C->P.Max);
-	C->P.Error = C->P.Desired - C->Angle;
-	C->P.PTerm = C->P.Error * C->P.Kp;
+	DoPID(&C->P, C->Angle, dT);
 
 	C->P.IntE = 0.0f; // for flip back to angle mode
 
 	AngleRateMix
 			= Limit(1.0f - (CurrMaxRollPitchStick * HorizonTransScale), 0.0f, 1.0f);
 
-	C->R.Desired = C->P.PTerm * AngleRateMix + C->P.Desired * C->P.Max * (1.0f
-			- AngleRateMix);
+	C->R.Desired = (C->P.PTerm + C->P.FFTerm) * AngleRateMix + C->P.Desired
+			* C->P.Max * (1.0f - AngleRateMix);
 
-	C->Out = -conditionOut(DoPID(&C->R, Rate[a], dT));
+	C->Out = -conditionPIDOut(&C->R, DoPID(&C->R, Rate[a], dT));
 
 } // DoHorizonControl
 
@@ -492,11 +543,13 @@ void InitControl(void) {
 
 	for (a = Pitch; a <= Yaw; a++) {
 		C = &A[a].P;
-		C->IntE = 0.0f;
-		C->RateF.Primed = C->RateDF.Primed = false;
+		C->IntE = C->Sat = 0.0f;
+		C->RateF.Primed = C->RateDF.Primed = C->RateMAF.Primed = false;
+		C->DesiredF.Primed = false;
 		C = &A[a].R;
-		C->IntE = 0.0f;
-		C->RateF.Primed = C->RateDF.Primed = false;
+		C->IntE = C->Sat = 0.0f;
+		C->RateF.Primed = C->RateDF.Primed = C->RateMAF.Primed = false;
+		C->DesiredF.Primed = false;
 
 		A[a].NavCorr = 0.0f;
 		A[a].Out = 0.0f;
@@ -51,9 +51,14 @@ enum DerivativeFilterTypes {maDFilt, pavelDFilt, mlDFilt, unknownDFilt};
 typedef struct {
 	real32 Desired, Error, Kp, Ki, Kd, IntE, IntLim, Max;
 	real32 PTerm, ITerm, DTerm, FFTerm;
+	real32 Kff, Beta, Kt, RelaxRate, Sat;
+	real32 DesiredP, DesiredD;
+	LPFilterStruct DesiredF;
 
 	real32 RateP, RateD, RateDp;
-	HistStruct RateF, RateDF;
+	LPFilterStruct RateF;
+	PavelStruct RateDF;
+	MAFilterStruct RateMAF;
 } PIDStruct;
 
 typedef struct {
@@ -77,6 +82,9 @@ real32 ComputeRateDerivative(AxisStruct *C);
 
 void DoControl(void);
 void InitControl(void);
+void InitPIDFilters(PIDStruct * C);
+void SetPIDShaping(PIDStruct * C, real32 Beta, real32 Kff, real32 RelaxS);
+real32 DoPID(PIDStruct * C, real32 Current, real32 dT);
 
 AxisStruct A[3];
 
@@ -55,6 +55,8 @@ const ParamStruct_t
 						{ YawRateKd, { 45, 45, 0, 0 } }, // // 91
 						{ MaxCompassYawRate, { 9, 9, 9, 9 } }, // 10 deg/S 89,
 						{ MaxYawRate, { 36, 36, 9, 9 } }, //  *10 deg/S 64
+						{ StickFF, { 30, 30, 0, 0 } }, // 104 setpoint rate feedforward
+						{ SetpointWeight, { 100, 100, 100, 100 } }, // % 105, 0 taken as 100
 
 						// Altitude Hold
 						{ AltPosKp, { 10, 10, 16, 16 } }, //  07
@@ -85,6 +87,7 @@ const ParamStruct_t
 						// Filters
 						{ DerivativeLPFHz, {75, 75, 75, 75 } }, // 78
 						{ GyroLPFHz, { 100, 100, 100, 100 } }, // 48
+						{ GyroOversample, { 1, 1, 1, 1 } }, // 103 gyro samples per control cycle
 						{ AccLPFHz, { 20, 20, 20, 20} }, // P90,
 
 						// Rx
@@ -199,9 +202,6 @@ const ParamStruct_t
 
 						{ Unused27, { 0, } }, // 27
 
-						{ Unused103, { 0, } }, // 103
-						{ Unused104, { 0, } }, // 104
-						{ Unused105, { 0, } }, // 105
 						{ Unused106, { 0, } }, // 106
 						{ Unused107, { 0, } }, // 107
 						{ Unused108, { 0, } }, // 108
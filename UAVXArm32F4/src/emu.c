@@ -148,7 +148,7 @@ void DoEmulation(void) {
 				Rate[a] -= (EM_MAX_THRUST * 0.25f * A[a].Out * EM_ARM_LEN
 						* InertiaR[a] - 2.0f * Sign(A[a].Out) * Sqr(Rate[a]))
 						* dT;
-				Temp = sinf(A[a].Angle) * Thrust;
+				Temp = Att.Sin[a] * Thrust;
 				Temp = Temp - Drag(Aircraft[a].Vel);
 				Aircraft[a].Vel += (Temp * EM_MASS_R) * dT;
 			}
@@ -162,8 +162,8 @@ void DoEmulation(void) {
 		Rotate(&GPS.C[NorthC].Vel, &GPS.C[EastC].Vel, -Aircraft[Pitch].Vel,
 				Aircraft[Roll].Vel, -Heading);
 
-		Acc[BF] = sinf(A[Pitch].Angle) * GRAVITY_MPS_S; // TODO: needs further work to cover lateral acc.
-		Acc[LR] = -sinf(A[Roll].Angle) * GRAVITY_MPS_S;
+		Acc[BF] = Att.Sin[Pitch] * GRAVITY_MPS_S; // TODO: needs further work to cover lateral acc.
+		Acc[LR] = -Att.Sin[Roll] * GRAVITY_MPS_S;
 
 		for (a = NorthC; a <= EastC; a++) {
 			GPS.C[a].Vel += Wind[a];
@@ -190,8 +190,9 @@ void GPSEmulation(void) {
 		RxChar(GPSRxSerial); // flush
 
 	NowmS = mSClock();
-	if (NowmS > mS[FakeGPSUpdate]) {
+	if (mSTimeout(NowmS, FakeGPSUpdate)) {
 		GPS.lastPosUpdatemS = GPS.lastVelUpdatemS = mSClock();
+		GPS.FixuS = uSClock64();
 		mSTimer(NowmS, FakeGPSUpdate, FAKE_GPS_DT_MS);
 
 		GPS.heading = Heading;
@@ -224,7 +225,7 @@ void InitEmulation(void) {
 		GPS.C[EastC].Raw = DEFAULT_HOME_LON;
 		GPS.longitudeCorrection = DEFAULT_LON_CORR;
 
-		mS[FakeGPSUpdate] = 0;
+		mSTimer(mSClock(), FakeGPSUpdate, 0);
 
 		Altitude = RangefinderAltitude = FakeAltitude = ROC
 				= 0.0f;
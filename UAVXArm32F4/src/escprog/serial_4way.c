@@ -818,10 +818,10 @@ void DoBLHeliSuite(uint8_t s) {
 
 	LEDOn(LEDYellowSel);
 
-	while ((mSClock() < Timeout) && !serialAvailable(s)) {
+	while (!TimeReached(mSClock(), Timeout) && !serialAvailable(s)) {
 	};
 
-	if (mSClock() < Timeout) {
+	if (!TimeReached(mSClock(), Timeout)) {
 
 		BLHeliSuiteActive = true;
 
@@ -64,7 +64,7 @@ static int suart_getc(void) {
     uint32_t wait_time = uSClock() + START_BIT_TIMEOUT;
     while (ESC_IS_HI) {
         // check for startbit begin
-        if (uSClock() >= wait_time) {
+        if (TimeReached(uSClock(), wait_time)) {
             return -1;
         }
     }
@@ -73,7 +73,7 @@ static int suart_getc(void) {
     btime = start_time + START_BIT_TIME;
     uint16_t bitmask = 0;
     for(bit = 0; bit < 10; bit++) {
-        while (uSClock() < btime);
+        while (!TimeReached(uSClock(), btime));
         if (ESC_IS_HI)
             bitmask |= (1 << bit);
         btime = btime + BIT_TIME;
@@ -99,7 +99,7 @@ void suart_putc(uint8_t byte) {
         bitmask >>= 1;
         if (bitmask == 0)
             break; // stopbit shifted out - but don't wait
-        while (uSClock() < btime);
+        while (!TimeReached(uSClock(), btime));
     }
 }
 
@@ -30,8 +30,8 @@ static uint8_t stkInBuf[16];
 #define STK_WAITCYLCES (STK_WAIT_TICKS * 35)       // 35ms
 #define STK_WAITCYLCES_START (STK_WAIT_TICKS / 2)  // 0.5ms
 #define STK_WAITCYLCES_EXT (STK_WAIT_TICKS * 5000) // 5s
-#define  WaitPinLo  while (ESC_IS_HI) { if (uSClock() > timeout_timer) goto timeout; }
-#define  WaitPinHi  while (ESC_IS_LO) { if (uSClock() > timeout_timer) goto timeout; }
+#define  WaitPinLo  while (ESC_IS_HI) { if (TimeReached(uSClock(), timeout_timer)) goto timeout; }
+#define  WaitPinHi  while (ESC_IS_LO) { if (TimeReached(uSClock(), timeout_timer)) goto timeout; }
 
 static uint32_t lastBitTime;
 static uint32_t hiLoTsh;
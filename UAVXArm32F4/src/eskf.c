@@ -0,0 +1,438 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Error state extended Kalman filter. The nominal state, attitude quaternion, NED position
+// and velocity and the gyro and acc biases, is propagated with the IMU each cycle. The 15
+// error states and their covariance are corrected by scalar updates from the accelerometer
+// as a gravity reference, magnetic heading, altitude and GPS with the corrections injected
+// into the nominal state after each group of updates. The transition matrix is mostly
+// identity and is applied block by block rather than as a 15x15 product.
+
+#include "UAVX.h"
+
+enum ESKFErrorStates {
+	ESKFPos = 0, ESKFVel = 3, ESKFAtt = 6, ESKFGyroBias = 9, ESKFAccBias = 12
+};
+
+// process noise
+#define ESKF_GYRO_NOISE		0.01f // rad/S/rtHz
+#define ESKF_ACC_NOISE		0.5f // M/S^2/rtHz
+#define ESKF_GYRO_BIAS_RW	2.0e-4f // rad/S^2/rtHz
+#define ESKF_ACC_BIAS_RW	2.0e-3f // M/S^3/rtHz
+
+// measurement noise
+#define ESKF_ACC_SDEV		1.0f // M/S^2 at full AccConfidence
+#define ESKF_MIN_ACC_CONFIDENCE	0.05f
+#define ESKF_HEADING_SDEV	DegreesToRadians(5.0f)
+#define ESKF_ALT_SDEV		0.5f // M
+#define ESKF_GPS_POS_SDEV	1.5f // M floor for GPS.hAcc
+#define ESKF_GPS_VEL_SDEV	0.3f // M/S floor for GPS.sAcc
+#define ESKF_UNAIDED_SDEV	10.0f // M/S zero velocity when there is no aiding
+#define ESKF_UNAIDED_S		1.0f
+#define ESKF_UNAIDED_PERIOD_S	0.2f
+#define ESKF_RESET_GATE		5.0f // position innovations beyond 5 SDev reset the state
+
+#define ESKF_ACC_DIV		4 // gravity reference on every 4th update
+
+ESKFStruct ESKF;
+
+static real32 dX[ESKF_N];
+static real32 R[3][3]; // body to NED from ESKF.q
+static real32 FVelAtt[3][3], FVelAccBias[3][3], FAttAtt[3][3];
+
+static void ESKFDCM(void) {
+	real32 q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+
+	q0q0 = ESKF.q[0] * ESKF.q[0];
+	q0q1 = ESKF.q[0] * ESKF.q[1];
+	q0q2 = ESKF.q[0] * ESKF.q[2];
+	q0q3 = ESKF.q[0] * ESKF.q[3];
+	q1q1 = ESKF.q[1] * ESKF.q[1];
+	q1q2 = ESKF.q[1] * ESKF.q[2];
+	q1q3 = ESKF.q[1] * ESKF.q[3];
+	q2q2 = ESKF.q[2] * ESKF.q[2];
+	q2q3 = ESKF.q[2] * ESKF.q[3];
+	q3q3 = ESKF.q[3] * ESKF.q[3];
+
+	R[0][0] = q0q0 + q1q1 - q2q2 - q3q3;
+	R[0][1] = 2.0f * (q1q2 - q0q3);
+	R[0][2] = 2.0f * (q0q2 + q1q3);
+	R[1][0] = 2.0f * (q1q2 + q0q3);
+	R[1][1] = q0q0 - q1q1 + q2q2 - q3q3;
+	R[1][2] = 2.0f * (q2q3 - q0q1);
+	R[2][0] = 2.0f * (q1q3 - q0q2);
+	R[2][1] = 2.0f * (q0q1 + q2q3);
+	R[2][2] = q0q0 - q1q1 - q2q2 + q3q3;
+
+} // ESKFDCM
+
+// q = q x (1, v/2) normalised, for both the gyro step and error injection
+
+static void ESKFRotate(real32 x, real32 y, real32 z) {
+	real32 q[4], normR;
+	idx i;
+
+	x *= 0.5f;
+	y *= 0.5f;
+	z *= 0.5f;
+
+	q[0] = ESKF.q[0] - ESKF.q[1] * x - ESKF.q[2] * y - ESKF.q[3] * z;
+	q[1] = ESKF.q[1] + ESKF.q[0] * x + ESKF.q[2] * z - ESKF.q[3] * y;
+	q[2] = ESKF.q[2] + ESKF.q[0] * y - ESKF.q[1] * z + ESKF.q[3] * x;
+	q[3] = ESKF.q[3] + ESKF.q[0] * z + ESKF.q[1] * y - ESKF.q[2] * x;
+
+	normR = invSqrt(Sqr(q[0]) + Sqr(q[1]) + Sqr(q[2]) + Sqr(q[3]));
+	for (i = 0; i < 4; i++)
+		ESKF.q[i] = q[i] * normR;
+
+	ESKFDCM();
+
+} // ESKFRotate
+
+// Applies the transition matrix to a row or column of P
+
+#define E(i) x[(i) * s]
+
+static void ESKFTransition(real32 * x, idx s) {
+	real32 Att[3], AccBias[3];
+	idx i;
+
+	for (i = 0; i < 3; i++) {
+		Att[i] = E(ESKFAtt + i);
+		AccBias[i] = E(ESKFAccBias + i);
+		E(ESKFPos + i) += E(ESKFVel + i) * dT;
+	}
+
+	for (i = 0; i < 3; i++) {
+		E(ESKFVel + i) += FVelAtt[i][0] * Att[0] + FVelAtt[i][1] * Att[1]
+				+ FVelAtt[i][2] * Att[2] + FVelAccBias[i][0] * AccBias[0]
+				+ FVelAccBias[i][1] * AccBias[1] + FVelAccBias[i][2]
+				* AccBias[2];
+		E(ESKFAtt + i) = FAttAtt[i][0] * Att[0] + FAttAtt[i][1] * Att[1]
+				+ FAttAtt[i][2] * Att[2] - E(ESKFGyroBias + i) * dT;
+	}
+
+} // ESKFTransition
+
+#undef E
+
+// Sequential scalar update - H is sparse so only its non zero terms are visited.
+// Returns false, leaving the state alone, if the innovation is outside Gate SDev.
+
+static boolean ESKFFuse(real32 * H, real32 Innov, real32 r, real32 Gate) {
+	real32 PHt[ESKF_N], K[ESKF_N], S;
+	idx Nz[ESKF_N], n, i, j;
+
+	n = 0;
+	for (i = 0; i < ESKF_N; i++)
+		if (H[i] != 0.0f) {
+			Nz[n++] = i;
+			Innov -= H[i] * dX[i];
+		}
+
+	S = r;
+	for (i = 0; i < ESKF_N; i++) {
+		PHt[i] = 0.0f;
+		for (j = 0; j < n; j++)
+			PHt[i] += ESKF.P[i][Nz[j]] * H[Nz[j]];
+	}
+	for (j = 0; j < n; j++)
+		S += H[Nz[j]] * PHt[Nz[j]];
+
+	if ((Gate > 0.0f) && (Sqr(Innov) > Sqr(Gate) * S))
+		return (false);
+
+	S = 1.0f / S;
+	for (i = 0; i < ESKF_N; i++) {
+		K[i] = PHt[i] * S;
+		dX[i] += K[i] * Innov;
+	}
+
+	for (i = 0; i < ESKF_N; i++)
+		for (j = 0; j <= i; j++)
+			ESKF.P[j][i] = ESKF.P[i][j] -= K[i] * PHt[j];
+
+	return (true);
+} // ESKFFuse
+
+static void ESKFInject(void) {
+	idx i;
+
+	for (i = 0; i < 3; i++) {
+		ESKF.Pos[i] += dX[ESKFPos + i];
+		ESKF.Vel[i] += dX[ESKFVel + i];
+		ESKF.GyroBias[i] += dX[ESKFGyroBias + i];
+		ESKF.AccBias[i] += dX[ESKFAccBias + i];
+	}
+	ESKFRotate(dX[ESKFAtt], dX[ESKFAtt + 1], dX[ESKFAtt + 2]);
+
+	memset(dX, 0, sizeof(dX));
+
+} // ESKFInject
+
+// Jumps in origin or altitude source are taken as a new reference rather than as motion
+
+static void ESKFReset(idx s, real32 * x, real32 z, real32 r) {
+	idx i;
+
+	*x = z;
+	dX[s] = 0.0f;
+	for (i = 0; i < ESKF_N; i++)
+		ESKF.P[s][i] = ESKF.P[i][s] = 0.0f;
+	ESKF.P[s][s] = r;
+
+} // ESKFReset
+
+static void ESKFFuseState(idx s, real32 * x, real32 z, real32 r, real32 Gate) {
+	real32 H[ESKF_N];
+
+	memset(H, 0, sizeof(H));
+	H[s] = 1.0f;
+	if (!ESKFFuse(H, z - *x, r, Gate))
+		ESKFReset(s, x, z, r);
+
+} // ESKFFuseState
+
+// Specific force is -g * Gravity[] + AccBias when unaccelerated
+
+static void ESKFFuseGravity(real32 * a) {
+	real32 H[ESKF_N], g[3], r;
+	idx i;
+
+	r = Sqr(ESKF_ACC_SDEV) / AccConfidence;
+
+	for (i = 0; i < 3; i++)
+		g[i] = R[2][i] * GRAVITY_MPS_S;
+
+	for (i = 0; i < 3; i++) {
+		memset(H, 0, sizeof(H));
+		switch (i) {
+		case X:
+			H[ESKFAtt + Y] = g[Z];
+			H[ESKFAtt + Z] = -g[Y];
+			break;
+		case Y:
+			H[ESKFAtt + X] = -g[Z];
+			H[ESKFAtt + Z] = g[X];
+			break;
+		default:
+			H[ESKFAtt + X] = g[Y];
+			H[ESKFAtt + Y] = -g[X];
+			break;
+		}
+		H[ESKFAccBias + i] = 1.0f;
+		ESKFFuse(H, a[i] + g[i] - ESKF.AccBias[i], r, 0.0f);
+	}
+
+} // ESKFFuseGravity
+
+// Without GPS or altitude a weak zero velocity keeps the unaided channels bounded
+
+static boolean ESKFUnaided(real32 * UnaidedS) {
+
+	*UnaidedS += dT;
+	if (*UnaidedS > ESKF_UNAIDED_S) {
+		*UnaidedS -= ESKF_UNAIDED_PERIOD_S;
+		return (true);
+	}
+
+	return (false);
+} // ESKFUnaided
+
+// Propagation is by the delta angle and velocity over dT from IMUDelta, coning and sculling
+// compensated and in the body frame at the start of the step
+
+void ESKFUpdate(real32 dAx, real32 dAy, real32 dAz, real32 dVx, real32 dVy,
+		real32 dVz) {
+	real32 w[3], f[3], an[3], a[3];
+	idx i, j, c;
+
+	AccConfidence = CalculateAccConfidence(sqrtf(Sqr(dVx) + Sqr(dVy) + Sqr(
+			dVz)) * dTR);
+
+	w[X] = dAx - ESKF.GyroBias[X] * dT;
+	w[Y] = dAy - ESKF.GyroBias[Y] * dT;
+	w[Z] = dAz - ESKF.GyroBias[Z] * dT;
+
+	f[X] = dVx - ESKF.AccBias[X] * dT; // f dT
+	f[Y] = dVy - ESKF.AccBias[Y] * dT;
+	f[Z] = dVz - ESKF.AccBias[Z] * dT;
+
+	// transition blocks at the attitude before the step
+	for (i = 0; i < 3; i++) {
+		an[i] = R[i][0] * f[0] + R[i][1] * f[1] + R[i][2] * f[2]; // an dT
+
+		FVelAtt[i][X] = R[i][Z] * f[Y] - R[i][Y] * f[Z]; // -R[f]x dT
+		FVelAtt[i][Y] = R[i][X] * f[Z] - R[i][Z] * f[X];
+		FVelAtt[i][Z] = R[i][Y] * f[X] - R[i][X] * f[Y];
+		for (j = 0; j < 3; j++)
+			FVelAccBias[i][j] = -R[i][j] * dT;
+	}
+	FAttAtt[X][X] = FAttAtt[Y][Y] = FAttAtt[Z][Z] = 1.0f; // I - [w]x dT
+	FAttAtt[X][Y] = w[Z];
+	FAttAtt[X][Z] = -w[Y];
+	FAttAtt[Y][X] = -w[Z];
+	FAttAtt[Y][Z] = w[X];
+	FAttAtt[Z][X] = w[Y];
+	FAttAtt[Z][Y] = -w[X];
+
+	// nominal state
+	an[DownC] += GRAVITY_MPS_S * dT;
+	for (i = 0; i < 3; i++) {
+		ESKF.Pos[i] += (ESKF.Vel[i] + 0.5f * an[i]) * dT;
+		ESKF.Vel[i] += an[i];
+	}
+	ESKFRotate(w[X], w[Y], w[Z]);
+
+	// P = F P F' + Q
+	for (j = 0; j < ESKF_N; j++)
+		ESKFTransition(&ESKF.P[0][j], ESKF_N);
+	for (i = 0; i < ESKF_N; i++)
+		ESKFTransition(&ESKF.P[i][0], 1);
+
+	for (i = 0; i < ESKF_N; i++)
+		for (j = 0; j < i; j++)
+			ESKF.P[j][i] = ESKF.P[i][j] = 0.5f * (ESKF.P[i][j] + ESKF.P[j][i]);
+
+	for (i = 0; i < 3; i++) {
+		ESKF.P[ESKFVel + i][ESKFVel + i] += Sqr(ESKF_ACC_NOISE) * dT;
+		ESKF.P[ESKFAtt + i][ESKFAtt + i] += Sqr(ESKF_GYRO_NOISE) * dT;
+		ESKF.P[ESKFGyroBias + i][ESKFGyroBias + i] += Sqr(ESKF_GYRO_BIAS_RW)
+				* dT;
+		ESKF.P[ESKFAccBias + i][ESKFAccBias + i] += Sqr(ESKF_ACC_BIAS_RW) * dT;
+	}
+
+	// corrections
+	if (++ESKF.AccDiv >= ESKF_ACC_DIV) {
+		ESKF.AccDiv = 0;
+		if ((AccConfidence > ESKF_MIN_ACC_CONFIDENCE) && (ESKF.HUnaidedS
+				> ESKF_UNAIDED_S)) {
+			a[X] = dVx * dTR;
+			a[Y] = dVy * dTR;
+			a[Z] = dVz * dTR;
+			ESKFFuseGravity(a);
+		}
+	}
+
+	if (ESKFUnaided(&ESKF.HUnaidedS))
+		for (c = NorthC; c <= EastC; c++)
+			ESKFFuseState(ESKFVel + c, &ESKF.Vel[c], 0.0f, Sqr(
+					ESKF_UNAIDED_SDEV), 0.0f);
+	if (ESKFUnaided(&ESKF.VUnaidedS))
+		ESKFFuseState(ESKFVel + DownC, &ESKF.Vel[DownC], 0.0f, Sqr(
+				ESKF_UNAIDED_SDEV), 0.0f);
+
+	ESKFInject();
+
+	SetAttitude(ESKF.q);
+
+} // ESKFUpdate
+
+// MagHeading is tilt compensated with the filter's own attitude so it is fused as a
+// rotation about the vertical only, the NED down axis in the body frame. Letting it
+// correct tilt as well closes a loop through CalculateMagneticHeading.
+
+void ESKFFuseHeading(real32 H) {
+	real32 Hx[ESKF_N];
+
+	if ((Sqr(R[0][0]) + Sqr(R[1][0])) > 0.01f) { // not near vertical
+		memset(Hx, 0, sizeof(Hx));
+		Hx[ESKFAtt + X] = R[2][X];
+		Hx[ESKFAtt + Y] = R[2][Y];
+		Hx[ESKFAtt + Z] = R[2][Z];
+		ESKFFuse(Hx, MakePi(H - FastAtan2(R[1][0], R[0][0])), Sqr(
+				ESKF_HEADING_SDEV), 0.0f);
+		ESKFInject();
+	}
+
+} // ESKFFuseHeading
+
+// Altitude and ROC are replaced by the filter's estimates
+
+void ESKFFuseAltitude(void) {
+
+	ESKFFuseState(ESKFPos + DownC, &ESKF.Pos[DownC], -Altitude, Sqr(
+			ESKF_ALT_SDEV), ESKF_RESET_GATE);
+	ESKFInject();
+	ESKF.VUnaidedS = 0.0f;
+
+	Altitude = -ESKF.Pos[DownC];
+	ROC = -ESKF.Vel[DownC];
+
+} // ESKFFuseAltitude
+
+// GPS is true north - the filter works to magnetic north as does A[Yaw].Angle. The
+// filtered North and East position and velocity replace the GPS values in Nav.
+
+void ESKFFuseGPS(void) {
+	real32 Pos[2], Vel[2], r;
+	idx a;
+
+	Rotate(&Pos[NorthC], &Pos[EastC], Nav.C[NorthC].Pos, Nav.C[EastC].Pos,
+			MagVariation);
+	Rotate(&Vel[NorthC], &Vel[EastC], Nav.C[NorthC].Vel, Nav.C[EastC].Vel,
+			MagVariation);
+
+	r = Sqr(fmaxf(GPS.hAcc, ESKF_GPS_POS_SDEV));
+	for (a = NorthC; a <= EastC; a++)
+		ESKFFuseState(ESKFPos + a, &ESKF.Pos[a], Pos[a], r, ESKF_RESET_GATE);
+
+	r = Sqr(fmaxf(GPS.sAcc, ESKF_GPS_VEL_SDEV));
+	for (a = NorthC; a <= EastC; a++)
+		ESKFFuseState(ESKFVel + a, &ESKF.Vel[a], Vel[a], r, 0.0f);
+
+	ESKFInject();
+	ESKF.HUnaidedS = 0.0f;
+
+	Rotate(&Nav.C[NorthC].Pos, &Nav.C[EastC].Pos, ESKF.Pos[NorthC],
+			ESKF.Pos[EastC], -MagVariation);
+	Rotate(&Nav.C[NorthC].Vel, &Nav.C[EastC].Vel, ESKF.Vel[NorthC],
+			ESKF.Vel[EastC], -MagVariation);
+
+} // ESKFFuseGPS
+
+// Attitude from the accelerometer and current heading, at rest at the altitude origin
+
+void InitESKF(void) {
+	real32 Pitch0, Roll0;
+	idx i;
+
+	memset(&ESKF, 0, sizeof(ESKF));
+	memset(dX, 0, sizeof(dX));
+
+	Roll0 = FastAtan2(-Acc[LR], -Acc[UD]);
+	Pitch0 = FastAtan2(Acc[BF], sqrtf(Sqr(Acc[LR]) + Sqr(Acc[UD])));
+	ConvertEulerToQuaternion(Pitch0, Roll0, A[Yaw].Angle);
+	ConvertQuaternionToEuler();
+	memcpy(ESKF.q, Att.q, sizeof(ESKF.q));
+	ESKFDCM();
+
+	ESKF.Pos[DownC] = -Altitude;
+
+	for (i = 0; i < 3; i++) {
+		ESKF.P[ESKFPos + i][ESKFPos + i] = Sqr(10.0f);
+		ESKF.P[ESKFVel + i][ESKFVel + i] = Sqr(1.0f);
+		ESKF.P[ESKFAtt + i][ESKFAtt + i] = Sqr(DegreesToRadians(10.0f));
+		ESKF.P[ESKFGyroBias + i][ESKFGyroBias + i] = Sqr(DegreesToRadians(1.0f));
+		ESKF.P[ESKFAccBias + i][ESKFAccBias + i] = Sqr(0.5f);
+	}
+	ESKF.P[ESKFAtt + Z][ESKFAtt + Z] = Sqr(DegreesToRadians(30.0f));
+
+} // InitESKF
@@ -0,0 +1,45 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+#ifndef _eskf_h
+#define _eskf_h
+
+#define ESKF_N		15 // error states - position, velocity, attitude, gyro and acc bias
+
+typedef struct {
+	real32 q[4]; // body to NED, magnetic north
+	real32 Pos[3], Vel[3]; // NED
+	real32 GyroBias[3], AccBias[3]; // body
+	real32 P[ESKF_N][ESKF_N];
+	real32 HUnaidedS, VUnaidedS;
+	uint8 AccDiv;
+} ESKFStruct;
+
+extern ESKFStruct ESKF;
+
+void InitESKF(void);
+void ESKFUpdate(real32 dAx, real32 dAy, real32 dAz, real32 dVx, real32 dVy,
+		real32 dVz);
+void ESKFFuseHeading(real32 H);
+void ESKFFuseAltitude(void);
+void ESKFFuseGPS(void);
+
+#endif
+
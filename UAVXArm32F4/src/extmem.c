@@ -31,6 +31,11 @@ boolean WriteBlockExtMem(uint32 a, uint16 l, int8 *v) {
 	return (F.HaveExtMem);
 } // WriteBlockMem
 
+boolean QueueBlockExtMem(uint32 a, uint16 l, int8 *v) {
+
+	return (WriteBlockExtMem(a, l, v)); // SPI page write does not hold the bus
+} // QueueBlockExtMem
+
 boolean EraseExtMem(void) {
 	uint16 i;
 	boolean r = true;
@@ -64,7 +69,7 @@ boolean EraseExtMem(void) {
 				LEDToggle(LEDBlueSel);
 				LEDToggle(LEDYellowSel);
 			} else {
-				uSTimer(uSClock(), MemReady, 0);
+				uSTimer(uSClock64(), MemReady, 0);
 			}
 		}
 	}
@@ -109,7 +114,7 @@ boolean WriteBlockExtMem(uint32 a, uint16 l, int8 *v) {
 	uint8 bank;
 	i8u8u u;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 	if (F.HaveExtMem) {
@@ -124,12 +129,48 @@ boolean WriteBlockExtMem(uint32 a, uint16 l, int8 *v) {
 		r &= sioWriteBlock(SIOMem, EEPROM_ID | bank, 0xff, 2 + l, b);
 	} else
 		r = false;
-	uSTimer(uSClock(), MemReady, 5000);
+	uSTimer(uSClock64(), MemReady, 5000);
 
 	return (r);
 
 } // WriteBlockMem
 
+// Blackbox blocks are queued behind the sensor transfers rather than holding
+// the caller for the ~0.8mS bus time. MemReady covers the transfer then the
+// 5mS page write once it completes.
+
+static uint8 QB[2 + MEM_BLOCK_SIZE];
+
+static void QueueBlockExtMemDone(boolean ok) {
+
+	uSTimer(uSClock64(), MemReady, 5000);
+} // QueueBlockExtMemDone
+
+boolean QueueBlockExtMem(uint32 a, uint16 l, int8 *v) {
+	uint16 i;
+	i8u8u u;
+
+	if (!F.HaveExtMem || (l > MEM_BLOCK_SIZE) || !uSTimeout(uSClock64(),
+			MemReady))
+		return (false);
+
+	QB[0] = (a >> 8) & 0xff;
+	QB[1] = a & 0xff;
+	for (i = 0; i < l; i++) {
+		u.i8 = v[i];
+		QB[i + 2] = u.u8;
+	}
+
+	uSTimer(uSClock64(), MemReady, 50000); // until QueueBlockExtMemDone
+	if (!sioQueueWrite(SIOMem, EEPROM_ID, 0xff, 2 + l, QB,
+			QueueBlockExtMemDone)) {
+		uSTimer(uSClock64(), MemReady, 0);
+		return (false);
+	}
+
+	return (true);
+} // QueueBlockExtMem
+
 boolean EraseExtMem(void) {
 	uint32 TimeoutmS;
 	uint32 a;
@@ -146,7 +187,7 @@ boolean EraseExtMem(void) {
 		for (a = 0; a < MEM_SIZE; a += MEM_BUFFER_SIZE) {
 			r &= WriteBlockExtMem(a, MEM_BUFFER_SIZE, B);
 
-			if (mSClock() > TimeoutmS) {
+			if (!TimeReached(TimeoutmS, mSClock())) {
 				TimeoutmS += 100;
 				LEDToggle(LEDBlueSel);
 				LEDToggle(LEDYellowSel);
@@ -168,7 +209,7 @@ void ReadBlockExtMem(uint32 a, uint16 l, int8 * v) {
 	uint8 b[2];
 
 	if (F.HaveExtMem) {
-		while (uSClock() < uS[MemReady]) {
+		while (!uSTimeout(uSClock64(), MemReady)) {
 			// BLOCKING
 		};
 		bank = 0; // only one chip (a & 0x00070000) >> 15;
@@ -249,7 +290,7 @@ boolean Write32ExtMem(uint32 a, int32 d) {
 
 void InitExtMem(void) {
 
-	uS[MemReady] = uSClock();
+	uS[MemReady] = uSClock64();
 
 #if defined(STM32F1)
 	F.HaveExtMem = false;
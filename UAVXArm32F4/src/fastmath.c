@@ -0,0 +1,129 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+
+#include "UAVX.h"
+
+// Polynomials are evaluated in single precision only and reduced ranges are
+// selected with conditional moves rather than loops. Cody-Waite reduction keeps
+// sin/cos accurate well past the angles the flight code produces.
+
+#define PIO2_1		1.5703125f // PI/2 in three parts, the first two short enough
+#define PIO2_2		4.837512969970703125e-4f // for exact products with the quadrant
+#define PIO2_3		7.54978995489188216e-8f
+
+real32 FastAtan2(real32 y, real32 x) {
+	// minimax atan on [0, 1] applied to the octant ratio
+	real32 ax, ay, a, s, r;
+
+	ax = fabsf(x);
+	ay = fabsf(y);
+	a = (ax >= ay) ? ay / Max(ax, 1.0e-30f) : ax / ay;
+	s = a * a;
+	r = ((((((-0.01172120f * s + 0.05265332f) * s - 0.11643287f) * s
+			+ 0.19354346f) * s - 0.33262347f) * s) + 0.99997726f) * a;
+
+	r = (ay > ax) ? HALF_PI - r : r;
+	r = (x < 0.0f) ? PI - r : r;
+
+	return ((y < 0.0f) ? -r : r);
+} // FastAtan2
+
+real32 FastAsin(real32 x) {
+	// Abramowitz and Stegun 4.4.46
+	real32 a, r;
+
+	a = Min(fabsf(x), 1.0f);
+	r = ((((((-0.0012624911f * a + 0.0066700901f) * a - 0.0170881256f) * a
+			+ 0.0308918810f) * a - 0.0501743046f) * a + 0.0889789874f) * a
+			- 0.2145988016f) * a + 1.5707963050f;
+	r = HALF_PI - sqrtf(1.0f - a) * r;
+
+	return ((x < 0.0f) ? -r : r);
+} // FastAsin
+
+void FastSinCos(real32 A, real32 * s, real32 * c) {
+	// reduced to |r| <= PI/4 in quadrant q
+	real32 r, r2, sr, cr;
+	int32 q;
+
+	q = (int32) (A * (2.0f / PI) + ((A < 0.0f) ? -0.5f : 0.5f));
+	r = ((A - q * PIO2_1) - q * PIO2_2) - q * PIO2_3;
+	r2 = r * r;
+
+	sr = r + r * r2 * (-1.6666667e-1f + r2 * (8.3333333e-3f + r2
+			* (-1.9841270e-4f + r2 * 2.7557319e-6f)));
+	cr = 1.0f + r2 * (-0.5f + r2 * (4.1666668e-2f + r2 * (-1.3888889e-3f
+			+ r2 * 2.4801587e-5f)));
+
+	// quadrants 0..3 give (s, c) = (sr, cr), (cr, -sr), (-sr, -cr), (-cr, sr)
+	*s = (q & 2) ? -((q & 1) ? cr : sr) : ((q & 1) ? cr : sr);
+	*c = ((q + 1) & 2) ? -((q & 1) ? sr : cr) : ((q & 1) ? sr : cr);
+
+} // FastSinCos
+
+real32 FastSin(real32 A) {
+	real32 s, c;
+
+	FastSinCos(A, &s, &c);
+	return (s);
+} // FastSin
+
+real32 FastCos(real32 A) {
+	real32 s, c;
+
+	FastSinCos(A, &s, &c);
+	return (c);
+} // FastCos
+
+real32 invSqrt(real32 x) {
+	// See: http://en.wikipedia.org/wiki/Fast_inverse_square_root with a second
+	// Newton step. Cheaper than VSQRT and VDIV, 14 cycles each, on the M4.
+	union {
+		real32 f;
+		uint32 i;
+	} u;
+	real32 halfx = 0.5f * x;
+
+	u.f = x;
+	u.i = 0x5f3759df - (u.i >> 1);
+	u.f *= 1.5f - halfx * u.f * u.f;
+	u.f *= 1.5f - halfx * u.f * u.f;
+
+	return (u.f);
+} // invSqrt
+
+real32 MakePi(real32 A) {
+
+	A -= TWO_PI * (int32) (A * (1.0f / TWO_PI));
+	A = (A < -PI) ? A + TWO_PI : A;
+
+	return ((A >= PI) ? A - TWO_PI : A);
+} // MakePi
+
+real32 Make2Pi(real32 A) {
+
+	A -= TWO_PI * (int32) (A * (1.0f / TWO_PI));
+	A = (A < 0.0f) ? A + TWO_PI : A;
+
+	return ((A >= TWO_PI) ? A - TWO_PI : A);
+} // Make2Pi
+
+
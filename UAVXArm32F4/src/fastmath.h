@@ -0,0 +1,40 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+
+#ifndef _fastmath_h
+#define _fastmath_h
+
+// Single precision replacements for libm on the hot path. Error bounds are absolute
+// in radians, or unity for sin/cos, and are checked by uavx-sitl -a.
+
+real32 FastAtan2(real32 y, real32 x); // < 2.5e-6
+real32 FastAsin(real32 x); // < 3e-7, x clamped to [-1, 1]
+void FastSinCos(real32 A, real32 * s, real32 * c); // < 2.5e-7 for |A| < 100
+real32 FastSin(real32 A);
+real32 FastCos(real32 A);
+real32 invSqrt(real32 x); // relative < 5e-6
+
+real32 MakePi(real32 A); // to [-PI, PI) for |A| < 1000
+real32 Make2Pi(real32 A); // to [0, TWO_PI) for |A| < 1000
+
+#endif
+
+
@@ -20,45 +20,41 @@
 
 #include "UAVX.h"
 
-void DFT8(real32 v, real32 *DFT) { // 137uS
-#if defined(INC_DFT)
-	const real32 mR = 0.125f;
-	static boolean Primed = false;
-	static real32 cosarg[8][8], sinarg[8][8];
-	static real32 inp[8];
-	long i, k;
-	double arg;
-	double x[8], y[8];
-
-	if (!Primed) {
-		for (i = 0; i < 8; i++) {
-			inp[i] = v;
-			arg = -2.0 * PI * (real32) i * mR;
-			for (k = 0; k < 8; k++) {
-				cosarg[i][k] = cosf(arg * (real32) k);
-				sinarg[i][k] = sinf(arg * (real32) k);
-			}
-		}
-		Primed = true;
-	} else {
-		for (i = 7; i > 0; i--)
-		inp[i] = inp[i - 1];
-		inp[0] = v;
-	}
+// Direct form I so the coefficients can be moved while running without upsetting the state.
 
-	for (i = 0; i < 8; i++) {
-		x[i] = y[i] = 0.0;
-		for (k = 0; k < 8; k++) {
-			x[i] += inp[k] * cosarg[i][k];
-			y[i] += inp[k] * sinarg[i][k];
-		}
-	}
+void SetNotch(BiquadStruct * F, real32 CentreHz, real32 Q, real32 dT) {
+	real32 w0, cosw0, alpha, a0R;
 
-	for (i = 0; i < 8; i++)
-	DFT[i] = sqrtf(Sqr(x[i]) + Sqr(y[i])) * mR;
+	w0 = TWO_PI * CentreHz * dT;
+	cosw0 = cosf(w0);
+	alpha = sinf(w0) / (2.0f * Q);
+	a0R = 1.0f / (1.0f + alpha);
 
-#endif
-} // DFT8
+	F->b0 = F->b2 = a0R;
+	F->b1 = F->a1 = -2.0f * cosw0 * a0R;
+	F->a2 = (1.0f - alpha) * a0R;
+
+} // SetNotch
+
+void InitBiquad(BiquadStruct * F, real32 v) {
+
+	F->x1 = F->x2 = v;
+	F->y1 = F->y2 = v * (F->b0 + F->b1 + F->b2) / (1.0f + F->a1 + F->a2);
+
+} // InitBiquad
+
+real32 Biquad(BiquadStruct * F, real32 v) {
+	real32 r;
+
+	r = F->b0 * v + F->b1 * F->x1 + F->b2 * F->x2 - F->a1 * F->y1 - F->a2
+			* F->y2;
+	F->x2 = F->x1;
+	F->x1 = v;
+	F->y2 = F->y1;
+	F->y1 = r;
+
+	return (r);
+} // Biquad
 
 
 // Algorithm from N. Wirth's book, implementation by N. Devillard.
@@ -116,39 +112,151 @@ real32 kth_smallest(real32 a[], uint16 n, uint16 k) {
 
 //#define median(a,n) kth_smallest(a,n,(((n)&1)?((n)/2):(((n)/2)-1)))
 
+// Sliding median in O(log N) per sample. The window sits in two heaps either side of the
+// median: larger entries in a min heap at positions 1, 2.. and smaller ones in a max heap at
+// -1, -2.. with the median at 0 as the root of both, so the parent of position i is i/2.
+// Each entry's heap position is tracked so the oldest can be replaced in place. As median()
+// an even count gives the lower median.
+
+#define MedH(i)		F->v[F->Heap[(i) + (MEDIAN_MAX_LEN / 2)]]
+
+static void MedianSwap(MedianFilterStruct * F, idx i, idx j) {
+	int8 * H = &F->Heap[MEDIAN_MAX_LEN / 2];
+	int8 t;
+
+	t = H[i];
+	H[i] = H[j];
+	H[j] = t;
+	F->Pos[H[i]] = i;
+	F->Pos[H[j]] = j;
+
+} // MedianSwap
+
+static void MedianMinDown(MedianFilterStruct * F, idx i) {
+	idx c, MinCt;
+
+	MinCt = F->Count >> 1;
+	for (c = i * 2; c <= MinCt; i = c, c *= 2) {
+		if ((c < MinCt) && (MedH(c + 1) < MedH(c)))
+			c++;
+		if (MedH(c) >= MedH(i))
+			break;
+		MedianSwap(F, c, i);
+	}
+
+} // MedianMinDown
+
+static void MedianMaxDown(MedianFilterStruct * F, idx i) {
+	idx c, MaxCt;
+
+	MaxCt = (F->Count - 1) >> 1;
+	for (c = i * 2; c >= -MaxCt; i = c, c *= 2) {
+		if ((c > -MaxCt) && (MedH(c - 1) > MedH(c)))
+			c--;
+		if (MedH(c) <= MedH(i))
+			break;
+		MedianSwap(F, c, i);
+	}
+
+} // MedianMaxDown
+
+static void MedianFix(MedianFilterStruct * F, idx p, boolean Larger) {
+	// the entry at p has been replaced and is Larger or smaller than before
+
+	if (p > 0) {
+		if (Larger)
+			MedianMinDown(F, p);
+		else {
+			while ((p > 0) && (MedH(p) < MedH(p / 2))) {
+				MedianSwap(F, p, p / 2);
+				p /= 2;
+			}
+			if ((p == 0) && (F->Count > 2) && (MedH(-1) > MedH(0))) {
+				MedianSwap(F, -1, 0);
+				MedianMaxDown(F, -1);
+			}
+		}
+	} else if (p < 0) {
+		if (!Larger)
+			MedianMaxDown(F, p);
+		else {
+			while ((p < 0) && (MedH(p) > MedH(p / 2))) {
+				MedianSwap(F, p, p / 2);
+				p /= 2;
+			}
+			if ((p == 0) && (F->Count > 1) && (MedH(1) < MedH(0))) {
+				MedianSwap(F, 1, 0);
+				MedianMinDown(F, 1);
+			}
+		}
+	} else if ((F->Count > 2) && (MedH(-1) > MedH(0))) {
+		MedianSwap(F, -1, 0);
+		MedianMaxDown(F, -1);
+	} else if ((F->Count > 1) && (MedH(1) < MedH(0))) {
+		MedianSwap(F, 1, 0);
+		MedianMinDown(F, 1);
+	}
+
+} // MedianFix
+
+void InitMedianFilter(MedianFilterStruct * F, idx N) {
 
-// FIR filter
+	F->N = Limit(N, 1, MEDIAN_MAX_LEN);
+	F->Count = F->Next = 0;
 
+} // InitMedianFilter
+
+real32 MedianFilter(MedianFilterStruct * F, real32 v) { // median of the last N samples
+	real32 Old;
+	idx p, e;
+
+	e = F->Next;
+	if (F->Count < F->N) { // filling 0, 1, -1, 2, -2..
+		p = (F->Count & 1) ? (F->Count + 1) >> 1 : -(F->Count >> 1);
+		F->Heap[p + (MEDIAN_MAX_LEN / 2)] = e;
+		F->Pos[e] = p;
+		F->v[e] = v;
+		F->Count++;
+		MedianFix(F, p, p < 0);
+	} else {
+		p = F->Pos[e];
+		Old = F->v[e];
+		F->v[e] = v;
+		MedianFix(F, p, v > Old);
+	}
+	F->Next = (e + 1 < F->N) ? e + 1 : 0;
 
-void InitSmoothr32xn(HistStruct * F) {
+	return (MedH(0));
+} // MedianFilter
+
+
+// Moving average
+
+void InitMAFilter(MAFilterStruct * F, idx N) { // N a power of 2 <= MA_MAX_LEN
+
+	F->N = Limit(N, 1, MA_MAX_LEN);
+	F->NR = 1.0f / F->N;
 	F->Primed = false;
-} // InitSmooth32xn
 
-real32 Smoothr32xn(HistStruct * F, uint8 n, real32 v) {
-	idx i, p;
+} // InitMAFilter
+
+real32 MAFilter(MAFilterStruct * F, real32 v) {
+	idx i;
 
 	if (!F->Primed) {
-		for (i = 0; i < n; i++)
+		for (i = 0; i < F->N; i++)
 			F->h[i] = v;
-
 		F->Head = 0;
-		F->Tail = (n - 1);
-
-		F->S = v * (real32) n;
+		F->S = v * F->N;
 		F->Primed = true;
 	} else {
-		p = F->Head;
-		F->S -= F->h[p];
-		F->Head = (p + 1) & (n - 1);
-		p = F->Tail;
-		p = (p + 1) & (n - 1);
-		F->h[p] = v;
-		F->Tail = p;
-		F->S += v;
+		F->S += v - F->h[F->Head];
+		F->h[F->Head] = v;
+		F->Head = (F->Head + 1) & (F->N - 1);
 	}
 
-	return (F->S / (real32) n);
-} // Smoothr32xn
+	return (F->S * F->NR);
+} // MAFilter
 
 __attribute__((always_inline))     inline real32 SimpleFilterCoefficient(real32 CutHz, real32 dT) {
 
@@ -166,100 +274,239 @@ real32 LeadFilter(real32 Pos, real32 VelP, real32 Vel, real32 Lag) {
 	return (Pos + Vel * Lag + (Vel - VelP) * Sqr(Lag));
 } // LeadFilter
 
+// Second order Butterworth low pass as a biquad, prewarped so the tan() is paid only here.
 
-real32 LPFilterBW(HistStruct * F, real32 v, const real32 CutHz, real32 dT) {
-	real32 r;
-	idx i;
+void SetButterworth(BiquadStruct * F, real32 CutHz, real32 dT) {
+	real32 wc, k1, k2, a0R;
 
-	// WARNING - the priming process uses the first dT only and so
-	// this is better instantiated using a constant for dT
-	if (!F->Primed) {
-		real32 wc, k1, k2, k3, a0, a1, a2, b1, b2;
-
-		wc = tan(PI * CutHz * dT);
-		k1 = sqrtf(2.0f) * wc;
-		k2 = Sqr(wc);
-		a0 = k2 / (1.0f + k1 + k2);
-		a1 = 2.0f * a0;
-		a2 = a0;
-		k3 = 2.0f * a0 / k2;
-		b1 = -2.0f * a0 + k3;
-		b2 = 1 - 2.0f * a0 - k3;
-		F->c[0] = a0;
-		F->c[1] = a1;
-		F->c[2] = a2;
-		F->c[3] = b1;
-		F->c[4] = b2;
-
-		for (i = 0; i < 5; i++)
-			F->h[i] = v;
-		F->Primed = true;
-	}
+	wc = tanf(PI * CutHz * dT);
+	k1 = sqrtf(2.0f) * wc;
+	k2 = Sqr(wc);
+	a0R = 1.0f / (1.0f + k1 + k2);
 
-	for (i = 4; i > 0; i--)
-		F->h[i] = F->h[i - 1];
-	F->h[0] = v;
+	F->b0 = F->b2 = k2 * a0R;
+	F->b1 = 2.0f * F->b0;
+	F->a1 = 2.0f * (k2 - 1.0f) * a0R;
+	F->a2 = (1.0f - k1 + k2) * a0R;
 
-	r = 0.0f;
-	for (i = 0; i < 5; i++)
-		r += F->h[i] * F->c[i];
+} // SetButterworth
 
-	return (r);
-} // LPFilterBW
 
-
-real32 PavelDifferentiator(HistStruct *F, real32 v) {
+real32 PavelDifferentiator(PavelStruct * F, real32 v) {
 	// Pavel Holoborodko, see http://www.holoborodko.com/pavel/numerical-methods/
 	// numerical-derivative/smooth-low-noise-differentiators/
 
-	idx i;
-	//const idx N = 5;
-	//static const real32 C[] = { 0.625f, 0.25f, -1.0f, -0.25f, 0.375f };
-
-	const idx N = 6;
 	// h[0] = 3/8, h[-1] = 1/2, h[-2] = -1/2, h[-3] = -3/4, h[-4] = 1/8, h[-5] = 1/4
-	const real32 C[] = { 0.375f, 0.5f, -0.5f, -0.75, 0.125f, 0.25f };
-
-	real32 r = 0.0f;
+	static const real32 C[PAVEL_LEN] = { 0.375f, 0.5f, -0.5f, -0.75, 0.125f,
+			0.25f };
+	real32 r;
+	idx i;
 
 	if (!F->Primed) {
-		for (i = 0; i < N; i++)
+		for (i = 0; i < PAVEL_LEN; i++)
 			F->h[i] = v;
 		F->Primed = true;
 	} else {
-		for (i = N; i > 0; --i)
+		for (i = PAVEL_LEN - 1; i > 0; i--)
 			F->h[i] = F->h[i - 1];
 		F->h[0] = v;
 	}
 
-	for (i = 0; i < N; ++i)
+	r = 0.0f;
+	for (i = 0; i < PAVEL_LEN; i++)
 		r += C[i] * F->h[i];
 
 	return (r);
 } // Pavel
 
-__attribute__((always_inline))     inline real32 LPFilter(HistStruct * F, const idx Order, real32 v,
-		const real32 CutHz, real32 dT) {
+// Cascaded first order low pass. InitLPFilter fixes the cut off and the coefficient for a
+// nominal dT, normally at a parameter change. A CutHz of zero passes samples through.
+
+void InitLPFilter(LPFilterStruct * F, idx Order, real32 CutHz, real32 dT) {
+
+	F->Order = Limit(Order, 1, LP_MAX_ORDER);
+	F->Tau = (CutHz > 0.0f) ? 1.0f / (TWO_PI * CutHz) : 0.0f;
+	F->dT = dT;
+	F->K = (dT > 0.0f) ? dT / (F->Tau + dT) : 1.0f;
+	F->Primed = false;
+
+} // InitLPFilter
+
+__attribute__((always_inline))     inline real32 LPFilter(LPFilterStruct * F, real32 v) {
 	idx n;
 
 	if (!F->Primed) {
-		for (n = 1; n <= Order; n++)
+		for (n = 1; n <= F->Order; n++)
 			F->h[n] = v;
 		F->Primed = true;
-		F->Tau = 1.0f / (TWO_PI * CutHz);
 	}
 
-	F->S = dT / (F->Tau + dT);
-
 	F->h[0] = v;
+	for (n = 1; n <= F->Order; n++)
+		F->h[n] += (F->h[n - 1] - F->h[n]) * F->K;
 
-	for (n = 1; n <= Order; n++)
-		F->h[n] += (F->h[n - 1] - F->h[n]) * F->S;
-
-	return (F->h[Order]);
+	return (F->h[F->Order]);
 
 } // LPFilter
 
+// As LPFilter for a varying dT. The coefficient is only recomputed when dT moves by more
+// than 1/64 of the interval it was computed for. A zero dT leaves the output unchanged.
+
+real32 LPFilterdT(LPFilterStruct * F, real32 v, real32 dT) {
+
+	if (dT <= 0.0f) {
+		if (F->Primed)
+			return (F->h[F->Order]);
+	} else if (fabsf(dT - F->dT) > (F->dT * 0.015625f)) {
+		F->dT = dT;
+		F->K = dT / (F->Tau + dT);
+	}
+
+	return (LPFilter(F, v));
+
+} // LPFilterdT
+
+// As LPFilterdT but dT is the interval between the capture times of successive samples.
+
+real32 LPFilterAt(LPFilterStruct * F, real32 v, uint64 SampleuS) {
+	real32 dT;
+
+	dT = (F->Primed && (SampleuS > F->SampleuS)) ? (SampleuS - F->SampleuS)
+			* 0.000001f : 0.0f;
+	F->SampleuS = SampleuS;
+
+	return (LPFilterdT(F, v, dT));
+
+} // LPFilterAt
+
+//______________________________________________________________________________________________
+
+// Three axis filter banks. Where the target has float vectors, SSE on the SITL host, each
+// stage is one operation on all lanes using the GCC vector extension. The Cortex-M4 has only
+// integer SIMD so there the lanes are unrolled into independent multiply-add chains which
+// hide the FPU latency. Define FILTER_BANK_SCALAR to check the scalar form on the host.
+
+#if (defined(__SSE__) || defined(__ARM_NEON)) && !defined(FILTER_BANK_SCALAR)
+#define FILTER_BANK_VECTORS
+typedef real32 real32x4 __attribute__((vector_size(16)));
+#define Lanes(p)	(*(real32x4 *) (p))
+#endif
+
+void InitLPFilterBank(LPFilterBankStruct * F, idx Order, real32 CutHz,
+		real32 dT) {
+
+	memset(F->h, 0, sizeof(F->h));
+	F->Order = Limit(Order, 1, LP_MAX_ORDER);
+	F->Tau = (CutHz > 0.0f) ? 1.0f / (TWO_PI * CutHz) : 0.0f;
+	F->dT = dT;
+	F->K = (dT > 0.0f) ? dT / (F->Tau + dT) : 1.0f;
+	F->Primed = false;
+
+} // InitLPFilterBank
+
+void LPFilterBankAt(LPFilterBankStruct * F, real32 * v, uint64 SampleuS) { // v[3] in place
+#if defined(FILTER_BANK_VECTORS)
+	real32x4 x, h;
+#endif
+	real32 dT;
+	idx a, n;
+
+	dT = (F->Primed && (SampleuS > F->SampleuS)) ? (SampleuS - F->SampleuS)
+			* 0.000001f : 0.0f;
+	F->SampleuS = SampleuS;
+
+	if (!F->Primed) {
+		for (n = 0; n <= F->Order; n++)
+			for (a = X; a <= Z; a++)
+				F->h[n][a] = v[a];
+		F->Primed = true;
+	} else if (dT > 0.0f) {
+		if (fabsf(dT - F->dT) > (F->dT * 0.015625f)) {
+			F->dT = dT;
+			F->K = dT / (F->Tau + dT);
+		}
+
+#if defined(FILTER_BANK_VECTORS)
+		x = (real32x4) {v[X], v[Y], v[Z], 0.0f}; // kept in registers between stages
+		for (n = 1; n <= F->Order; n++) {
+			h = Lanes(F->h[n]);
+			h += (x - h) * F->K;
+			Lanes(F->h[n]) = x = h;
+		}
+#else
+		for (a = X; a <= Z; a++)
+			F->h[0][a] = v[a];
+
+		for (n = 1; n <= F->Order; n++) {
+			F->h[n][X] += (F->h[n - 1][X] - F->h[n][X]) * F->K;
+			F->h[n][Y] += (F->h[n - 1][Y] - F->h[n][Y]) * F->K;
+			F->h[n][Z] += (F->h[n - 1][Z] - F->h[n][Z]) * F->K;
+		}
+#endif
+	}
+
+	for (a = X; a <= Z; a++)
+		v[a] = F->h[F->Order][a];
+
+} // LPFilterBankAt
+
+void InitBiquadBank(BiquadBankStruct * F) { // all lanes pass through
+	idx a;
+
+	memset(F, 0, sizeof(BiquadBankStruct));
+	for (a = 0; a < FILTER_LANES; a++)
+		F->b0[a] = 1.0f;
+
+} // InitBiquadBank
+
+void SetBiquadBankLane(BiquadBankStruct * F, idx a, BiquadStruct * C) {
+
+	F->b0[a] = C->b0;
+	F->b1[a] = C->b1;
+	F->b2[a] = C->b2;
+	F->a1[a] = C->a1;
+	F->a2[a] = C->a2;
+
+} // SetBiquadBankLane
+
+void PrimeBiquadBankLane(BiquadBankStruct * F, idx a, real32 v) {
+
+	F->x1[a] = F->x2[a] = v;
+	F->y1[a] = F->y2[a] = v * (F->b0[a] + F->b1[a] + F->b2[a]) / (1.0f
+			+ F->a1[a] + F->a2[a]);
+
+} // PrimeBiquadBankLane
+
+void BiquadBank(BiquadBankStruct * F, real32 * v) { // v[3] in place
+#if defined(FILTER_BANK_VECTORS)
+	real32x4 x, r;
+
+	x = (real32x4) {v[X], v[Y], v[Z], 0.0f};
+	r = Lanes(F->b0) * x + Lanes(F->b1) * Lanes(F->x1) + Lanes(F->b2) * Lanes(F->x2)
+			- Lanes(F->a1) * Lanes(F->y1) - Lanes(F->a2) * Lanes(F->y2);
+	Lanes(F->x2) = Lanes(F->x1);
+	Lanes(F->x1) = x;
+	Lanes(F->y2) = Lanes(F->y1);
+	Lanes(F->y1) = r;
+
+	v[X] = r[X];
+	v[Y] = r[Y];
+	v[Z] = r[Z];
+#else
+	real32 r;
+	idx a;
+
+	for (a = X; a <= Z; a++) {
+		r = F->b0[a] * v[a] + F->b1[a] * F->x1[a] + F->b2[a] * F->x2[a] - F->a1[a]
+				* F->y1[a] - F->a2[a] * F->y2[a];
+		F->x2[a] = F->x1[a];
+		F->x1[a] = v[a];
+		F->y2[a] = F->y1[a];
+		F->y1[a] = v[a] = r;
+	}
+#endif
+} // BiquadBank
+
 
 int16 SensorSlewLimit(uint8 sensor, int16 * O, int16 N, int16 Slew) {
 	int16 L, H;
@@ -313,44 +560,6 @@ real32 DeadZone(real32 v, real32 t) {
 } // DeadZone
 
 
-real32 Make2Pi(real32 A) {
-	while (A < 0)
-		A += DegreesToRadians(360.0f);
-	while (A >= DegreesToRadians(360.0f))
-		A -= DegreesToRadians(360.0f);
-
-	return (A);
-} // Make2Pi
-
-real32 MakePi(real32 A) {
-	while (A < -DegreesToRadians(180.0f))
-		A += DegreesToRadians(360.0f);
-	while (A >= DegreesToRadians(180.0f))
-		A -= DegreesToRadians(360.0f);
-
-	return (A);
-} // MakePi
-
-
-real32 invSqrt(real32 x) {
-
-#if defined(STM32F4)
-	return (1.0f / sqrtf(x)); // hopefully gcc uses VSQRT for M4
-#else
-	// Fast inverse square-root
-	// See: http://en.wikipedia.org/wiki/Fast_inverse_square_root
-
-	real32 halfx = 0.5f * x;
-	real32 y = x;
-	uint32 i = *(uint32*) &y;
-	i = 0x5f3759df - (i >> 1);
-	y = *(real32*) &i;
-	y = y * (1.5f - (halfx * y * y));
-	return y;
-#endif
-} // invSqrt
-
-
 void Rotate(real32 * nx, real32 * ny, real32 x, real32 y, real32 A) { // A rotation CW
 	static real32 cA = 1.0f;
 	static real32 sA = 0.0f;
@@ -358,8 +567,7 @@ void Rotate(real32 * nx, real32 * ny, real32 x, real32 y, real32 A) { // A rotat
 	real32 Temp;
 
 	if (A != AP) { // saves ~7uS for successive calls with same angle
-		cA = cosf(A);
-		sA = sinf(A);
+		FastSinCos(A, &sA, &cA);
 		AP = A;
 	}
 
@@ -22,28 +22,40 @@
 #ifndef _filters_h
 #define _filters_h
 
-void DFT8(real32 v, real32 *DFT);
+void SetNotch(BiquadStruct * F, real32 CentreHz, real32 Q, real32 dT);
+void InitBiquad(BiquadStruct * F, real32 v);
+real32 Biquad(BiquadStruct * F, real32 v);
 
 real32 kth_smallest(real32 a[], uint16 n, uint16 k);
 #define median(a,n) kth_smallest(a,n,(((n)&1)?((n)/2):(((n)/2)-1)))
+void InitMedianFilter(MedianFilterStruct * F, idx N);
+real32 MedianFilter(MedianFilterStruct * F, real32 v);
 
-void InitSmoothr32xn(HistStruct * F);
-real32 Smoothr32xn(HistStruct * F, uint8 n, real32 v);
+void InitMAFilter(MAFilterStruct * F, idx N);
+real32 MAFilter(MAFilterStruct * F, real32 v);
 
 real32 SimpleFilter(real32 O, real32 N, const real32 K);
 real32 SimpleFilterCoefficient(real32 CutHz, real32 dT);
-real32 LPFilter(HistStruct * F, const idx Order, real32 v, const real32 CutHz, real32 dT);
-real32 LPFilterBW(HistStruct * F, real32 v, const real32 CutHz, real32 dT);
-real32 PavelDifferentiator(HistStruct *F, real32 v);
+void InitLPFilter(LPFilterStruct * F, idx Order, real32 CutHz, real32 dT);
+real32 LPFilter(LPFilterStruct * F, real32 v);
+real32 LPFilterdT(LPFilterStruct * F, real32 v, real32 dT);
+real32 LPFilterAt(LPFilterStruct * F, real32 v, uint64 SampleuS);
+void SetButterworth(BiquadStruct * F, real32 CutHz, real32 dT);
+real32 PavelDifferentiator(PavelStruct * F, real32 v);
+
+void InitLPFilterBank(LPFilterBankStruct * F, idx Order, real32 CutHz,
+		real32 dT);
+void LPFilterBankAt(LPFilterBankStruct * F, real32 * v, uint64 SampleuS);
+void InitBiquadBank(BiquadBankStruct * F);
+void SetBiquadBankLane(BiquadBankStruct * F, idx a, BiquadStruct * C);
+void PrimeBiquadBankLane(BiquadBankStruct * F, idx a, real32 v);
+void BiquadBank(BiquadBankStruct * F, real32 * v);
 
 real32 Threshold(real32 v, real32 t);
 real32 DeadZone(real32 v, real32 t);
 real32 SlewLimit(real32 * Old, real32 New, const real32 Rate, real32 dT);
 int16 SensorSlewLimit(uint8 sensor, int16 * Old, int16 New, int16 Slew);
 
-real32 Make2Pi(real32);
-real32 MakePi(real32);
-real32 invSqrt(real32 x);
 void Rotate(real32 * nx, real32 * ny, real32 x, real32 y, real32 A);
 real32 DecayX(real32 v, real32 d, real32 dT);
 real32 scaleRangef(real32 v, real32 srcMin, real32 srcMax, real32 destMin,
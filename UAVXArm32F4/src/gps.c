@@ -46,10 +46,12 @@ const uint32 GPSBaud = 115200;
 const uint32 UBXGPSBaud = 115200; //230400;
 
 real32 GPSdT, GPSdTR;
-real32 GPSLag = 1.0f; // MTK 0.5 for UBlox
+real32 GPSLag = GPS_LAG_S;
+real32 GPSRxLag = 0.0f; // measured, first packet byte to use of the fix
 real32 GPSMinhAcc = GPS_MIN_HACC;
 
 uint32 LastGPSUpdatemS = 0;
+uint64 GPSPacketuS = 0; // local time of the first byte of the current packet
 
 uint8 nll, cc, lo, hi, ll, ss, tt, GPSCheckSumChar;
 uint8 GPSTxCheckSum, RxCheckSum;
@@ -449,7 +451,7 @@ void UbxSetInterval(uint8 s, uint16 Interval) {
 	Delay1mS(50);
 } // UbxSetInterval
 
-void UbxSaveConfig(uint8 s) {
+void UbxSendSaveConfig(uint8 s) {
 	enum clearMask { // beware 8M flags extended
 		ioport = _b0,
 		msgConf = _b1,
@@ -481,7 +483,12 @@ void UbxSaveConfig(uint8 s) {
 	TxUbxu8(s, devEEPROM | devFlash | devBBR);
 	TxUbxCheckSum(s);
 
-	Delay1mS(1000);
+} // UbxSendSaveConfig
+
+void UbxSaveConfig(uint8 s) {
+
+	UbxSendSaveConfig(s);
+	Delay1mS(UBX_SAVE_CONFIG_MS);
 
 } // UbxSaveConfig
 
@@ -646,6 +653,7 @@ void ParseUbxPacket(void) {
 		case UBX_NAV_PVT:
 			GPS.missionTime = GPS.lastPosUpdatemS = GPS.lastVelUpdatemS
 					= ubx.payload.pvt.iTOW;
+			GPS.FixuS = GPSPacketuS;
 			// = ubx.payload.pvt.year;
 			// = ubx.payload.pvt.month;
 			// = ubx.payload.pvt.day;
@@ -716,6 +724,7 @@ void ParseUbxPacket(void) {
 			break;
 		case UBX_NAV_POSLLH:
 			GPS.missionTime = GPS.lastPosUpdatemS = ubx.payload.posllh.iTOW;
+			GPS.FixuS = GPSPacketuS;
 			GPS.lat = GPS.C[NorthC].Raw = (real64) ubx.payload.posllh.lat;
 			GPS.lon = GPS.C[EastC].Raw = (real64) ubx.payload.posllh.lon;
 			GPS.height = GPS.altitude = ubx.payload.posllh.hMSL * 0.001f; // mm => m
@@ -807,8 +816,10 @@ void RxUbxPacket(void) {
 		c = RxChar(GPSRxSerial);
 		switch (RxState) {
 		case WaitSentinel:
-			if (c == UBX_PREAMBLE1)
+			if (c == UBX_PREAMBLE1) {
+				GPSPacketuS = uSClock64();
 				RxState = WaitSentinel2;
+			}
 			break;
 		case WaitSentinel2:
 			RxState = (c == UBX_PREAMBLE2) ? WaitClass : WaitSentinel;
@@ -868,7 +879,7 @@ boolean WaitUbxAck(uint8 class, uint8 id) {
 	Timeout = mSClock() + 500;
 	do {
 		RxUbxPacket();
-	} while ((mSClock() < Timeout) && ((ubx.class != class) || (ubx.id != id)));
+	} while (!TimeReached(mSClock(), Timeout) && ((ubx.class != class) || (ubx.id != id)));
 
 	return ((ubx.class == class) && (ubx.id == id));
 
@@ -1027,6 +1038,7 @@ void ParseMTKPacket(void) {
 	GPS.noofsats = MTKBuffer.msg.satellites;
 	GPS.fix = MTKBuffer.msg.fixtype;
 	GPS.lastVelUpdatemS = GPS.lastPosUpdatemS = MTKBuffer.msg.utc_time;
+	GPS.FixuS = GPSPacketuS;
 
 	GPS.hDOP = MTKBuffer.msg.hdop * 0.01f;
 	GPS.hAcc = GPS.vAcc = GPS.hDOP * GPS_HDOP_TO_HACC; // TODO: kludge
@@ -1046,9 +1058,11 @@ void RxMTKPacket(void) {
 		switch (RxState) {
 		case WaitSentinel:
 			if (c == PREAMBLE1_MTK16) {
+				GPSPacketuS = uSClock64();
 				UseMTK16GPS = true;
 				RxState = WaitID;
 			} else if (c == PREAMBLE1_MTK19) {
+				GPSPacketuS = uSClock64();
 				UseMTK16GPS = false;
 				RxState = WaitID;
 			} else
@@ -1207,7 +1221,7 @@ void ParseGXGGASentence(void) { // full position $GXGGA fix
 	UpdateField();
 
 	UpdateField(); //UTime
-	PacketTimemS = mSClock(); // ConvertUTime(lo, hi);
+	PacketTimemS = (uint32) (GPSPacketuS / 1000); // ConvertUTime(lo, hi);
 
 	UpdateField(); //Lat
 	GPS.C[NorthC].Raw = ConvertLatLon(lo, hi);
@@ -1241,8 +1255,10 @@ void ParseGXGGASentence(void) { // full position $GXGGA fix
 	//UpdateField();   // GHeightUnit
 
 	F.GPSValid = (GPS.fix > 0) && (GPS.noofsats >= GPS_MIN_SATELLITES);
-	if (F.GPSValid)
+	if (F.GPSValid) {
 		GPS.missionTime = GPS.lastPosUpdatemS = PacketTimemS;
+		GPS.FixuS = GPSPacketuS;
+	}
 
 } // ParseGXGGASentence
 
@@ -1255,7 +1271,7 @@ void ParseGXRMCSentence() { // main current position and heading
 	UpdateField();
 
 	UpdateField(); //UTime
-	PacketTimemS = mSClock(); //ConvertUTime(lo, hi);
+	PacketTimemS = (uint32) (GPSPacketuS / 1000); //ConvertUTime(lo, hi);
 
 	UpdateField();
 	if (NMEA.s[lo] == 'A') {
@@ -1334,7 +1350,7 @@ void ProcessGPSSentence(void) {
 				if ((CurrGPSType != UBXBinGPS)
 						&& (CurrGPSType != UBXBinGPSInit)) {
 					for (a = NorthC; a <= EastC; a++) {
-						GPS.C[a].Vel = (GPS.C[a].Pos - GPS.C[a].PosP) * GPSdT;
+						GPS.C[a].Vel = (GPS.C[a].Pos - GPS.C[a].PosP) * GPSdTR;
 						GPS.C[a].PosP = GPS.C[a].Pos;
 					}
 					GPS.gspeed = sqrtf(Sqr(GPS.C[NorthC].Vel)
@@ -1368,6 +1384,7 @@ void RxNMEAPacket(void) {
 		switch (RxState) {
 		case WaitSentinel:
 			if (c == '$') {
+				GPSPacketuS = uSClock64();
 				ll = tt = ss = RxCheckSum = 0;
 				RxState = WaitID;
 			}
@@ -1389,6 +1406,7 @@ void RxNMEAPacket(void) {
 			if (c == '*')
 				RxState = WaitCheckSum;
 			else if (c == '$') {
+				GPSPacketuS = uSClock64();
 				ll = tt = RxCheckSum = 0;
 				RxState = WaitID;
 			} else {
@@ -1474,12 +1492,16 @@ void UpdateGPS(void) {
 			ProcessGPSSentence();
 
 			F.NewGPSPosition = F.GPSValid && F.OriginValid;
-			if (F.NewGPSPosition)
+			if (F.NewGPSPosition) {
 				mSTimer(NowmS, GPSTimeout, GPS_TIMEOUT_MS);
+				GPSRxLag = SimpleFilter(GPSRxLag, (uSClock64() - GPS.FixuS)
+						* 0.000001f, 0.1f);
+				GPSLag = GPS_LAG_S + GPSRxLag; // receiver latency is not observable
+			}
 		}
 
 	} else {
-		if (NowmS > mS[GPSTimeout]) {
+		if (mSTimeout(NowmS, GPSTimeout)) {
 
 			F.NavigationEnabled = false;
 			ZeroNavCorrections();
@@ -1506,7 +1528,7 @@ void InitGPS(void) {
 		GPS.C[EastC].OriginRaw = DEFAULT_HOME_LON;
 		GPS.longitudeCorrection = DEFAULT_LON_CORR;
 
-		mS[FakeGPSUpdate] = 0;
+		mSTimer(mSClock(), FakeGPSUpdate, 0);
 	}
 
 	LEDOn(LEDBlueSel);
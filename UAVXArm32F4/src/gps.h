@@ -41,6 +41,7 @@ typedef struct {
 	uint8 fix;
 	int32 missionTime, startTime;
 	int32 lastVelUpdatemS, lastPosUpdatemS;
+	uint64 FixuS; // local time the packet carrying the position started to arrive
 	real32 altitude, relAltitude, originAltitude, geoidheight;
 	GPSCoord C[3];
 	real32 longitudeCorrection;
@@ -82,6 +83,9 @@ typedef struct {
 
 GPSRec GPS;
 
+#define UBX_SAVE_CONFIG_MS 1000
+
+void UbxSendSaveConfig(uint8 s);
 void UbxSaveConfig(uint8 s);
 
 void UpdateField(void);
@@ -119,9 +123,10 @@ extern const uint8 NMEATags[MAX_NMEA_SENTENCES][5];
 extern uint8 GPSPacketTag;
 extern real32 GPSdT, GPSdTR;
 extern uint32 LastGPSUpdatemS;
+extern uint64 GPSPacketuS;
 extern uint8 nll, cc, lo, hi;
 extern boolean EmptyField;
-extern real32 GPSLag;
+extern real32 GPSLag, GPSRxLag;
 extern real32 GPSMinhAcc;
 
 extern uint8 CurrGPSType;
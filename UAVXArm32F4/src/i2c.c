@@ -20,11 +20,15 @@
 
 #include "UAVX.h"
 
-#define I2C_DEFAULT_TIMEOUT 30000
-
 #if (MAX_I2C_PORTS>0)
 
 volatile i2cStateDef i2cState[MAX_I2C_PORTS] = { { 0 } };
+i2cStatsStruct i2cStats[MAX_I2C_PORTS];
+
+static i2cTransStruct i2cQ[MAX_I2C_PORTS][I2C_QUEUE_LEN];
+static volatile uint8 i2cQHead[MAX_I2C_PORTS], i2cQTail[MAX_I2C_PORTS]; // free running, masked on use
+
+static void i2cFinish(idx i2cCurr, boolean ok);
 
 
 void i2c_er_handler(uint8 i2cCurr) {
@@ -58,16 +62,20 @@ void i2c_er_handler(uint8 i2cCurr) {
 		}
 	}
 	d->I2C->SR1 &= ~0x0f00; //reset all the error bits to clear the interrupt
-	i2cState[i2cCurr].busy = false;
+	if (i2cState[i2cCurr].busy) {
+		i2cStats[i2cCurr].Errors++;
+		i2cFinish(i2cCurr, false);
+	}
 } // i2c_er_handler
 
 void i2c_ev_handler(uint8 i2cCurr) {
 	// Original source unknown but based on those in baseflight by TimeCop
-	static int8 i; //index is signed -1==send the sub-address
+	int8 i; //index is signed -1==send the sub-address
 	uint8 SReg_1; //read the status register here
 	I2CPortDef * d;
 
 	d = &I2CPorts[i2cCurr];
+	i = i2cState[i2cCurr].i;
 
 	SReg_1 = d->I2C->SR1;
 
@@ -168,6 +176,7 @@ void i2c_ev_handler(uint8 i2cCurr) {
 				I2C_ITConfig(d->I2C, I2C_IT_BUF, DISABLE); //disable TXE to allow the buffer to flush
 		}
 	}
+	i2cState[i2cCurr].i = i;
 	if (i == i2cState[i2cCurr].bytes + 1) { //we have completed the current job
 		//Completion Tasks go here
 		//End of completion tasks
@@ -175,29 +184,35 @@ void i2c_ev_handler(uint8 i2cCurr) {
 		// d->I2C->CR1 &= ~0x0800;   //reset the POS bit so NACK applied to the current byte
 		if (i2cState[i2cCurr].final_stop) //if there is a final stop and no more jobs, bus is inactive, disable interrupts to prevent BTF
 			I2C_ITConfig(d->I2C, I2C_IT_EVT | I2C_IT_ERR, DISABLE); //Disable EVT and ERR interrupts while bus inactive
-		i2cState[i2cCurr].busy = false;
+		i2cFinish(i2cCurr, true);
 	}
 } // i2c_ev_handler
 
 
-boolean i2cReadBlock(uint8 i2cSel, uint8 id, uint8 reg, uint8 len, uint8* buf) {
-	// Original source unknown but based on those in baseflight by TimeCop
-	uint32 timeout = I2C_DEFAULT_TIMEOUT;
-	idx i2cCurr;
+//______________________________________________________________________________________________
+
+// Transactions. Each port has its own queue. The main loop is the only producer and the
+// event ISR retires the head on completion and starts the next, so a sensor driver may post
+// its reads and collect the results on a later pass. Errors retire the transaction at once
+// and a stalled transaction is abandoned after I2C_TIMEOUT_US by i2cCheckTimeout.
+
+static void i2cStart(idx i2cCurr) {
+	i2cTransStruct * t;
 	I2CPortDef * d;
 
-	i2cCurr = i2cMap[i2cSel] - 1;
+	t = &i2cQ[i2cCurr][i2cQHead[i2cCurr] & (I2C_QUEUE_LEN - 1)];
 	d = &I2CPorts[i2cCurr];
 
-	i2cState[i2cCurr].addr = id;
-	i2cState[i2cCurr].reg = reg;
-	i2cState[i2cCurr].writing = false;
-	i2cState[i2cCurr].reading = true;
+	i2cState[i2cCurr].addr = t->id;
+	i2cState[i2cCurr].reg = t->reg;
+	i2cState[i2cCurr].writing = !t->Read;
+	i2cState[i2cCurr].reading = t->Read;
 	i2cState[i2cCurr].subaddress_sent = false;
 	i2cState[i2cCurr].final_stop = false;
-	i2cState[i2cCurr].read_p = buf;
-	i2cState[i2cCurr].write_p = buf;
-	i2cState[i2cCurr].bytes = len;
+	i2cState[i2cCurr].read_p = t->data;
+	i2cState[i2cCurr].write_p = t->data;
+	i2cState[i2cCurr].bytes = t->len;
+	i2cState[i2cCurr].StartuS = uSClock();
 	i2cState[i2cCurr].busy = true;
 
 	if (!(d->I2C->CR2 & I2C_IT_EVT)) { //if we are restarting the driver
@@ -209,67 +224,141 @@ boolean i2cReadBlock(uint8 i2cSel, uint8 id, uint8 reg, uint8 len, uint8* buf) {
 		I2C_ITConfig(d->I2C, I2C_IT_EVT | I2C_IT_ERR, ENABLE); //allow the interrupts to fire off again
 	}
 
-	while (i2cState[i2cCurr].busy && (--timeout > 0)) {
-	}
-	if (timeout == 0) {
+} // i2cStart
+
+static void i2cFinish(idx i2cCurr, boolean ok) {
+	i2cTransStruct * t;
+
+	t = &i2cQ[i2cCurr][i2cQHead[i2cCurr] & (I2C_QUEUE_LEN - 1)];
+
+	if (ok)
+		i2cStats[i2cCurr].Completed++;
+	else {
 		i2cState[i2cCurr].i2cErrors++;
 		setStat(I2CFailS, i2cState[i2cCurr].i2cErrors);
-		i2cInit(i2cCurr);
-		return (false);
 	}
 
-	return (true);
-} // i2cReadBlock
+	i2cState[i2cCurr].ok = ok;
+	i2cState[i2cCurr].busy = false;
+	i2cQHead[i2cCurr]++;
 
-boolean i2cWriteBlock(uint8 i2cSel, uint8 id, uint8 reg, uint8 len_,
-		uint8 *data) {
-	// Original source unknown but based on those in baseflight by TimeCop
-	idx i, i2cCurr;
-	uint8 my_data[128]; // TODO: magic number
-	uint32 timeout = I2C_DEFAULT_TIMEOUT;
-	I2CPortDef * d;
+	if (t->Done)
+		t->Done(ok);
 
-	if (len_ > 127)
-		return (false);
+	if (i2cQHead[i2cCurr] != i2cQTail[i2cCurr])
+		i2cStart(i2cCurr);
 
-	i2cCurr = i2cMap[i2cSel] - 1;
-	d = &I2CPorts[i2cCurr];
+} // i2cFinish
 
-	i2cState[i2cCurr].addr = id;
-	i2cState[i2cCurr].reg = reg;
-	i2cState[i2cCurr].subaddress_sent = false;
-	i2cState[i2cCurr].final_stop = false;
-	i2cState[i2cCurr].writing = true;
-	i2cState[i2cCurr].reading = false;
-	i2cState[i2cCurr].write_p = my_data;
-	i2cState[i2cCurr].read_p = my_data;
-	i2cState[i2cCurr].bytes = len_;
-	i2cState[i2cCurr].busy = true;
+void i2cCheckTimeout(uint8 i2cSel) {
+	boolean TimedOut;
+	idx i2cCurr;
+	I2CPortDef * d;
 
-	for (i = 0; i < len_; i++)
-		my_data[i] = data[i];
+	i2cCurr = i2cMap[i2cSel] - 1;
+	d = &I2CPorts[i2cCurr];
 
-	if (!(d->I2C->CR2 & I2C_IT_EVT)) { //if we are restarting the driver
-		if (!(d->I2C->CR1 & 0x0100)) { // ensure sending a start
-			while (d->I2C->CR1 & 0x0200) { //wait for any stop to finish sending
-			}
-			I2C_GenerateSTART(d->I2C, ENABLE); //send the start for the new job
+	if (i2cState[i2cCurr].busy && ((uSClock() - i2cState[i2cCurr].StartuS)
+			> I2C_TIMEOUT_US(i2cState[i2cCurr].bytes))) {
+		__disable_irq();
+		TimedOut = i2cState[i2cCurr].busy; // may have completed meanwhile
+		if (TimedOut)
+			I2C_ITConfig(d->I2C, I2C_IT_EVT | I2C_IT_ERR | I2C_IT_BUF, DISABLE);
+		__enable_irq();
+
+		if (TimedOut) { // ISRs are off so the reset may take its time
+			i2cStats[i2cCurr].Timeouts++;
+			i2cInit(i2cCurr);
+			i2cFinish(i2cCurr, false);
 		}
-		I2C_ITConfig(d->I2C, I2C_IT_EVT | I2C_IT_ERR, ENABLE); //allow the interrupts to fire off again
 	}
 
-	while (i2cState[i2cCurr].busy && --timeout > 0) {
-	}
-	if (timeout == 0) {
-		i2cState[i2cCurr].i2cErrors++;
-		setStat(I2CFailS, i2cState[i2cCurr].i2cErrors);
-		i2cInit(i2cCurr);
+} // i2cCheckTimeout
+
+static boolean i2cQueue(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		boolean Read, uint8 * data, i2cDoneFn Done) {
+	i2cTransStruct * t;
+	uint8 Entries;
+	idx i2cCurr;
+
+	i2cCurr = i2cMap[i2cSel] - 1;
+
+	if (len > 127)
+		return (false);
+
+	if ((uint8) (i2cQTail[i2cCurr] - i2cQHead[i2cCurr]) >= I2C_QUEUE_LEN) {
+		i2cStats[i2cCurr].Overflows++;
 		return (false);
 	}
 
+	t = &i2cQ[i2cCurr][i2cQTail[i2cCurr] & (I2C_QUEUE_LEN - 1)];
+	t->id = id;
+	t->reg = reg;
+	t->len = len;
+	t->Read = Read;
+	t->data = data;
+	t->Done = Done;
+
+	__disable_irq();
+	i2cQTail[i2cCurr]++;
+	Entries = i2cQTail[i2cCurr] - i2cQHead[i2cCurr];
+	if (!i2cState[i2cCurr].busy)
+		i2cStart(i2cCurr);
+	__enable_irq();
+
+	i2cStats[i2cCurr].Queued++;
+	if (Entries > i2cStats[i2cCurr].MaxQueue)
+		i2cStats[i2cCurr].MaxQueue = Entries;
+
 	return (true);
-} // i2cWriteBlock
+} // i2cQueue
+
+boolean i2cQueueRead(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, i2cDoneFn Done) {
+	return (i2cQueue(i2cSel, id, reg, len, true, data, Done));
+} // i2cQueueRead
+
+boolean i2cQueueWrite(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, i2cDoneFn Done) {
+	return (i2cQueue(i2cSel, id, reg, len, false, data, Done));
+} // i2cQueueWrite
+
+boolean i2cIdle(uint8 i2cSel) {
+	idx i2cCurr;
+
+	i2cCurr = i2cMap[i2cSel] - 1;
+
+	return (i2cQHead[i2cCurr] == i2cQTail[i2cCurr]);
+} // i2cIdle
+
+void i2cWaitIdle(uint8 i2cSel) {
+
+	while (!i2cIdle(i2cSel))
+		i2cCheckTimeout(i2cSel);
+
+} // i2cWaitIdle
+
+// Blocking transfers queue behind any pending transactions and wait for their own
+
+static boolean i2cTransfer(uint8 i2cSel, uint8 id, uint8 reg, uint8 len,
+		boolean Read, uint8 * data) {
 
+	i2cWaitIdle(i2cSel);
+	if (!i2cQueue(i2cSel, id, reg, len, Read, data, 0))
+		return (false);
+	i2cWaitIdle(i2cSel);
+
+	return (i2cState[i2cMap[i2cSel] - 1].ok);
+} // i2cTransfer
+
+boolean i2cReadBlock(uint8 i2cSel, uint8 id, uint8 reg, uint8 len, uint8* buf) {
+	return (i2cTransfer(i2cSel, id, reg, len, true, buf));
+} // i2cReadBlock
+
+boolean i2cWriteBlock(uint8 i2cSel, uint8 id, uint8 reg, uint8 len_,
+		uint8 *data) {
+	return (i2cTransfer(i2cSel, id, reg, len_, false, data));
+} // i2cWriteBlock
 
 boolean i2cResponse(uint8 i2cSel, uint8 d) { // returns true unless there is an I2C timeout????
 	uint8 v;
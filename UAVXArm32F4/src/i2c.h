@@ -24,6 +24,10 @@
 
 #define I2C_CLOCK_HZ 400000
 
+#define I2C_QUEUE_LEN		8
+#define I2C_BYTE_US			((9 * 1000000 + I2C_CLOCK_HZ - 1) / I2C_CLOCK_HZ)
+#define I2C_TIMEOUT_US(n)	(200 + ((n) + 3) * I2C_BYTE_US * 2) // twice the bus time plus clock stretching
+
 typedef struct { // TODO: possibly combine with Port def
 	boolean error;
 	boolean busy;
@@ -37,8 +41,29 @@ typedef struct { // TODO: possibly combine with Port def
 	uint16 bytes;
 	uint8* write_p;
 	uint8* read_p;
+	int8 i; // byte index, -1 for the sub-address
+	boolean ok; // result of the last transaction
+	uint32 StartuS;
 } i2cStateDef;
 
+// Transactions - queued per port by the main loop and completed by the event/error ISRs
+
+typedef void (*i2cDoneFn)(boolean ok);
+
+typedef struct {
+	uint8 id;
+	uint8 reg;
+	uint8 len;
+	boolean Read;
+	uint8 * data; // must remain valid until Done
+	i2cDoneFn Done;
+} i2cTransStruct;
+
+typedef struct {
+	uint32 Queued, Completed, Errors, Timeouts, Overflows;
+	uint32 MaxQueue;
+} i2cStatsStruct;
+
 boolean i2cReadBlock(uint8 devSel, uint8 id, uint8 reg, uint8 l,
 		uint8 *data);
 boolean i2cWriteBlock(uint8 devSel, uint8 id, uint8 reg, uint8 len,
@@ -46,12 +71,21 @@ boolean i2cWriteBlock(uint8 devSel, uint8 id, uint8 reg, uint8 len,
 
 boolean i2cResponse(uint8 devSel, uint8 d);
 
+boolean i2cQueueRead(uint8 devSel, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, i2cDoneFn Done);
+boolean i2cQueueWrite(uint8 devSel, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, i2cDoneFn Done);
+void i2cCheckTimeout(uint8 devSel);
+boolean i2cIdle(uint8 devSel);
+void i2cWaitIdle(uint8 devSel);
+
 void i2c_er_handler(uint8 i2cCurr);
 void i2c_ev_handler(uint8 i2cCurr);
 
 void i2cInit(uint8 I2CCurr);
 
 extern volatile i2cStateDef i2cState[];
+extern i2cStatsStruct i2cStats[];
 
 
 #endif
@@ -41,8 +41,8 @@ const real32 GyroScale[] = { //
 
 uint8 CurrAttSensorType = UAVXArm32IMU;
 
-HistStruct AccF[3];
-HistStruct GyroF[3];
+LPFilterBankStruct AccF;
+LPFilterBankStruct GyroF;
 
 real32 GyroBias[3];
 real32 Acc[3], Rate[3];
@@ -54,19 +54,185 @@ real32 GyroLPFreqHz, AccLPFreqHz;
 const idx RollPitchGyroLPFOrder = 2;
 const idx RollPitchAccLPFOrder = 2;
 
+#if defined(USE_GYRO_OVERSAMPLING)
+
+// Gyro samples taken between control cycles are low pass filtered at the sample rate
+// and averaged down to the control cycle rate. GetIMU takes the last sample of each cycle.
+
+uint8 CurrGyroOversample = 1;
+uint32 CurrGyroSampleuS = PID_CYCLE_2000US;
+real32 CurrGyroSampleS = PID_CYCLE_2000US * 1.0e-6f;
+uint32 GyroOversamplesMissed = 0;
+
+static real32 GyroSum[3];
+static uint8 GyroSamples = 0;
+
+static void AccumulateGyro(void) {
+	real32 g[3];
+	idx a;
+
+	SampleIMUDelta(RawGyro, RawAcc); // acc held from the last full read
+
+	for (a = X; a <= Z; a++)
+		g[a] = RawGyro[a];
+	if (P(GyroLPFHz) > 0)
+		LPFilterBankAt(&GyroF, g, mpu6xxxSampleuS);
+	for (a = X; a <= Z; a++)
+		GyroSum[a] += g[a];
+	GyroSamples++;
+
+} // AccumulateGyro
+
+void SampleGyro(void) {
+
+	if (GyroSamples < (CurrGyroOversample - 1)) {
+		ReadGyro();
+		AccumulateGyro();
+	}
+
+} // SampleGyro
+
+static void DecimateGyro(void) {
+	real32 SamplesR;
+	idx a;
+
+	AccumulateGyro();
+
+	GyroOversamplesMissed += CurrGyroOversample - GyroSamples;
+	SamplesR = 1.0f / GyroSamples;
+	for (a = X; a <= Z; a++) {
+		RawGyro[a] = GyroSum[a] * SamplesR;
+		GyroSum[a] = 0.0f;
+	}
+	GyroSamples = 0;
+
+} // DecimateGyro
+
+#endif
+
+// Delta angle and velocity over the control cycle from every gyro and acc sample. Coning
+// and sculling, the rotation within the cycle seen by the later samples, are corrected by
+// Savage's two sample recursion. Sums are in units of one sample interval and are scaled to
+// the cycle once its dT is known, so samples need not be time stamped individually.
+
+IMUDeltaStruct IMUDelta;
+
+static real32 DeltaA[3], DeltaV[3], Coning[3], Sculling[3], PrevdA[3], PrevdV[3];
+static uint32 DeltaSamples = 0;
+
+void AccumulateIMUDelta(const real32 * w, const real32 * f) {
+	real32 a[3], v[3];
+	idx i;
+
+	for (i = X; i <= Z; i++) {
+		a[i] = DeltaA[i] + PrevdA[i] * (1.0f / 6.0f);
+		v[i] = DeltaV[i] + PrevdV[i] * (1.0f / 6.0f);
+	}
+
+	Coning[X] += 0.5f * (a[Y] * w[Z] - a[Z] * w[Y]);
+	Coning[Y] += 0.5f * (a[Z] * w[X] - a[X] * w[Z]);
+	Coning[Z] += 0.5f * (a[X] * w[Y] - a[Y] * w[X]);
+
+	Sculling[X] += 0.5f * (a[Y] * f[Z] - a[Z] * f[Y] + v[Y] * w[Z] - v[Z] * w[Y]);
+	Sculling[Y] += 0.5f * (a[Z] * f[X] - a[X] * f[Z] + v[Z] * w[X] - v[X] * w[Z]);
+	Sculling[Z] += 0.5f * (a[X] * f[Y] - a[Y] * f[X] + v[X] * w[Y] - v[Y] * w[X]);
+
+	for (i = X; i <= Z; i++) {
+		DeltaA[i] += w[i];
+		DeltaV[i] += f[i];
+		PrevdA[i] = w[i];
+		PrevdV[i] = f[i];
+	}
+	DeltaSamples++;
+
+} // AccumulateIMUDelta
+
+// Raw sensor frame sample as GetIMU maps it to the body frame but ahead of the software
+// LPF and notches, so the estimators no longer see filtered rates. Summing every sample is
+// already an average over the cycle, the on-chip DLPF limits the bandwidth, and the
+// filter lag would otherwise show as attitude error in manoeuvres. The notches also only
+// run once per cycle. The rate loops still use the filtered Rate[].
+
+void SampleIMUDelta(const real32 * g, const real32 * a) {
+	real32 w[3], f[3];
+
+	w[X] = (g[Y] - GyroBias[Y]) * GyroScale[CurrAttSensorType];
+	w[Y] = (g[X] - GyroBias[X]) * GyroScale[CurrAttSensorType];
+	w[Z] = -(g[Z] - GyroBias[Z]) * GyroScale[CurrAttSensorType];
+
+	f[X] = (a[Y] - NV.AccCal.Bias[Y]) * NV.AccCal.Scale[Y];
+	f[Y] = (a[X] - NV.AccCal.Bias[X]) * NV.AccCal.Scale[X];
+	f[Z] = -(a[Z] - NV.AccCal.Bias[Z]) * NV.AccCal.Scale[Z];
+
+	AccumulateIMUDelta(w, f);
+
+} // SampleIMUDelta
+
+void ResetIMUDelta(void) {
+	idx i;
+
+	for (i = X; i <= Z; i++)
+		DeltaA[i] = DeltaV[i] = Coning[i] = Sculling[i] = 0.0f;
+	DeltaSamples = 0;
+
+} // ResetIMUDelta
+
+// Without samples, as under emulation, the cycle's Rate and Acc are integrated directly
+
+void CompleteIMUDelta(real32 dT) {
+	real32 h, hh;
+	idx i;
+
+	IMUDelta.dT = dT;
+	IMUDelta.Samples = DeltaSamples;
+
+	if (DeltaSamples == 0) {
+		IMUDelta.Angle[X] = Rate[Roll] * dT;
+		IMUDelta.Angle[Y] = Rate[Pitch] * dT;
+		IMUDelta.Angle[Z] = Rate[Yaw] * dT;
+		for (i = X; i <= Z; i++)
+			IMUDelta.Vel[i] = Acc[i] * dT;
+	} else {
+		h = dT / DeltaSamples;
+		hh = h * h;
+		for (i = X; i <= Z; i++)
+			IMUDelta.Angle[i] = DeltaA[i] * h + Coning[i] * hh;
+
+		IMUDelta.Vel[X] = DeltaV[X] * h + (0.5f * (DeltaA[Y] * DeltaV[Z]
+				- DeltaA[Z] * DeltaV[Y]) + Sculling[X]) * hh;
+		IMUDelta.Vel[Y] = DeltaV[Y] * h + (0.5f * (DeltaA[Z] * DeltaV[X]
+				- DeltaA[X] * DeltaV[Z]) + Sculling[Y]) * hh;
+		IMUDelta.Vel[Z] = DeltaV[Z] * h + (0.5f * (DeltaA[X] * DeltaV[Y]
+				- DeltaA[Y] * DeltaV[X]) + Sculling[Z]) * hh;
+	}
+
+	ResetIMUDelta();
+
+} // CompleteIMUDelta
+
 // NED
 // P,R,Y
 // BF, LR, UD
 
 void GetIMU(void) {
-	idx a;
 
 	ReadAccAndGyro(true);
 
-	if (P(GyroLPFHz) > 0)
-		for (a = X; a <= Z; a++) // TODO: perhaps add slewlimiter?
-			RawGyro[a] = LPFilter(&GyroF[a], RollPitchGyroLPFOrder, RawGyro[a],
-					CurrGyroLPFHz, CurrPIDCycleS);
+#if defined(USE_GYRO_OVERSAMPLING)
+	if ((CurrGyroOversample > 1) && !F.UsingAnalogGyros)
+		DecimateGyro();
+	else
+#endif
+	{
+		if (DeltaSamples == 0) // unless drained from the FIFO
+			SampleIMUDelta(RawGyro, RawAcc);
+		if (P(GyroLPFHz) > 0) // TODO: perhaps add slewlimiter?
+			LPFilterBankAt(&GyroF, RawGyro, mpu6xxxSampleuS);
+	}
+
+#if defined(USE_GYRO_NOTCH)
+	UpdateGyroNotches(RawGyro);
+#endif
 
 	UpdateGyroTempComp();
 
@@ -75,9 +241,7 @@ void GetIMU(void) {
 	Rate[Yaw] = -(RawGyro[Z] - GyroBias[Z]) * GyroScale[CurrAttSensorType];
 
 	if (P(AccLPFHz) > 0)
-		for (a = X; a <= Z; a++)
-			RawAcc[a] = LPFilter(&AccF[a], RollPitchAccLPFOrder, RawAcc[a],
-					CurrAccLPFHz, CurrPIDCycleS);
+		LPFilterBankAt(&AccF, RawAcc, mpu6xxxSampleuS);
 
 	if (CurrAttSensorType == InfraRedAngle) {
 
@@ -153,14 +317,36 @@ void ErectGyros(int32 TS) {
 
 	LEDOff(LEDRedSel);
 
+	ResetIMUDelta(); // samples taken against the old bias
+
 } // ErectGyros
 
+// Filter coefficients follow the cut offs and the nominal sample intervals and are only
+// recomputed here, at a parameter change.
+
 void InitSWFilters(void) {
+	real32 GyrodT;
 	idx a;
 
-	for (a = X; a <= Z; a++)
-		AccF[a].Primed = GyroF[a].Primed = A[a].P.RateF.Primed = A[a].R.RateF.Primed
-				= A[a].P.RateDF.Primed = A[a].R.RateDF.Primed = false;
+#if defined(USE_GYRO_OVERSAMPLING)
+	GyrodT = (CurrGyroOversample > 1) ? CurrGyroSampleS : CurrPIDCycleS;
+#else
+	GyrodT = CurrPIDCycleS;
+#endif
+
+	InitLPFilterBank(&GyroF, RollPitchGyroLPFOrder, CurrGyroLPFHz, GyrodT);
+	InitLPFilterBank(&AccF, RollPitchAccLPFOrder, CurrAccLPFHz, CurrPIDCycleS);
+
+	for (a = X; a <= Z; a++) {
+		InitPIDFilters(&A[a].P);
+		InitPIDFilters(&A[a].R);
+	}
+
+	InitAltitudeFilters();
+
+#if defined(USE_GYRO_NOTCH)
+	InitGyroSpectrum();
+#endif
 } // InitSWFilters
 
 
@@ -195,6 +381,8 @@ void InitIMU(void) {
 
 	F.AccCalibrated = F.IMUCalibrated = !r;
 
+	ResetIMUDelta();
+
 } // InitIMU
 
 
@@ -44,6 +44,23 @@ void ErectGyros(int32 d);
 
 #define ACC_TRIM_STEP 20
 
+#define MAX_GYRO_OVERSAMPLE 8
+
+void SampleGyro(void);
+
+typedef struct {
+	real32 Angle[3], Vel[3]; // body frame rad and M/S over dT
+	real32 dT;
+	uint32 Samples;
+} IMUDeltaStruct;
+
+void AccumulateIMUDelta(const real32 * w, const real32 * f);
+void SampleIMUDelta(const real32 * g, const real32 * a);
+void ResetIMUDelta(void);
+void CompleteIMUDelta(real32 dT);
+
+extern IMUDeltaStruct IMUDelta;
+
 void ShowAccType(uint8 s);
 void ShowGyroType(uint8 s, uint8 g);
 void CaptureAccTrimOffsets(void);
@@ -53,8 +70,8 @@ void CalculateAccelerations(void);
 void InitIMU(void);
 void InitSWFilters(void);
 
-extern HistStruct AccF[3];
-extern HistStruct GyroF[3];
+extern LPFilterBankStruct AccF;
+extern LPFilterBankStruct GyroF;
 
 extern const uint8 MPUMap[];
 extern const real32 MPUSign[];
@@ -66,7 +83,11 @@ extern uint8 CurrAttSensorType;
 extern real32 Acc[], Rate[];
 extern real32 RateEnergySum;
 extern uint32 RateEnergySamples;
-extern const idx RollPitchLPFOrder;
+extern const idx RollPitchGyroLPFOrder, RollPitchAccLPFOrder;
+
+extern uint8 CurrGyroOversample;
+extern uint32 CurrGyroSampleuS, GyroOversamplesMissed;
+extern real32 CurrGyroSampleS;
 
 #endif
 
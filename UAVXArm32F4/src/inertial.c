@@ -23,7 +23,7 @@
 
 #define MAX_MAG_YAW_RATE_RADPS DegreesToRadians(60) // TODO: 180 may be too high - above this rate AHRS compensation of heading is zero
 real32 dT, dTR, dTOn2, dTROn2;
-uint32 LastInertialUpdateuS = 0;
+uint64 LastInertialSampleuS = 0;
 real32 AccConfidenceSDevR = 5.0f;
 real32 AccConfidence;
 real32 AccZ;
@@ -32,6 +32,25 @@ real32 EstMagHeading = 0.0f;
 
 uint8 CurrStateEst = EstUnknown;
 
+// dT is the interval between the capture times of successive IMU samples rather than between
+// passes of the main loop so scheduling jitter does not enter the integration. The nominal
+// cycle is used if the capture time has not advanced or after a stall of the main loop.
+
+void CalculatedT(uint64 SampleuS) {
+
+	if ((LastInertialSampleuS != 0) && (SampleuS > LastInertialSampleuS)
+			&& ((SampleuS - LastInertialSampleuS) < (CurrPIDCycleuS << 4)))
+		dT = (SampleuS - LastInertialSampleuS) * 0.000001f;
+	else
+		dT = CurrPIDCycleS;
+	LastInertialSampleuS = SampleuS;
+
+	dTOn2 = 0.5f * dT;
+	dTR = 1.0f / dT;
+	dTROn2 = dTR * 0.5f;
+
+} // CalculatedT
+
 real32 CalculateAccConfidence(real32 AccMag) {
 	// Gaussian decay in accelerometer value belief
 	static real32 confp = 1.0f;
@@ -102,32 +121,81 @@ real32 KpMag;
 //#define zeta (sqrtf(0.75f)*gyroMeasDrift) // compute zeta aka KiAccBase not used
 
 real32 q0, q1, q2, q3;
-real32 q0q0, q0q1, q0q2, q0q3;
-real32 q1q1, q1q2, q1q3;
-real32 q2q2, q2q3;
-real32 q3q3;
 
-real32 bi00, bi01, bi02;
-real32 bi10, bi11, bi12;
-real32 bi20, bi21, bi22;
+// Attitude is derived once per estimator update - consumers read Att rather than
+// recomputing quaternion products or taking sin/cos of the Euler angles
 
-void ConvertQuaternionToEuler(void) {
+AttitudeStruct Att = { { 1.0f, 0.0f, 0.0f, 0.0f }, { { 1.0f, 0.0f, 0.0f }, {
+		0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } }, { 0.0f, 0.0f, 0.0f }, {
+		1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 1.0f } };
 
-	bi00 = q0q0 + q1q1 - q2q2 - q3q3; // yaw
-	//bi01 = 2.0f * (q1q2 - q0q3);
-	//bi02 = 2.0f * (q0q2 + q1q3);
+static void SinCosFromRatio(real32 y, real32 x, real32 Angle, real32 * s,
+		real32 * c) {
+	real32 h;
 
-	bi10 = 2.0f * (q1q2 + q0q3);
-	//bi11 = q0q0 - q1q1 + q2q2 - q3q3; // yaw
-	//bi12 = 2.0f * (q2q3 - q0q1);
+	h = Sqr(x) + Sqr(y);
+	if (h > 1.0e-12f) {
+		h = invSqrt(h);
+		*s = y * h;
+		*c = x * h;
+	} else
+		FastSinCos(Angle, s, c);
+
+} // SinCosFromRatio
+
+static void AttitudeFromQuaternion(const real32 * q) {
+	real32 q0q0, q0q1, q0q2, q0q3;
+	real32 q1q1, q1q2, q1q3;
+	real32 q2q2, q2q3;
+	real32 q3q3;
+
+	q0q0 = q[0] * q[0];
+	q0q1 = q[0] * q[1];
+	q0q2 = q[0] * q[2];
+	q0q3 = q[0] * q[3];
+	q1q1 = q[1] * q[1];
+	q1q2 = q[1] * q[2];
+	q1q3 = q[1] * q[3];
+	q2q2 = q[2] * q[2];
+	q2q3 = q[2] * q[3];
+	q3q3 = q[3] * q[3];
+
+	memcpy(Att.q, q, sizeof(Att.q));
+
+	Att.DCM[0][0] = q0q0 + q1q1 - q2q2 - q3q3; // yaw
+	Att.DCM[0][1] = 2.0f * (q1q2 - q0q3);
+	Att.DCM[0][2] = 2.0f * (q0q2 + q1q3);
+
+	Att.DCM[1][0] = 2.0f * (q1q2 + q0q3);
+	Att.DCM[1][1] = q0q0 - q1q1 + q2q2 - q3q3;
+	Att.DCM[1][2] = 2.0f * (q2q3 - q0q1);
+
+	Att.DCM[2][0] = 2.0f * (q1q3 - q0q2); // pitch gx
+	Att.DCM[2][1] = 2.0f * (q0q1 + q2q3); // roll gy
+	Att.DCM[2][2] = q0q0 - q1q1 - q2q2 + q3q3; // yaw gz
+
+	Att.Gravity[X] = Att.DCM[2][0];
+	Att.Gravity[Y] = Att.DCM[2][1];
+	Att.Gravity[Z] = Att.DCM[2][2];
+
+	A[Roll].Angle = FastAtan2(Att.DCM[2][1], Att.DCM[2][2]);
+	A[Pitch].Angle = -FastAsin(Att.DCM[2][0]);
+	A[Yaw].Angle = FastAtan2(Att.DCM[1][0], Att.DCM[0][0]);
+
+	// sin/cos straight from the DCM, no trig
+	SinCosFromRatio(Att.DCM[2][1], Att.DCM[2][2], A[Roll].Angle,
+			&Att.Sin[Roll], &Att.Cos[Roll]);
+	Att.Sin[Pitch] = -Limit1(Att.DCM[2][0], 1.0f);
+	Att.Cos[Pitch] = sqrtf(1.0f - Sqr(Att.Sin[Pitch]));
+	SinCosFromRatio(Att.DCM[1][0], Att.DCM[0][0], A[Yaw].Angle,
+			&Att.Sin[Yaw], &Att.Cos[Yaw]);
+
+} // AttitudeFromQuaternion
 
-	bi20 = 2.0f * (q1q3 - q0q2); // pitch gx
-	bi21 = 2.0f * (q0q1 + q2q3); // roll gy
-	bi22 = q0q0 - q1q1 - q2q2 + q3q3; // yaw gz
+void ConvertQuaternionToEuler(void) {
+	const real32 q[4] = { q0, q1, q2, q3 };
 
-	A[Roll].Angle = atan2f(bi21, bi22);
-	A[Pitch].Angle = -asinf(bi20);
-	A[Yaw].Angle = atan2f(bi10, bi00);
+	AttitudeFromQuaternion(q);
 
 } // ConvertQuaternionToEuler
 
@@ -135,12 +203,9 @@ void ConvertQuaternionToEuler(void) {
 void ConvertEulerToQuaternion(real32 p, real32 r, real32 y) {
 	real32 t0, t1, t2, t3, t4, t5, normR;
 
-	t0 = cosf(y * 0.5f);
-	t1 = sinf(y * 0.5f);
-	t2 = cosf(r * 0.5f);
-	t3 = sinf(r * 0.5f);
-	t4 = cosf(p * 0.5f);
-	t5 = sinf(p * 0.5f);
+	FastSinCos(y * 0.5f, &t1, &t0);
+	FastSinCos(r * 0.5f, &t3, &t2);
+	FastSinCos(p * 0.5f, &t5, &t4);
 
 	q0 = t0 * t2 * t4 + t1 * t3 * t5;
 	q1 = t0 * t3 * t4 - t1 * t2 * t5;
@@ -156,16 +221,36 @@ void ConvertEulerToQuaternion(real32 p, real32 r, real32 y) {
 
 } // ConvertEulerToQuaternion
 
+// MadgwickMARGUpdate works with gravity up, its quaternion is rolled by PI
+// with pitch and yaw reversed - see the conversion back to NED in MadgwickMARGUpdate
+
+void ConvertEulerToMARGQuaternion(real32 p, real32 r, real32 y) {
+
+	ConvertEulerToQuaternion(-p, (r < 0.0f) ? r + PI : r - PI, -y);
+
+} // ConvertEulerToMARGQuaternion
+
+void SetAttitude(real32 * q) { // from another estimator
+
+	q0 = q[0];
+	q1 = q[1];
+	q2 = q[2];
+	q3 = q[3];
+
+	ConvertQuaternionToEuler();
+
+} // SetAttitude
+
 
 real32 GravityCompensatedAccZ(void) {
 
-	return 2.0f * (q1q3 - q0q2) * Acc[X] + 2.0f * (q0q1 + q2q3) * Acc[Y]
-			+ (q0q0 - q1q1 - q2q2 + q3q3) * Acc[Z] + GRAVITY_MPS_S;
+	return Att.Gravity[X] * Acc[X] + Att.Gravity[Y] * Acc[Y] + Att.Gravity[Z]
+			* Acc[Z] + GRAVITY_MPS_S;
 } // GravityCompensatedAccZ
 
 real32 AttitudeCosine(void) { // for attitude throttle compensation
 
-	return q0q0 - q1q1 - q2q2 + q3q3;
+	return Att.DCM[2][2];
 
 } // AttitudeCosine
 
@@ -175,16 +260,10 @@ void VersanoCompensation(void) {
 	// http://www.varesano.net/blog/fabio/simple-gravity-compensation-9-dom-imus
 	// compensate the accelerometer readings from gravity.
 
-	real32 cx, cy, cz;
-
 	// get expected direction of gravity from previous iteration!
-	cx = 2.0f * (q1q3 - q0q2);
-	cy = 2.0f * (q0q1 + q2q3);
-	cz = q0q0 - q1q1 - q2q2 + q3q3;
-
-	ax -= cx;
-	ay -= cy;
-	az -= cz;
+	ax -= Att.Gravity[X];
+	ay -= Att.Gravity[Y];
+	az -= Att.Gravity[Z];
 
 #endif
 } // VersanoCompensation
@@ -197,13 +276,22 @@ void InitMadgwick(void) {
 
 	GetIMU();
 
-	real32 normR = 1.0f / sqrtf(Sqr(Acc[BF]) + Sqr(Acc[LR]) + Sqr(Acc[UD]));
+	real32 normR = invSqrt(Sqr(Acc[BF]) + Sqr(Acc[LR]) + Sqr(Acc[UD]));
 
-	A[Pitch].Angle = asinf(-Acc[BF] * normR);
-	A[Roll].Angle = asinf(Acc[LR] * normR);
+	A[Pitch].Angle = FastAsin(-Acc[BF] * normR);
+	A[Roll].Angle = FastAsin(Acc[LR] * normR);
 	A[Yaw].Angle = MagHeading;
 
-	ConvertEulerToQuaternion(A[Pitch].Angle, A[Roll].Angle, A[Yaw].Angle);
+	if (CurrStateEst == MadgwickMARG)
+		ConvertEulerToMARGQuaternion(A[Pitch].Angle, A[Roll].Angle,
+				A[Yaw].Angle);
+	else
+		ConvertEulerToQuaternion(A[Pitch].Angle, A[Roll].Angle, A[Yaw].Angle);
+
+	if (CurrStateEst == ErrorStateEKF)
+		InitESKF();
+
+	ResetIMUDelta(); // first update starts from here
 
 } // InitMadgwick
 
@@ -223,10 +311,12 @@ void UpdateHeading(void) {
 		}
 	} else {
 
-		if (CurrStateEst == MadgwickIMU) {
+		if ((CurrStateEst == MadgwickIMU) || (CurrStateEst == ErrorStateEKF)) {
 			GetMagnetometer();
 			if (F.NewMagValues) {
 				CalculateMagneticHeading();
+				if (CurrStateEst == ErrorStateEKF)
+					ESKFFuseHeading(MagHeading);
 				F.ValidHeading = true;
 			}
 		} else
@@ -259,15 +349,15 @@ void UpdateHeading(void) {
 #define gyroMeasError DegreesToRadians(0.5f) // gyroscope measurement error in rad/s (shown as 5 deg/s)
 #define gyroMeasDrift DegreesToRadians(0.02f) // gyroscope measurement error in rad/s/s (shown as 0.2f deg/s/s)
 #define beta 0.2f
-#define beta1 (sqrt(0.75f) * gyroMeasError) // compute beta
-#define zeta (sqrt(0.75f) * gyroMeasDrift) // compute zeta
+#define beta1 (sqrtf(0.75f) * gyroMeasError) // compute beta
+#define zeta (sqrtf(0.75f) * gyroMeasDrift) // compute zeta
 // paper suggest Beta=0.041 for MARG
 //#define betaDef 0.1f // 2 * proportional gain
 //real32 beta = betaDef; // 2 * proportional gain (Kp)
 real32 BetaBase;
 
-void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
-		real32 az, real32 mx, real32 my, real32 mz) {
+void MadgwickMARGUpdate(real32 dAx, real32 dAy, real32 dAz, real32 ax,
+		real32 ay, real32 az, real32 mx, real32 my, real32 mz) {
 	real32 Beta;
 	real32 AccMag, normR;
 	real32 s0, s1, s2, s3;
@@ -276,6 +366,8 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 	real32 wq0, wq1, wq2, wq3;
 	real32 _2q0mx, _2q0my, _2q0mz, _2q1mx, _2bx, _2bz, _4bx, _4bz, _8bx, _8bz,
 			_2q0, _2q1, _2q2, _2q3, _4q0, _4q1, _4q2, _8q1, _8q2;
+	real32 q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+	real32 qNED[4];
 
 	q0q0 = q0 * q0;
 	q0q1 = q0 * q1;
@@ -293,11 +385,11 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 	_2q2 = 2.0f * q2;
 	_2q3 = 2.0f * q3;
 
-	// Rate of change of quaternion from gyroscope
-	wq0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
-	wq1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
-	wq2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
-	wq3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+	// Change of quaternion from the gyro delta angle
+	wq0 = 0.5f * (-q1 * dAx - q2 * dAy - q3 * dAz);
+	wq1 = 0.5f * (q0 * dAx + q2 * dAz - q3 * dAy);
+	wq2 = 0.5f * (q0 * dAy - q1 * dAz + q3 * dAx);
+	wq3 = 0.5f * (q0 * dAz + q1 * dAy - q2 * dAx);
 
 	AccMag = sqrtf(Sqr(ax) + Sqr(ay) + Sqr(az));
 	AccConfidence = CalculateAccConfidence(AccMag);
@@ -309,9 +401,7 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 	az *= normR;
 
 	// default KpAccBase is 0.2 paper says 0.041
-	Beta = State == InFlight ? BetaBase * AccConfidence : BetaBase * 2.5f;
-
-	GetMagnetometer();
+	Beta = (State == InFlight ? BetaBase * AccConfidence : BetaBase * 2.5f) * dT;
 
 	if (F.NewMagValues) {
 		F.NewMagValues = false;
@@ -334,7 +424,7 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 				+ _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
 		hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1
 				+ my * q2q2 + _2q2 * mz * q3 - my * q3q3;
-		_2bx = sqrt(hx * hx + hy * hy);
+		_2bx = sqrtf(hx * hx + hy * hy);
 		_2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1
 				+ _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
 		_4bx = 2.0f * _2bx;
@@ -344,28 +434,28 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 
 		// Gradient descent algorithm corrective step
 		s0 = -_2q2 * (2.0f * (q1q3 - q0q2) - ax) + _2q1 * (2.0f * (q0q1 + q2q3)
-				- ay) + -_4bz * q2 * (_4bx * (0.5 - q2q2 - q3q3) + _4bz * (q1q3
+				- ay) + -_4bz * q2 * (_4bx * (0.5f - q2q2 - q3q3) + _4bz * (q1q3
 				- q0q2) - mx) + (-_4bx * q3 + _4bz * q1) * (_4bx
 				* (q1q2 - q0q3) + _4bz * (q0q1 + q2q3) - my) + _4bx * q2
-				* (_4bx * (q0q2 + q1q3) + _4bz * (0.5 - q1q1 - q2q2) - mz);
+				* (_4bx * (q0q2 + q1q3) + _4bz * (0.5f - q1q1 - q2q2) - mz);
 		s1 = _2q3 * (2.0f * (q1q3 - q0q2) - ax) + _2q0 * (2.0f * (q0q1 + q2q3)
-				- ay) + -4.0f * q1 * (2.0f * (0.5 - q1q1 - q2q2) - az) + _4bz
-				* q3 * (_4bx * (0.5 - q2q2 - q3q3) + _4bz * (q1q3 - q0q2) - mx)
+				- ay) + -4.0f * q1 * (2.0f * (0.5f - q1q1 - q2q2) - az) + _4bz
+				* q3 * (_4bx * (0.5f - q2q2 - q3q3) + _4bz * (q1q3 - q0q2) - mx)
 				+ (_4bx * q2 + _4bz * q0) * (_4bx * (q1q2 - q0q3) + _4bz
 						* (q0q1 + q2q3) - my) + (_4bx * q3 - _8bz * q1) * (_4bx
-				* (q0q2 + q1q3) + _4bz * (0.5 - q1q1 - q2q2) - mz);
+				* (q0q2 + q1q3) + _4bz * (0.5f - q1q1 - q2q2) - mz);
 		s2 = -_2q0 * (2.0f * (q1q3 - q0q2) - ax) + _2q3 * (2.0f * (q0q1 + q2q3)
-				- ay) + (-4.0f * q2) * (2.0f * (0.5 - q1q1 - q2q2) - az)
-				+ (-_8bx * q2 - _4bz * q0) * (_4bx * (0.5 - q2q2 - q3q3) + _4bz
+				- ay) + (-4.0f * q2) * (2.0f * (0.5f - q1q1 - q2q2) - az)
+				+ (-_8bx * q2 - _4bz * q0) * (_4bx * (0.5f - q2q2 - q3q3) + _4bz
 						* (q1q3 - q0q2) - mx) + (_4bx * q1 + _4bz * q3) * (_4bx
 				* (q1q2 - q0q3) + _4bz * (q0q1 + q2q3) - my) + (_4bx * q0
-				- _8bz * q2) * (_4bx * (q0q2 + q1q3) + _4bz * (0.5 - q1q1
+				- _8bz * q2) * (_4bx * (q0q2 + q1q3) + _4bz * (0.5f - q1q1
 				- q2q2) - mz);
 		s3 = _2q1 * (2.0f * (q1q3 - q0q2) - ax) + _2q2 * (2.0f * (q0q1 + q2q3)
-				- ay) + (-_8bx * q3 + _4bz * q1) * (_4bx * (0.5 - q2q2 - q3q3)
+				- ay) + (-_8bx * q3 + _4bz * q1) * (_4bx * (0.5f - q2q2 - q3q3)
 				+ _4bz * (q1q3 - q0q2) - mx) + (-_4bx * q0 + _4bz * q2) * (_4bx
 				* (q1q2 - q0q3) + _4bz * (q0q1 + q2q3) - my) + (_4bx * q1)
-				* (_4bx * (q0q2 + q1q3) + _4bz * (0.5 - q1q1 - q2q2) - mz);
+				* (_4bx * (q0q2 + q1q3) + _4bz * (0.5f - q1q1 - q2q2) - mz);
 	} else {
 
 		_4q0 = 4.0f * q0;
@@ -396,11 +486,10 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 	wq2 -= Beta * s2;
 	wq3 -= Beta * s3;
 
-	// Integrate rate of change of quaternion to yield quaternion
-	q0 += wq0 * dT;
-	q1 += wq1 * dT;
-	q2 += wq2 * dT;
-	q3 += wq3 * dT;
+	q0 += wq0;
+	q1 += wq1;
+	q2 += wq2;
+	q3 += wq3;
 
 	// Normalise quaternion
 	normR = invSqrt(Sqr(q0) + Sqr(q1) + Sqr(q2) + Sqr(q3));
@@ -409,14 +498,13 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 	q2 *= normR;
 	q3 *= normR;
 
-	ConvertQuaternionToEuler();
-
-	A[Yaw].Angle = -A[Yaw].Angle;
-	A[Pitch].Angle = -A[Pitch].Angle;
-	if (A[Roll].Angle < 0)
-		A[Roll].Angle += PI;
-	else
-		A[Roll].Angle -= PI;
+	// back from gravity up to NED, a roll by PI ahead of q, so that the angles,
+	// DCM, gravity and sin/cos in Att all agree
+	qNED[0] = -q1;
+	qNED[1] = q0;
+	qNED[2] = -q3;
+	qNED[3] = q2;
+	AttitudeFromQuaternion(qNED);
 
 } // MadgwickMARGUpdate
 
@@ -426,8 +514,8 @@ void MadgwickMARGUpdate(real32 gx, real32 gy, real32 gz, real32 ax, real32 ay,
 // Madgwick Quaternion version of Mahony et al.  Discrete Cosine Transform code
 // rewritten by Prof G.K. Egan
 
-void MadgwickUpdate(boolean AHRS, real32 gx, real32 gy, real32 gz, real32 ax,
-		real32 ay, real32 az, real32 mx, real32 my, real32 mz) {
+void MadgwickUpdate(boolean AHRS, real32 dAx, real32 dAy, real32 dAz,
+		real32 ax, real32 ay, real32 az, real32 mx, real32 my, real32 mz) {
 
 	real32 normR;
 
@@ -436,6 +524,8 @@ void MadgwickUpdate(boolean AHRS, real32 gx, real32 gy, real32 gz, real32 ax,
 	real32 bx, bz;
 	real32 vx, vy, vz;
 	real32 wx, wy, wz;
+	real32 q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+	real32 Kp;
 
 	q0q0 = q0 * q0;
 	q0q1 = q0 * q1;
@@ -467,14 +557,13 @@ void MadgwickUpdate(boolean AHRS, real32 gx, real32 gy, real32 gz, real32 ax,
 
 	KpAcc = State == InFlight ? KpAccBase * AccConfidence : KpAccBase * 5.0f;
 	//KpAcc = KpAccBase * AccConfidence;
-	gx += (vy * az - vz * ay) * KpAcc;
-	gy += (vz * ax - vx * az) * KpAcc;
-	gz += (vx * ay - vy * ax) * KpAcc;
+	Kp = KpAcc * dT;
+	dAx += (vy * az - vz * ay) * Kp;
+	dAy += (vz * ax - vx * az) * Kp;
+	dAz += (vx * ay - vy * ax) * Kp;
 
 	if (AHRS) {
 
-		GetMagnetometer();
-
 		if (F.NewMagValues) { // no compensation for latency
 			F.NewMagValues = false;
 			F.ValidHeading = true;
@@ -502,17 +591,18 @@ void MadgwickUpdate(boolean AHRS, real32 gx, real32 gy, real32 gz, real32 ax,
 			wy = 2.0f * (bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3));
 			wz = 2.0f * (bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2));
 
-			gx += (my * wz - mz * wy) * KpMag;
-			gy += (mz * wx - mx * wz) * KpMag;
-			gz += (mx * wy - my * wx) * KpMag;
+			Kp = KpMag * dT;
+			dAx += (my * wz - mz * wy) * Kp;
+			dAy += (mz * wx - mx * wz) * Kp;
+			dAz += (mx * wy - my * wx) * Kp;
 		}
 	}
 
-	// integrate quaternion rate
-	q0i = (-q1 * gx - q2 * gy - q3 * gz) * dTOn2;
-	q1i = (q0 * gx + q2 * gz - q3 * gy) * dTOn2;
-	q2i = (q0 * gy - q1 * gz + q3 * gx) * dTOn2;
-	q3i = (q0 * gz + q1 * gy - q2 * gx) * dTOn2;
+	// rotate by the corrected delta angle
+	q0i = (-q1 * dAx - q2 * dAy - q3 * dAz) * 0.5f;
+	q1i = (q0 * dAx + q2 * dAz - q3 * dAy) * 0.5f;
+	q2i = (q0 * dAy - q1 * dAz + q3 * dAx) * 0.5f;
+	q3i = (q0 * dAz + q1 * dAy - q2 * dAx) * 0.5f;
 	// two steps to preserve old to new q
 	q0 += q0i;
 	q1 += q1i;
@@ -536,7 +626,7 @@ void TrackPitchAttitude(void) {
 
 	if (F.IsFixedWing && (DesiredThrottle < IdleThrottle)
 			&& (State == InFlight)) {
-		if (mSClock() > GlidingTimemS)
+		if (!TimeReached(GlidingTimemS, mSClock()))
 			FWGlideAngleOffsetRad = SimpleFilter(FWGlideAngleOffsetRad,
 					A[Pitch].Angle, 0.1f);
 	} else
@@ -547,24 +637,50 @@ void TrackPitchAttitude(void) {
 void UpdateInertial(void) {
 	int32 a;
 
-	if (F.Emulation && ((State == InFlight)|| (State == Launching)))
+	ProfileBegin(ProfIMU);
+	if (F.Emulation && ((State == InFlight)|| (State == Launching))) {
+		CalculatedT(uSClock64());
 		DoEmulation(); // produces ROC, Altitude etc.
-	else
-		GetIMU(); // 397uS !!!!!!!!!!!!!!!!!!
-
-	if (CurrStateEst == MadgwickMARG)
-		MadgwickMARGUpdate(Rate[Roll], Rate[Pitch], Rate[Yaw], Acc[BF],
-				Acc[LR], Acc[UD], Mag[X], Mag[Y], Mag[Z]);
-	else
-		// IMU = 41uS
-		MadgwickUpdate(CurrStateEst == MadgwickAHRS, Rate[Roll], Rate[Pitch],
-				Rate[Yaw], Acc[BF], Acc[LR], Acc[UD], Mag[X], Mag[Y], Mag[Z]);
+		ResetIMUDelta();
+	} else {
+		GetIMU();
+		CalculatedT(mpu6xxxSampleuS);
+	}
+	CompleteIMUDelta(dT);
+	ProfileEnd(ProfIMU);
+
+	ProfileBegin(ProfEstimator);
+	switch (CurrStateEst) {
+	case ErrorStateEKF:
+		ESKFUpdate(IMUDelta.Angle[X], IMUDelta.Angle[Y], IMUDelta.Angle[Z],
+				IMUDelta.Vel[X], IMUDelta.Vel[Y], IMUDelta.Vel[Z]);
+		break;
+	case MadgwickMARG:
+		GetMagnetometer();
+		MadgwickMARGUpdate(IMUDelta.Angle[X], IMUDelta.Angle[Y],
+				IMUDelta.Angle[Z], Acc[BF], Acc[LR], Acc[UD], Mag[X], Mag[Y],
+				Mag[Z]);
+		break;
+	default:
+		if (CurrStateEst == MadgwickAHRS)
+			GetMagnetometer();
+		MadgwickUpdate(CurrStateEst == MadgwickAHRS, IMUDelta.Angle[X],
+				IMUDelta.Angle[Y], IMUDelta.Angle[Z], Acc[BF], Acc[LR], Acc[UD],
+				Mag[X], Mag[Y], Mag[Z]);
+		break;
+	}
+	ProfileEnd(ProfEstimator);
 
+	ProfileBegin(ProfControl);
 	DoControl();
+	ProfileEnd(ProfControl);
 
 	// one cycle delay OK
-	UpdateHeading(); // 225uS!!!
+	ProfileBegin(ProfHeading);
+	UpdateHeading();
+	ProfileEnd(ProfHeading);
 
+	ProfileBegin(ProfGPS);
 	UpdateGPS();
 	if (F.NewGPSPosition) {
 		F.NewGPSPosition = false;
@@ -573,16 +689,23 @@ void UpdateInertial(void) {
 			Nav.C[a].Pos = GPS.C[a].Pos;
 			Nav.C[a].Vel = GPS.C[a].Vel;
 		}
+		Nav.FixuS = GPS.FixuS;
+
+		if ((CurrStateEst == ErrorStateEKF) && !F.Emulation)
+			ESKFFuseGPS();
 
 		UpdateWhere();
 
 		F.NavigationEnabled = true;
 		F.NewNavUpdate = Nav.Sensitivity > NAV_SENS_THRESHOLD_STICK;
 	}
+	ProfileEnd(ProfGPS);
 
 	if (!F.Emulation) {
+		ProfileBegin(ProfAltitude);
 		UpdateAltitudeEstimates();
 		UpdateAirspeed();
+		ProfileEnd(ProfAltitude);
 	}
 
 	TrackPitchAttitude();
@@ -596,8 +719,8 @@ void UpdateInertial(void) {
 void UpdateWhere(void) {
 
 	Nav.Distance = sqrtf(Sqr(Nav.C[EastC].Pos) + Sqr(Nav.C[NorthC].Pos));
-	Nav.Bearing = Make2Pi(atan2f(Nav.C[EastC].Pos, Nav.C[NorthC].Pos));
-	Nav.Elevation = MakePi(atan2f(Altitude, Nav.Distance));
+	Nav.Bearing = Make2Pi(FastAtan2(Nav.C[EastC].Pos, Nav.C[NorthC].Pos));
+	Nav.Elevation = MakePi(FastAtan2(Altitude, Nav.Distance));
 	Nav.Hint = MakePi((Nav.Bearing - PI) - Heading);
 
 } // UpdateWhere
@@ -25,10 +25,20 @@
 extern uint8 CurrStateEst;
 
 enum StateEstimators {
-	MadgwickIMU, MadgwickAHRS, MadgwickMARG, EstUnknown
+	MadgwickIMU, MadgwickAHRS, MadgwickMARG, ErrorStateEKF, EstUnknown
 };
 
 void InitMadgwick(void);
+void ConvertQuaternionToEuler(void);
+void ConvertEulerToQuaternion(real32 p, real32 r, real32 y);
+void ConvertEulerToMARGQuaternion(real32 p, real32 r, real32 y);
+void SetAttitude(real32 * q);
+void MadgwickUpdate(boolean AHRS, real32 dAx, real32 dAy, real32 dAz, real32 ax,
+		real32 ay, real32 az, real32 mx, real32 my, real32 mz);
+void MadgwickMARGUpdate(real32 dAx, real32 dAy, real32 dAz, real32 ax, real32 ay,
+		real32 az, real32 mx, real32 my, real32 mz);
+real32 CalculateAccConfidence(real32 AccMag);
+void CalculatedT(uint64 SampleuS);
 void UpdateInertial(void);
 
 void GetIMU(void);
@@ -37,6 +47,15 @@ void CheckNavEnable(void);
 
 void ShowIMUType(uint8 s);
 
+typedef struct {
+	real32 q[4];
+	real32 DCM[3][3];
+	real32 Sin[3], Cos[3]; // of A[].Angle
+	real32 Gravity[3]; // body frame
+} AttitudeStruct;
+
+extern AttitudeStruct Att;
+
 real32 GravityCompensatedAccZ(void);
 real32 AttitudeCosine(void);
 void UpdateWhere(void);
@@ -46,11 +65,11 @@ extern const char * IMUName[];
 extern real32 AccConfidenceSDevR, AccConfidence;
 extern real32 KpAccBase, KpMagBase, BetaBase;
 
-extern HistStruct AccZF;
+extern LPFilterStruct AccZF;
 extern real32 AccZ;
 extern real32 AltLPFHz;
 
-extern uint32 LastInertialUpdateuS;
+extern uint64 LastInertialSampleuS;
 
 #endif
 
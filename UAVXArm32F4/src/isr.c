@@ -24,9 +24,11 @@
 
 volatile uint32 sysTickUptime = 0;
 volatile uint32 sysTickCycleCounter = 0;
+volatile uint64 sysTickuS = 0;
 
 void SysTick_Handler(void) {
-	sysTickCycleCounter = SysTick->VAL; // *DWT_CYCCNT;
+	sysTickCycleCounter += SystemCoreClock / 1000; // SysTick reload, DWT also runs from HCLK
+	sysTickuS += 1000;
 	sysTickUptime++;
 } // SysTick_Handler
 
@@ -92,6 +94,27 @@ void TIM3_IRQHandler(void) {
 
 } // TIM3_IRQHandler
 
+//______________________________________________________________________________________________
+
+// Sensors
+
+#if defined(USE_MPU6XXX_INT)
+
+void EXTI15_10_IRQHandler(void) {
+
+	if (EXTI_GetITStatus(EXTI_Line14) != RESET) {
+		MPU6XXXDataReadyStruct DataReady;
+
+		EXTI_ClearITPendingBit(EXTI_Line14);
+		DataReady.c = cycleCounter();
+		DataReady.uS = uSClock64();
+		ringPut(&MPU6XXXDataReadyQ, &DataReady);
+	}
+
+} // EXTI15_10_IRQHandler
+
+#endif
+
 
 //______________________________________________________________________________________________
 
@@ -168,6 +191,9 @@ void DMA1_Stream6_IRQHandler(void) {
 
 void DMA1_Stream3_IRQHandler(void) {
 
+#if defined(USE_SPI_DMA) // SPI2 Rx - USART3 Tx DMA is not used
+	spiDMAISR();
+#else
 	DMA_ClearITPendingBit(DMA1_Stream3, DMA_IT_TCIF3);
 	DMA_Cmd(DMA1_Stream3, DISABLE);
 
@@ -176,6 +202,7 @@ void DMA1_Stream3_IRQHandler(void) {
 		if (TxQHead[I2CSerial] != TxQTail[2])
 		serialTxDMA(2);
 	}
+#endif
 
 } // DMA1_Stream3_IRQHandler
 
@@ -44,9 +44,11 @@ void SysTick_Handler(void);
 
 void SysTick_Handler(void);
 void GPSInISR(void);
+void EXTI15_10_IRQHandler(void);
 
 extern volatile uint32 sysTickUptime;
 extern volatile uint32 sysTickCycleCounter;
+extern volatile uint64 sysTickuS;
 
 
 
@@ -0,0 +1,125 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+#include "UAVX.h"
+
+int16 UbxSaveConfigStep(uint8 n) {
+
+	if (n == 0) {
+		UbxSendSaveConfig(GPSTxSerial);
+		return (UBX_SAVE_CONFIG_MS); // GPS is busy writing its own flash
+	} else
+		return (JOB_DONE);
+
+} // UbxSaveConfigStep
+
+int16 InitGPSStep(uint8 n) {
+
+	InitGPS();
+
+	return (JOB_DONE);
+} // InitGPSStep
+
+JobStruct Jobs[MAX_JOBS] = { //
+		{ UbxSaveConfigStep, 2, false, }, //
+				{ UpdateNVStep, NV_JOB_STEPS, true, }, //
+				{ InitGPSStep, 1, true, }, //
+				{ InitBlackBoxStep, 1, false, }, //
+		};
+
+static uint8 Queue[MAX_JOBS];
+uint8 JobsQueued = 0;
+
+void QueueJob(uint8 j) {
+
+	if (!Jobs[j].Queued) {
+		Jobs[j].Queued = true;
+		Jobs[j].n = 0;
+		Jobs[j].WaitmS = mSClock();
+		Queue[JobsQueued++] = j;
+	}
+
+} // QueueJob
+
+boolean JobPending(uint8 j) {
+	return (Jobs[j].Queued);
+} // JobPending
+
+uint8 JobProgress(uint8 j) { // percent
+	return (Jobs[j].Queued ? Min((Jobs[j].n * 100) / Jobs[j].Steps, 99) : 100);
+} // JobProgress
+
+static boolean MayStall(void) {
+	return (!F.DrivesArmed && (State != Landed)); // Landed spins up on throttle alone
+} // MayStall
+
+// Runs one step of the oldest job that is not held while the drives may spin. A job waiting on its
+// device holds up those behind it so jobs sharing a device keep their order.
+
+void RunJobs(void) {
+	uint32 StartuS, StepuS;
+	JobStruct * j;
+	int16 Wait;
+	idx q;
+
+	for (q = 0; q < JobsQueued; q++) {
+		j = &Jobs[Queue[q]];
+		if (!j->Grounded || MayStall()) {
+			if (TimeReached(mSClock(), j->WaitmS)) {
+
+				StartuS = uSClock();
+				Wait = j->Step(j->n++);
+				StepuS = uSClock() - StartuS;
+
+				j->StepsRun++;
+				if (StepuS > j->MaxStepuS) {
+					j->MaxStepuS = StepuS;
+					j->MaxStepState = State;
+				}
+				StatsMax(JobStallS, StepuS / 1000);
+
+				if (Wait == JOB_DONE) {
+					j->Queued = false;
+					j->Runs++;
+					for (JobsQueued--; q < JobsQueued; q++)
+						Queue[q] = Queue[q + 1];
+				} else if (Wait == JOB_RESTART) {
+					j->n = 0;
+					j->WaitmS = mSClock() + JOB_RESTART_MS;
+				} else
+					j->WaitmS = mSClock() + Wait;
+			}
+			break;
+		}
+	}
+
+} // RunJobs
+
+void InitJobs(void) {
+	idx j;
+
+	for (j = 0; j < MAX_JOBS; j++) {
+		Jobs[j].Queued = false;
+		Jobs[j].Runs = Jobs[j].StepsRun = Jobs[j].MaxStepuS = 0;
+	}
+	JobsQueued = 0;
+
+} // InitJobs
+
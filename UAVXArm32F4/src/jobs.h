@@ -0,0 +1,60 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+#ifndef _jobs_h
+#define _jobs_h
+
+// Work too slow for the control cycle is queued by the state machine and run a step at a
+// time from the JobsTask slot in the scheduler. A step returns the mS to wait before the
+// next step, so device settle times no longer busy wait. Jobs that must stall the CPU,
+// such as the flash sector erase, are held while the drives are, or may be, spinning.
+
+#define JOB_DONE	(-1)
+#define JOB_NEXT	0
+#define JOB_RESTART	(-2) // from step 0 after JOB_RESTART_MS
+#define JOB_RESTART_MS	1000
+
+enum JobIDs { // each job is queued at most once
+	UbxSaveConfigJob, UpdateNVJob, InitGPSJob, InitBlackBoxJob, MAX_JOBS
+};
+
+typedef struct {
+	int16 (*Step)(uint8 n); // returns JOB_DONE, JOB_NEXT, JOB_RESTART or mS to wait
+	uint8 Steps; // expected, for progress only
+	boolean Grounded; // stalls the CPU so only run with the drives stopped
+	// run time
+	boolean Queued;
+	uint8 n;
+	uint32 WaitmS;
+	uint32 Runs, StepsRun, MaxStepuS;
+	uint8 MaxStepState; // State when MaxStepuS was taken
+} JobStruct;
+
+extern void QueueJob(uint8 j);
+extern boolean JobPending(uint8 j);
+extern uint8 JobProgress(uint8 j);
+extern void RunJobs(void);
+extern void InitJobs(void);
+
+extern JobStruct Jobs[];
+extern uint8 JobsQueued;
+
+#endif
+
@@ -209,17 +209,17 @@ static void wsStartDMA1(uint16 BuffSize) {
 			.DMA_Channel = DMA_Channel_0,
 			.DMA_DIR = DMA_DIR_MemoryToPeripheral, .DMA_FIFOMode =
 					DMA_FIFOMode_Disable, .DMA_FIFOThreshold =
-					DMA_FIFOThreshold_HalfFull, .DMA_Memory0BaseAddr =
-					(uint32) wsPWMBuffer, .DMA_MemoryBurst =
+					DMA_FIFOThreshold_HalfFull, .DMA_MemoryBurst =
 					DMA_MemoryBurst_Single, .DMA_MemoryDataSize =
 					DMA_MemoryDataSize_HalfWord, .DMA_MemoryInc =
 					DMA_MemoryInc_Enable, .DMA_Mode = DMA_Mode_Circular,
-			.DMA_PeripheralBaseAddr = (uint32) &TIM8->CCR1,
 			.DMA_PeripheralBurst = DMA_PeripheralBurst_Single,
 			.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord,
 			.DMA_PeripheralInc = DMA_PeripheralInc_Disable, .DMA_Priority =
 					DMA_Priority_High }; // Medium
 
+	dma_init.DMA_Memory0BaseAddr = (uint32) wsPWMBuffer;
+	dma_init.DMA_PeripheralBaseAddr = (uint32) &TIM8->CCR1;
 	dma_init.DMA_BufferSize = BuffSize;
 
 	DMA_Init(DMA2_Stream2, &dma_init);
@@ -582,7 +582,7 @@ void LEDChaser(void) {
 	uint32 NowmS;
 
 	NowmS = mSClock();
-	if (NowmS > mS[LEDChaserUpdate]) {
+	if (mSTimeout(NowmS, LEDChaserUpdate)) {
 		if (F.AltControlEnabled && F.HoldingAlt) {
 			LEDOff(LEDChase[LEDPattern]);
 			if (LEDPattern < MAX_LEDS)
@@ -36,6 +36,7 @@ real32 MagVariationWMM2010 = 0.0f;
 real32 MagLockE, MagHeading, Heading, CompassOffset;
 uint8 MagnetometerType;
 real32 MagdT;
+uint64 MagSampleuS = 0; // capture time of Mag[]
 
 real32 Mag[3];
 int16 RawMag[3];
@@ -79,42 +80,84 @@ boolean ReadMagnetometer(void) {
 } // ReadMagnetometer
 
 
-void GetMagnetometer(void) {
-	uint32 NowmS;
-	static uint32 LastMagUpdateuS = 0;
+// The field registers are read through the sio queue on the MAG_TIME_MS tick and the sample
+// is published from a later pass once the transfer has completed, so the read no longer
+// stalls the control cycle. Samples are stamped when their transfer completes.
+
+enum MagReadStates {
+	MagReadIdle, MagReadBusy, MagReadReady, MagReadFailed
+};
+
+static volatile uint8 MagReadState = MagReadIdle;
+static volatile uint64 MagReadSampleuS;
+static uint8 MagReadB[6];
+
+static void MagReadDone(boolean ok) {
+
+	MagReadSampleuS = uSClock64();
+	MagReadState = ok ? MagReadReady : MagReadFailed;
+
+} // MagReadDone
+
+static void PublishMagnetometer(uint64 SampleuS) {
 	int32 a;
 
-	if (F.MagnetometerActive) {
-		NowmS = mSClock();
-		if (NowmS >= mS[MagnetometerUpdate]) {
-			mSTimer(NowmS, MagnetometerUpdate, MAG_TIME_MS);
+	MagdT = ((MagSampleuS != 0) && (SampleuS > MagSampleuS)) ? (SampleuS
+			- MagSampleuS) * 0.000001f : MAG_TIME_MS * 0.001f;
+	MagSampleuS = SampleuS;
+
+	if (F.InvertMagnetometer) {
+		Mag[BF] = (real32) RawMag[MX] * MagScale[MX]; // -
+		Mag[LR] = -(real32) RawMag[MY] * MagScale[MY];
+		Mag[UD] = (real32) RawMag[MZ] * MagScale[MZ];
+	} else {
+		Mag[BF] = (real32) RawMag[MY] * MagScale[MY];
+		Mag[LR] = (real32) RawMag[MX] * MagScale[MX];
+		Mag[UD] = -(real32) RawMag[MZ] * MagScale[MZ];
+	}
 
-			RawMag[MX] = -4096;
+	for (a = X; a <= Z; a++)
+		Mag[a] -= NV.MagCal.Bias[a];
 
-			MagdT = dTUpdate(uSClock(), &LastMagUpdateuS);
+	real32 NormR = invSqrt(Sqr(Mag[0]) + Sqr(Mag[1]) + Sqr(Mag[2]));
+	for (a = X; a <= Z; a++)
+		Mag[a] *= NormR;
 
-			if (ReadMagnetometer()) {
+	F.NewMagValues = true;
 
-				if (F.InvertMagnetometer) {
-					Mag[BF] = (real32) RawMag[MX] * MagScale[MX]; // -
-					Mag[LR] = -(real32) RawMag[MY] * MagScale[MY];
-					Mag[UD] = (real32) RawMag[MZ] * MagScale[MZ];
-				} else {
-					Mag[BF] = (real32) RawMag[MY] * MagScale[MY];
-					Mag[LR] = (real32) RawMag[MX] * MagScale[MX];
-					Mag[UD] = -(real32) RawMag[MZ] * MagScale[MZ];
-				}
+} // PublishMagnetometer
 
-				for (a = X; a <= Z; a++)
-					Mag[a] -= NV.MagCal.Bias[a];
+void GetMagnetometer(void) {
+	uint32 NowmS;
+	idx a;
 
-				real32 NormR = invSqrt(Sqr(Mag[0]) + Sqr(Mag[1]) + Sqr(Mag[2]));
-				for (a = X; a <= Z; a++)
-					Mag[a] *= NormR;
+	if (F.MagnetometerActive) {
+		NowmS = mSClock();
+		if (mSTimeout(NowmS, MagnetometerUpdate) && (MagReadState
+				== MagReadIdle)) {
+			mSTimer(NowmS, MagnetometerUpdate, MAG_TIME_MS);
 
-				F.NewMagValues = true;
-			} else
+			MagReadState = MagReadBusy;
+			if (!sioQueueRead(SIOMag, HMC5XXX_ID, HMC5XXX_DATA, 6, MagReadB,
+					MagReadDone))
+				MagReadState = MagReadFailed;
+		}
+
+		if (MagReadState == MagReadReady) {
+			for (a = 0; a < 3; a++) // HMC5XXX order X Z Y as MX MZ MY
+				RawMag[a] = ((int16) MagReadB[a * 2] << 8) | MagReadB[a * 2 + 1];
+
+			if ((RawMag[0] != -4096) && (RawMag[1] != -4096) && (RawMag[2]
+					!= -4096))
+				PublishMagnetometer(MagReadSampleuS);
+			else {
+				incStat(CompassFailS);
 				F.NewMagValues = false;
+			}
+			MagReadState = MagReadIdle;
+		} else if (MagReadState == MagReadFailed) {
+			F.NewMagValues = false; // counted as I2CFailS
+			MagReadState = MagReadIdle;
 		}
 	} else
 		F.NewMagValues = false;
@@ -129,15 +172,15 @@ void CalculateMagneticHeading(void) {
 	if (F.NewMagValues) {
 		F.NewMagValues = false;
 
-		cR = cosf(-A[Roll].Angle);
-		sR = sinf(-A[Roll].Angle);
-		cP = cosf(A[Pitch].Angle);
-		sP = sinf(A[Pitch].Angle);
+		sR = -Att.Sin[Roll]; // -Roll
+		cR = Att.Cos[Roll];
+		sP = Att.Sin[Pitch];
+		cP = Att.Cos[Pitch];
 
 		xh = Mag[BF] * cP + sP * (Mag[UD] * cR - Mag[LR] * sR);
 		yh = Mag[LR] * cR + Mag[UD] * sR;
 
-		MagHeading = -atan2f(yh, xh); // filtering is difficult because of 360deg discontinuity
+		MagHeading = -FastAtan2(yh, xh); // filtering is difficult because of 360deg discontinuity
 	}
 
 } // CalculateMagneticHeading
@@ -280,7 +323,7 @@ void CalibrateHMC5XXX(uint8 s) {
 		while (ss < MAG_CAL_SAMPLES) {
 
 			mSTimer(mSClock(), MagnetometerUpdate, MAG_TIME_MS);
-			while (mSClock() < mS[MagnetometerUpdate]) {
+			while (!mSTimeout(mSClock(), MagnetometerUpdate)) {
 			};
 
 			LEDToggle(LEDBlueSel);
@@ -63,6 +63,7 @@ extern real32 Mag[];
 extern volatile uint16 MagSample;
 extern real32 MagTemperature;
 extern real32 MagdT;
+extern uint64 MagSampleuS;
 
 #endif
 
@@ -31,7 +31,7 @@
 #define FLAG_BYTES  10
 
 extern volatile uint32 mS[];
-extern volatile uint32 uS[];
+extern volatile uint64 uS[];
 extern real32 dT, dTR, dTOn2, dTROn2;
 extern uint32 CurrPIDCycleuS;
 extern real32 CurrPIDCycleS;
@@ -40,7 +40,7 @@ extern uint32 LastUpdateuS;
 extern const char SerHello[];
 
 enum uSTimes {
-	NextCycleUpdate, MemReady, LastCycleTime, uSLastArrayEntry
+	NextCycleUpdate, MemReady, LastCycleTime, NextGyroUpdate, uSLastArrayEntry
 };
 
 
@@ -64,7 +64,6 @@ enum mSTimes {
 	StickTimeout,
 	LEDChaserUpdate,
 	LastBattery,
-	BatteryUpdate,
 	TelemetryUpdate,
 	NavActiveTime,
 	BeeperUpdate,
@@ -359,13 +359,13 @@ void mavlinkUpdate(uint8 s) {
 			RxChar(s);
 	//mavlinkPollRx(s);
 
-	if (NowmS > LastHeartbeatmS) {
+	if (TimeReached(NowmS, LastHeartbeatmS)) {
 		LastHeartbeatmS = NowmS + 1000;
 		mavlinkSendHeartbeat(s);
 		mavlinkSendSysStatus(s);
 	}
 
-	if (NowmS >= mS[TelemetryUpdate]) {
+	if (mSTimeout(NowmS, TelemetryUpdate)) {
 		mSTimer(NowmS, TelemetryUpdate, 100);
 
 		if ((Tick % 2) == 0) { // 5Hz
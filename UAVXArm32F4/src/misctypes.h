@@ -116,14 +116,73 @@ typedef struct {
 	boolean Prime;
 } real32x15Window;
 
+// Filters hold coefficients computed by their Init/Set functions so each sample costs only
+// multiply-adds.
+
+#define LP_MAX_ORDER	3
+#define MA_MAX_LEN		32
+#define PAVEL_LEN		6
+
+typedef struct { // cascaded first order low pass
+	real32 h[LP_MAX_ORDER + 1];
+	real32 K, Tau;
+	real32 dT; // interval K was computed for
+	uint64 SampleuS; // capture time of the last sample for LPFilterAt
+	uint8 Order;
+	boolean Primed;
+} LPFilterStruct;
+
+typedef struct { // moving average over a power of 2 samples
+	real32 h[MA_MAX_LEN];
+	real32 S, NR;
+	uint8 N, Head;
+	boolean Primed;
+} MAFilterStruct;
+
 typedef struct {
-	real32 c[5];
-	real32 h[64]; // for rate of change use
-	real32 S;
-	real32 Tau;
+	real32 h[PAVEL_LEN];
 	boolean Primed;
-	uint8 Head, Tail;
-} HistStruct;
+} PavelStruct;
+
+#define MEDIAN_MAX_LEN	63
+
+typedef struct { // sliding median, see MedianFilter
+	real32 v[MEDIAN_MAX_LEN]; // window in arrival order
+	int8 Pos[MEDIAN_MAX_LEN]; // heap position of each entry
+	int8 Heap[MEDIAN_MAX_LEN]; // entries by position, median at MEDIAN_MAX_LEN/2
+	uint8 N, Count, Next;
+} MedianFilterStruct;
+
+typedef struct {
+	real32 b0, b1, b2, a1, a2; // normalised, a0 = 1
+	real32 x1, x2, y1, y2;
+} BiquadStruct;
+
+// Three axis banks hold the axes side by side, structure of arrays, with a fourth lane of
+// padding so each stage is one vector operation where the target has them.
+
+#define FILTER_LANES	4
+
+typedef struct {
+	real32 h[LP_MAX_ORDER + 1][FILTER_LANES] __attribute__((aligned(16)));
+	real32 K, Tau;
+	real32 dT;
+	uint64 SampleuS;
+	uint8 Order;
+	boolean Primed;
+} LPFilterBankStruct;
+
+typedef struct {
+	real32 b0[FILTER_LANES] __attribute__((aligned(16)));
+	real32 b1[FILTER_LANES] __attribute__((aligned(16)));
+	real32 b2[FILTER_LANES] __attribute__((aligned(16)));
+	real32 a1[FILTER_LANES] __attribute__((aligned(16)));
+	real32 a2[FILTER_LANES] __attribute__((aligned(16)));
+	real32 x1[FILTER_LANES] __attribute__((aligned(16)));
+	real32 x2[FILTER_LANES] __attribute__((aligned(16)));
+	real32 y1[FILTER_LANES] __attribute__((aligned(16)));
+	real32 y2[FILTER_LANES] __attribute__((aligned(16)));
+} BiquadBankStruct;
 
 typedef struct {
 	uint32 h[64]; // for rate of change use
@@ -297,6 +297,7 @@ void UpdateMulticopterMix(real32 CurrThrottlePW) {
 } // UpdateMulticopterMix
 
 boolean MotorDemandRescale;
+real32 MixScale = 1.0f; // roll and pitch demand delivered after rescaling
 
 boolean RescaleMix(real32 CurrThrottlePW) {
 	uint8 m;
@@ -313,6 +314,7 @@ boolean RescaleMix(real32 CurrThrottlePW) {
 
 	if (DemandSwing > AvailableSwing) {
 		Scale = AvailableSwing / DemandSwing;
+		MixScale = Scale;
 		Rl *= Scale;
 		Pl *= Scale;
 
@@ -348,6 +350,7 @@ void DoMulticopterMix(void) {
 
 	UpdateMulticopterMix(CurrThrottlePW);
 
+	MixScale = 1.0f;
 	F.EnforceDriveSymmetry = true;
 	if (F.EnforceDriveSymmetry)
 		if (RescaleMix(CurrThrottlePW))
@@ -30,6 +30,7 @@ void MixAndLimitCam(void);
 void InitServoSense(void);
 
 extern real32 IdleThrottlePW;
+extern real32 MixScale;
 extern real32 NetThrottle;
 extern boolean LaunchOrTransitionMode;
 
@@ -44,7 +44,14 @@ uint8 MPU6XXXDHPF = 0;
 
 real32 MPU6XXXTemperature = 25.0f;
 uint8 MPU_ID = MPU_0x68_ID;
-uint32 mpu6xxxLastUpdateuS = 0;
+uint64 mpu6xxxSampleuS = 0; // capture time of the latest sample
+
+// data ready times from the EXTI ISR, more than one queued means the loop was late
+#define MPU_DATA_READY_Q_LEN 4
+static MPU6XXXDataReadyStruct MPU6XXXDataReadyQBuf[MPU_DATA_READY_Q_LEN];
+RingStruct MPU6XXXDataReadyQ = { 0, 0, MPU_DATA_READY_Q_LEN - 1, sizeof(MPU6XXXDataReadyStruct),
+		(uint8 *) MPU6XXXDataReadyQBuf, 0, 0 };
+uint32 MPU6XXXDataReadyLate = 0;
 
 real32 RawAcc[3], RawGyro[3];
 
@@ -65,14 +72,188 @@ void ComputeMPU6XXXTemperature(int16 T) {
 
 } // ComputeMPU6XXXTemperature
 
+#if defined(USE_SPI_DMA) && !defined(USE_MPU6XXX_FIFO)
+
+// The acc/temperature/gyro burst is queued at the start of the control cycle and moved by
+// DMA while the drives are updated. ReadAccAndGyro collects it falling back to a blocking
+// read if no burst was started or it failed.
+
+enum MPUBurstStates {
+	MPUBurstIdle, MPUBurstBusy, MPUBurstReady, MPUBurstFailed
+};
+
+static uint8 MPUBurst[14];
+static volatile uint8 MPUBurstState = MPUBurstIdle;
+static volatile uint64 MPUBurstuS;
+
+static void MPUBurstDone(boolean ok) {
+
+	MPUBurstState = ok ? MPUBurstReady : MPUBurstFailed;
+
+} // MPUBurstDone
+
+void StartAccAndGyroRead(void) {
+
+	if (spiDMAEnabled && spiDevUsed[SIOIMU] && (MPUBurstState == MPUBurstIdle)) {
+		MPUBurstState = MPUBurstBusy;
+		MPUBurstuS = uSClock64(); // the bus is idle at cycle start so this is the latch time
+		if (!spiQueueRead(SIOIMU, MPU_RA_ACC_XOUT_H, sizeof(MPUBurst), MPUBurst,
+				MPUBurstDone))
+			MPUBurstState = MPUBurstIdle;
+	}
+
+} // StartAccAndGyroRead
+
+static boolean CollectAccAndGyro(int16 * B) {
+	boolean r;
+	idx i;
+
+	if (MPUBurstState == MPUBurstIdle)
+		return (false);
+
+	while (MPUBurstState == MPUBurstBusy)
+		spiCheckTimeout();
+
+	r = MPUBurstState == MPUBurstReady;
+	if (r) {
+		for (i = 0; i < 7; i++)
+			B[i] = (int16) (((uint16) MPUBurst[i * 2] << 8) | MPUBurst[i * 2 + 1]);
+		mpu6xxxSampleuS = MPUBurstuS;
+	}
+	MPUBurstState = MPUBurstIdle;
+
+	return (r);
+} // CollectAccAndGyro
+
+#endif
+
+// The n oldest of the Queued samples are averaged to one. Samples are back dated from the
+// FIFO count read at ReaduS by the sample interval, the newest being on average half an
+// interval old, and the mean time stamps the result.
+
+MPUFIFOStruct MPUFIFO = { 1000000 / MPU_FIFO_HZ, };
+
+// Samples to drain for a FIFO count, negative if the FIFO must be reset as a full FIFO
+// has dropped samples and may be misaligned
+
+int16 MPU6XXXFIFOSamples(uint16 Count) {
+	uint16 Queued;
+
+	if ((Count > (MPU_FIFO_BYTES - MPU_FIFO_SAMPLE_BYTES)) || ((Count
+			% MPU_FIFO_SAMPLE_BYTES) != 0)) {
+		MPUFIFO.Overflows++;
+		return (-1);
+	}
+
+	Queued = Count / MPU_FIFO_SAMPLE_BYTES;
+	if (Queued == 0)
+		MPUFIFO.Empty++;
+
+	return (Min(Queued, MPU_FIFO_MAX_SAMPLES));
+} // MPU6XXXFIFOSamples
+
+uint16 MPU6XXXFIFODecimate(uint64 ReaduS, uint16 Queued, const uint8 * F,
+		uint16 n, int16 * B) {
+	int32 Sum[7];
+	real32 v[7];
+	idx i, s;
+
+	for (i = 0; i < 7; i++)
+		Sum[i] = 0;
+
+	for (s = 0; s < n; s++, F += MPU_FIFO_SAMPLE_BYTES) {
+		for (i = 0; i < 7; i++) {
+			v[i] = (int16) (((uint16) F[i * 2] << 8) | F[i * 2 + 1]);
+			Sum[i] += (int32) v[i];
+		}
+		SampleIMUDelta(&v[4], &v[0]); // every sample, not just their mean
+	}
+
+	for (i = 0; i < 7; i++) // rounded to nearest
+		B[i] = (Sum[i] >= 0) ? (Sum[i] + (n >> 1)) / n : -((-Sum[i] + (n
+				>> 1)) / n);
+
+	// oldest sample at ReaduS - (Queued - 0.5) * SampleuS
+	mpu6xxxSampleuS = ReaduS - (((uint64) (2 * Queued - n)
+			* MPUFIFO.SampleuS) >> 1);
+	MPUFIFO.LastSampleuS = ReaduS - ((((uint64) (Queued - n) << 1) + 1)
+			* MPUFIFO.SampleuS >> 1);
+
+	MPUFIFO.Drains++;
+	MPUFIFO.Samples += n;
+	if (Queued > MPUFIFO.MaxQueued)
+		MPUFIFO.MaxQueued = Queued;
+
+	return (n);
+} // MPU6XXXFIFODecimate
+
+#if defined(USE_MPU6XXX_FIFO)
+
+static void ResetMPU6XXXFIFO(void) {
+	uint8 v;
+
+	v = sioReadataddr(SIOIMU, MPU_ID, MPU_RA_USER_CTRL);
+	bitSet(v, MPU_RA_USERCTRL_FIFO_EN_BIT);
+	bitSet(v, MPU_RA_USERCTRL_FIFO_RESET_BIT);
+	sioWrite(SIOIMU, MPU_ID, MPU_RA_USER_CTRL, v);
+
+} // ResetMPU6XXXFIFO
+
+static void InitMPU6XXXFIFO(void) {
+
+	// 1KHz as the acc - the divider thins the 8KHz gyro rate with the DLPF off
+	MPUFIFO.SampleuS = 1000000 / MPU_FIFO_HZ;
+	sioWrite(SIOIMU, MPU_ID, MPU_RA_SMPLRT_DIV, ((MPU6XXXDLPF == 0)
+			|| (MPU6XXXDLPF == 7)) ? 7 : 0);
+
+	sioWrite(SIOIMU, MPU_ID, MPU_RA_FIFO_EN, (1 << MPU_RA_TEMP_FIFO_EN_BIT) | (1
+			<< MPU_RA_XG_FIFO_EN_BIT) | (1 << MPU_RA_YG_FIFO_EN_BIT) | (1
+			<< MPU_RA_ZG_FIFO_EN_BIT) | (1 << MPU_RA_ACC_FIFO_EN_BIT));
+
+	ResetMPU6XXXFIFO();
+
+} // InitMPU6XXXFIFO
+
+static boolean ReadMPU6XXXFIFO(int16 * B) {
+	static uint8 F[MPU_FIFO_MAX_SAMPLES * MPU_FIFO_SAMPLE_BYTES];
+	uint8 C[2];
+	uint16 Count;
+	int16 n;
+	uint64 ReaduS;
+
+	sioReadBlock(SIOIMU, MPU_ID, MPU_RA_FIFO_COUNTH, 2, C);
+	ReaduS = uSClock64();
+	Count = ((uint16) C[0] << 8) | C[1];
+
+	n = MPU6XXXFIFOSamples(Count);
+	if (n < 0)
+		ResetMPU6XXXFIFO();
+	if (n <= 0)
+		return (false);
+
+	sioReadBlock(SIOIMU, MPU_ID, MPU_RA_FIFO_R_W, n * MPU_FIFO_SAMPLE_BYTES, F);
+
+	MPU6XXXFIFODecimate(ReaduS, Count / MPU_FIFO_SAMPLE_BYTES, F, n, B);
+
+	return (true);
+} // ReadMPU6XXXFIFO
+
+#endif
+
 void ReadAccAndGyro(boolean UseSelectedAttSensors) { // Roll Right +, Pitch Up +, Yaw ACW +
 	int16 B[7];
 	idx a;
 	static int16 BP[7] = { 0, 0, 0, 0, 0, 0, 0 };
 
-	sioReadBlocki16vataddr(SIOIMU, MPU_ID, MPU_RA_ACC_XOUT_H, 7, B, true);
-
-	mpu6xxxLastUpdateuS = uSClock();
+#if defined(USE_MPU6XXX_FIFO)
+	if (!ReadMPU6XXXFIFO(B)) // empty or reset - read the data registers
+#elif defined(USE_SPI_DMA)
+	if (!CollectAccAndGyro(B))
+#endif
+	{
+		mpu6xxxSampleuS = uSClock64(); // registers latch at the start of the burst
+		sioReadBlocki16vataddr(SIOIMU, MPU_ID, MPU_RA_ACC_XOUT_H, 7, B, true);
+	}
 	mpuReads++;
 
 	if ((CurrAttSensorType == InfraRedAngle) && !IsMulticopter) {
@@ -122,6 +303,22 @@ void ReadAccAndGyro(boolean UseSelectedAttSensors) { // Roll Right +, Pitch Up +
 } // ReadAccAndGyro
 
 
+#if defined(USE_GYRO_OVERSAMPLING)
+
+void ReadGyro(void) { // gyro only for the fast stage - no slew limiting
+	int16 B[3];
+
+	mpu6xxxSampleuS = uSClock64();
+	sioReadBlocki16vataddr(SIOIMU, MPU_ID, MPU_RA_GYRO_XOUT_H, 3, B, true);
+
+	RawGyro[X] = (real32) B[0];
+	RawGyro[Y] = (real32) B[1];
+	RawGyro[Z] = (real32) B[2];
+
+} // ReadGyro
+
+#endif
+
 void CalibrateAccAndGyro(uint8 s) {
 	// (C) G.K. Egan 2012
 	// Basic idea from MEMSIC #AN-00MX-002 Ricardo Dao 4 Nov 2002
@@ -192,6 +389,7 @@ void CalibrateAccAndGyro(uint8 s) {
 		NVChanged = true;
 		UpdateNV();
 		UpdateGyroTempComp();
+		ResetIMUDelta();
 		DoBeep(8, 1);
 		LEDOff(LEDBlueSel);
 		SendAckPacket(s, UAVXMiscPacketTag, 1);
@@ -288,11 +486,44 @@ void InitMPU6XXX(void) {
 	MPU6000DLPF = sioReadataddr(SIOIMU, MPU_ID, MPU_RA_ACC_CONFIG2) & 0x07;
 #endif
 
+#if defined(USE_MPU6XXX_INT)
+	InitMPU6XXXDataReady();
+#elif defined(USE_MPU6XXX_FIFO)
+	InitMPU6XXXFIFO();
+#endif
+
 	Delay1mS(100); // added to prevent apparent SPI hang
 
 } // InitMPU6XXX
 
 
+#if defined(USE_MPU6XXX_INT)
+
+void InitMPU6XXXDataReady(void) {
+	uint32 SampleHz;
+	uint8 v;
+
+	// data ready once per control cycle - internal rate is 8KHz only with the DLPF off
+	SampleHz = ((MPU6XXXDLPF == 0) || (MPU6XXXDLPF == 7)) ? 8000 : 1000;
+	sioWrite(SIOIMU, MPU_ID, MPU_RA_SMPLRT_DIV, Limit((int32) ((SampleHz
+			* CurrPIDCycleuS) / 1000000) - 1, 0, 255));
+
+	// active low 50uS pulse to suit the pulled up falling edge EXTI line
+	v = sioReadataddr(SIOIMU, MPU_ID, MPU_RA_INT_PIN_CFG);
+	bitSet(v, MPU_RA_INTCFG_INT_LEVEL_BIT);
+	bitClear(v, MPU_RA_INTCFG_LATCH_INT_EN_BIT);
+	bitSet(v, MPU_RA_INTCFG_INT_RD_CLEAR_BIT);
+	sioWrite(SIOIMU, MPU_ID, MPU_RA_INT_PIN_CFG, v);
+
+	sioWrite(SIOIMU, MPU_ID, MPU_RA_INT_ENABLE, 1
+			<< MPU_RA_INTERRUPT_DATA_RDY_BIT);
+
+	ringFlush(&MPU6XXXDataReadyQ);
+
+} // InitMPU6XXXDataReady
+
+#endif
+
 void CheckMPU6XXXActive(void) {
 	boolean r;
 
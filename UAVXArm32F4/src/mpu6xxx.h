@@ -40,14 +40,49 @@ extern uint8 MPU6XXXDHPF;
 extern uint8 MPU6XXXAccDLPF;
 extern real32 MPU6XXXTemperature;
 
+// FIFO acquisition - acc, temperature and gyro in register order so each sample decodes
+// as the burst read
+
+#define MPU_FIFO_SAMPLE_BYTES	14
+#define MPU_FIFO_MAX_SAMPLES	16 // per drain, within a uint8 block length
+#define MPU_FIFO_HZ				1000
+#if defined(V4_BOARD)
+#define MPU_FIFO_BYTES			512 // MPU6500
+#else
+#define MPU_FIFO_BYTES			1024
+#endif
+
+typedef struct {
+	uint32 SampleuS;
+	uint32 Drains, Samples, Empty, Overflows;
+	uint16 MaxQueued;
+	uint64 LastSampleuS; // newest sample drained
+} MPUFIFOStruct;
+
+extern MPUFIFOStruct MPUFIFO;
+
+int16 MPU6XXXFIFOSamples(uint16 Count);
+uint16 MPU6XXXFIFODecimate(uint64 ReaduS, uint16 Queued, const uint8 * F,
+		uint16 n, int16 * B);
+
 void CalibrateAccAndGyro(uint8 s);
 void InitMPU6XXX(void);
 void CheckMPU6XXXActive(void);
+void InitMPU6XXXDataReady(void);
+void StartAccAndGyroRead(void);
 void ReadAccAndGyro(boolean UseSelectedAttSensors);
+void ReadGyro(void);
 void UpdateGyroTempComp(void);
 
 extern uint8 MPU_ID;
-extern uint32 mpu6xxxLastUpdateuS;
+extern uint64 mpu6xxxSampleuS;
+typedef struct {
+	uint64 uS;
+	uint32 c;
+} MPU6XXXDataReadyStruct;
+
+extern RingStruct MPU6XXXDataReadyQ;
+extern uint32 MPU6XXXDataReadyLate;
 extern real32 RawAcc[], RawGyro[];
 extern uint32 gyroGlitches;
 extern uint32 mpuReads;
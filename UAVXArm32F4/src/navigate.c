@@ -24,6 +24,7 @@
 
 real32 NavdT, NavdTR;
 uint32 LastNavUpdateuS = 0;
+uint64 LastNavFixuS = 0;
 NavStruct Nav;
 real32 DesiredVel;
 real32 POIHeading = 0.0f;
@@ -90,7 +91,7 @@ void CompensateCrossTrackError1D(void) {
 
 	DiffHeading = Nav.WPBearing - Nav.OriginalWPBearing;
 	if (UseCrossTrack(DiffHeading)) {
-		Nav.CrossTrackE = sinf(DiffHeading) * Nav.WPDistance;
+		Nav.CrossTrackE = FastSin(DiffHeading) * Nav.WPDistance;
 		Nav.WPBearing
 				+= Limit1(Nav.CrossTrackE * Nav.CrossTrackKp, DegreesToRadians(30));
 		Nav.WPBearing = Make2Pi(Nav.WPBearing);
@@ -214,7 +215,7 @@ void NavYaw(WPStruct * W) {
 
 			POIDistance = sqrtf(Sqr(POIEastDiff) + Sqr(POINorthDiff));
 			Nav.DesiredHeading = (POIDistance > (NV.Mission.ProximityRadius
-					* 2.0f)) ? atan2f(POIEastDiff, POINorthDiff) : Heading;
+					* 2.0f)) ? FastAtan2(POIEastDiff, POINorthDiff) : Heading;
 		} else {
 
 			if (F.UsingTurnToWP) {
@@ -281,6 +282,9 @@ void Navigate(WPStruct * W) {
 	idx a;
 
 	NavdT = dTUpdate(uSClock(), &LastNavUpdateuS);
+	if ((LastNavFixuS != 0) && (Nav.FixuS > LastNavFixuS)) // between fixes used
+		NavdT = (Nav.FixuS - LastNavFixuS) * 0.000001f;
+	LastNavFixuS = Nav.FixuS;
 	NavdTR = 1.0f / NavdT;
 
 	Nav.C[NorthC].DesPos = W->Pos[NorthC];
@@ -290,7 +294,7 @@ void Navigate(WPStruct * W) {
 	Nav.C[EastC].PosE = Nav.C[EastC].DesPos - Nav.C[EastC].Pos;
 
 	Nav.WPDistance = sqrtf(Sqr(Nav.C[EastC].PosE) + Sqr(Nav.C[NorthC].PosE));
-	Nav.WPBearing = Make2Pi(atan2f(Nav.C[EastC].PosE, Nav.C[NorthC].PosE));
+	Nav.WPBearing = Make2Pi(FastAtan2(Nav.C[EastC].PosE, Nav.C[NorthC].PosE));
 
 	CompensateCrossTrackError1D();
 
@@ -304,8 +308,9 @@ void Navigate(WPStruct * W) {
 
 	} else {
 
-		VelScale[NorthC] = Abs(cosf(Nav.WPBearing));
-		VelScale[EastC] = Abs(sinf(Nav.WPBearing));
+		FastSinCos(Nav.WPBearing, &VelScale[EastC], &VelScale[NorthC]);
+		VelScale[NorthC] = fabsf(VelScale[NorthC]);
+		VelScale[EastC] = fabsf(VelScale[EastC]);
 
 		CheckProximity(Min(GPS.vAcc * 1.5f, NV.Mission.ProximityAltitude),
 				WP.Action == navOrbit ? WP.OrbitRadius : Min(GPS.hAcc * 1.5f,
@@ -70,7 +70,11 @@ extern NVStruct NV;
 
 extern boolean NVChanged;
 
+#define NV_SLICE_BYTES		64 // programmed per job step, ~16uS per word
+#define NV_JOB_STEPS		(1 + (sizeof(NVStruct) + NV_SLICE_BYTES - 1) / NV_SLICE_BYTES)
+
 extern boolean UpdateNV(void);
+extern int16 UpdateNVStep(uint8 n);
 extern int8 ReadNV(uint32 a);
 extern void ReadBlockNV(uint32 a, uint16 l, int8 *v);
 
@@ -78,6 +82,7 @@ extern boolean EraseExtMem(void);
 
 extern void ReadBlockExtMem(uint32 a, uint16 l, int8 * v);
 boolean WriteBlockExtMem(uint32 a, uint16 l, int8 *v);
+extern boolean QueueBlockExtMem(uint32 a, uint16 l, int8 *v);
 
 extern void LogSerial(uint8 ch);
 extern void InitExtMem();
@@ -201,10 +201,10 @@ void UpdateDrives(void) {
 	if (DrivesInitialised) {
 		if (UAVXAirframe == IREmulation) {
 
-			PW[IRRollC] = OUT_NEUTRAL + PWSense[IRRollC] * sinf(A[Roll].Angle)
+			PW[IRRollC] = OUT_NEUTRAL + PWSense[IRRollC] * Att.Sin[Roll]
+					* OUT_NEUTRAL;
+			PW[IRPitchC] = OUT_NEUTRAL + PWSense[IRPitchC] * Att.Sin[Pitch]
 					* OUT_NEUTRAL;
-			PW[IRPitchC] = OUT_NEUTRAL + PWSense[IRPitchC] * sinf(
-					A[Pitch].Angle) * OUT_NEUTRAL;
 			PW[IRZC] = OUT_NEUTRAL + PWSense[IRZC] * 0.0f; // TODO:
 
 			for (m = 0; m < NoOfDrives; m++)
@@ -107,6 +107,10 @@ void RegeneratePIDCoeffs(void) {
 	const real32 ScaleRateKi = 0.05f; // ???
 	const real32 ScaleRateIL = 0.015f; // ??
 	const real32 ScaleRateKd = 0.0001f; // 0.0045
+	const real32 ScaleRateKff = 0.0001f; // as Kd on the setpoint rate
+	const real32 RelaxS = 0.25f; // integrators frozen for full stick in this
+	real32 Beta;
+	idx a;
 
 	// Roll
 	C = &A[Roll];
@@ -190,6 +194,18 @@ void RegeneratePIDCoeffs(void) {
 	Alt.R.Kd = (real32) P(AltVelKd) * 0.00016f;
 	Alt.R.Max = ALT_MAX_ROC_MPS; // default
 
+	// Shaping - stick feedforward and setpoint weighting
+	Beta = (real32) P(SetpointWeight) * 0.01f;
+	for (a = Pitch; a <= Roll; a++) {
+		SetPIDShaping(&A[a].P, 1.0f, (real32) P(StickFF) * 0.01f, RelaxS);
+		SetPIDShaping(&A[a].R, Beta, (real32) P(StickFF) * ScaleRateKff,
+				RelaxS);
+	}
+	SetPIDShaping(&A[Yaw].P, 1.0f, 0.0f, 0.0f);
+	SetPIDShaping(&A[Yaw].R, Beta, (real32) P(StickFF) * ScaleRateKff, RelaxS);
+	SetPIDShaping(&Alt.P, 1.0f, 0.0f, 0.0f);
+	SetPIDShaping(&Alt.R, 1.0f, 0.0f, 0.0f);
+
 	// Camera
 	Cam.RollKp = P(RollCamKp) * 0.1f;
 	Cam.PitchKp = P(PitchCamKp) * 0.1f;
@@ -351,6 +367,24 @@ void UpdateParameters(void) {
 		CurrGyroLPFHz = P(GyroLPFHz);
 		CurrDerivativeLPFHz = P(DerivativeLPFHz);
 
+		// were Unused103-105 so boards upgraded in place may hold anything
+		if ((P(GyroOversample) < 1) || (P(GyroOversample) > MAX_GYRO_OVERSAMPLE))
+			SetP(GyroOversample, 1);
+		if (P(StickFF) > 100)
+			SetP(StickFF, 0);
+		if ((P(SetpointWeight) < 1) || (P(SetpointWeight) > 100))
+			SetP(SetpointWeight, 100);
+
+#if defined(USE_GYRO_OVERSAMPLING)
+#if defined(USE_MPU6XXX_FIFO)
+		CurrGyroOversample = 1; // the FIFO already holds every sample
+#else
+		CurrGyroOversample = P(GyroOversample);
+#endif
+		CurrGyroSampleuS = CurrPIDCycleuS / CurrGyroOversample;
+		CurrGyroSampleS = CurrGyroSampleuS * 1.0e-6f;
+#endif
+
 		DriveLPFTau = SimpleFilterCoefficient(CurrGyroLPFHz, CurrPIDCycleS);
 		ServoLPFTau = SimpleFilterCoefficient(20.0f, CurrPIDCycleS);
 
@@ -429,7 +463,7 @@ void UpdateSticksState(void) {
 		break;
 	case SticksChanging:
 		if (StickPattern == pattern) {
-			if (NowmS > mS[StickTimeout])
+			if (mSTimeout(NowmS, StickTimeout))
 				SticksState = SticksChanged;
 		} else
 			SticksState = MonitorSticks;
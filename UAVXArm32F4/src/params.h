@@ -26,6 +26,7 @@ extern const real32 OKp, OIL, IKp, IKd;
 
 void RegeneratePIDCoeffs(void);
 void UpdateParameters(void);
+void SetPIDPeriod(void);
 void UseDefaultParameters(uint8 DefaultPS);
 void DoStickProgramming(void);
 void CheckParametersInitialised(void);
@@ -207,9 +208,9 @@ enum Params { // MAX 128
 	PitchRateIntLimit, // 100
 	YawRateKi, // 101
 	YawRateIntLimit, // 102
-	Unused103, // 103
-	Unused104, // 104
-	Unused105, // 105
+	GyroOversample, // 103
+	StickFF, // 104
+	SetpointWeight, // 105
 	Unused106, // 106
 	Unused107, // 107
 	Unused108, // 108
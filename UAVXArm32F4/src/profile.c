@@ -0,0 +1,118 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+#include "UAVX.h"
+
+ProfileStruct Profile[MAX_PROBES];
+
+const char * ProfileName[MAX_PROBES] = { "Cycle", "Drives", "IMU",
+		"Estimator", "Control", "Heading", "GPS", "Altitude", "State",
+		"Navigation", "DFT", "Tasks", "Latency" };
+
+static uint8 ProfileBin(uint32 c) {
+	uint8 e;
+
+	if (c < 4)
+		return (c);
+
+	e = 31 - __CLZ(c);
+	return ((e - 1) * 4 + ((c >> (e - 2)) & 3));
+} // ProfileBin
+
+static uint32 ProfileBinUpperc(uint8 b) {
+	uint8 e;
+
+	if (b < 4)
+		return (b + 1);
+	if (b >= (PROFILE_BINS - 1)) // 8 << 29 does not fit
+		return (0xffffffff);
+
+	e = (b >> 2) + 1;
+	return ((uint32) (4 + (b & 3) + 1) << (e - 2));
+} // ProfileBinUpperc
+
+void ProfileBegin(uint8 p) {
+	Profile[p].Startc = cycleCounter();
+} // ProfileBegin
+
+void ProfileEnd(uint8 p) {
+	ProfileInterval(p, cycleCounter() - Profile[p].Startc);
+} // ProfileEnd
+
+void ProfileInterval(uint8 p, uint32 c) {
+	ProfileStruct * P;
+	uint8 b;
+	idx i;
+
+	P = &Profile[p];
+
+	if ((P->Count == 0) || (c < P->Minc))
+		P->Minc = c;
+	if (c > P->Maxc)
+		P->Maxc = c;
+	P->Sumc += c;
+	P->Count++;
+
+	b = ProfileBin(c);
+	if (P->Bin[b] == 0xffff) // halve to keep the distribution shape
+		for (i = 0; i < PROFILE_BINS; i++)
+			P->Bin[i] >>= 1;
+	P->Bin[b]++;
+
+} // ProfileInterval
+
+void ResetProfile(void) { // probes may be open
+	uint32 Startc;
+	idx p;
+
+	for (p = 0; p < MAX_PROBES; p++) {
+		Startc = Profile[p].Startc;
+		memset(&Profile[p], 0, sizeof(ProfileStruct));
+		Profile[p].Startc = Startc;
+	}
+
+} // ResetProfile
+
+uint32 ProfilePercentilec(uint8 p, uint8 Percent) {
+	ProfileStruct * P;
+	uint32 Total, Sum, Threshold;
+	idx b;
+
+	P = &Profile[p];
+
+	Total = 0;
+	for (b = 0; b < PROFILE_BINS; b++)
+		Total += P->Bin[b];
+
+	Threshold = (Total * Percent + 99) / 100;
+	Sum = 0;
+	for (b = 0; b < PROFILE_BINS; b++) {
+		Sum += P->Bin[b];
+		if ((Sum >= Threshold) && (Sum > 0))
+			return (Min(ProfileBinUpperc(b), P->Maxc));
+	}
+
+	return (P->Maxc);
+} // ProfilePercentilec
+
+uint32 ProfileTenthsuS(uint32 c) {
+	return (((uint64) c * 10) / TicksuS);
+} // ProfileTenthsuS
+
@@ -0,0 +1,66 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+#ifndef _profile_h
+#define _profile_h
+
+// Named begin/end probes timed with the DWT cycle counter. Each probe keeps
+// min/mean/max and a log-linear histogram (4 bins per octave) for percentiles.
+
+#define PROFILE_BINS	124
+#define PROFILE_PACKET_PROBES	8
+
+enum ProfileProbes {
+	ProfCycle,
+	ProfDrives,
+	ProfIMU,
+	ProfEstimator,
+	ProfControl,
+	ProfHeading,
+	ProfGPS,
+	ProfAltitude,
+	ProfStateMachine,
+	ProfNavigation,
+	ProfDFT,
+	ProfTasks,
+	ProfLatency, // sample to UpdateDrives
+	MAX_PROBES
+};
+
+typedef struct {
+	uint32 Startc;
+	uint32 Count;
+	uint32 Minc, Maxc;
+	uint64 Sumc;
+	uint16 Bin[PROFILE_BINS];
+} ProfileStruct;
+
+extern void ProfileBegin(uint8 p);
+extern void ProfileEnd(uint8 p);
+extern void ProfileInterval(uint8 p, uint32 c);
+extern void ResetProfile(void);
+extern uint32 ProfilePercentilec(uint8 p, uint8 Percent);
+extern uint32 ProfileTenthsuS(uint32 c);
+
+extern ProfileStruct Profile[];
+extern const char * ProfileName[];
+
+#endif
+
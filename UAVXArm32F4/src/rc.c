@@ -77,12 +77,20 @@ boolean RxLoopbackEnabled = false;
 uint8 CurrComboPort1Config = ComboPort1ConfigUnknown;
 uint8 CurrComboPort2Config = ComboPort2Unused;
 
+static RCWidthFrameStruct RCWidthQBuf[RC_FRAME_Q_LEN];
+static RCFrameStruct_t RCFrameQBuf[RC_FRAME_Q_LEN];
+RingStruct RCWidthQ = { 0, 0, RC_FRAME_Q_LEN - 1, sizeof(RCWidthFrameStruct),
+		(uint8 *) RCWidthQBuf, 0, 0 };
+RingStruct RCFrameQ = { 0, 0, RC_FRAME_Q_LEN - 1, sizeof(RCFrameStruct_t),
+		(uint8 *) RCFrameQBuf, 0, 0 };
+
+static RCWidthFrameStruct RCISRFrame; // being captured by the PPM ISRs
+static RCFrameStruct_t RCRxFrame; // serial frame being decoded by the main loop
+
 void RCSerialISR(uint32 TimerVal) {
 	int32 Temp;
-	uint32 NowuS;
 	int16 Width;
 
-	NowuS = uSClock();
 	Temp = RCInp[0].PrevEdge;
 	if (TimerVal < Temp)
 		Temp -= (int32) 0x0000ffff;
@@ -94,31 +102,23 @@ void RCSerialISR(uint32 TimerVal) {
 
 		Channel = 0; // Sync pulse detected - next CH is CH1
 		RCSyncWidthuS = Width;
-		RCFrameIntervaluS = NowuS - RCLastFrameuS;
-		RCLastFrameuS = NowuS;
-
-		F.RCFrameOK = true;
-		F.RCNewValues = false;
+		RCISRFrame.FrameuS = uSClock();
+		RCISRFrame.OK = true;
 	} else {
 
-		if (RCWidthOK(Width))
-			RCInp[Channel].Raw = Width;
+		if (RCWidthOK(Width) && (Channel < RC_MAX_CHANNELS))
+			RCISRFrame.Raw[Channel] = Width;
 		else {
 			// preserve old value i.e. default hold
 			incStat(RCGlitchesS);
-			F.RCFrameOK = false;
+			RCISRFrame.OK = false;
 		}
 
 		// MUST demand rock solid RC frames for autonomous functions not
 		// to be cancelled by noise-generated partially correct frames
-		if (++Channel >= DiscoveredRCChannels) {
-			F.RCNewValues = F.RCFrameOK;
-			if (F.RCNewValues)
-				SignalCount++;
-			else
-				SignalCount -= RC_GOOD_RATIO;
-			SignalCount = Limit1(SignalCount, RC_GOOD_BUCKET_MAX);
-			F.Signal = SignalCount > 0;
+		if (++Channel == DiscoveredRCChannels) {
+			RCISRFrame.Channels = Channel;
+			ringPut(&RCWidthQ, &RCISRFrame);
 		}
 	}
 
@@ -132,7 +132,6 @@ void RCParallelISR(TIM_TypeDef *tim) {
 	int32 Width;
 	RCInpDefStruct_t * RCPtr;
 	TIMChannelDef * u;
-	uint32 NowuS;
 
 	// scan ALL RC inputs as the channel pulses arrive
 	// in arbitrary order depending on Rx
@@ -174,28 +173,17 @@ void RCParallelISR(TIM_TypeDef *tim) {
 							- RCPtr->RisingEdge);
 
 				if (RCWidthOK(Width)) {
-					RCPtr->Raw = Width;
+					RCISRFrame.Raw[c] = Width;
 					OKChannels++;
 				} else
 					incStat(RCGlitchesS);
 
 				if (c == 0) {
-
-					F.RCFrameOK = OKChannels == DiscoveredRCChannels;
-
-					F.RCNewValues = F.RCFrameOK;
-					if (F.RCNewValues) {
-						NowuS = uSClock();
-						RCFrameIntervaluS = NowuS - RCLastFrameuS;
-						RCLastFrameuS = NowuS;
-						SignalCount++;
-					} else
-						SignalCount -= RC_GOOD_RATIO;
-
-					SignalCount = Limit1(SignalCount, RC_GOOD_BUCKET_MAX);
+					RCISRFrame.FrameuS = uSClock();
+					RCISRFrame.OK = OKChannels == DiscoveredRCChannels;
+					RCISRFrame.Channels = MAX_RC_INPS;
+					ringPut(&RCWidthQ, &RCISRFrame);
 					OKChannels = 0;
-					F.Signal = SignalCount > 0;
-					F.RCFrameOK = false;
 				}
 				TIM_ICInitStructure.TIM_ICPolarity = TIM_ICPolarity_Rising;
 			} else {
@@ -210,35 +198,57 @@ void RCParallelISR(TIM_TypeDef *tim) {
 
 } // RCParallelISR
 
+static void CheckRCWidths(void) {
+	RCWidthFrameStruct W;
+	idx c;
+
+	while (ringGet(&RCWidthQ, &W)) {
+		F.RCFrameOK = W.OK;
+		if (W.OK) {
+			for (c = 0; c < W.Channels; c++)
+				RCInp[c].Raw = W.Raw[c];
+			RCFrameIntervaluS = W.FrameuS - RCLastFrameuS;
+			RCLastFrameuS = W.FrameuS;
+			F.RCNewValues = true;
+			SignalCount++;
+		} else
+			SignalCount -= RC_GOOD_RATIO;
+
+		SignalCount = Limit1(SignalCount, RC_GOOD_BUCKET_MAX);
+		F.Signal = SignalCount > 0;
+	}
+
+} // CheckRCWidths
+
 // Futaba SBus
 
 
 void DoSBus(void) {
 	idx i;
 
-	RCInp[0].Raw = RCFrame.u.c.c1;
-	RCInp[1].Raw = RCFrame.u.c.c2;
-	RCInp[2].Raw = RCFrame.u.c.c3; // Futaba Throttle
-	RCInp[3].Raw = RCFrame.u.c.c4;
-	RCInp[4].Raw = RCFrame.u.c.c5;
-	RCInp[5].Raw = RCFrame.u.c.c6;
-	RCInp[6].Raw = RCFrame.u.c.c7;
-	RCInp[7].Raw = RCFrame.u.c.c8;
-	RCInp[8].Raw = RCFrame.u.c.c9;
-	RCInp[9].Raw = RCFrame.u.c.c10;
-	RCInp[10].Raw = RCFrame.u.c.c11;
-	RCInp[11].Raw = RCFrame.u.c.c12;
-	RCInp[12].Raw = RCFrame.u.c.c13;
-	RCInp[13].Raw = RCFrame.u.c.c14;
-	RCInp[14].Raw = RCFrame.u.c.c15;
-	RCInp[15].Raw = RCFrame.u.c.c16;
+	RCInp[0].Raw = RCRxFrame.u.c.c1;
+	RCInp[1].Raw = RCRxFrame.u.c.c2;
+	RCInp[2].Raw = RCRxFrame.u.c.c3; // Futaba Throttle
+	RCInp[3].Raw = RCRxFrame.u.c.c4;
+	RCInp[4].Raw = RCRxFrame.u.c.c5;
+	RCInp[5].Raw = RCRxFrame.u.c.c6;
+	RCInp[6].Raw = RCRxFrame.u.c.c7;
+	RCInp[7].Raw = RCRxFrame.u.c.c8;
+	RCInp[8].Raw = RCRxFrame.u.c.c9;
+	RCInp[9].Raw = RCRxFrame.u.c.c10;
+	RCInp[10].Raw = RCRxFrame.u.c.c11;
+	RCInp[11].Raw = RCRxFrame.u.c.c12;
+	RCInp[12].Raw = RCRxFrame.u.c.c13;
+	RCInp[13].Raw = RCRxFrame.u.c.c14;
+	RCInp[14].Raw = RCRxFrame.u.c.c15;
+	RCInp[15].Raw = RCRxFrame.u.c.c16;
 
 	for (i = 0; i < 16; i++)
 		RCInp[i].Raw = (real32) RCInp[i].Raw * 0.625f + 880;
 	//RCInp[i].Raw = Limit((real32)RCInp[i].Raw * 0.625f + 880, RC_MIN_WIDTH_US, RC_MAX_WIDTH_US);
 
-	RCInp[16].Raw = RCFrame.u.b[22] & 0b0001 ? 2000 : 1000;
-	RCInp[17].Raw = RCFrame.u.b[22] & 0b0010 ? 2000 : 1000;
+	RCInp[16].Raw = RCRxFrame.u.b[22] & 0b0001 ? 2000 : 1000;
+	RCInp[17].Raw = RCRxFrame.u.b[22] & 0b0010 ? 2000 : 1000;
 
 	F.RCNewValues = true;
 
@@ -254,7 +264,7 @@ void SpektrumSBusISR(uint8 v) { // based on MultiWii
 	uint32 Interval, NowuS;
 
 	NowuS = uSClock();
-	Interval = NowuS - RCFrame.lastByteReceived; // uS clock wraps every 71 minutes - ignore
+	Interval = NowuS - RCFrame.lastByteReceived; // unsigned difference is wrap-safe
 	RCFrame.lastByteReceived = NowuS;
 
 	switch (CurrComboPort1Config) {
@@ -279,24 +289,9 @@ void SpektrumSBusISR(uint8 v) { // based on MultiWii
 				RCFrame.state = SBusWaitEnd;
 			break;
 		case SBusWaitEnd:
+			RCFrame.u.b[23] = v;
+			ringPut(&RCFrameQ, &RCFrame);
 
-			SBusFutabaValidFrame = v == SBUS_END_BYTE; // Futaba should be zero others not!
-			SBusSignalLost = (RCFrame.u.b[22] & SBUS_SIGNALLOST_MASK) != 0;
-			SBusFailsafe = (RCFrame.u.b[22] & SBUS_FAILSAFE_MASK) != 0;
-
-			F.RCFrameOK = !SBusSignalLost;
-			if (F.RCFrameOK) {
-				F.RCFrameReceived = F.Signal = true;
-				RCFrameIntervaluS = NowuS - RCLastFrameuS;
-				RCLastFrameuS = NowuS;
-				SignalCount++;
-			} else {
-				SignalCount -= RC_GOOD_RATIO;
-				incStat(RCGlitchesS);
-			}
-
-			SignalCount = Limit1(SignalCount, RC_GOOD_BUCKET_MAX);
-			F.Signal = SignalCount > 0;
 			RCFrame.index = 0;
 			RCFrame.state = SBusWaitSentinel;
 
@@ -312,11 +307,10 @@ void SpektrumSBusISR(uint8 v) { // based on MultiWii
 			RCFrame.index = 0;
 		}
 
-		RCFrame.u.b[RCFrame.index++] = v;
-		if (RCFrame.index >= SPEK_FRAME_SIZE) {
-			RCFrameIntervaluS = NowuS - RCLastFrameuS;
-			RCLastFrameuS = NowuS;
-			F.RCFrameReceived = F.Signal = true;
+		if (RCFrame.index < SPEK_FRAME_SIZE) {
+			RCFrame.u.b[RCFrame.index++] = v;
+			if (RCFrame.index == SPEK_FRAME_SIZE)
+				ringPut(&RCFrameQ, &RCFrame);
 		}
 		break;
 	default:
@@ -334,9 +328,9 @@ boolean CheckDeltang(void) {
 	if (CurrComboPort1Config == Deltang1024_M7to10) {
 		CheckSum = 0;
 		for (i = 1; i < 16; i++)
-			CheckSum += RCFrame.u.b[i];
+			CheckSum += RCRxFrame.u.b[i];
 
-		OK &= (RCFrame.u.b[0] == CheckSum) && ((RCFrame.u.b[1] & 0x80) != 0);
+		OK &= (RCRxFrame.u.b[0] == CheckSum) && ((RCRxFrame.u.b[1] & 0x80) != 0);
 	}
 
 	return (OK);
@@ -347,35 +341,53 @@ void CheckSpektrumSBus(void) {
 	uint8 i;
 	uint16 v;
 
-	if (F.RCFrameReceived) {
-		F.RCFrameReceived = false;
+	while (ringGet(&RCFrameQ, &RCRxFrame)) {
 		switch (CurrComboPort1Config) {
 		case FutabaSBus_M7to10:
-			DoSBus();
+			SBusFutabaValidFrame = RCRxFrame.u.b[23] == SBUS_END_BYTE; // Futaba should be zero others not!
+			SBusSignalLost = (RCRxFrame.u.b[22] & SBUS_SIGNALLOST_MASK) != 0;
+			SBusFailsafe = (RCRxFrame.u.b[22] & SBUS_FAILSAFE_MASK) != 0;
+
+			F.RCFrameOK = !SBusSignalLost;
+			if (F.RCFrameOK) {
+				RCFrameIntervaluS = RCRxFrame.lastByteReceived - RCLastFrameuS;
+				RCLastFrameuS = RCRxFrame.lastByteReceived;
+				SignalCount++;
+				DoSBus();
+			} else {
+				SignalCount -= RC_GOOD_RATIO;
+				incStat(RCGlitchesS);
+			}
+
+			SignalCount = Limit1(SignalCount, RC_GOOD_BUCKET_MAX);
+			F.Signal = SignalCount > 0;
 			break;
 		case Deltang1024_M7to10:
 		case Spektrum1024_M7to10:
 		case Spektrum2048_M7to10:
 		case BadDM9_M7to10:
+			RCFrameIntervaluS = RCRxFrame.lastByteReceived - RCLastFrameuS;
+			RCLastFrameuS = RCRxFrame.lastByteReceived;
+			F.Signal = true;
 
 			for (i = 2; i < SPEK_FRAME_SIZE; i += 2)
-				if ((RCFrame.u.b[i] & RCFrame.u.b[i + 1]) != 0xff) {
+				if ((RCRxFrame.u.b[i] & RCRxFrame.u.b[i + 1]) != 0xff) {
 
-					SpekFrameNo = (i == 2) && ((RCFrame.u.b[i] >> 7) == 1);
-					Channel = (RCFrame.u.b[i] >> SpekChanShift) & 0x0f;
+					SpekFrameNo = (i == 2) && ((RCRxFrame.u.b[i] >> 7) == 1);
+					Channel = (RCRxFrame.u.b[i] >> SpekChanShift) & 0x0f;
 					if ((Channel + 1) > DiscoveredRCChannels)
 						DiscoveredRCChannels = Channel + 1;
-					v = ((uint32) (RCFrame.u.b[i] & SpekChanMask) << 8)
-							| RCFrame.u.b[i + 1];
+					v = ((uint32) (RCRxFrame.u.b[i] & SpekChanMask) << 8)
+							| RCRxFrame.u.b[i + 1];
 
 					RCInp[Channel].Raw = (v - SpekOffset) * SpekScale + 1500;
 				}
 
 			if (CurrComboPort1Config == Deltang1024_M7to10)
-				RSSIDeltang = RCFrame.u.b[1] & 0x1f;
+				RSSIDeltang = RCRxFrame.u.b[1] & 0x1f;
 			else
-				LostFrameCount = ((uint16) RCFrame.u.b[0] << 8) //TODO:???
-						| RCFrame.u.b[1];
+				LostFrameCount = ((uint16) RCRxFrame.u.b[0] << 8) //TODO:???
+						| RCRxFrame.u.b[1];
 
 			F.RCNewValues = CheckDeltang();
 
@@ -471,8 +483,8 @@ void DoSpektrumBind(void) {
 
 	InitSerialPort(RCSerial, true);
 
-	while (!F.RCFrameReceived)
-		CheckSpektrumSBus();
+	while (!ringAvailable(&RCFrameQ)) { // first frame is decoded by CheckRC
+	};
 
 } // DoSpektrumBind
 
@@ -578,6 +590,8 @@ void InitRC(void) {
 	DesiredThrottle = StickThrottle = 0.0f;
 
 	Channel = 0;
+	ringFlush(&RCWidthQ);
+	ringFlush(&RCFrameQ);
 	setStat(RCGlitchesS, 0);
 	SignalCount = -RC_GOOD_BUCKET_MAX;
 	F.Signal = F.RCNewValues = false;
@@ -604,9 +618,8 @@ void CheckRC(void) {
 
 	switch (CurrComboPort1Config) {
 	case CPPM_GPS_M7to10:
-		break;
 	case ParallelPPM:
-		// nothing to do
+		CheckRCWidths();
 		break;
 	case Deltang1024_M7to10:
 	case Spektrum1024_M7to10:
@@ -620,7 +633,7 @@ void CheckRC(void) {
 		break;
 	} // switch
 
-	if (uSClock() > (RCLastFrameuS + RC_SIGNAL_TIMEOUT_US)) {
+	if (!TimeReached(RCLastFrameuS + RC_SIGNAL_TIMEOUT_US, uSClock())) {
 		F.Signal = false;
 		SignalCount = -RC_GOOD_BUCKET_MAX;
 	}
@@ -670,10 +683,10 @@ void SBusLoopback(void) {
 		Primed = true;
 	}
 
-	if (uSClock() > NextUpdateuS) {
+	if (TimeReached(uSClock(), NextUpdateuS)) {
 		NextUpdateuS = NextUpdateuS + 14000;
 
-		if (mSClock() > NextWigglemS) {
+		if (!TimeReached(NextWigglemS, mSClock())) {
 			NextWigglemS = mSClock() + 200;
 			TestFrame.u.c.c3 = SBusInsert(1000 + Wiggle);
 			Wiggle += 10;
@@ -725,10 +738,10 @@ void SpekLoopback(boolean HiRes) {
 
 	uint32 NowuS = uSClock();
 
-	if (NowuS > NextUpdateuS) {
+	if (TimeReached(NowuS, NextUpdateuS)) {
 		if (TicTac) {
 
-			if (mSClock() > NextWigglemS) {
+			if (!TimeReached(NextWigglemS, mSClock())) {
 				NextWigglemS = mSClock() + 500;
 				LBFrame[1] = Wiggle;
 				Wiggle += 10;
@@ -863,7 +876,7 @@ void CheckThrottleMoved(void) {
 	uint32 NowmS;
 
 	NowmS = mSClock();
-	if (NowmS < mS[ThrottleUpdate])
+	if (!mSTimeout(NowmS, ThrottleUpdate))
 		ThrNeutral = DesiredThrottle;
 	else {
 		ThrLow = ThrNeutral - THR_MIDDLE_WINDOW_STICK;
@@ -145,7 +145,19 @@ void CheckThrottleMoved(void);
 void ReceiverTest(uint8 s);
 void UpdateRCMap(void);
 
-// ISR
+// ISR - complete frames are handed to the main loop through rings, widths for CPPM and
+// parallel PPM and raw bytes for Spektrum and SBus
+
+#define RC_FRAME_Q_LEN 4 // power of 2
+
+typedef struct {
+	uint32 FrameuS;
+	boolean OK;
+	uint8 Channels;
+	int16 Raw[RC_MAX_CHANNELS];
+} RCWidthFrameStruct;
+
+extern RingStruct RCWidthQ, RCFrameQ;
 
 void RCSerialISR(uint32 Now);
 void RCParallelISR(TIM_TypeDef *tim);
@@ -0,0 +1,127 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+#include "UAVX.h"
+
+// The index accesses are the only synchronisation. On the Cortex-M4 the acquire and release
+// forms compile to the load or store and a DMB which also orders them against DMA.
+
+#define ringLoad(p)			__atomic_load_n(p, __ATOMIC_ACQUIRE)
+#define ringStore(p, v)		__atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+void ringInit(RingStruct * R, void * Buf, uint16 Entries, uint16 Size) {
+
+	R->Buf = (uint8 *) Buf;
+	R->Mask = Entries - 1; // must be a power of 2
+	R->Size = Size;
+	R->Head = R->Tail = 0;
+	R->Overruns = 0;
+	R->MaxUsed = 0;
+
+} // ringInit
+
+void ringFlush(RingStruct * R) { // consumer
+
+	ringStore(&R->Head, ringLoad(&R->Tail));
+
+} // ringFlush
+
+static boolean ringReserve(RingStruct * R, uint16 t) {
+	uint16 Used;
+
+	Used = (t - ringLoad(&R->Head)) & R->Mask;
+	if (Used == R->Mask) {
+		R->Overruns++;
+		return (false);
+	}
+	if (Used >= R->MaxUsed)
+		R->MaxUsed = Used + 1;
+
+	return (true);
+} // ringReserve
+
+boolean ringPut(RingStruct * R, const void * v) { // producer
+	uint16 t;
+
+	t = R->Tail;
+	if (!ringReserve(R, t))
+		return (false);
+
+	memcpy(&R->Buf[t * R->Size], v, R->Size);
+	ringStore(&R->Tail, (t + 1) & R->Mask);
+
+	return (true);
+} // ringPut
+
+boolean ringPutByte(RingStruct * R, uint8 v) { // producer, Size 1
+	uint16 t;
+
+	t = R->Tail;
+	if (!ringReserve(R, t))
+		return (false);
+
+	R->Buf[t] = v;
+	ringStore(&R->Tail, (t + 1) & R->Mask);
+
+	return (true);
+} // ringPutByte
+
+void ringPublish(RingStruct * R, uint16 Tail) { // for a producer that cannot, DMA
+
+	ringStore(&R->Tail, Tail & R->Mask);
+
+} // ringPublish
+
+boolean ringGet(RingStruct * R, void * v) { // consumer
+	uint16 h;
+
+	h = R->Head;
+	if (h == ringLoad(&R->Tail))
+		return (false);
+
+	memcpy(v, &R->Buf[h * R->Size], R->Size);
+	ringStore(&R->Head, (h + 1) & R->Mask);
+
+	return (true);
+} // ringGet
+
+uint8 ringGetByte(RingStruct * R) { // consumer, Size 1 and ringAvailable
+	uint16 h;
+	uint8 v;
+
+	h = R->Head;
+	v = R->Buf[h];
+	ringStore(&R->Head, (h + 1) & R->Mask);
+
+	return (v);
+} // ringGetByte
+
+uint16 ringUsed(RingStruct * R) {
+
+	return ((ringLoad(&R->Tail) - ringLoad(&R->Head)) & R->Mask);
+
+} // ringUsed
+
+boolean ringAvailable(RingStruct * R) { // consumer
+
+	return (R->Head != ringLoad(&R->Tail));
+
+} // ringAvailable
+
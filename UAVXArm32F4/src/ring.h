@@ -0,0 +1,51 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+
+#ifndef _ring_h
+#define _ring_h
+
+// Single producer/single consumer ring. Tail is only written by the producer and Head only by
+// the consumer so neither side needs interrupts masked. An entry is copied in before Tail is
+// published (release) and Tail is read before the entry is copied out (acquire). A full ring
+// drops the new entry and counts an overrun.
+
+typedef struct {
+	uint16 Head; // next entry to be read - consumer
+	uint16 Tail; // next free entry - producer
+	uint16 Mask; // entries - 1, a power of 2
+	uint16 Size; // bytes per entry
+	uint8 * Buf;
+	uint32 Overruns; // producer
+	uint16 MaxUsed; // producer
+} RingStruct;
+
+void ringInit(RingStruct * R, void * Buf, uint16 Entries, uint16 Size);
+void ringFlush(RingStruct * R);
+boolean ringPut(RingStruct * R, const void * v);
+boolean ringGet(RingStruct * R, void * v);
+boolean ringPutByte(RingStruct * R, uint8 v);
+uint8 ringGetByte(RingStruct * R);
+void ringPublish(RingStruct * R, uint16 Tail);
+uint16 ringUsed(RingStruct * R);
+boolean ringAvailable(RingStruct * R);
+
+#endif
+
@@ -0,0 +1,135 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+#include "UAVX.h"
+
+const uint32 RateGroupPerioduS[MAX_RATE_GROUPS] = { 10000, 20000, 100000,
+		200000, 500000 };
+
+void CheckTelemetryTask(void) {
+	CheckTelemetry(TelemetrySerial);
+} // CheckTelemetryTask
+
+TaskStruct Tasks[MAX_TASKS] = { //
+		{ CheckAlarms, RG50Hz, 20, }, //
+				{ CheckBatteries, RG5Hz, 40, }, //
+				{ CheckTelemetryTask, RG100Hz, 400, }, //
+				{ DoCalibrationAlarm, RG2Hz, 20, }, //
+				{ UpdatewsLed, RG10Hz, 60, }, //
+				{ RunJobs, RG100Hz, 300, }, //
+		};
+
+uint32 CycleLateuS = 0;
+uint32 MaxCycleLateuS = 0;
+uint32 CycleOverruns = 0;
+static boolean CulpritFound = false;
+static boolean CycleSlot = false;
+
+void InitScheduler(void) {
+	uint32 NowuS;
+	idx t;
+
+	NowuS = uSClock();
+	for (t = 0; t < MAX_TASKS; t++) {
+		Tasks[t].ReleaseuS = NowuS;
+		Tasks[t].Runs = Tasks[t].DeadlineMisses = Tasks[t].BudgetOverruns
+				= Tasks[t].CycleOverruns = 0;
+		Tasks[t].LastuS = Tasks[t].MaxuS = Tasks[t].TotaluS = 0;
+	}
+
+	CycleLateuS = MaxCycleLateuS = CycleOverruns = 0;
+	CulpritFound = CycleSlot = false;
+
+} // InitScheduler
+
+void SchedulerCycleStart(uint32 DueuS, uint32 NowuS) {
+
+	CycleLateuS = NowuS - DueuS;
+	if (CycleLateuS > MaxCycleLateuS)
+		MaxCycleLateuS = CycleLateuS;
+
+	if (CycleLateuS > SCHED_LATE_US) {
+		CycleOverruns++;
+		incStat(SchedOverrunsS);
+		if (!CulpritFound)
+			setStat(SchedCulpritS, SCHED_FOREGROUND);
+	}
+
+	CulpritFound = false;
+	CycleSlot = true;
+
+} // SchedulerCycleStart
+
+void RunTasks(void) {
+	uint32 NowuS, SlackuS, StartuS, PerioduS, DueuS;
+	TaskStruct * t;
+	boolean Late;
+	idx i, Next;
+
+	NowuS = uSClock();
+	DueuS = uS[NextCycleUpdate];
+	SlackuS = TimeReached(NowuS, DueuS) ? 0 : DueuS - NowuS;
+
+	Next = MAX_TASKS;
+	for (i = 0; (i < MAX_TASKS) && (Next == MAX_TASKS); i++) {
+		t = &Tasks[i];
+		if (TimeReached(NowuS, t->ReleaseuS)) {
+			Late = TimeReached(NowuS, t->ReleaseuS + RateGroupPerioduS[t->Group]);
+			if ((t->BudgetuS <= SlackuS) || (Late && CycleSlot))
+				Next = i;
+		}
+	}
+	CycleSlot = false;
+
+	if (Next < MAX_TASKS) {
+		t = &Tasks[Next];
+		PerioduS = RateGroupPerioduS[t->Group];
+
+		if (TimeReached(NowuS, t->ReleaseuS + PerioduS))
+			t->DeadlineMisses++;
+
+		t->ReleaseuS += PerioduS;
+		if (TimeReached(NowuS, t->ReleaseuS)) // skip missed releases
+			t->ReleaseuS = NowuS + PerioduS;
+
+		ProfileBegin(ProfTasks);
+		StartuS = uSClock();
+		t->Run();
+		NowuS = uSClock();
+		ProfileEnd(ProfTasks);
+
+		t->LastuS = NowuS - StartuS;
+		t->TotaluS += t->LastuS;
+		if (t->LastuS > t->MaxuS)
+			t->MaxuS = t->LastuS;
+		if (t->LastuS > t->BudgetuS)
+			t->BudgetOverruns++;
+		t->Runs++;
+
+		if (!TimeReached(StartuS, DueuS) && !TimeReached(DueuS + SCHED_LATE_US,
+				NowuS)) {
+			t->CycleOverruns++;
+			setStat(SchedCulpritS, Next + 1);
+			CulpritFound = true;
+		}
+	}
+
+} // RunTasks
+
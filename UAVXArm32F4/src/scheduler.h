@@ -0,0 +1,65 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+#ifndef _scheduler_h
+#define _scheduler_h
+
+// Housekeeping tasks run in the slack between flight control cycles. A task is only
+// started if its CPU budget fits before the next cycle is due. Tasks that have missed
+// their deadline may start straight after a cycle, when the slack is greatest, so none
+// are starved. Any task still running when a cycle falls due is recorded as the culprit.
+
+#define SCHED_LATE_US	50 // cycle start jitter tolerated before it counts as an overrun
+#define SCHED_FOREGROUND	0 // culprit when the control cycle or Rx polling is itself late
+
+enum RateGroups {
+	RG100Hz, RG50Hz, RG10Hz, RG5Hz, RG2Hz, MAX_RATE_GROUPS
+};
+
+enum TaskIDs { // in priority order
+	AlarmsTask,
+	BatteryTask,
+	TelemetryTask,
+	CalibrationAlarmTask,
+	wsLEDTask,
+	JobsTask,
+	MAX_TASKS
+};
+
+typedef struct {
+	void (*Run)(void);
+	uint8 Group;
+	uint16 BudgetuS;
+	// run time
+	uint32 ReleaseuS;
+	uint32 Runs, DeadlineMisses, BudgetOverruns, CycleOverruns;
+	uint32 LastuS, MaxuS, TotaluS;
+} TaskStruct;
+
+extern void InitScheduler(void);
+extern void SchedulerCycleStart(uint32 DueuS, uint32 NowuS);
+extern void RunTasks(void);
+
+extern TaskStruct Tasks[];
+extern const uint32 RateGroupPerioduS[];
+extern uint32 CycleLateuS, MaxCycleLateuS, CycleOverruns;
+
+#endif
+
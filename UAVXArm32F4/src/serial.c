@@ -32,9 +32,7 @@ volatile int16 TxQHead[MAX_SERIAL_PORTS];
 volatile int16 TxQNewHead[MAX_SERIAL_PORTS];
 
 volatile uint8 RxQ[MAX_SERIAL_PORTS][SERIAL_BUFFER_SIZE] __attribute__((aligned(4)));
-volatile int16 RxQTail[MAX_SERIAL_PORTS];
-volatile int16 RxQHead[MAX_SERIAL_PORTS];
-volatile int16 RxQNewHead[MAX_SERIAL_PORTS];
+RingStruct RxRing[MAX_SERIAL_PORTS]; // over RxQ, filled by serialISR or the Rx DMA
 volatile boolean RxEnabled[MAX_SERIAL_PORTS];
 
 uint8 TxCheckSum[MAX_SERIAL_PORTS];
@@ -75,11 +73,11 @@ boolean serialAvailable(uint8 s) {
 		//	break;
 	default:
 		if (SerialPorts[s].DMAUsed) {
-			RxQTail[s] = SERIAL_BUFFER_SIZE - DMA_GetCurrDataCounter(
-					SerialPorts[s].RxDMAStream);
-			r = RxQHead[s] != RxQTail[s];
+			ringPublish(&RxRing[s], SERIAL_BUFFER_SIZE - DMA_GetCurrDataCounter(
+					SerialPorts[s].RxDMAStream));
+			r = ringAvailable(&RxRing[s]);
 		} else if (SerialPorts[s].InterruptsUsed)
-			r = RxQTail[s] != RxQHead[s];
+			r = ringAvailable(&RxRing[s]);
 		else
 			r = (USART_GetFlagStatus(SerialPorts[s].USART, USART_FLAG_RXNE)
 					== SET);
@@ -100,10 +98,9 @@ uint8 RxChar(uint8 s) {
 		//	TM_USB_VCP_Getc(&ch);
 		//	break;
 	default:
-		if (SerialPorts[s].DMAUsed || SerialPorts[s].InterruptsUsed) {
-			ch = RxQ[s][RxQHead[s]];
-			RxQHead[s] = (RxQHead[s] + 1) & (SERIAL_BUFFER_SIZE - 1);
-		} else
+		if (SerialPorts[s].DMAUsed || SerialPorts[s].InterruptsUsed)
+			ch = ringGetByte(&RxRing[s]);
+		else
 			ch = USART_ReceiveData(SerialPorts[s].USART);
 		break;
 	}// switch
@@ -189,13 +186,8 @@ void serialISR(uint8 s) {
 		if (RxEnabled[s]) {
 			if ((s == RCSerial) && RxUsingSerial)
 				SpektrumSBusISR(ch);
-			else {
-				RxQ[s][RxQTail[s]] = ch;
-				RxQTail[s] = (RxQTail[s] + 1) & (SERIAL_BUFFER_SIZE - 1);
-				if (RxQTail[s] == RxQHead[s]) { // full
-					//USART_ITConfig(SerialPorts[s].USART, USART_IT_RXNE, DISABLE);
-				}
-			}
+			else
+				ringPutByte(&RxRing[s], ch); // dropped and counted if full
 		}
 	}
 
@@ -35,9 +35,7 @@ extern volatile int16 TxQHead[];
 extern volatile int16 TxQNewHead[];
 
 extern volatile uint8 RxQ[][SERIAL_BUFFER_SIZE];
-extern volatile int16 RxQTail[];
-extern volatile int16 RxQHead[];
-extern volatile int16 RxQNewHead[];
+extern RingStruct RxRing[];
 extern volatile boolean RxEnabled[];
 
 extern uint8 TxCheckSum[];
@@ -37,6 +37,41 @@ boolean sioWriteBlock(uint8 sioDev, uint8 id, uint8 reg, uint8 len, uint8 * data
 
 } // sioWriteBlock
 
+// Queued transfers call Done on completion, which may be from an ISR. SPI devices without
+// DMA transactions fall back to a blocking transfer and call Done before returning.
+
+boolean sioQueueRead(uint8 sioDev, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, sioDoneFn Done) {
+	boolean r;
+
+	if (spiDevUsed[sioDev]) {
+		if (spiDMAEnabled)
+			return (spiQueueRead(sioDev, reg, len, data, Done));
+		r = spiReadBlock(sioDev, id, reg, len, data);
+		if (Done)
+			Done(r);
+		return (true);
+	} else
+		return (i2cQueueRead(sioDev, id, reg, len, data, Done));
+
+} // sioQueueRead
+
+boolean sioQueueWrite(uint8 sioDev, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, sioDoneFn Done) {
+	boolean r;
+
+	if (spiDevUsed[sioDev]) {
+		if (spiDMAEnabled)
+			return (spiQueueWrite(sioDev, reg, len, data, Done));
+		r = spiWriteBlock(sioDev, id, reg, len, data);
+		if (Done)
+			Done(r);
+		return (true);
+	} else
+		return (i2cQueueWrite(sioDev, id, reg, len, data, Done));
+
+} // sioQueueWrite
+
 
 // derivative
 
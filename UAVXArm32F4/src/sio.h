@@ -27,6 +27,13 @@ extern boolean sioReadBlock(uint8 sioDev, uint8 id, uint8 reg, uint8 len,
 extern boolean sioWriteBlock(uint8 sioDev, uint8 id, uint8 reg, uint8 len,
 		uint8 * data);
 
+typedef void (*sioDoneFn)(boolean ok);
+
+extern boolean sioQueueRead(uint8 sioDev, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, sioDoneFn Done);
+extern boolean sioQueueWrite(uint8 sioDev, uint8 id, uint8 reg, uint8 len,
+		uint8 * data, sioDoneFn Done);
+
 extern uint8 sioRead(uint8 sioDev, uint8 id, uint8 reg);
 extern uint8 sioReadataddr(uint8 sioDev, uint8 id, uint8 reg);
 extern boolean sioReadBlockataddr(uint8 sioDev, uint8 id, uint8 reg, uint8 len,
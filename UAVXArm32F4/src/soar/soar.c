@@ -105,7 +105,7 @@ boolean SuppressThrottle(void) {
 } // SuppressThrottle
 
 boolean CommenceThermalling(void) {
-	return (mSClock() > mS[CruiseTimeout]) && (VarioFilt > THERMAL_MIN_MPS)
+	return mSTimeout(mSClock(), CruiseTimeout) && (VarioFilt > THERMAL_MIN_MPS)
 			&& InAltitudeBand();
 	//&& (StickThrottle <= IdleThrottle); // zzz
 } // CommenceThermalling
@@ -113,7 +113,7 @@ boolean CommenceThermalling(void) {
 
 boolean ResumeGlide(void) {
 
-	return (mSClock() > mS[ThermalTimeout]) && (!InAltitudeBand()
+	return mSTimeout(mSClock(), ThermalTimeout) && (!InAltitudeBand()
 			|| !ThermalOK());
 
 } // ResumeGlide
@@ -0,0 +1,265 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU 
+//    General Public License as published by the Free Software Foundation, either version 3 of the 
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.  
+//    If not, see http://www.gnu.org/licenses/
+
+// Gyro vibration spectrum and dynamic notches. The gyros are sampled into a rolling window at
+// the control rate and each axis in turn is Hann windowed and transformed, one axis per cycle
+// every GYRO_SPECTRUM_HOP samples. The strongest peaks above GYRO_NOTCH_MIN_HZ, normally
+// motor and prop noise, steer biquad notches applied to the gyros ahead of the rate loop.
+
+#include "UAVX.h"
+
+#define M	(GYRO_SPECTRUM_N/2) // complex transform length
+
+GyroNotchStruct GyroNotch[3];
+BiquadBankStruct GyroNotchBank[GYRO_NOTCHES]; // notch n of each axis, inactive lanes pass through
+real32 GyroSpectrum[3][GYRO_SPECTRUM_BINS]; // magnitude, raw gyro units
+uint32 GyroSpectrumAnalyses = 0;
+
+static real32 Window[GYRO_SPECTRUM_N];
+static real32 TwCos[M], TwSin[M]; // exp(-j 2 PI k / N)
+static uint8 BitRev[M];
+static real32 Samples[3][GYRO_SPECTRUM_N];
+static idx SampleHead, SamplesTaken, HopPhase;
+static real32 Re[M], Im[M];
+
+static void FFT(void) { // radix 2 in place over Re, Im
+	real32 tr, ti, wr, wi;
+	idx i, j, Len, Half, Step;
+
+	for (i = 0; i < M; i++) {
+		j = BitRev[i];
+		if (j > i) {
+			tr = Re[i];
+			Re[i] = Re[j];
+			Re[j] = tr;
+			ti = Im[i];
+			Im[i] = Im[j];
+			Im[j] = ti;
+		}
+	}
+
+	for (Len = 2; Len <= M; Len <<= 1) {
+		Half = Len >> 1;
+		Step = GYRO_SPECTRUM_N / Len;
+		for (i = 0; i < M; i += Len)
+			for (j = 0; j < Half; j++) {
+				wr = TwCos[j * Step];
+				wi = TwSin[j * Step];
+				tr = wr * Re[i + j + Half] - wi * Im[i + j + Half];
+				ti = wr * Im[i + j + Half] + wi * Re[i + j + Half];
+				Re[i + j + Half] = Re[i + j] - tr;
+				Im[i + j + Half] = Im[i + j] - ti;
+				Re[i + j] += tr;
+				Im[i + j] += ti;
+			}
+	}
+
+} // FFT
+
+static void Transform(idx a) { // real N point transform as an N/2 point complex one
+	const real32 Scale = 2.0f / GYRO_SPECTRUM_N; // Hann coherent gain 0.5
+	real32 er, ei, odr, odi, xr, xi;
+	idx i, k, s;
+
+	s = SampleHead; // oldest
+	for (i = 0; i < M; i++) {
+		Re[i] = Samples[a][s] * Window[2 * i];
+		s = (s + 1) & (GYRO_SPECTRUM_N - 1);
+		Im[i] = Samples[a][s] * Window[2 * i + 1];
+		s = (s + 1) & (GYRO_SPECTRUM_N - 1);
+	}
+
+	FFT();
+
+	GyroSpectrum[a][0] = fabsf(Re[0] + Im[0]) * Scale * 0.5f;
+	GyroSpectrum[a][M] = fabsf(Re[0] - Im[0]) * Scale * 0.5f;
+	for (k = 1; k < M; k++) {
+		er = 0.5f * (Re[k] + Re[M - k]);
+		ei = 0.5f * (Im[k] - Im[M - k]);
+		odr = 0.5f * (Im[k] + Im[M - k]);
+		odi = -0.5f * (Re[k] - Re[M - k]);
+		xr = er + TwCos[k] * odr - TwSin[k] * odi;
+		xi = ei + TwCos[k] * odi + TwSin[k] * odr;
+		GyroSpectrum[a][k] = sqrtf(Sqr(xr) + Sqr(xi)) * Scale;
+	}
+
+} // Transform
+
+static idx FindPeaks(idx a, idx kMin, real32 * PeakHz, real32 BinHz) {
+	real32 * S = GyroSpectrum[a];
+	real32 Mean, Floor, m, d;
+	idx k, p, n, Best;
+	boolean Taken[GYRO_SPECTRUM_BINS];
+
+	Mean = 0.0f;
+	for (k = kMin; k < M; k++) {
+		Mean += S[k];
+		Taken[k] = false;
+	}
+	Mean /= (M - kMin);
+	Floor = Max(Mean * GYRO_NOTCH_SNR, DegreesToRadians(GYRO_NOTCH_MIN_AMP_DPS)
+			/ GyroScale[CurrAttSensorType]);
+
+	n = 0;
+	for (p = 0; p < GYRO_NOTCHES; p++) {
+		Best = 0;
+		for (k = kMin; k < M; k++)
+			if (!Taken[k] && (S[k] > Floor) && (S[k] > S[k - 1]) && (S[k]
+					>= S[k + 1]) && ((Best == 0) || (S[k] > S[Best])))
+				Best = k;
+		if (Best == 0)
+			break;
+
+		for (k = Max(kMin, Best - 2); k <= Min(M - 1, Best + 2); k++)
+			Taken[k] = true;
+
+		m = S[Best - 1] - 2.0f * S[Best] + S[Best + 1]; // parabolic interpolation
+		d = (m < 0.0f) ? Limit(0.5f * (S[Best - 1] - S[Best + 1]) / m, -0.5f, 0.5f)
+				: 0.0f;
+		PeakHz[n++] = (Best + d) * BinHz;
+	}
+
+	if (n > 0) {
+		GyroNotch[a].PeakHz = PeakHz[0];
+		GyroNotch[a].PeakAmp = S[(idx) (PeakHz[0] / BinHz + 0.5f)];
+	} else
+		GyroNotch[a].PeakAmp = 0.0f;
+
+	return (n);
+} // FindPeaks
+
+static void SteerNotches(idx a) {
+	GyroNotchStruct * N = &GyroNotch[a];
+	real32 PeakHz[GYRO_NOTCHES];
+	real32 BinHz, MaxHz, Hz, e, BestE;
+	BiquadStruct C;
+	boolean Assigned[GYRO_NOTCHES];
+	idx n, p, Peaks, Best, kMin;
+
+	BinHz = 1.0f / (GYRO_SPECTRUM_N * CurrPIDCycleS);
+	MaxHz = 0.45f / CurrPIDCycleS;
+	kMin = Max(1, (idx) (GYRO_NOTCH_MIN_HZ / BinHz + 0.5f));
+
+	Transform(a);
+
+#if defined(INC_DFT)
+	if (a == X) // bands of the pitch gyro spectrum for telemetry
+		for (n = 0; n < 8; n++) {
+			DFT[n] = 0.0f;
+			for (p = n * (M / 8); p < (n + 1) * (M / 8); p++)
+				DFT[n] = Max(DFT[n], GyroSpectrum[X][p]);
+		}
+#endif
+
+	Peaks = FindPeaks(a, kMin, PeakHz, BinHz);
+
+	for (n = 0; n < GYRO_NOTCHES; n++)
+		Assigned[n] = false;
+
+	for (p = 0; p < Peaks; p++) { // strongest first, to the nearest tracking notch
+		Best = GYRO_NOTCHES;
+		BestE = 3.0f * BinHz;
+		for (n = 0; n < GYRO_NOTCHES; n++)
+			if (!Assigned[n] && N->Active[n]) {
+				e = fabsf(N->CentreHz[n] - PeakHz[p]);
+				if (e < BestE) {
+					BestE = e;
+					Best = n;
+				}
+			}
+		for (n = 0; (Best == GYRO_NOTCHES) && (n < GYRO_NOTCHES); n++)
+			if (!Assigned[n] && !N->Active[n])
+				Best = n;
+		if (Best == GYRO_NOTCHES) { // all tracking, move the nearest
+			BestE = MaxHz;
+			for (n = 0; n < GYRO_NOTCHES; n++)
+				if (!Assigned[n] && ((e = fabsf(N->CentreHz[n] - PeakHz[p]))
+						< BestE)) {
+					BestE = e;
+					Best = n;
+				}
+		}
+		if (Best == GYRO_NOTCHES)
+			continue;
+
+		Assigned[Best] = true;
+		Hz = Limit(PeakHz[p], GYRO_NOTCH_MIN_HZ, MaxHz);
+		if (N->Active[Best])
+			N->CentreHz[Best] += GYRO_NOTCH_TRACK * (Hz - N->CentreHz[Best]);
+		else
+			N->CentreHz[Best] = Hz;
+		SetNotch(&C, N->CentreHz[Best], GYRO_NOTCH_Q, CurrPIDCycleS);
+		SetBiquadBankLane(&GyroNotchBank[Best], a, &C);
+		if (!N->Active[Best]) {
+			PrimeBiquadBankLane(&GyroNotchBank[Best], a, Samples[a][(SampleHead
+					- 1) & (GYRO_SPECTRUM_N - 1)]);
+			N->Active[Best] = true;
+		}
+	}
+
+	GyroSpectrumAnalyses++;
+
+} // SteerNotches
+
+void UpdateGyroNotches(real32 * g) {
+	idx a, n;
+
+	for (a = X; a <= Z; a++)
+		Samples[a][SampleHead] = g[a];
+	SampleHead = (SampleHead + 1) & (GYRO_SPECTRUM_N - 1);
+
+	if (SamplesTaken < GYRO_SPECTRUM_N)
+		SamplesTaken++;
+	else if (HopPhase <= Z) {
+		ProfileBegin(ProfDFT);
+		SteerNotches(HopPhase);
+		ProfileEnd(ProfDFT);
+	}
+	if (++HopPhase >= GYRO_SPECTRUM_HOP)
+		HopPhase = 0;
+
+	for (n = 0; n < GYRO_NOTCHES; n++)
+		BiquadBank(&GyroNotchBank[n], g);
+
+} // UpdateGyroNotches
+
+void InitGyroSpectrum(void) {
+	idx i, j, r;
+
+	for (i = 0; i < GYRO_SPECTRUM_N; i++)
+		Window[i] = 0.5f - 0.5f * cosf(TWO_PI * i / GYRO_SPECTRUM_N);
+
+	for (i = 0; i < M; i++) {
+		TwCos[i] = cosf(TWO_PI * i / GYRO_SPECTRUM_N);
+		TwSin[i] = -sinf(TWO_PI * i / GYRO_SPECTRUM_N);
+		r = 0;
+		for (j = 1; j < M; j <<= 1)
+			r = (r << 1) | ((i & j) ? 1 : 0);
+		BitRev[i] = r;
+	}
+
+	memset(GyroNotch, 0, sizeof(GyroNotch));
+	for (i = 0; i < GYRO_NOTCHES; i++)
+		InitBiquadBank(&GyroNotchBank[i]);
+	memset(GyroSpectrum, 0, sizeof(GyroSpectrum));
+	SampleHead = SamplesTaken = HopPhase = 0;
+
+} // InitGyroSpectrum
+
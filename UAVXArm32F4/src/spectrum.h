@@ -0,0 +1,50 @@
+// ===============================================================================================
+// =                                UAVX Quadrocopter Controller                                 =
+// =                           Copyright (c) 2008 by Prof. Greg Egan                             =
+// =                 Original V3.15 Copyright (c) 2007 Ing. Wolfgang Mahringer                   =
+// =                     http://code.google.com/p/uavp-mods/ http://uavp.ch                      =
+// ===============================================================================================
+
+//    This is part of UAVX.
+
+//    UAVX is free software: you can redistribute it and/or modify it under the terms of the GNU
+//    General Public License as published by the Free Software Foundation, either version 3 of the
+//    License, or (at your option) any later version.
+
+//    UAVX is distributed in the hope that it will be useful,but WITHOUT ANY WARRANTY; without
+//    even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+//    See the GNU General Public License for more details.
+
+//    You should have received a copy of the GNU General Public License along with this program.
+//    If not, see http://www.gnu.org/licenses/
+
+
+#ifndef _spectrum_h
+#define _spectrum_h
+
+#define GYRO_SPECTRUM_N			64 // window, a power of 2
+#define GYRO_SPECTRUM_BINS		((GYRO_SPECTRUM_N/2)+1)
+#define GYRO_SPECTRUM_HOP		8 // samples between analyses of each axis
+#define GYRO_NOTCHES			2 // per axis
+#define GYRO_NOTCH_MIN_HZ		60.0f
+#define GYRO_NOTCH_Q			3.0f
+#define GYRO_NOTCH_SNR			3.0f // peak over band mean magnitude
+#define GYRO_NOTCH_MIN_AMP_DPS	0.5f
+#define GYRO_NOTCH_TRACK		0.5f // centre frequency smoothing per analysis
+
+typedef struct {
+	real32 CentreHz[GYRO_NOTCHES];
+	boolean Active[GYRO_NOTCHES];
+	real32 PeakHz, PeakAmp; // strongest peak of the last analysis, raw units
+} GyroNotchStruct;
+
+void InitGyroSpectrum(void);
+void UpdateGyroNotches(real32 * g);
+
+extern GyroNotchStruct GyroNotch[];
+extern BiquadBankStruct GyroNotchBank[];
+extern real32 GyroSpectrum[][GYRO_SPECTRUM_BINS];
+extern uint32 GyroSpectrumAnalyses;
+
+#endif
+
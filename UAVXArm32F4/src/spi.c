@@ -22,21 +22,48 @@
 
 uint32 spiErrors = 0;
 
+boolean spiDMAEnabled = false;
+spiDMAStatsStruct spiDMAStats;
+
+spiBusStruct spiBus[MAX_SPI_PORTS];
+
+#define SPI_BR_MASK	0b0000000000111000
+
+static void spiResumeDMA(uint8 spiPort);
+
+// Returns true if the port rate had to be changed
+
+static boolean spiConfigure(SPI_TypeDef * SPIx, uint8 devSel, boolean R) {
+	uint16 devRate;
+	spiBusStruct * b;
+
+	b = &spiBus[spiMap[devSel] - 1];
+	b->ConfigDev = devSel + 1;
+
+	devRate = R ? spiDef[devSel].ReadRate : spiDef[devSel].WriteRate;
+
+	if ((SPIx->CR1 & SPI_BR_MASK) == devRate)
+		return (false);
+
+	SPI_Cmd(SPIx, DISABLE);
+	SPIx->CR1 = (SPIx->CR1 & ~SPI_BR_MASK) | devRate;
+	SPI_Cmd(SPIx, ENABLE);
+
+	b->Reconfigs++;
+	b->CycleReconfigs++;
+
+	return (true);
+} // spiConfigure
+
 SPI_TypeDef * spiSetBaudRate(uint8 devSel, boolean R) {
 	// It would be good if there was some consistency with SPI protocols!!!
 	// All of this for the HMC5983.
 
 	//static uint16 lastDevClockHigh = false;
-	uint16 devRate;
 	SPI_TypeDef * SPIx;
 
 	SPIx = SPIPorts[spiMap[devSel] - 1].SPIx;
 
-	SPI_Cmd(SPIx, DISABLE);
-
-	devRate = R ? spiDef[devSel].ReadRate : spiDef[devSel].WriteRate;
-
-	SPIx->CR1 = (SPIx->CR1 & 0b1111111111000111) | devRate;
 	/*
 	 if (spiDef[devSel].ClockHigh != lastDevClockHigh) {
 	 lastDevClockHigh = spiDef[devSel].ClockHigh;
@@ -52,9 +79,8 @@ SPI_TypeDef * spiSetBaudRate(uint8 devSel, boolean R) {
 	 Delay1uS(5); // ???? zzzz
 	 }
 	 */
-	Delay1uS(5);
-
-	SPI_Cmd(SPIx, ENABLE);
+	if (spiConfigure(SPIx, devSel, R))
+		Delay1uS(5);
 
 	return (SPIx);
 
@@ -62,15 +88,74 @@ SPI_TypeDef * spiSetBaudRate(uint8 devSel, boolean R) {
 
 
 void spiSelect(uint8 devSel, boolean Sel) {
+	spiBusStruct * b;
+
+	b = &spiBus[spiMap[devSel] - 1];
 
 	if (Sel) {
+		if ((b->Owner != 0) && (b->Owner != (devSel + 1))) {
+			b->CSConflicts++;
+			digitalWrite(&SPISelectPins[b->Owner - 1], 1);
+		}
 		Delay1uS(1);
 		digitalWrite(&SPISelectPins[devSel], 0);
-	} else
+		b->Owner = devSel + 1;
+	} else {
 		digitalWrite(&SPISelectPins[devSel], 1);
+		if (b->Owner == (devSel + 1))
+			b->Owner = 0;
+	}
 
 } // spiSelect
 
+// Queued DMA transactions go first. Time spent waiting for them is counted against the
+// port. Transactions queued while a polled transfer owns the bus start on its release.
+
+SPI_TypeDef * spiAcquire(uint8 devSel, boolean R) {
+	SPI_TypeDef * SPIx;
+	spiBusStruct * b;
+	uint32 StartuS, WaituS;
+
+	b = &spiBus[spiMap[devSel] - 1];
+
+	if (spiDMAEnabled && !spiIdle()) {
+		StartuS = uSClock();
+		spiWaitIdle();
+		WaituS = uSClock() - StartuS;
+		b->WaituS += WaituS;
+		b->CycleWaituS += WaituS;
+	}
+
+	SPIx = spiSetBaudRate(devSel, R);
+	spiSelect(devSel, true);
+	b->Acquires++;
+
+	return (SPIx);
+} // spiAcquire
+
+void spiRelease(uint8 devSel) {
+
+	spiSelect(devSel, false);
+	if (spiDMAEnabled)
+		spiResumeDMA(spiMap[devSel] - 1);
+
+} // spiRelease
+
+void spiBusCycleStart(void) {
+	spiBusStruct * b;
+	idx i;
+
+	for (i = 0; i < MAX_SPI_PORTS; i++) {
+		b = &spiBus[i];
+		if (b->CycleReconfigs > b->MaxCycleReconfigs)
+			b->MaxCycleReconfigs = b->CycleReconfigs;
+		if (b->CycleWaituS > b->MaxCycleWaituS)
+			b->MaxCycleWaituS = b->CycleWaituS;
+		b->CycleReconfigs = b->CycleWaituS = 0;
+	}
+
+} // spiBusCycleStart
+
 uint8 spiSend(SPI_TypeDef * SPIx, uint8 d) {
 
 	while (!(SPIx->SR & SPI_I2S_FLAG_TXE)) {
@@ -119,14 +204,9 @@ uint8 spiSendzzz(SPI_TypeDef * SPIx, uint8 d) {
 
 } // spiSend
 
-boolean spiReadBlock(uint8 devSel, uint8 id, uint8 d, uint8 len, uint8* data) {
-	idx i;
-	SPI_TypeDef * s;
-	uint32 r;
+static uint8 spiReadPrefix(uint8 devSel, uint8 len) {
 	uint8 Prefix;
 
-	r = spiErrors;
-
 	// KLUDGE
 
 	if (devSel == mpu60xxSel)
@@ -139,15 +219,26 @@ boolean spiReadBlock(uint8 devSel, uint8 id, uint8 d, uint8 len, uint8* data) {
 	} else
 		Prefix = 0;
 
-	s = spiSetBaudRate(devSel, true);
+	return (Prefix);
+} // spiReadPrefix
 
-	spiSelect(devSel, true);
+boolean spiReadBlock(uint8 devSel, uint8 id, uint8 d, uint8 len, uint8* data) {
+	idx i;
+	SPI_TypeDef * s;
+	uint32 r;
+	uint8 Prefix;
+
+	r = spiErrors;
+
+	Prefix = spiReadPrefix(devSel, len);
+
+	s = spiAcquire(devSel, true);
 	spiSend(s, Prefix | d); // MANY devices do not use Read if MSB set so do not OR in here
 
 	for (i = 0; i < len; i++)
 		data[i] = spiSend(s, 0);
 
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
 	return (r == spiErrors);
 
@@ -161,17 +252,312 @@ boolean spiWriteBlock(uint8 devSel, uint8 id, uint8 d, uint8 len, uint8 *data) {
 
 	r = spiErrors;
 
-	s = spiSetBaudRate(devSel, false);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, false);
 	spiSend(s, d);
 
 	for (i = 0; i < len; i++)
 		spiSend(s, data[i]);
 
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
 	return (r == spiErrors);
 
 } // spiWriteBlock
 
+//______________________________________________________________________________________________
+
+// DMA transactions. All devices share one SPI port (spiMap) so a single queue serves the
+// bus. The main loop is the only producer and the Rx stream ISR retires the head and starts
+// the next so back to back transactions need no attention from the main loop. Synchronous
+// transfers wait for the queue to drain before using the bus.
+
+#if !defined(STM32F1)
+
+static SPIPortDef * spiDMAPort;
+static spiTransStruct spiQ[SPI_QUEUE_LEN];
+static volatile uint8 spiQHead = 0, spiQTail = 0; // free running, masked on use
+static volatile boolean spiDMABusy = false;
+static uint32 spiDMAStartuS;
+static uint8 spiTxBuffer[SPI_DMA_MAX_LEN + 1];
+static uint8 spiRxBuffer[SPI_DMA_MAX_LEN + 1];
+
+// Streams are 0x18 apart from 0x10 within each controller with their 6 flag bits packed
+// four to a status register around a gap at bit 12
+
+#define DMA_STREAM_FEIF		0x01
+#define DMA_STREAM_TEIF		0x08
+#define DMA_STREAM_TCIF		0x20
+#define DMA_STREAM_FLAGS	0x3d
+
+static const uint8 spiDMAShift[4] = { 0, 6, 16, 22 };
+
+static uint32 spiDMAFlags(DMA_Stream_TypeDef * s) {
+	DMA_TypeDef * d;
+	uint8 n;
+
+	d = ((uint32) s < DMA2_BASE) ? DMA1 : DMA2;
+	n = (((uint32) s & 0xff) - 0x10) / 0x18;
+
+	return (((n < 4) ? d->LISR : d->HISR) >> spiDMAShift[n & 3])
+			& DMA_STREAM_FLAGS;
+} // spiDMAFlags
+
+static void spiClearDMAFlags(DMA_Stream_TypeDef * s) {
+	DMA_TypeDef * d;
+	uint8 n;
+
+	d = ((uint32) s < DMA2_BASE) ? DMA1 : DMA2;
+	n = (((uint32) s & 0xff) - 0x10) / 0x18;
+
+	if (n < 4)
+		d->LIFCR = DMA_STREAM_FLAGS << spiDMAShift[n];
+	else
+		d->HIFCR = DMA_STREAM_FLAGS << spiDMAShift[n - 4];
+} // spiClearDMAFlags
+
+static void spiStartDMA(void) {
+	spiTransStruct * t;
+	SPI_TypeDef * SPIx;
+	idx i;
+
+	t = &spiQ[spiQHead & (SPI_QUEUE_LEN - 1)];
+	SPIx = spiDMAPort->SPIx;
+
+	// no settling delay - nothing is clocked until the streams are enabled
+	spiConfigure(SPIx, t->devSel, t->Read);
+
+	if (t->Read) {
+		spiTxBuffer[0] = spiReadPrefix(t->devSel, t->len) | t->reg;
+		memset(&spiTxBuffer[1], 0, t->len);
+	} else {
+		spiTxBuffer[0] = t->reg;
+		for (i = 0; i < t->len; i++)
+			spiTxBuffer[i + 1] = t->data[i];
+	}
+
+	(void) SPIx->DR; // stale byte would shift the Rx stream
+
+	spiClearDMAFlags(spiDMAPort->RxDMAStream);
+	spiClearDMAFlags(spiDMAPort->TxDMAStream);
+	DMA_SetCurrDataCounter(spiDMAPort->RxDMAStream, t->len + 1);
+	DMA_SetCurrDataCounter(spiDMAPort->TxDMAStream, t->len + 1);
+
+	spiDMABusy = true;
+	spiDMAStartuS = uSClock();
+
+	digitalWrite(&SPISelectPins[t->devSel], 0);
+	spiBus[spiMap[t->devSel] - 1].Owner = t->devSel + 1;
+
+	DMA_Cmd(spiDMAPort->RxDMAStream, ENABLE);
+	DMA_Cmd(spiDMAPort->TxDMAStream, ENABLE);
+	SPI_I2S_DMACmd(SPIx, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+
+} // spiStartDMA
+
+static void spiFinishDMA(boolean ok) {
+	spiTransStruct * t;
+
+	t = &spiQ[spiQHead & (SPI_QUEUE_LEN - 1)];
+
+	SPI_I2S_DMACmd(spiDMAPort->SPIx, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx,
+			DISABLE);
+	DMA_Cmd(spiDMAPort->TxDMAStream, DISABLE);
+	DMA_Cmd(spiDMAPort->RxDMAStream, DISABLE);
+
+	digitalWrite(&SPISelectPins[t->devSel], 1);
+	spiBus[spiMap[t->devSel] - 1].Owner = 0;
+
+	if (ok) {
+		if (t->Read)
+			memcpy(t->data, &spiRxBuffer[1], t->len);
+		spiDMAStats.Completed++;
+	} else {
+		spiErrors++;
+		setStat(SPIFailS, spiErrors);
+	}
+
+	spiDMABusy = false;
+	spiQHead++;
+
+	if (t->Done)
+		t->Done(ok);
+
+	if (spiQHead != spiQTail)
+		spiStartDMA();
+
+} // spiFinishDMA
+
+void spiDMAISR(void) {
+	boolean ok;
+	uint32 f;
+
+	f = spiDMAFlags(spiDMAPort->RxDMAStream);
+	spiClearDMAFlags(spiDMAPort->RxDMAStream);
+
+	if (spiDMABusy && (f & (DMA_STREAM_TEIF | DMA_STREAM_TCIF))) {
+		ok = (f & DMA_STREAM_TEIF) == 0;
+		if (!ok)
+			spiDMAStats.Errors++;
+		spiFinishDMA(ok);
+	}
+
+} // spiDMAISR
+
+void spiCheckTimeout(void) {
+
+	if (spiDMABusy && ((uSClock() - spiDMAStartuS) > SPI_DMA_TIMEOUT_US)) {
+		__disable_irq();
+		if (spiDMABusy) { // may have completed meanwhile
+			spiDMAStats.Timeouts++;
+			spiFinishDMA(false);
+		}
+		__enable_irq();
+	}
+
+} // spiCheckTimeout
+
+static boolean spiQueue(uint8 devSel, uint8 reg, uint8 len, boolean Read,
+		uint8 * data, spiDoneFn Done) {
+	spiTransStruct * t;
+	uint8 Entries;
+
+	if (!spiDMAEnabled || (len > SPI_DMA_MAX_LEN))
+		return (false);
+
+	if ((uint8) (spiQTail - spiQHead) >= SPI_QUEUE_LEN) {
+		spiDMAStats.Overflows++;
+		return (false);
+	}
+
+	t = &spiQ[spiQTail & (SPI_QUEUE_LEN - 1)];
+	t->devSel = devSel;
+	t->reg = reg;
+	t->len = len;
+	t->Read = Read;
+	t->data = data;
+	t->Done = Done;
+
+	__disable_irq();
+	spiQTail++;
+	Entries = spiQTail - spiQHead;
+	if (!spiDMABusy && (spiBus[spiMap[devSel] - 1].Owner == 0))
+		spiStartDMA();
+	__enable_irq();
+
+	spiDMAStats.Queued++;
+	if (Entries > spiDMAStats.MaxQueue)
+		spiDMAStats.MaxQueue = Entries;
+
+	return (true);
+} // spiQueue
+
+boolean spiQueueRead(uint8 devSel, uint8 reg, uint8 len, uint8 * data,
+		spiDoneFn Done) {
+	return (spiQueue(devSel, reg, len, true, data, Done));
+} // spiQueueRead
+
+boolean spiQueueWrite(uint8 devSel, uint8 reg, uint8 len, uint8 * data,
+		spiDoneFn Done) {
+	return (spiQueue(devSel, reg, len, false, data, Done));
+} // spiQueueWrite
+
+boolean spiIdle(void) {
+	return (spiQHead == spiQTail);
+} // spiIdle
+
+static void spiResumeDMA(uint8 spiPort) {
+
+	__disable_irq();
+	if (!spiDMABusy && !spiIdle() && (spiBus[spiPort].Owner == 0))
+		spiStartDMA();
+	__enable_irq();
+
+} // spiResumeDMA
+
+void spiWaitIdle(void) {
+
+	while (!spiIdle())
+		spiCheckTimeout();
+
+} // spiWaitIdle
+
+boolean spiInitDMA(uint8 spiPort) {
+	DMA_InitTypeDef DMA_InitStructure;
+	NVIC_InitTypeDef NVIC_InitStructure;
+	SPIPortDef * p;
+
+	p = &SPIPorts[spiPort];
+
+	spiQHead = spiQTail = 0;
+	spiDMABusy = false;
+	memset(&spiDMAStats, 0, sizeof(spiDMAStats));
+
+	spiDMAEnabled = p->Used && (p->TxDMAStream != 0) && (p->RxDMAStream != 0);
+
+	if (spiDMAEnabled) {
+		spiDMAPort = p;
+
+		RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_DMA1 | RCC_AHB1Periph_DMA2, ENABLE);
+
+		DMA_StructInit(&DMA_InitStructure);
+		DMA_InitStructure.DMA_Channel = p->DMAChannel;
+		DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32) &p->SPIx->DR;
+		DMA_InitStructure.DMA_MemoryInc = DMA_MemoryInc_Enable;
+		DMA_InitStructure.DMA_Mode = DMA_Mode_Normal;
+
+		DMA_DeInit(p->RxDMAStream);
+		DMA_InitStructure.DMA_DIR = DMA_DIR_PeripheralToMemory;
+		DMA_InitStructure.DMA_Memory0BaseAddr = (uint32) spiRxBuffer;
+		DMA_InitStructure.DMA_Priority = DMA_Priority_VeryHigh;
+		DMA_Init(p->RxDMAStream, &DMA_InitStructure);
+		DMA_ITConfig(p->RxDMAStream, DMA_IT_TC | DMA_IT_TE, ENABLE);
+
+		DMA_DeInit(p->TxDMAStream);
+		DMA_InitStructure.DMA_DIR = DMA_DIR_MemoryToPeripheral;
+		DMA_InitStructure.DMA_Memory0BaseAddr = (uint32) spiTxBuffer;
+		DMA_InitStructure.DMA_Priority = DMA_Priority_High;
+		DMA_Init(p->TxDMAStream, &DMA_InitStructure);
+
+		NVIC_InitStructure.NVIC_IRQChannel = p->RxDMAISR;
+		NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+		NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+		NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+		NVIC_Init(&NVIC_InitStructure);
+	}
+
+	return (spiDMAEnabled);
+} // spiInitDMA
+
+#else
+
+static void spiResumeDMA(uint8 spiPort) {
+} // spiResumeDMA
+
+void spiDMAISR(void) {
+} // spiDMAISR
+
+void spiCheckTimeout(void) {
+} // spiCheckTimeout
+
+boolean spiQueueRead(uint8 devSel, uint8 reg, uint8 len, uint8 * data,
+		spiDoneFn Done) {
+	return (false);
+} // spiQueueRead
+
+boolean spiQueueWrite(uint8 devSel, uint8 reg, uint8 len, uint8 * data,
+		spiDoneFn Done) {
+	return (false);
+} // spiQueueWrite
+
+boolean spiIdle(void) {
+	return (true);
+} // spiIdle
+
+void spiWaitIdle(void) {
+} // spiWaitIdle
+
+boolean spiInitDMA(uint8 spiPort) {
+	return (false);
+} // spiInitDMA
+
+#endif
@@ -43,5 +43,58 @@ extern boolean spiWriteBlock(uint8 devSel, uint8 id, uint8 reg, uint8 len,
 
 extern uint32 spiErrors;
 
+// Bus manager - a port is owned by at most one device at a time. Polled transfers acquire
+// the bus, waiting for queued DMA transactions to drain, and the port is only reconfigured
+// when the device rate differs from the one already set.
+
+typedef struct {
+	uint8 Owner; // devSel + 1 with chip select asserted, zero if none
+	uint8 ConfigDev; // devSel + 1 the port was last configured for
+	uint32 Acquires, Reconfigs, CSConflicts, WaituS;
+	uint32 CycleReconfigs, CycleWaituS; // since spiBusCycleStart
+	uint32 MaxCycleReconfigs, MaxCycleWaituS;
+} spiBusStruct;
+
+extern SPI_TypeDef * spiAcquire(uint8 devSel, boolean R);
+extern void spiRelease(uint8 devSel);
+extern void spiBusCycleStart(void);
+
+extern spiBusStruct spiBus[];
+
+// DMA transactions - queued by the main loop and completed by the SPI Rx DMA stream ISR
+
+#define SPI_QUEUE_LEN		8
+#define SPI_DMA_MAX_LEN		32 // bytes after the register address
+#define SPI_DMA_TIMEOUT_US	500
+
+typedef void (*spiDoneFn)(boolean ok);
+
+typedef struct {
+	uint8 devSel;
+	uint8 reg;
+	uint8 len;
+	boolean Read;
+	uint8 * data;
+	spiDoneFn Done;
+} spiTransStruct;
+
+typedef struct {
+	uint32 Queued, Completed, Errors, Timeouts, Overflows;
+	uint32 MaxQueue;
+} spiDMAStatsStruct;
+
+extern boolean spiInitDMA(uint8 spiPort);
+extern boolean spiQueueRead(uint8 devSel, uint8 reg, uint8 len, uint8 * data,
+		spiDoneFn Done);
+extern boolean spiQueueWrite(uint8 devSel, uint8 reg, uint8 len, uint8 * data,
+		spiDoneFn Done);
+extern void spiDMAISR(void);
+extern void spiCheckTimeout(void);
+extern boolean spiIdle(void);
+extern void spiWaitIdle(void);
+
+extern boolean spiDMAEnabled;
+extern spiDMAStatsStruct spiDMAStats;
+
 #endif
 
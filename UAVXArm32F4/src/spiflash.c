@@ -113,17 +113,15 @@ void flashSendAddress(SPI_TypeDef * s, uint32 a) {
 uint8 flashReadStatus(uint8 devSel) {
 	SPI_TypeDef * s;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
-	s = spiSetBaudRate(devSel, true);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, true);
 	oxo = spiSend(s, STATUS_FL);
 	flashStatus1 = spiSend(s, 0);
 	//flashStatus2 = spiSend(s, 0);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
 	return(flashStatus1);
 
@@ -135,17 +133,15 @@ boolean flashDeviceInfoValid(uint8 devSel) {
 	SPI_TypeDef * s;
 	boolean r;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
-	s = spiSetBaudRate(devSel, true);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, true);
 	oxo = spiSend(s, DEV_FL);
 	for (i = 0; i < 5; i++)
 		flashInfo[i] = spiSend(s, 0);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
 	r = true;
 	for (i = 0; i < 5; i++)
@@ -159,20 +155,18 @@ boolean flashDeviceInfoValid(uint8 devSel) {
 void flashReset(uint8 devSel) {
 	SPI_TypeDef * s;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
-	s = spiSetBaudRate(devSel, false);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, false);
 	oxo = spiSend(s, 0x80);
 	oxo = spiSend(s, 0);
 	oxo = spiSend(s, 0);
 	oxo = spiSend(s, 0);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
-	uSTimer(uSClock(),MemReady, 35);
+	uSTimer(uSClock64(), MemReady, 35);
 
 } // flashReset
 
@@ -182,15 +176,13 @@ boolean flashReadPage(uint8 devSel, uint32 a, uint32 len, int8 * data) {
 	SPI_TypeDef * s;
 	uint32 r;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
 	r = spiErrors;
 
-	s = spiSetBaudRate(devSel, true);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, true);
 	oxo = spiSend(s, RD_FL);
 	flashSendAddress(s, a);
 	oxo = spiSend(s, 0); // dummy to allow setup
@@ -199,7 +191,7 @@ boolean flashReadPage(uint8 devSel, uint32 a, uint32 len, int8 * data) {
 	oxo = spiSend(s, 0);
 	for (i = 0; i < len; i++)
 		data[i] = spiSend(s, 0);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
 	return (r == spiErrors);
 
@@ -213,20 +205,18 @@ boolean flashReadPage(uint8 devSel, uint32 a, uint32 len, int8 * data) {
 boolean flashConfig256(uint8 devSel) {
 	SPI_TypeDef * s;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
-	s = spiSetBaudRate(devSel, false);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, false);
 	oxo = spiSend(s, 0x3d);
 	oxo = spiSend(s, 0x2a);
 	oxo = spiSend(s, 0x80);
 	oxo = spiSend(s, 0xa6);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
-	uSTimer(uSClock(),MemReady, 35000);
+	uSTimer(uSClock64(), MemReady, 35000);
 
 	return(flashFlagSet(devSel, FLAG_256));
 
@@ -238,22 +228,20 @@ boolean flashReadModifyWrite(uint8 devSel, uint32 a, uint32 len, int8 *data) {
 	SPI_TypeDef * s;
 	uint32 r;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
 	r = spiErrors;
 
-	s = spiSetBaudRate(devSel, false);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, false);
 	oxo = spiSend(s, RD_MOD_WR_B1_FL);
 	flashSendAddress(s, a);
 	for (i = 0; i < len; i++)
 		oxo = spiSend(s, data[i]);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
-	uSTimer(uSClock(),MemReady, 35000);
+	uSTimer(uSClock64(), MemReady, 35000);
 
 	return (r == spiErrors);
 
@@ -267,20 +255,18 @@ boolean flashErasePage(uint8 devSel, uint32 a) {
 	SPI_TypeDef * s;
 	uint32 r;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
 	r = spiErrors;
 
-	s = spiSetBaudRate(devSel, false);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, false);
 	oxo = spiSend(s, ERASE_PAGE_FL);
 	flashSendAddress(s, a);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
-	uSTimer(uSClock(),MemReady, 35000);
+	uSTimer(uSClock64(), MemReady, 35000);
 
 	return (r == spiErrors);
 
@@ -290,22 +276,20 @@ boolean flashEraseSector(uint8 devSel, uint32 a) {
 	SPI_TypeDef * s;
 	uint32 r;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
 	r = spiErrors;
 
-	s = spiSetBaudRate(devSel, false);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, false);
 
 	oxo = spiSend(s, ERASE_SECTOR_FL);
 	flashSendAddress(s, a);
 
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
-	uSTimer(uSClock(),MemReady, 6500000);
+	uSTimer(uSClock64(), MemReady, 6500000);
 
 	return (r == spiErrors);
 
@@ -316,22 +300,20 @@ boolean flashErase(uint8 devSel) {
 	SPI_TypeDef * s;
 	uint32 r;
 
-	while (uSClock() < uS[MemReady]) {
+	while (!uSTimeout(uSClock64(), MemReady)) {
 		// BLOCKING
 	};
 
 	r = spiErrors;
 
-	s = spiSetBaudRate(devSel, false);
-
-	spiSelect(devSel, true);
+	s = spiAcquire(devSel, false);
 	oxo = spiSend(s, 0xc7);
 	oxo = spiSend(s, 0x94);
 	oxo = spiSend(s, 0x80);
 	oxo = spiSend(s, 0x9a);
-	spiSelect(devSel, false);
+	spiRelease(devSel);
 
-	uSTimer(uSClock(),MemReady, 208000000);
+	uSTimer(uSClock64(), MemReady, 208000000);
 
 	return (r == spiErrors);
 
@@ -63,6 +63,11 @@ enum Statistics {
 	BadNumS,
 	MinsAccS,
 	MaxsAccS,
+	SchedOverrunsS,
+	SchedCulpritS,
+	IMUDataReadyMissS,
+	JobStallS,
+	NVWriteFailS,
 };
 // NO MORE THAN 32 or 64 bytes
 
@@ -37,8 +37,41 @@ void ReadBlockNV(uint32 a, uint16 l, int8 * v) {
 } // ReadBlockNV
 
 
-boolean UpdateNV(void) {
+// the flash is only left unlocked for the duration of each erase or program
+
+static boolean EraseNV(void) {
+	boolean r;
+
+	FLASH_Unlock();
+#if defined(STM32F1)
+	FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
+	r = FLASH_ErasePage(FLASH_SCRATCH_ADDR) == FLASH_COMPLETE;
+#else
+	FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR | FLASH_FLAG_WRPERR
+			| FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR | FLASH_FLAG_PGSERR);
+	r = FLASH_EraseSector(FLASH_SCRATCH_SECTOR, VoltageRange_3)
+			== FLASH_COMPLETE;
+#endif
+	FLASH_Lock();
+
+	return (r);
+} // EraseNV
+
+static boolean ProgramNV(uint16 a, uint16 l) {
+	boolean r = true;
 	uint16 i;
+
+	FLASH_Unlock();
+	for (i = a; r && (i < (a + l)); i += 4)
+		r = FLASH_ProgramWord(FLASH_SCRATCH_ADDR + i, *(uint32 *) ((uint8 *) &NV
+				+ i)) == FLASH_COMPLETE;
+	FLASH_Lock();
+
+	return (r);
+} // ProgramNV
+
+
+boolean UpdateNV(void) {
 	boolean r = true;
 
 	//for (i = 0; i < l; i++) // TODO: optimise to word compares
@@ -46,31 +79,51 @@ boolean UpdateNV(void) {
 
 
 		if (NVChanged) {
-			FLASH_Unlock();
-#if defined(STM32F1)
-			FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_PGERR | FLASH_FLAG_WRPRTERR);
-			r = FLASH_ErasePage(FLASH_SCRATCH_ADDR) == FLASH_COMPLETE;
-#else
-			FLASH_ClearFlag(FLASH_FLAG_EOP | FLASH_FLAG_OPERR
-					| FLASH_FLAG_WRPERR | FLASH_FLAG_PGAERR | FLASH_FLAG_PGPERR
-					| FLASH_FLAG_PGSERR);
-			r = FLASH_EraseSector(FLASH_SCRATCH_SECTOR, VoltageRange_3)
-					== FLASH_COMPLETE;
-#endif
-			if (r) {
-				for (i = 0; i < sizeof(NV); i += 4) {
-					r = FLASH_ProgramWord(FLASH_SCRATCH_ADDR + i,
-							*(uint32 *) ((uint8 *) &NV + i)) == FLASH_COMPLETE;
-					if (!r)
-						break;
-				}
-			}
-			FLASH_Lock();
+			r = EraseNV() && ProgramNV(0, sizeof(NV));
+			if (r)
+				NVChanged = false;
+			else
+				incStat(NVWriteFailS);
 		}
 
-		NVChanged = false;
-
 	return (r);
 } // UpdateNV
 
+// UpdateNV as a job - the sector erase stalls instruction fetch for its full duration
+// so only the programming can be sliced. NVChanged is cleared once the sector reads back
+// as NV, so changes made while the job runs are caught by the next update. A failed
+// erase or slice is counted and the job restarts, at most NV_WRITE_RETRIES times.
+
+#define NV_WRITE_RETRIES	3
+
+int16 UpdateNVStep(uint8 n) {
+	static uint8 Retries = 0;
+	uint16 a;
+
+	if (n == 0) {
+		if (!NVChanged)
+			return (JOB_DONE);
+		if (EraseNV())
+			return (JOB_NEXT);
+	} else {
+		a = (n - 1) * NV_SLICE_BYTES;
+		if (a >= sizeof(NV)) {
+			NVChanged = memcmp((void *) FLASH_SCRATCH_ADDR, &NV, sizeof(NV))
+					!= 0;
+			Retries = 0;
+			return (JOB_DONE);
+		}
+		if (ProgramNV(a, Min(NV_SLICE_BYTES, sizeof(NV) - a)))
+			return (JOB_NEXT);
+	}
+
+	incStat(NVWriteFailS); // failed
+	if (++Retries <= NV_WRITE_RETRIES)
+		return (JOB_RESTART);
+
+	Retries = 0;
+	return (JOB_DONE);
+
+} // UpdateNVStep
+
 
@@ -658,6 +658,34 @@ void SendStatsPacket(uint8 s) {
 #endif
 } // SendStatsPacket
 
+void SendProfilePacket(uint8 s) {
+	ProfileStruct * P;
+	idx p, First, n;
+
+	for (First = 0; First < MAX_PROBES; First += PROFILE_PACKET_PROBES) {
+		n = Min(MAX_PROBES - First, PROFILE_PACKET_PROBES);
+
+		SendPacketHeader(s);
+
+		TxESCu8(s, UAVXProfilePacketTag);
+		TxESCu8(s, n * 20 + 2);
+		TxESCu8(s, First);
+		TxESCu8(s, n);
+
+		for (p = First; p < (First + n); p++) { // 0.1uS
+			P = &Profile[p];
+			TxESCi32(s, P->Count);
+			TxESCi32(s, ProfileTenthsuS(P->Minc));
+			TxESCi32(s, P->Count > 0 ? ProfileTenthsuS(P->Sumc / P->Count) : 0);
+			TxESCi32(s, ProfileTenthsuS(P->Maxc));
+			TxESCi32(s, ProfileTenthsuS(ProfilePercentilec(p, 99)));
+		}
+
+		SendPacketTrailer(s);
+	}
+
+} // SendProfilePacket
+
 void SendBBPacket(uint8 s, int32 seqNo, uint8 l, int8 * B) {
 	idx i;
 
@@ -683,10 +711,10 @@ void SendNoisePacket(uint8 s) {
 	TxESCu8(s, UAVXNoisePacketTag);
 	TxESCu8(s, 3 + 8 * 2);
 #if defined(INC_DFT)
-	TxESCu8(s, 0);
+	TxESCu8(s, 2); // 0 was the acc DFT in MPU_1G/5000, now the pitch gyro in deg/S*10
 	TxESCi16(s, 1000000 / CurrPIDCycleuS);
 	for (i = 0; i < 8; i++)
-	TxESCi16(s, DFT[i] * 5000.0 / MPU_1G);
+	TxESCi16(s, RadiansToDegrees(DFT[i] * GyroScale[CurrAttSensorType]) * 10.0f);
 #else
 	m = 0;
 	for (i = 0; i < 8; i++)
@@ -1040,6 +1068,10 @@ void ProcessRxPacket(uint8 s) {
 	case UAVXRequestPacketTag:
 		switch (UAVXPacket[2]) {
 		case UAVXMiscPacketTag:
+			if (Armed()) { // all block the telemetry task, some for seconds
+				SendAckPacket(s, UAVXPacket[3], false);
+				break;
+			}
 			switch (UAVXPacket[3]) {
 			case miscCalIMU:
 				CalibrateAccAndGyro(s);
@@ -1097,6 +1129,9 @@ void ProcessRxPacket(uint8 s) {
 		case UAVXStatsPacketTag:
 			SendStatsPacket(s);
 			break;
+		case UAVXProfilePacketTag:
+			SendProfilePacket(s);
+			break;
 		case UAVXFlightPacketTag:
 			SendFlightPacket(s);
 			break;
@@ -1131,15 +1166,14 @@ void ProcessRxPacket(uint8 s) {
 void UAVXPollRx(uint8 s) {
 	uint8 ch;
 
-	if (F.UsingUplink) {
-		if (serialAvailable(s)) {
+	if (F.UsingUplink)
+		while (serialAvailable(s)) { // polled at RG100Hz so drain the ring
 			ch = RxChar(s);
 			ParseRxPacket(ch);
-		}
 
-		if (PacketReceived)
-			ProcessRxPacket(s);
-	}
+			if (PacketReceived)
+				ProcessRxPacket(s);
+		}
 
 } // UAVXPollRx
 
@@ -1155,8 +1189,10 @@ void UseUAVXTelemetry(uint8 s) {
 		SendNavPacket(s); // 2+54+4 = 60
 		SendNoisePacket(s); // 24
 		SendStatsPacket(s); // ~80 -> 104
-		if ((State == Preflight) || (State == Ready)) //Warmup) || (State == Landed))
+		if ((State == Preflight) || (State == Ready)) { //Warmup) || (State == Landed))
 			SendCalibrationPacket(s);
+			SendProfilePacket(s); // 2 x 166
+		}
 	}
 	SendFlight = !SendFlight;
 } // UseUAVXTelemetry
@@ -1177,7 +1213,7 @@ void CheckTelemetry(uint8 s) {
 
 	if (!(Armed() || (UAVXAirframe == Instrumentation))) {
 		SetTelemetryBaudRate(s, 115200);
-		if (NowmS >= mS[TelemetryUpdate]) {
+		if (mSTimeout(NowmS, TelemetryUpdate)) {
 			mSTimer(NowmS, TelemetryUpdate, UAVX_TEL_INTERVAL_MS);
 			UseUAVXTelemetry(s);
 		}
@@ -1185,14 +1221,14 @@ void CheckTelemetry(uint8 s) {
 		switch (CurrTelType) {
 		case UAVXTelemetry:
 			SetTelemetryBaudRate(s, 115200);
-			if (NowmS >= mS[TelemetryUpdate]) {
+			if (mSTimeout(NowmS, TelemetryUpdate)) {
 				mSTimer(NowmS, TelemetryUpdate, UAVX_TEL_INTERVAL_MS);
 				UseUAVXTelemetry(s);
 			}
 			break;
 		case UAVXMinTelemetry:
 			SetTelemetryBaudRate(s, 115200);
-			if (NowmS >= mS[TelemetryUpdate]) {
+			if (mSTimeout(NowmS, TelemetryUpdate)) {
 				mSTimer(NowmS, TelemetryUpdate, UAVX_MIN_TEL_INTERVAL_MS);
 				SendMinPacket(s);
 				if (State == Warmup)
@@ -1203,7 +1239,7 @@ void CheckTelemetry(uint8 s) {
 		case UAVXRatePIDTelemetry:
 		case UAVXAltPIDTelemetry:
 			SetTelemetryBaudRate(s, 115200);
-			if (NowmS >= mS[TelemetryUpdate]) {
+			if (mSTimeout(NowmS, TelemetryUpdate)) {
 				mSTimer(NowmS, TelemetryUpdate, UAVX_PID_TEL_INTERVAL_MS);
 				if (((State == InFlight) || (State == Launching)) && !F.Bypass)
 					switch (CurrTelType) {
@@ -1221,7 +1257,7 @@ void CheckTelemetry(uint8 s) {
 			break;
 		case UAVXMinimOSDTelemetry:
 			SetTelemetryBaudRate(s, 115200); //57600);
-			if (NowmS >= mS[TelemetryUpdate]) {
+			if (mSTimeout(NowmS, TelemetryUpdate)) {
 				mSTimer(NowmS, TelemetryUpdate, UAVX_MINIMOSD_TEL_INTERVAL_MS);
 				SendMinimOSDPacket(s);
 				SendGuidancePacket(s);
@@ -1239,7 +1275,7 @@ void CheckTelemetry(uint8 s) {
 		case FrSkyV1Telemetry:
 		case FrSkyV2SPortTelemetry:
 			SetTelemetryBaudRate(s, 9600);
-			if (NowmS >= mS[TelemetryUpdate]) {
+			if (mSTimeout(NowmS, TelemetryUpdate)) {
 				mSTimer(NowmS, TelemetryUpdate, FRSKY_TEL_INTERVAL_MS);
 				SendFrSkyTelemetry(s);
 			}
@@ -71,6 +71,7 @@ enum PacketTags {
 	UAVXRatePIDPacketTag = 64,
 	UAVXAltPIDPacketTag = 65,
 	UAVXGPSPIDPacketTag = 66,
+	UAVXProfilePacketTag = 67,
 
 	FrSkyPacketTag = 99
 };
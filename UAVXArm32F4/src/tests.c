@@ -155,14 +155,14 @@ void CommissioningTest(uint8 s) {
 		GetIMU();
 
 		F.BaroActive = true; // force
-		if (mSClock() >= mS[BaroUpdate]) {
+		if (mSTimeout(mSClock(), BaroUpdate)) {
 			mSTimer(mSClock(), BaroUpdate, 4);
 			GetBaro();
 		}
 
 		GetMagnetometer();
 
-		if (mSClock() > Timeout) {
+		if (!TimeReached(Timeout, mSClock())) {
 			Timeout += 500;
 
 			TxString(s, " B: ");
@@ -235,15 +235,11 @@ void CommissioningTest(uint8 s) {
 	while (true) {
 		Delay1mS(2);
 
-		dT = dTUpdate(uSClock(), &LastInertialUpdateuS);
-		dTOn2 = 0.5f * dT;
-		dTR = 1.0f / dT;
-		dTROn2 = dTR * 0.5f;
-
 		GetIMU();
+		CalculatedT(mpu6xxxSampleuS);
 		DoMadgwickAttitude(false);
 
-		if (mSClock() > Timeout) {
+		if (!TimeReached(Timeout, mSClock())) {
 			Timeout += 500;
 
 			OK(s, F.IMUActive);
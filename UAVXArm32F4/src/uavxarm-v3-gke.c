@@ -24,13 +24,14 @@ Flags F;
 uint8 State;
 uint32 CurrPIDCycleuS = PID_CYCLE_2000US;
 real32 CurrPIDCycleS;
-volatile uint32 uS[uSLastArrayEntry];
+volatile uint64 uS[uSLastArrayEntry];
 volatile uint32 mS[mSLastArrayEntry];
 
 uint8 ch;
 int8 i, m;
 
 void InitMisc(void) {
+	uint32 NowmS;
 	idx i;
 
 	State = Preflight;
@@ -38,8 +39,9 @@ void InitMisc(void) {
 	for (i = 0; i < FLAG_BYTES; i++)
 		F.AllFlags[i] = false;
 
+	NowmS = mSClock(); // timers start expired whatever the uptime origin
 	for (i = 0; i < mSLastArrayEntry; i++)
-		mS[i] = 0;
+		mS[i] = NowmS;
 
 	for (i = 0; i < uSLastArrayEntry; i++)
 		uS[i] = 0;
@@ -49,15 +51,6 @@ void InitMisc(void) {
 
 } // InitMisc
 
-void CalculatedT(uint32 NowuS) {
-
-	dT = dTUpdate(NowuS, &LastInertialUpdateuS);
-	dTOn2 = 0.5f * dT;
-	dTR = 1.0f / dT;
-	dTROn2 = dTR * 0.5f;
-
-} // CalculatedT
-
 void ResetMainTimeouts(void) {
 	uint32 NowmS;
 
@@ -69,8 +62,13 @@ void ResetMainTimeouts(void) {
 
 
 int main() {
-	uint32 NowuS;
-	static uint32 LastUpdateuS = 0;
+	uint64 NowuS, SampleuS;
+	uint32 Samplec;
+#if defined(USE_MPU6XXX_INT)
+	MPU6XXXDataReadyStruct DataReady;
+#endif
+	static uint64 LastUpdateuS = 0;
+	static uint32 PrevSamplec = 0;
 
 	CheckParametersInitialised();
 
@@ -114,6 +112,9 @@ int main() {
 
 	LEDOn(LEDGreenSel);
 	InitIMU(); // connects pass through for mag
+#if defined(USE_MPU6XXX_INT)
+	InitSensorInterrupts();
+#endif
 
 	LEDOn(LEDBlueSel);
 	InitMagnetometer();
@@ -141,7 +142,9 @@ int main() {
 
 	FirstPass = true;
 	mSTimer(mSClock(), LastBattery, 0);
-	uSTimer(uSClock(), NextCycleUpdate, CurrPIDCycleuS);
+	uSTimer(uSClock64(), NextCycleUpdate, CurrPIDCycleuS);
+	InitScheduler();
+	InitJobs();
 
 	State = Preflight;
 
@@ -161,26 +164,71 @@ int main() {
 
 		}
 
-		NowuS = uSClock();
-		if (NowuS >= uS[NextCycleUpdate]) {
+		NowuS = uSClock64();
+
+#if defined(USE_GYRO_OVERSAMPLING)
+		if ((CurrGyroOversample > 1) && uSTimeout(NowuS, NextGyroUpdate)) {
+			uSTimer(NowuS, NextGyroUpdate, CurrGyroSampleuS);
+			SampleGyro();
+		}
+#endif
+
+#if defined(USE_MPU6XXX_INT)
+		if (ringAvailable(&MPU6XXXDataReadyQ) || (NowuS >= (uS[NextCycleUpdate]
+				+ (CurrPIDCycleuS >> 1)))) { // timer fallback if data ready lost
+#else
+		if (uSTimeout(NowuS, NextCycleUpdate)) {
+#endif
 
 			Probe(1);
+			ProfileBegin(ProfCycle);
+
+#if defined(USE_MPU6XXX_INT)
+			if (ringGet(&MPU6XXXDataReadyQ, &DataReady)) {
+				while (ringGet(&MPU6XXXDataReadyQ, &DataReady))
+					MPU6XXXDataReadyLate++; // use the latest
+				SampleuS = DataReady.uS;
+				Samplec = DataReady.c;
+			} else {
+				incStat(IMUDataReadyMissS);
+				SampleuS = uS[NextCycleUpdate];
+				Samplec = cycleCounter();
+			}
+#else
+			SampleuS = uS[NextCycleUpdate];
+			Samplec = cycleCounter(); // IMU is read a few uS later
+#endif
+			SchedulerCycleStart(SampleuS, NowuS);
+			spiBusCycleStart();
+
+#if defined(USE_SPI_DMA) && !defined(USE_MPU6XXX_FIFO)
+			StartAccAndGyroRead(); // burst completes while the drives are updated
+#endif
 
+			ProfileBegin(ProfDrives);
+			if (PrevSamplec != 0)
+				ProfileInterval(ProfLatency, cycleCounter() - PrevSamplec);
 			UpdateDrives(); // from previous cycle - one cycle lag minimise jitter
+			ProfileEnd(ProfDrives);
+			PrevSamplec = Samplec;
 
 			//---------------
-			CalculatedT(NowuS);
 			UpdateInertial();
 			//---------------
 
+#if defined(USE_MPU6XXX_INT)
+			uSTimer(SampleuS, NextCycleUpdate, CurrPIDCycleuS); // expected next sample
+#else
 			uSTimer(NowuS, NextCycleUpdate, CurrPIDCycleuS);
+#endif
+#if defined(USE_GYRO_OVERSAMPLING)
+			uSTimer(NowuS, NextGyroUpdate, CurrGyroSampleuS);
+#endif
 
-			uSTimer(NowuS, LastCycleTime, -LastUpdateuS);
+			uS[LastCycleTime] = NowuS - LastUpdateuS;
 			LastUpdateuS = NowuS;
 
-			// Housekeeping here
-
-
+			ProfileBegin(ProfStateMachine);
 			switch (State) {
 			case Preflight:
 
@@ -205,6 +253,8 @@ int main() {
 					AlarmState = NoAlarms;
 					InitialThrottle = StickThrottle;
 
+					QueueJob(UpdateNVJob); // disarmed so saves any stick programming
+
 					State = Ready;
 				}
 
@@ -223,10 +273,10 @@ int main() {
 				DoBeep(8, 2);
 
 				if (GPSRxSerial == TelemetrySerial)
-					InitGPS();
+					QueueJob(InitGPSJob);
 
 				DoBeep(8, 2);
-				InitBlackBox();
+				QueueJob(InitBlackBoxJob);
 
 				InitControl();
 				InitNavigation();
@@ -235,6 +285,7 @@ int main() {
 					ErectGyros(5);
 
 				ZeroStats();
+				ResetProfile();
 				F.IsArmed = true;
 				mSTimer(mSClock(), WarmupTimeout, WARMUP_TIMEOUT_MS);
 
@@ -246,8 +297,8 @@ int main() {
 				BatteryCurrentADCZero = SimpleFilter(BatteryCurrentADCZero,
 						analogRead(BattCurrentAnalogSel), 0.5f);
 
-				if (mSClock() > mS[WarmupTimeout]) {
-					UbxSaveConfig(GPSTxSerial); //does this save ephemeris stuff?
+				if (mSTimeout(mSClock(), WarmupTimeout)) {
+					QueueJob(UbxSaveConfigJob); //does this save ephemeris stuff?
 
 					DoBeeps(3);
 					DoBeep(8, 2);
@@ -280,13 +331,13 @@ int main() {
 						if (F.OriginValid) { // for now only works with GPS
 
 							LEDsOff();
-							UbxSaveConfig(GPSTxSerial);
+							QueueJob(UbxSaveConfigJob);
 							F.DrivesArmed = false;
 
 							State = InFlight;
 						}
 					} else {
-						if (mSClock() > mS[ArmedTimeout])
+						if (mSTimeout(mSClock(), ArmedTimeout))
 							InitiateShutdown(PIC);
 						else {
 							if (F.GPSToLaunchRequired && !F.OriginValid)
@@ -300,8 +351,7 @@ int main() {
 								RateEnergySum = 0.0f;
 								RateEnergySamples = 0;
 
-								UbxSaveConfig(GPSTxSerial);
-								UpdateNV(); // also captures stick programming
+								QueueJob(UbxSaveConfigJob);
 
 								LEDsOff();
 
@@ -332,7 +382,7 @@ int main() {
 					F.DrivesArmed = true;
 					State = InFlight;
 				} else {
-					if (mSClock() < mS[ThrottleIdleTimeout])
+					if (!mSTimeout(mSClock(), ThrottleIdleTimeout))
 						DesiredThrottle = IdleThrottle;
 					else {
 						F.DrivesArmed = CurrESCType == DCMotorsWithIdle;
@@ -346,7 +396,6 @@ int main() {
 						if (Tuning) {
 							// TODO: save tuning?
 						}
-						UpdateNV(); // also captures stick programming
 
 						ResetMainTimeouts();
 						mSTimer(mSClock(), ThrottleIdleTimeout,
@@ -378,7 +427,9 @@ int main() {
 
 				LEDChaser();
 
+				ProfileBegin(ProfNavigation);
 				DoNavigation();
+				ProfileEnd(ProfNavigation);
 
 				if (UAVXAirframe == Instrumentation) {
 					if (F.NavigationEnabled)
@@ -402,7 +453,6 @@ int main() {
 							RateEnergySum
 									+= Sqr(Abs(Rate[X]) + Abs(Rate[Y]) + Abs(Rate[Z]));
 							RateEnergySamples++;
-							DFT8(RawAcc[X], DFT); // 145uS
 							DoAltitudeControl();
 						}
 					}
@@ -414,19 +464,16 @@ int main() {
 					State = Preflight;
 				break;
 			} // switch state
+			ProfileEnd(ProfStateMachine);
 
-			setStat(UtilisationS, State == InFlight ? ((uSClock() - NowuS)
+			setStat(UtilisationS, State == InFlight ? ((uSClock64() - NowuS)
 					* 100.0f) / CurrPIDCycleuS : 0);
 
+			ProfileEnd(ProfCycle);
 			Probe(0);
 		} // if next cycle
 
-		CheckBatteries();
-		CheckAlarms();
-		DoCalibrationAlarm();
-
-		CheckTelemetry(TelemetrySerial);
-		UpdatewsLed();
+		RunTasks(); // housekeeping in the slack before the next cycle
 
 	} // while true
 